@@ -0,0 +1,119 @@
+/**
+ * Copyright (C) 2015-2018 Virgil Security Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *     (3) Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+ */
+
+/**
+ * @file benchmark_symmetric_cipher.cxx
+ * @brief Benchmark for symmetric encryption throughput
+ */
+
+#define BENCHPRESS_CONFIG_MAIN
+#include "benchpress.hpp"
+
+#include <functional>
+
+#include <virgil/crypto/VirgilByteArray.h>
+#include <virgil/crypto/foundation/VirgilRandom.h>
+#include <virgil/crypto/foundation/VirgilSymmetricCipher.h>
+
+using std::placeholders::_1;
+
+using virgil::crypto::VirgilByteArray;
+using virgil::crypto::foundation::VirgilRandom;
+using virgil::crypto::foundation::VirgilSymmetricCipher;
+
+constexpr size_t kDataSize = 1024 * 1024;
+
+void benchmark_encrypt(benchpress::context* ctx, VirgilSymmetricCipher::Algorithm algorithm) {
+    VirgilRandom random("benchmark_symmetric_cipher");
+    VirgilSymmetricCipher cipher(algorithm);
+    const VirgilByteArray key = random.randomize(cipher.keyLength());
+    const VirgilByteArray iv = random.randomize(cipher.ivSize());
+    const VirgilByteArray testData = random.randomize(kDataSize);
+    VirgilByteArray encryptedData(cipher.updateOutputSizeMax(kDataSize) + cipher.blockSize() + 16);
+    cipher.setEncryptionKey(key);
+    cipher.setIV(iv);
+
+    ctx->set_bytes(kDataSize);
+    ctx->reset_timer();
+    for (size_t i = 0; i < ctx->num_iterations(); ++i) {
+        cipher.reset();
+        const size_t written = cipher.update(
+                testData.data(), testData.size(), encryptedData.data(), encryptedData.size());
+        (void)cipher.finish(encryptedData.data() + written, encryptedData.size() - written);
+    }
+}
+
+void benchmark_decrypt(benchpress::context* ctx, VirgilSymmetricCipher::Algorithm algorithm) {
+    VirgilRandom random("benchmark_symmetric_cipher");
+    VirgilSymmetricCipher cipher(algorithm);
+    const VirgilByteArray key = random.randomize(cipher.keyLength());
+    const VirgilByteArray iv = random.randomize(cipher.ivSize());
+    const VirgilByteArray testData = random.randomize(kDataSize);
+    cipher.setEncryptionKey(key);
+    const VirgilByteArray encryptedData = cipher.crypt(testData, iv);
+
+    cipher.clear();
+    cipher.setDecryptionKey(key);
+    cipher.setIV(iv);
+    VirgilByteArray decryptedData(cipher.updateOutputSizeMax(encryptedData.size()) + cipher.blockSize());
+
+    ctx->set_bytes(kDataSize);
+    ctx->reset_timer();
+    for (size_t i = 0; i < ctx->num_iterations(); ++i) {
+        cipher.reset();
+        const size_t written = cipher.update(
+                encryptedData.data(), encryptedData.size(), decryptedData.data(), decryptedData.size());
+        (void)cipher.finish(decryptedData.data() + written, decryptedData.size() - written);
+    }
+}
+
+BENCHMARK("Encrypt 1MB -> AES-128-GCM       ",
+        std::bind(benchmark_encrypt, _1, VirgilSymmetricCipher::Algorithm::AES_128_GCM));
+BENCHMARK("Encrypt 1MB -> AES-256-GCM       ",
+        std::bind(benchmark_encrypt, _1, VirgilSymmetricCipher::Algorithm::AES_256_GCM));
+BENCHMARK("Encrypt 1MB -> AES-256-CBC       ",
+        std::bind(benchmark_encrypt, _1, VirgilSymmetricCipher::Algorithm::AES_256_CBC));
+BENCHMARK("Encrypt 1MB -> CHACHA20-POLY1305 ",
+        std::bind(benchmark_encrypt, _1, VirgilSymmetricCipher::Algorithm::CHACHA20_POLY1305));
+
+BENCHMARK("Decrypt 1MB -> AES-128-GCM       ",
+        std::bind(benchmark_decrypt, _1, VirgilSymmetricCipher::Algorithm::AES_128_GCM));
+BENCHMARK("Decrypt 1MB -> AES-256-GCM       ",
+        std::bind(benchmark_decrypt, _1, VirgilSymmetricCipher::Algorithm::AES_256_GCM));
+BENCHMARK("Decrypt 1MB -> AES-256-CBC       ",
+        std::bind(benchmark_decrypt, _1, VirgilSymmetricCipher::Algorithm::AES_256_CBC));
+BENCHMARK("Decrypt 1MB -> CHACHA20-POLY1305 ",
+        std::bind(benchmark_decrypt, _1, VirgilSymmetricCipher::Algorithm::CHACHA20_POLY1305));
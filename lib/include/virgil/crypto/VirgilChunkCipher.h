@@ -43,6 +43,7 @@
 #include "VirgilByteArray.h"
 #include "VirgilDataSource.h"
 #include "VirgilDataSink.h"
+#include "VirgilSeekableDataSource.h"
 
 namespace virgil { namespace crypto {
 
@@ -64,6 +65,24 @@ public:
     static constexpr size_t kPreferredChunkSize = 1024 * 1024;
     ///@}
 public:
+    /**
+     * @brief Define number of threads used to encrypt / decrypt chunks.
+     *
+     * If more than one thread is used, chunks are read ahead from the source,
+     *     processed by the worker threads and written to the sink in the original order.
+     * At most two chunks per thread are kept in memory at a time.
+     *
+     * @param threadsNum - number of worker threads, or @link kThreadsNumAuto @endlink.
+     * @note By default chunks are processed in the caller thread.
+     * @note Encrypted data does not depend on the number of threads.
+     */
+    void setThreadsNum(size_t threadsNum);
+
+    /**
+     * @brief Return number of threads used to encrypt / decrypt chunks.
+     */
+    size_t getThreadsNum() const;
+
     /**
      * @brief Encrypt data read from given source and write it the sink.
      * @param source - source of the data to be encrypted.
@@ -77,6 +96,21 @@ public:
             VirgilDataSource& source, VirgilDataSink& sink, bool embedContentInfo = true,
             size_t preferredChunkSize = kPreferredChunkSize);
 
+    /**
+     * @brief Return exact size of the data written by the following encryption of the data of the given size.
+     *
+     * Cipher state is not changed, but recipients' keys are encrypted with a dummy key to find out
+     *     the content info size, so this call takes about as long as building the content info.
+     *
+     * @param dataSize - size of the data to be read from the source.
+     * @param embedContentInfo - the same value MUST be given to the following encrypt() call.
+     * @param preferredChunkSize - the same value MUST be given to the following encrypt() call.
+     * @note Recipients, custom parameters and the content encryption algorithm of the following encryption
+     *     MUST be the same.
+     */
+    size_t calculateEncryptedSize(
+            size_t dataSize, bool embedContentInfo = true, size_t preferredChunkSize = kPreferredChunkSize);
+
     /**
      * @brief Decrypt data read from given source for recipient defined by id and private key,
      *     and write it to the sink.
@@ -87,6 +121,16 @@ public:
             VirgilDataSource& source, VirgilDataSink& sink, const VirgilByteArray& recipientId,
             const VirgilByteArray& privateKey, const VirgilByteArray& privateKeyPassword = VirgilByteArray());
 
+    /**
+     * @brief Decrypt data read from given source for recipient defined by id and parsed private key,
+     *     and write it to the sink.
+     * @note Content info MUST be defined, if it was not embedded to the encrypted data.
+     * @see method setContentInfo().
+     */
+    void decryptWithKey(
+            VirgilDataSource& source, VirgilDataSink& sink, const VirgilByteArray& recipientId,
+            const VirgilPrivateKeyHandle& privateKey);
+
     /**
      * @brief Decrypt data read from given source for recipient defined by password,
      *     and write it to the sink.
@@ -95,9 +139,48 @@ public:
      */
     void decryptWithPassword(VirgilDataSource& source, VirgilDataSink& sink, const VirgilByteArray& pwd);
 
+    /**
+     * @name Random access decryption
+     *
+     * Decrypt only part of the original data: bytes within range [offset, offset + length).
+     * Only chunks that cover requested range are read from the source, decrypted and authenticated.
+     *
+     * @note Content info MUST be defined, if it was not embedded to the encrypted data.
+     * @note If offset is beyond the end of the original data, nothing is written to the sink.
+     * @note Data encrypted by previous versions of the library is decrypted from the beginning,
+     *     because its chunk nonces can not be derived from the chunk position.
+     * @see method setContentInfo().
+     */
+    ///@{
+    /**
+     * @brief Decrypt given range of the data read from the seekable source
+     *     for recipient defined by id and private key, and write it to the sink.
+     */
+    void decryptRangeWithKey(
+            VirgilSeekableDataSource& source, VirgilDataSink& sink, size_t offset, size_t length,
+            const VirgilByteArray& recipientId, const VirgilByteArray& privateKey,
+            const VirgilByteArray& privateKeyPassword = VirgilByteArray());
+
+    /**
+     * @brief Decrypt given range of the data read from the seekable source
+     *     for recipient defined by id and parsed private key, and write it to the sink.
+     */
+    void decryptRangeWithKey(
+            VirgilSeekableDataSource& source, VirgilDataSink& sink, size_t offset, size_t length,
+            const VirgilByteArray& recipientId, const VirgilPrivateKeyHandle& privateKey);
+
+    /**
+     * @brief Decrypt given range of the data read from the seekable source
+     *     for recipient defined by password, and write it to the sink.
+     */
+    void decryptRangeWithPassword(
+            VirgilSeekableDataSource& source, VirgilDataSink& sink, size_t offset, size_t length,
+            const VirgilByteArray& pwd);
+    ///@}
+
 private:
     /**
-     * @brief Store actual chunk size in the custom parameters.
+     * @brief Store actual chunk size and the way chunk nonce is derived in the custom parameters.
      */
     void storeChunkSize(size_t chunkSize);
 
@@ -106,10 +189,31 @@ private:
      */
     size_t retrieveChunkSize() const;
 
+    /**
+     * @brief Define whether chunk nonce is derived from the chunk index.
+     *
+     * Data encrypted by previous versions of the library use nonce derivation
+     *     that depends on how encrypted data was read from the source.
+     */
+    bool isChunkNonceIndexed() const;
+
+    /**
+     * @brief Init encryption, build content info and store chunk parameters, return actual chunk size.
+     */
+    size_t prepareChunkEncryption(size_t preferredChunkSize);
+
     /**
      * @brief Do encryption / decryption depends on the configured mode.
      */
     void process(VirgilDataSource& source, VirgilDataSink& sink, size_t actualChunkSize);
+
+    /**
+     * @brief Do decryption of the chunks that cover given range.
+     */
+    void processRange(VirgilSeekableDataSource& source, VirgilDataSink& sink, size_t offset, size_t length);
+
+private:
+    size_t threadsNum_ = 1;
 };
 
 }}
@@ -59,6 +59,37 @@ public:
      */
     VirgilByteArray encrypt(const VirgilByteArray& data, bool embedContentInfo = true);
 
+    /**
+     * @brief Return exact size of the data returned by the following encryption of the data of the given size.
+     *
+     * Cipher state is not changed, but recipients' keys are encrypted with a dummy key to find out
+     *     the content info size, so this call takes about as long as building the content info.
+     *
+     * @param dataSize - size of the data to be encrypted.
+     * @param embedContentInfo - the same value MUST be given to the following encrypt() call.
+     * @note Recipients, custom parameters and the content encryption algorithm of the following encryption
+     *     MUST be the same.
+     */
+    size_t calculateEncryptedSize(size_t dataSize, bool embedContentInfo = true);
+
+    /**
+     * @brief Encrypt given data to the given buffer.
+     *
+     * Content info (if embedded) and encrypted data are written directly to the buffer, so no copies are made.
+     *
+     * @param data - data to be encrypted.
+     * @param dataSize - size of the data to be encrypted.
+     * @param encryptedData - output buffer.
+     * @param encryptedDataCapacity - size of the output buffer,
+     *     MUST be at least @link calculateEncryptedSize() @endlink.
+     * @param embedContentInfo - determines whether to embed content info the the encrypted data, or not.
+     * @return Number of bytes written to the output buffer.
+     * @throw VirgilCryptoException with VirgilCryptoError::InvalidArgument, if output buffer is too small.
+     */
+    size_t encrypt(
+            const unsigned char* data, size_t dataSize, unsigned char* encryptedData, size_t encryptedDataCapacity,
+            bool embedContentInfo = true);
+
     /**
      * @brief Decrypt given data for recipient defined by id and private key.
      * @note Content info MUST be defined, if it was not embedded to the encrypted data.
@@ -70,6 +101,16 @@ public:
             const VirgilByteArray& recipientId, const VirgilByteArray& privateKey,
             const VirgilByteArray& privateKeyPassword = VirgilByteArray());
 
+    /**
+     * @brief Decrypt given data for recipient defined by id and parsed private key.
+     * @note Content info MUST be defined, if it was not embedded to the encrypted data.
+     * @see method setContentInfo().
+     * @return Decrypted data.
+     */
+    VirgilByteArray decryptWithKey(
+            const VirgilByteArray& encryptedData,
+            const VirgilByteArray& recipientId, const VirgilPrivateKeyHandle& privateKey);
+
     /**
      * @brief Decrypt given data for recipient defined by password.
      * @note Content info MUST be defined, if it was not embedded to the encrypted data.
@@ -77,12 +118,70 @@ public:
      * @return Decrypted data.
      */
     VirgilByteArray decryptWithPassword(const VirgilByteArray& encryptedData, const VirgilByteArray& pwd);
+
+    /**
+     * @name Compact envelope
+     *
+     * Compact envelope replaces ASN.1 content info with the fixed binary layout,
+     *     so it is preferable for the small messages that are encrypted at high rate.
+     *
+     * Restrictions:
+     *     - only key recipients of the same key type, that supports key agreement, i.e. Curve25519 or NIST P-256;
+     *     - only AEAD content encryption algorithms;
+     *     - password recipients and custom parameters are not supported.
+     *
+     * @note Compact envelope can not be decrypted with decryptWithKey(), and vice versa.
+     */
+    ///@{
+    /**
+     * @brief Encrypt given data to the compact envelope.
+     * @note Added recipients are kept, so the same cipher can encrypt the next message.
+     * @return Compact envelope with encrypted data.
+     * @throw VirgilCryptoException with VirgilCryptoError::InvalidState, if recipients or custom parameters
+     *     can not be stored in the compact envelope.
+     */
+    VirgilByteArray encryptCompact(const VirgilByteArray& data);
+
+    /**
+     * @brief Decrypt given compact envelope for recipient defined by id and private key.
+     * @return Decrypted data.
+     * @throw VirgilCryptoException with VirgilCryptoError::InvalidFormat, if compact envelope is malformed.
+     * @throw VirgilCryptoException with VirgilCryptoError::NotFoundKeyRecipient, if recipient is not found.
+     */
+    VirgilByteArray decryptCompactWithKey(
+            const VirgilByteArray& encryptedData,
+            const VirgilByteArray& recipientId, const VirgilByteArray& privateKey,
+            const VirgilByteArray& privateKeyPassword = VirgilByteArray());
+
+    /**
+     * @brief Decrypt given compact envelope for recipient defined by id and parsed private key.
+     * @return Decrypted data.
+     * @throw VirgilCryptoException with VirgilCryptoError::InvalidFormat, if compact envelope is malformed.
+     * @throw VirgilCryptoException with VirgilCryptoError::NotFoundKeyRecipient, if recipient is not found.
+     */
+    VirgilByteArray decryptCompactWithKey(
+            const VirgilByteArray& encryptedData,
+            const VirgilByteArray& recipientId, const VirgilPrivateKeyHandle& privateKey);
+    ///@}
 private:
+    /**
+     * @brief Encrypt given data with the prepared symmetric cipher.
+     * @return Number of bytes written to the output buffer.
+     */
+    size_t encryptPayload(
+            const unsigned char* data, size_t dataSize, unsigned char* encryptedData, size_t encryptedDataCapacity);
+
     /**
      * @brief Decrypt given data.
      * @return Decrypted data.
      */
     VirgilByteArray decrypt(const VirgilByteArray& encryptedData);
+
+    /**
+     * @brief Decrypt given compact envelope.
+     * @return Decrypted data.
+     */
+    VirgilByteArray decryptCompact(const VirgilByteArray& encryptedData);
 };
 
 }}
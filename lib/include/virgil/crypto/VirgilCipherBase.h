@@ -37,24 +37,22 @@
 #ifndef VIRGIL_CIPHER_BASE_H
 #define VIRGIL_CIPHER_BASE_H
 
+#include <functional>
 #include <map>
 #include <set>
 #include <memory>
 
 #include "VirgilByteArray.h"
+#include "VirgilContentKeyCache.h"
 #include "VirgilCustomParams.h"
-
-/**
- * @name Forward declaration
- */
-/// @{
-namespace virgil { namespace crypto { namespace foundation {
-class VirgilSymmetricCipher;
-}}}
-/// @}
+#include "VirgilPublicKeyHandle.h"
+#include "VirgilPrivateKeyHandle.h"
+#include "foundation/VirgilSymmetricCipher.h"
 
 namespace virgil { namespace crypto {
 
+class VirgilContentInfo;
+
 /**
  * @brief This class provides configuration methods to all Virgil*Cipher classes.
  */
@@ -78,6 +76,14 @@ public:
      */
     void addKeyRecipient(const VirgilByteArray& recipientId, const VirgilByteArray& publicKey);
 
+    /**
+     * @brief Add recipient defined with id and parsed public key.
+     * @param recipientId Recipient's unique identifier, MUST not be empty.
+     * @param publicKey Recipient's parsed public key.
+     * @throw VirgilCryptoException with VirgilCryptoErrorCode::InvalidArgument, if invalid arguments are given.
+     */
+    void addKeyRecipient(const VirgilByteArray& recipientId, const VirgilPublicKeyHandle& publicKey);
+
     /**
      * @brief Remove recipient with given identifier.
      * @param recipientId Recipient's unique identifier.
@@ -182,6 +188,199 @@ public:
      */
     const VirgilCustomParams& customParams() const;
     ///@}
+    /**
+     * @name Content encryption algorithm
+     */
+    ///@{
+    /**
+     * @brief Define symmetric algorithm that is used for the content encryption.
+     *
+     * Default algorithm is AES-256-GCM.
+     * ChaCha20-Poly1305 is preferable for the platforms that have no hardware AES support.
+     *
+     * @note Use this method before encryption process.
+     * @note Decryption algorithm is always taken from the content info.
+     */
+    void setContentEncryptionAlgorithm(foundation::VirgilSymmetricCipher::Algorithm algorithm);
+
+    /**
+     * @brief Return symmetric algorithm that is used for the content encryption.
+     */
+    foundation::VirgilSymmetricCipher::Algorithm getContentEncryptionAlgorithm() const;
+    ///@}
+    /**
+     * @name Multi-threading
+     */
+    ///@{
+    /**
+     * @property kThreadsNumAuto
+     * @brief Use as many threads as hardware supports.
+     */
+    static constexpr size_t kThreadsNumAuto = 0;
+
+    /**
+     * @brief Define number of threads used to encrypt content encryption key for the recipients.
+     *
+     * Each recipient's key encryption (ECIES, RSA or password based) is independent,
+     *     so recipients are distributed between threads.
+     *
+     * @param threadsNum - number of threads, or @link kThreadsNumAuto @endlink.
+     * @note By default recipients are processed in the caller thread.
+     * @note Order of the recipients in the content info does not depend on the number of threads.
+     */
+    void setRecipientsThreadsNum(size_t threadsNum);
+
+    /**
+     * @brief Return number of threads used to encrypt content encryption key for the recipients.
+     */
+    size_t getRecipientsThreadsNum() const;
+
+    /**
+     * @brief Define number of threads used to decrypt large content.
+     *
+     * Currently it speeds up AES-CBC decryption of the data given at once, if it is several megabytes.
+     *
+     * @param threadsNum - number of threads, or @link kThreadsNumAuto @endlink.
+     * @note By default content is decrypted in the caller thread.
+     */
+    void setDecryptionThreadsNum(size_t threadsNum);
+
+    /**
+     * @brief Return number of threads used to decrypt large content.
+     */
+    size_t getDecryptionThreadsNum() const;
+    ///@}
+    /**
+     * @name Shared ephemeral key
+     */
+    ///@{
+    /**
+     * @brief Define whether key recipients of the same elliptic curve share one ephemeral key.
+     *
+     * By default each key recipient gets its own ephemeral key (ECIES).
+     * If enabled, one ephemeral key is generated per envelope per curve and stored once in the content info
+     *     (CMS KeyAgreeRecipientInfo), so each recipient costs one Diffie-Hellman computation,
+     *     one key derivation (HKDF-SHA256) and one AES-256 key wrap.
+     * Recipients with keys that do not support Diffie-Hellman (RSA, Ed25519) are still encrypted with ECIES / RSA.
+     *
+     * @note Use this method before encryption process.
+     * @note Decryption supports both modes regardless of this option.
+     */
+    void setSharedEphemeralKeyEnabled(bool enabled);
+
+    /**
+     * @brief Return true if key recipients of the same elliptic curve share one ephemeral key.
+     */
+    bool isSharedEphemeralKeyEnabled() const;
+    ///@}
+    /**
+     * @name Content info encoding
+     */
+    ///@{
+    /**
+     * @brief Define whether repeated key encryption algorithms are written to the content info only once.
+     *
+     * Recipients refer to the written algorithm instead of repeating it,
+     *     that makes content info noticeably smaller when data is encrypted for many recipients of the same key type.
+     *
+     * @note Compact content info has version v1, that can not be read by previous versions of the library.
+     * @note Content info of both versions is read regardless of this option.
+     */
+    void setCompactContentInfoEnabled(bool enabled);
+
+    /**
+     * @brief Return true if repeated key encryption algorithms are written to the content info only once.
+     */
+    bool isCompactContentInfoEnabled() const;
+    ///@}
+    /**
+     * @name Content info parsing
+     */
+    ///@{
+    /**
+     * @brief Define whether only the decrypting key recipient is read from the embedded content info.
+     *
+     * If enabled and decryption is initialized with a key, other key recipients are skipped
+     *     while the content info is extracted from the encrypted data, so they are not materialized.
+     * It speeds up decryption of the data encrypted for a huge number of recipients.
+     *
+     * @note If enabled, getContentInfo() and keyRecipientExists() reflect only the decrypting key recipient
+     *     after the content info was extracted.
+     * @note Content info given to the setContentInfo() is always read entirely.
+     */
+    void setKeyRecipientFilterEnabled(bool enabled);
+
+    /**
+     * @brief Return true if only the decrypting key recipient is read from the embedded content info.
+     */
+    bool isKeyRecipientFilterEnabled() const;
+    ///@}
+    /**
+     * @name Content key cache
+     */
+    ///@{
+    /**
+     * @brief Use given cache to store and lookup decrypted content encryption keys.
+     *
+     * If the same encrypted data is decrypted again with the same credentials,
+     *     content encryption key is taken from the cache, so asymmetric (or password based) decryption is skipped.
+     * Share one cache between ciphers to get the benefit across cipher instances.
+     *
+     * @note Cache is not used by default.
+     */
+    void setContentKeyCache(const VirgilContentKeyCache& contentKeyCache);
+
+    /**
+     * @brief Stop using content key cache, cache itself is not cleared.
+     */
+    void removeContentKeyCache();
+    ///@}
+    /**
+     * @name Re-keying
+     *
+     * Change recipients of the already encrypted data without re-encryption of the data itself.
+     *
+     * Usage:
+     *     1. Set content info of the encrypted data with setContentInfo().
+     *     2. Add new recipients with addKeyRecipient(), addPasswordRecipient().
+     *     3. Remove revoked recipients with removeKeyRecipient(), removePasswordRecipients().
+     *     4. Call one of the rekey*() methods with credentials of the recipient that still has access.
+     *     5. Replace old content info with the returned one, encrypted data is left untouched.
+     *
+     * @note Content encryption key and algorithm, and custom parameters are preserved,
+     *     so returned content info can be used with data encrypted by any cipher.
+     * @note Recipient given to the rekey*() method MUST not be removed before the call.
+     */
+    ///@{
+    /**
+     * @brief Decrypt content encryption key for recipient defined by id and private key,
+     *     and encrypt it for the added recipients.
+     * @return New content info.
+     * @throw VirgilCryptoException with VirgilCryptoError::InvalidState, if content info is not defined.
+     * @throw VirgilCryptoException with VirgilCryptoError::NotFoundKeyRecipient, if recipient is not found.
+     */
+    VirgilByteArray rekeyWithKey(
+            const VirgilByteArray& recipientId, const VirgilByteArray& privateKey,
+            const VirgilByteArray& privateKeyPassword = VirgilByteArray());
+
+    /**
+     * @brief Decrypt content encryption key for recipient defined by id and parsed private key,
+     *     and encrypt it for the added recipients.
+     * @return New content info.
+     * @throw VirgilCryptoException with VirgilCryptoError::InvalidState, if content info is not defined.
+     * @throw VirgilCryptoException with VirgilCryptoError::NotFoundKeyRecipient, if recipient is not found.
+     */
+    VirgilByteArray rekeyWithKey(const VirgilByteArray& recipientId, const VirgilPrivateKeyHandle& privateKey);
+
+    /**
+     * @brief Decrypt content encryption key for recipient defined by password,
+     *     and encrypt it for the added recipients.
+     * @return New content info.
+     * @throw VirgilCryptoException with VirgilCryptoError::InvalidState, if content info is not defined.
+     * @throw VirgilCryptoException with VirgilCryptoError::NotFoundPasswordRecipient, if password is wrong.
+     */
+    VirgilByteArray rekeyWithPassword(const VirgilByteArray& pwd);
+    ///@}
     /**
      * @name Helpers to create shared key with Diffie–Hellman algorithms
      */
@@ -202,6 +401,16 @@ public:
     static VirgilByteArray computeShared(
             const VirgilByteArray& publicKey,
             const VirgilByteArray& privateKey, const VirgilByteArray& privateKeyPassword = VirgilByteArray());
+
+    /**
+     * @brief Compute shared secret key on a given parsed keys
+     * @param publicKey - alice public key.
+     * @param privateKey - bob private key.
+     * @throw VirgilCryptoException - if keys are not compatible.
+     * @warning Keys SHOULD be of the identical type, i.e. both of type Curve25519.
+     */
+    static VirgilByteArray computeShared(
+            const VirgilPublicKeyHandle& publicKey, const VirgilPrivateKeyHandle& privateKey);
     ///@}
 
 protected:
@@ -216,6 +425,22 @@ protected:
      */
     VirgilByteArray filterAndSetupContentInfo(const VirgilByteArray& encryptedData, bool isLastChunk);
 
+    /**
+     * @brief Extract content info from the encrypted data and setup it, but do not copy payload that follows it.
+     *
+     * Content info is parsed incrementally, so encrypted data can be given in the chunks of any size.
+     *
+     * @param encryptedData - data that was encrypted.
+     * @param encryptedDataSize - size of the data that was encrypted.
+     * @param isLastChunk - tell filter that given data is the last one.
+     * @param bufferedPayload - payload held by the filter while content info was detected, it precedes not consumed
+     *     bytes of the given data. Usually it is empty, or it is a few bytes if content info is absent.
+     * @return Number of consumed bytes, the rest of the given data is a payload if decryption is ready.
+     */
+    size_t filterAndSetupContentInfo(
+            const unsigned char* encryptedData, size_t encryptedDataSize, bool isLastChunk,
+            VirgilByteArray& bufferedPayload);
+
     /**
      * @brief Configures symmetric cipher for encryption.
      * @note cipher's key randomly generated.
@@ -223,6 +448,56 @@ protected:
      */
     void initEncryption();
 
+    /**
+     * @brief Return exact size of the content info, that the following encryption builds.
+     *
+     * Cipher state is not changed. Recipients' keys are encrypted for a copy of the content info
+     *     with a dummy content encryption key, because size of the encrypted key does not depend on its value.
+     *
+     * @param setupCustomParams - called with custom parameters of the copy, if encryption adds some of them.
+     */
+    size_t predictContentInfoSize(const std::function<void(VirgilCustomParams&)>& setupCustomParams = nullptr);
+
+    /**
+     * @brief Return exact size of the data encrypted with single update() and finish() calls.
+     * @param dataSize - size of the data to be encrypted.
+     * @note If encryption is not initialized, size is calculated for the content encryption algorithm.
+     */
+    size_t calculateEncryptedPayloadSize(size_t dataSize) const;
+
+    /**
+     * @brief Return size of the content info, that is returned by getContentInfo(), without building it.
+     */
+    size_t calculateContentInfoSize() const;
+
+    /**
+     * @brief Write content info, that is returned by getContentInfo(), to the beginning of the given buffer.
+     * @return Written bytes count.
+     */
+    size_t writeContentInfo(unsigned char* buffer, size_t bufferSize) const;
+
+    /**
+     * @brief Configure symmetric cipher for encryption and build compact envelope header.
+     *
+     * All key recipients share one ephemeral key, so they MUST have the same key type, that supports
+     *     key agreement. Header is authenticated as additional data of the content encryption.
+     *
+     * @return Compact envelope header, encrypted content follows it.
+     * @throw VirgilCryptoException with VirgilCryptoError::InvalidState, if recipients or custom parameters
+     *     can not be stored in the compact envelope.
+     * @throw VirgilCryptoException with VirgilCryptoError::UnsupportedAlgorithm,
+     *     if content encryption algorithm is not AEAD.
+     */
+    VirgilByteArray initCompactEncryption();
+
+    /**
+     * @brief Read compact envelope header and configure symmetric cipher for decryption.
+     * @note Decryption MUST be initialized with a key before this call.
+     * @return Header size, encrypted content follows it.
+     * @throw VirgilCryptoException with VirgilCryptoError::NotFoundKeyRecipient, if recipient is not found.
+     */
+    size_t initCompactDecryption(const unsigned char* encryptedData, size_t encryptedDataSize);
+
     /**
      * @brief Stores recipient's password that is used for cipher's key decryption when content becomes available.
      * @param pwd - recipient's password.
@@ -239,6 +514,13 @@ protected:
             const VirgilByteArray& recipientId,
             const VirgilByteArray& privateKey, const VirgilByteArray& privateKeyPassword);
 
+    /**
+     * @brief Stores recipient's information that is used for cipher's key decryption when content becomes available.
+     * @param recipientId - recipient's id.
+     * @param privateKey - recipient's parsed private key.
+     */
+    void initDecryptionWithKey(const VirgilByteArray& recipientId, const VirgilPrivateKeyHandle& privateKey);
+
     /**
      * Return true if one one of the init function was called.
      */
@@ -260,6 +542,15 @@ protected:
      */
     virgil::crypto::foundation::VirgilSymmetricCipher& getSymmetricCipher();
 
+    /**
+     * @brief Create independent symmetric cipher configured with the same algorithm, key and mode
+     *     as the cipher returned by the method @link getSymmetricCipher() @endlink.
+     *
+     * Use it to process independent parts of the data in parallel.
+     * @note This method SHOULD be called after encryption or decryption is initialized.
+     */
+    virgil::crypto::foundation::VirgilSymmetricCipher createSymmetricCipher() const;
+
     /**
      * @brief Build VirgilContentInfo object.
      *
@@ -304,6 +595,34 @@ private:
      */
     void accomplishInitDecryption();
 
+private:
+    /**
+     * @brief Decrypt content encryption key with credentials given to the initDecryption*() methods.
+     * @note Content key cache is used if defined.
+     */
+    VirgilByteArray acquireContentEncryptionKey();
+
+    /**
+     * @brief Decrypt content encryption key with credentials given to the initDecryption*() methods.
+     */
+    VirgilByteArray decryptContentEncryptionKey();
+
+    /**
+     * @brief Encrypt given content encryption key for the recipients added to the given content info.
+     */
+    void encryptContentEncryptionKey(VirgilContentInfo& contentInfo, const VirgilByteArray& symmetricCipherKey);
+
+    /**
+     * @brief Encrypt content encryption key for the added recipients and return new content info.
+     * @note Decryption MUST be initialized before this call.
+     */
+    VirgilByteArray rekey();
+
+    /**
+     * @brief Define identifier of the content key cache entry for the current content info and credentials.
+     */
+    VirgilByteArray defineContentKeyCacheEntryId();
+
 private:
     class Impl;
 
@@ -38,6 +38,8 @@
 #define VIRGIL_CRYPTO_CONTENT_INFO_H
 
 #include "VirgilCustomParams.h"
+#include "VirgilKeyPair.h"
+#include "VirgilPublicKeyHandle.h"
 #include "foundation/asn1/VirgilAsn1Compatible.h"
 
 #include <memory>
@@ -55,11 +57,13 @@ public:
      * @code
      * Marshalling format:
      *     VirgilContentInfo ::= SEQUENCE {
-     *         version ::= INTEGER { v0(0) },
+     *         version ::= INTEGER { v0(0), v1(1) },
      *         cmsContent ContentInfo, -- Imports from RFC 5652
-     *         customParams [0] IMPLICIT VirgilCustomParams OPTIONAL
+     *         customParams [0] IMPLICIT VirgilCustomParams OPTIONAL,
+     *         algorithms [1] IMPLICIT SEQUENCE OF AlgorithmIdentifier OPTIONAL -- v1 only
      *     }
      * @endcode
+     * @see foundation::cms::VirgilCMSContentInfo
      */
     ///@{
     size_t asn1Write(
@@ -68,6 +72,8 @@ public:
 
     void asn1Read(virgil::crypto::foundation::asn1::VirgilAsn1Reader& asn1Reader) override;
     ///@}
+
+    using VirgilAsn1Compatible::fromAsn1;
 public:
     /**
      * @brief PIMPL initialization.
@@ -85,6 +91,14 @@ public:
      */
     void addKeyRecipient(const VirgilByteArray& recipientId, const VirgilByteArray& publicKey);
 
+    /**
+     * @brief Add recipient defined with id and parsed public key.
+     * @param recipientId Recipient's unique identifier, MUST not be empty.
+     * @param publicKey Recipient's parsed public key.
+     * @throw VirgilCryptoException with VirgilCryptoErrorCode::InvalidArgument, if invalid arguments are given.
+     */
+    void addKeyRecipient(const VirgilByteArray& recipientId, const VirgilPublicKeyHandle& publicKey);
+
     /**
      * @brief Check whether recipient with given identifier exists.
      *
@@ -184,7 +198,15 @@ private:
      */
     ///@{
     /**
-     * @brief Iterate over key recipients.
+     * @brief Read content info, but keep only key recipients with the given identifier.
+     *
+     * Other key recipients are not materialized, so they can not be found or decrypted later.
+     */
+    void fromAsn1(const VirgilByteArray& data, const VirgilByteArray& keyRecipientId);
+
+    /**
+     * @brief Find key recipient with given identifier and decrypt its key.
+     * @note Lookup is done with the hash index, that is built once after content info is read.
      */
     VirgilByteArray decryptKeyRecipient(
             const VirgilByteArray& recipientId,
@@ -192,25 +214,91 @@ private:
                     const VirgilByteArray& algorithm, const VirgilByteArray& encryptedKey)> decrypt) const;
 
     /**
-     * @brief Iterate over password recipients.
+     * @brief Find key recipient that shares originator's key and decrypt its key.
      */
-    VirgilByteArray decryptPasswordRecipient(
+    VirgilByteArray decryptKeyAgreeRecipient(
+            const VirgilByteArray& recipientId,
             std::function<VirgilByteArray(
-                    const VirgilByteArray& algorithm, const VirgilByteArray& encryptedKey)> decrypt) const;
+                    const VirgilByteArray& originatorKey, const VirgilByteArray& algorithm,
+                    const VirgilByteArray& encryptedKey)> decrypt) const;
+
+    /**
+     * @brief Try password recipients until key of one of them is decrypted.
+     * @param decrypt - write decrypted key and return true, or return false if key can not be decrypted,
+     *     i.e. password is wrong. Exception is treated as false, but it is expected to be thrown rarely.
+     * @param threadsNum - if greater than 1, decrypt function is called concurrently.
+     * @return Key of the first suitable recipient in the stored order, or empty array if there is no one.
+     */
+    VirgilByteArray decryptPasswordRecipient(
+            std::function<bool(
+                    const VirgilByteArray& algorithm, const VirgilByteArray& encryptedKey,
+                    VirgilByteArray& key)> decrypt,
+            size_t threadsNum = 1) const;
 
     struct EncryptionResult {
         VirgilByteArray encryptionAlgorithm;
         VirgilByteArray encryptedContent;
     };
 
-    void encryptKeyRecipients(std::function<EncryptionResult(const VirgilByteArray& publicKey)> encrypt);
+    /**
+     * @brief Encrypt content encryption key for each key recipient.
+     * @param threadsNum - if greater than 1, encrypt function is called concurrently.
+     * @note Recipients order does not depend on the number of threads.
+     */
+    void encryptKeyRecipients(
+            std::function<EncryptionResult(const VirgilPublicKeyHandle& publicKey)> encrypt, size_t threadsNum = 1);
 
-    void encryptPasswordRecipients(std::function<EncryptionResult(const VirgilByteArray& pwd)> encrypt);
+    struct KeyAgreement {
+        VirgilByteArray originatorKey;
+        VirgilByteArray keyEncryptionAlgorithm;
+        std::function<VirgilByteArray(const VirgilPublicKeyHandle& publicKey)> encrypt;
+    };
+
+    /**
+     * @brief Encrypt content encryption key for key recipients, that can share one originator's key.
+     * @param agree - return key agreement for the given key type, or nullptr if it is not applicable.
+     *     It is called once per key type, recipients of the same key type share the returned key agreement.
+     * @param threadsNum - if greater than 1, key agreement encrypt function is called concurrently.
+     * @note Recipients that are not processed by this method are left for the encryptKeyRecipients().
+     */
+    void encryptKeyAgreeRecipients(
+            std::function<std::shared_ptr<KeyAgreement>(VirgilKeyPair::Type keyType)> agree, size_t threadsNum = 1);
+
+    /**
+     * @brief Encrypt content encryption key for each password recipient.
+     * @param threadsNum - if greater than 1, encrypt function is called concurrently.
+     * @note Recipients order does not depend on the number of threads.
+     */
+    void encryptPasswordRecipients(
+            std::function<EncryptionResult(const VirgilByteArray& pwd)> encrypt, size_t threadsNum = 1);
+
+    /**
+     * @brief Call given function for each key recipient, that was added and is not encrypted yet.
+     * @note Recipients are visited in the order of their identifiers.
+     */
+    void forEachKeyRecipient(
+            std::function<void(
+                    const VirgilByteArray& recipientId, const VirgilPublicKeyHandle& publicKey)> visit) const;
+
+    /**
+     * @brief Return true if password recipients were added and are not encrypted yet.
+     */
+    bool hasPasswordRecipients() const;
 
     void setContentEncryptionAlgorithm(const VirgilByteArray& contentEncryptionAlgorithm);
 
     VirgilByteArray getContentEncryptionAlgorithm() const;
 
+    /**
+     * @brief Define whether repeated key encryption algorithms are written once and then referenced.
+     *
+     * Compact encoding has version v1, that is not supported by previous versions of the library.
+     * @note Both encodings are read regardless of this option.
+     */
+    void setCompactEncodingEnabled(bool enabled);
+
+    bool isCompactEncodingEnabled() const;
+
     bool isReadyForEncryption();
 
     bool isReadyForDecryption();
@@ -225,6 +313,10 @@ public:
     VirgilContentInfo& operator=(VirgilContentInfo&& rhs) noexcept;
 
     ~VirgilContentInfo() noexcept;
+
+    VirgilContentInfo(const VirgilContentInfo& rhs);
+
+    VirgilContentInfo& operator=(const VirgilContentInfo& rhs);
     //! @endcond
 
 private:
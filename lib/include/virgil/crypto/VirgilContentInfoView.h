@@ -0,0 +1,201 @@
+/**
+ * Copyright (C) 2015-2018 Virgil Security Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *     (3) Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+ */
+
+#ifndef VIRGIL_CRYPTO_CONTENT_INFO_VIEW_H
+#define VIRGIL_CRYPTO_CONTENT_INFO_VIEW_H
+
+#include "VirgilByteArray.h"
+
+#include <cstddef>
+#include <type_traits>
+
+namespace virgil { namespace crypto {
+
+/**
+ * @brief Read-only view over the DER encoded VirgilContentInfo.
+ *
+ * In contrast to the VirgilContentInfo, this class does not decode the whole structure,
+ *     it only locates requested fields within the given buffer, so nothing is copied or allocated.
+ * Use it when only recipient identifiers or custom parameters are needed, i.e. for message routing.
+ *
+ * @note Algorithm references of the compact content info (v1) are resolved, so viewed fields are the same
+ *     for both versions.
+ * @warning Viewed buffer MUST outlive the view and MUST not be modified.
+ * @see VirgilContentInfo for the marshalling format.
+ */
+class VirgilContentInfoView {
+public:
+    /**
+     * @brief Non-owning reference to the bytes within the viewed buffer.
+     */
+    struct Bytes {
+        const unsigned char* data;
+        size_t size;
+
+        bool empty() const { return size == 0; }
+
+        bool equals(const VirgilByteArray& other) const;
+
+        bool equals(const Bytes& other) const;
+
+        VirgilByteArray toBytes() const { return VirgilByteArray(data, data + size); }
+    };
+
+    /**
+     * @brief Type of the CMS RecipientInfo.
+     */
+    enum class RecipientType {
+        KeyTrans, ///< KeyTransRecipientInfo
+        KeyAgree, ///< KeyAgreeRecipientInfo, recipients share originator's key
+        Password ///< PasswordRecipientInfo
+    };
+
+    /**
+     * @brief Recipient's fields within the viewed buffer.
+     */
+    struct Recipient {
+        RecipientType type;
+        Bytes recipientId; ///< empty for password recipient
+        Bytes keyEncryptionAlgorithm; ///< DER encoded AlgorithmIdentifier
+        Bytes encryptedKey;
+        Bytes originatorKey; ///< DER encoded SubjectPublicKeyInfo, only for key agree recipient
+    };
+
+public:
+    /**
+     * @brief Create view over the given content info.
+     * @param contentInfo - DER encoded VirgilContentInfo, trailing data is allowed and is ignored.
+     * @throw VirgilCryptoException with VirgilCryptoError::InvalidFormat, if content info is malformed.
+     */
+    explicit VirgilContentInfoView(const VirgilByteArray& contentInfo);
+
+    /**
+     * @brief Create view over the given content info.
+     * @see VirgilContentInfoView(const VirgilByteArray&)
+     */
+    VirgilContentInfoView(const unsigned char* data, size_t size);
+
+    /**
+     * @brief Return size of the content info within the viewed buffer.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Call func(const Recipient&) for each recipient in the order they are stored.
+     * @throw VirgilCryptoException with VirgilCryptoError::InvalidFormat, if recipient info is malformed.
+     */
+    template<typename Func>
+    void forEachRecipient(Func&& func) const {
+        using FuncType = typename std::remove_reference<Func>::type;
+        visitRecipients(
+                [](void* ctx, const Recipient& recipient) -> bool {
+                    (*static_cast<FuncType*>(ctx))(recipient);
+                    return true;
+                },
+                const_cast<void*>(static_cast<const void*>(&func)));
+    }
+
+    /**
+     * @brief Call func(const Bytes&) for each key recipient identifier.
+     * @throw VirgilCryptoException with VirgilCryptoError::InvalidFormat, if recipient info is malformed.
+     */
+    template<typename Func>
+    void forEachRecipientId(Func&& func) const {
+        forEachRecipient([&func](const Recipient& recipient) {
+            if (recipient.type != RecipientType::Password) {
+                func(recipient.recipientId);
+            }
+        });
+    }
+
+    /**
+     * @brief Find key recipient with given identifier.
+     * @param recipientId - recipient's identifier.
+     * @param recipient - if not null, found recipient's fields are written to it.
+     * @return true if recipient is found, false - otherwise.
+     * @throw VirgilCryptoException with VirgilCryptoError::InvalidFormat, if recipient info is malformed.
+     */
+    bool findRecipient(const VirgilByteArray& recipientId, Recipient* recipient = nullptr) const;
+
+    /**
+     * @name Custom parameters
+     *
+     * Each getter returns false if parameter with given key and type is absent.
+     * Key can be given as a null-terminated string or as a view, so it is looked up without allocation.
+     */
+    ///@{
+    bool getCustomInteger(const VirgilByteArray& key, int& value) const;
+
+    bool getCustomInteger(const char* key, int& value) const;
+
+    bool getCustomInteger(const Bytes& key, int& value) const;
+
+    bool getCustomString(const VirgilByteArray& key, Bytes& value) const;
+
+    bool getCustomString(const char* key, Bytes& value) const;
+
+    bool getCustomString(const Bytes& key, Bytes& value) const;
+
+    bool getCustomData(const VirgilByteArray& key, Bytes& value) const;
+
+    bool getCustomData(const char* key, Bytes& value) const;
+
+    bool getCustomData(const Bytes& key, Bytes& value) const;
+    ///@}
+
+private:
+    /**
+     * @brief Call visit() for each recipient until it returns false.
+     */
+    void visitRecipients(bool (* visit)(void* ctx, const Recipient& recipient), void* ctx) const;
+
+    bool findCustomParam(const Bytes& key, unsigned char valueTag, Bytes& value) const;
+
+    /**
+     * @brief Return referenced algorithm identifier if given one is a reference, or given one otherwise.
+     */
+    Bytes resolveAlgorithm(const Bytes& algorithm) const;
+
+private:
+    Bytes contentInfo_;
+    Bytes recipientInfos_;
+    Bytes customParams_;
+    Bytes algorithms_;
+};
+
+}}
+
+#endif //VIRGIL_CRYPTO_CONTENT_INFO_VIEW_H
@@ -0,0 +1,124 @@
+/**
+ * Copyright (C) 2015-2018 Virgil Security Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *     (3) Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+ */
+
+#ifndef VIRGIL_CONTENT_KEY_CACHE_H
+#define VIRGIL_CONTENT_KEY_CACHE_H
+
+#include <cstddef>
+#include <memory>
+
+#include "VirgilByteArray.h"
+
+namespace virgil { namespace crypto {
+
+/**
+ * @brief Bounded cache of the decrypted content encryption keys.
+ *
+ * When the same encrypted data is decrypted by the same recipient many times,
+ *     the cache allows to skip asymmetric (or password based) decryption of the content encryption key.
+ *
+ * Entry is identified by the digest of the content info, recipient identifier and recipient's credentials
+ *     (private key and its password, or password for password based decryption),
+ *     so a key is never returned to the caller that can not decrypt it by itself.
+ *
+ * Least recently used entries are evicted when capacity is reached.
+ * Keys are zeroized when they are evicted, when cache is cleared, and when the last handle is destroyed.
+ *
+ * Handle is cheap to copy, copies share the same cache.
+ * Cache can be used from multiple threads simultaneously.
+ *
+ * @see VirgilCipherBase::setContentKeyCache()
+ */
+class VirgilContentKeyCache {
+public:
+    /**
+     * @brief Create empty cache.
+     * @param capacity - maximum number of the cached keys.
+     * @throw VirgilCryptoException with VirgilCryptoError::InvalidArgument, if capacity is zero.
+     */
+    explicit VirgilContentKeyCache(size_t capacity);
+
+    /**
+     * @brief Return maximum number of the cached keys.
+     */
+    size_t capacity() const;
+
+    /**
+     * @brief Return current number of the cached keys.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Zeroize and remove all cached keys.
+     */
+    void clear();
+
+private:
+    /**
+     * @brief Find key by the entry identifier and mark it as recently used.
+     * @return Found key, or empty byte array if key is absent.
+     */
+    VirgilByteArray find(const VirgilByteArray& entryId) const;
+
+    /**
+     * @brief Add or replace key with given entry identifier.
+     */
+    void insert(const VirgilByteArray& entryId, const VirgilByteArray& key);
+
+    friend class VirgilCipherBase;
+
+public:
+    //! @cond Doxygen_Suppress
+    VirgilContentKeyCache(const VirgilContentKeyCache& rhs);
+
+    VirgilContentKeyCache& operator=(const VirgilContentKeyCache& rhs);
+
+    VirgilContentKeyCache(VirgilContentKeyCache&& rhs) noexcept;
+
+    VirgilContentKeyCache& operator=(VirgilContentKeyCache&& rhs) noexcept;
+
+    ~VirgilContentKeyCache() noexcept;
+    //! @endcond
+
+private:
+    class Impl;
+
+    std::shared_ptr<Impl> impl_;
+};
+
+}}
+
+#endif /* VIRGIL_CONTENT_KEY_CACHE_H */
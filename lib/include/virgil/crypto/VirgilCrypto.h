@@ -50,6 +50,9 @@
 #include "VirgilDataSink.h"
 #include "VirgilDataSource.h"
 #include "VirgilKeyPair.h"
+#include "VirgilPrivateKeyHandle.h"
+#include "VirgilPublicKeyHandle.h"
+#include "VirgilSeekableDataSource.h"
 #include "VirgilSigner.h"
 #include "VirgilSignerBase.h"
 #include "VirgilStreamCipher.h"
@@ -37,8 +37,8 @@
 #ifndef VIRGIL_CRYPTO_VIRGIL_CUSTOM_PARAMS_H
 #define VIRGIL_CRYPTO_VIRGIL_CUSTOM_PARAMS_H
 
-#include <map>
 #include <string>
+#include <vector>
 
 #include "VirgilByteArray.h"
 #include "foundation/asn1/VirgilAsn1Compatible.h"
@@ -97,12 +97,36 @@ public:
      */
     void setInteger(const VirgilByteArray& key, int value);
 
+    /**
+     * @brief Set parameter with type: Integer.
+     * @param key - null-terminated key.
+     */
+    void setInteger(const char* key, int value);
+
     /**
      * @brief Get parameter with type: Integer.
      * @throw VirgilCryptoException if given key is absent.
      */
     int getInteger(const VirgilByteArray& key) const;
 
+    /**
+     * @brief Get parameter with type: Integer.
+     * @param key - null-terminated key, that is looked up without allocation.
+     * @throw VirgilCryptoException if given key is absent.
+     */
+    int getInteger(const char* key) const;
+
+    /**
+     * @brief Define whether parameter with type: Integer is set.
+     */
+    bool hasInteger(const VirgilByteArray& key) const;
+
+    /**
+     * @brief Define whether parameter with type: Integer is set.
+     * @param key - null-terminated key, that is looked up without allocation.
+     */
+    bool hasInteger(const char* key) const;
+
     /**
      * @brief Remove parameter with type: Integer.
      * @note Do nothing if given key is absent.
@@ -120,6 +144,24 @@ public:
      */
     VirgilByteArray getString(const VirgilByteArray& key) const;
 
+    /**
+     * @brief Get parameter with type: String.
+     * @param key - null-terminated key, that is looked up without allocation.
+     * @throw VirgilCryptoException if given key is absent.
+     */
+    VirgilByteArray getString(const char* key) const;
+
+    /**
+     * @brief Define whether parameter with type: String is set.
+     */
+    bool hasString(const VirgilByteArray& key) const;
+
+    /**
+     * @brief Define whether parameter with type: String is set.
+     * @param key - null-terminated key, that is looked up without allocation.
+     */
+    bool hasString(const char* key) const;
+
     /**
      * @brief Remove parameter with type: String.
      * @note Do nothing if given key is absent.
@@ -137,6 +179,24 @@ public:
      */
     VirgilByteArray getData(const VirgilByteArray& key) const;
 
+    /**
+     * @brief Get parameter with type: Data.
+     * @param key - null-terminated key, that is looked up without allocation.
+     * @throw VirgilCryptoException if given key is absent.
+     */
+    VirgilByteArray getData(const char* key) const;
+
+    /**
+     * @brief Define whether parameter with type: Data is set.
+     */
+    bool hasData(const VirgilByteArray& key) const;
+
+    /**
+     * @brief Define whether parameter with type: Data is set.
+     * @param key - null-terminated key, that is looked up without allocation.
+     */
+    bool hasData(const char* key) const;
+
     /**
      * @brief Remove parameter with type: Data.
      * @note Do nothing if given key is absent.
@@ -149,9 +209,51 @@ public:
     void clear();
     ///@}
 private:
-    std::map<VirgilByteArray, int> intValues_;
-    std::map<VirgilByteArray, VirgilByteArray> stringValues_;
-    std::map<VirgilByteArray, VirgilByteArray> dataValues_;
+    /**
+     * @brief Parameter type, that is equal to the ASN.1 context tag of the parameter value.
+     */
+    enum class ValueType {
+        Integer = 0,
+        String = 1,
+        Data = 2
+    };
+
+    /**
+     * @brief Parameter, which key and value are stored within the shared storage.
+     */
+    struct Entry {
+        ValueType type;
+        size_t keyOffset;
+        size_t keySize;
+        size_t valueOffset;
+        size_t valueSize;
+        int intValue;
+    };
+
+    std::vector<Entry>::const_iterator lowerBound(ValueType type, const unsigned char* key, size_t keySize) const;
+
+    const Entry* find(ValueType type, const unsigned char* key, size_t keySize) const;
+
+    const Entry& get(ValueType type, const unsigned char* key, size_t keySize) const;
+
+    void set(ValueType type, const unsigned char* key, size_t keySize, const unsigned char* value, size_t valueSize,
+            int intValue);
+
+    void remove(ValueType type, const unsigned char* key, size_t keySize);
+
+    VirgilByteArray value(const Entry& entry) const;
+
+    size_t writeEntry(virgil::crypto::foundation::asn1::VirgilAsn1Writer& asn1Writer, const Entry& entry) const;
+
+    /**
+     * @brief Drop keys and values of the removed or overwritten parameters from the storage.
+     */
+    void compact();
+
+private:
+    std::vector<Entry> entries_; ///< sorted by type and key
+    VirgilByteArray storage_; ///< keys and values of the parameters
+    size_t unusedStorageSize_ = 0;
 };
 
 }}
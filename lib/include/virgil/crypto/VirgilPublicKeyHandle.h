@@ -0,0 +1,103 @@
+/**
+ * Copyright (C) 2015-2018 Virgil Security Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *     (3) Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+ */
+
+#ifndef VIRGIL_PUBLIC_KEY_HANDLE_H
+#define VIRGIL_PUBLIC_KEY_HANDLE_H
+
+#include <memory>
+
+#include "VirgilByteArray.h"
+
+/**
+ * @name Forward declaration
+ */
+/// @{
+namespace virgil { namespace crypto { namespace foundation {
+class VirgilAsymmetricCipher;
+}}}
+/// @}
+
+namespace virgil { namespace crypto {
+
+/**
+ * @brief Immutable handle to the parsed public key.
+ *
+ * Public key is parsed once on the handle creation, so it can be reused
+ *     for any number of operations without paying parsing cost again.
+ *
+ * Handle is cheap to copy, copies share the same parsed key.
+ * Handle can be used from multiple threads simultaneously.
+ */
+class VirgilPublicKeyHandle {
+public:
+    /**
+     * @brief Parse given public key.
+     * @param publicKey - public key in DER or PEM format.
+     * @throw VirgilCryptoException with VirgilCryptoError::InvalidPublicKey, if public key is invalid.
+     */
+    explicit VirgilPublicKeyHandle(const VirgilByteArray& publicKey);
+
+    /**
+     * @brief Provide parsed key context for exclusive use by the calling thread.
+     *
+     * Context is returned to the handle when returned object is destroyed.
+     *
+     * @warning Used for internal purposes only.
+     */
+    std::shared_ptr<const foundation::VirgilAsymmetricCipher> acquireCipher() const;
+
+public:
+    //! @cond Doxygen_Suppress
+    VirgilPublicKeyHandle(const VirgilPublicKeyHandle& rhs);
+
+    VirgilPublicKeyHandle& operator=(const VirgilPublicKeyHandle& rhs);
+
+    VirgilPublicKeyHandle(VirgilPublicKeyHandle&& rhs) noexcept;
+
+    VirgilPublicKeyHandle& operator=(VirgilPublicKeyHandle&& rhs) noexcept;
+
+    ~VirgilPublicKeyHandle() noexcept;
+    //! @endcond
+
+private:
+    class Impl;
+
+    std::shared_ptr<Impl> impl_;
+};
+
+}}
+
+#endif /* VIRGIL_PUBLIC_KEY_HANDLE_H */
@@ -0,0 +1,72 @@
+/**
+ * Copyright (C) 2015-2018 Virgil Security Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *     (3) Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+ */
+
+#ifndef VIRGIL_CRYPTO_VIRGIL_SEEKABLE_DATA_SOURCE_H
+#define VIRGIL_CRYPTO_VIRGIL_SEEKABLE_DATA_SOURCE_H
+
+#include <cstddef>
+
+#include "VirgilByteArray.h"
+
+namespace virgil { namespace crypto {
+
+/**
+ * @brief This is base class for input streams that support random access.
+ *
+ * Defines interface that allows read data from the arbitrary position of the input stream.
+ */
+class VirgilSeekableDataSource {
+public:
+    /**
+     * @brief Return total number of bytes in the target source.
+     */
+    virtual size_t size() = 0;
+
+    /**
+     * @brief Return data read from the target source.
+     * @param offset - position of the first byte to be read.
+     * @param length - number of bytes to be read.
+     * @note Returned data MUST be exactly of the requested length,
+     *     unless the end of the target source is reached.
+     */
+    virtual VirgilByteArray readAt(size_t offset, size_t length) = 0;
+
+    virtual ~VirgilSeekableDataSource() noexcept = default;
+};
+
+}}
+
+#endif /* VIRGIL_CRYPTO_VIRGIL_SEEKABLE_DATA_SOURCE_H */
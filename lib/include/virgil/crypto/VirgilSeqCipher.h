@@ -64,6 +64,13 @@ public:
     void startDecryptionWithKey(
             const VirgilByteArray& recipientId, const VirgilByteArray& privateKey,
             const VirgilByteArray& privateKeyPassword = VirgilByteArray());
+
+    /**
+     * @brief Start sequential decryption for recipient defined by id and parsed private key.
+     * @note Content info MUST be defined, if it was not embedded to the encrypted data.
+     * @see method setContentInfo().
+     */
+    void startDecryptionWithKey(const VirgilByteArray& recipientId, const VirgilPrivateKeyHandle& privateKey);
     /**
      * @brief Start sequential decryption for recipient defined by id and private key.
      * @note Content info MUST be defined, if it was not embedded to the encrypted data.
@@ -90,6 +90,19 @@ public:
      */
     bool verify(const VirgilByteArray& publicKey);
 
+    /**
+     * @brief Sign data that was collected by update() function with given parsed private key.
+     * @return Virgil Security sign.
+     */
+    VirgilByteArray sign(const VirgilPrivateKeyHandle& privateKey);
+
+    /**
+     * @brief Verify sign and data that was collected by update() function to be conformed
+     *     to the given parsed public key.
+     * @return true if sign is valid and data was not malformed.
+     */
+    bool verify(const VirgilPublicKeyHandle& publicKey);
+
 private:
     VirgilByteArray unpackedSignature_;
     foundation::VirgilHash hash_;
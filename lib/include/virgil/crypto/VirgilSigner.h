@@ -72,6 +72,18 @@ public:
      * @return true if sign is valid and data was not malformed.
      */
     bool verify(const VirgilByteArray& data, const VirgilByteArray& sign, const VirgilByteArray& publicKey);
+
+    /**
+     * @brief Sign data with given parsed private key.
+     * @return Virgil Security sign.
+     */
+    VirgilByteArray sign(const VirgilByteArray& data, const VirgilPrivateKeyHandle& privateKey);
+
+    /**
+     * @brief Verify sign and data to be conformed to the given parsed public key.
+     * @return true if sign is valid and data was not malformed.
+     */
+    bool verify(const VirgilByteArray& data, const VirgilByteArray& sign, const VirgilPublicKeyHandle& publicKey);
 };
 
 }}
@@ -38,6 +38,8 @@
 #define VIRGIL_CRYPTO_SIGNER_BASE_H
 
 #include "VirgilByteArray.h"
+#include "VirgilPublicKeyHandle.h"
+#include "VirgilPrivateKeyHandle.h"
 #include "foundation/VirgilHash.h"
 #include "foundation/VirgilAsymmetricCipher.h"
 
@@ -85,6 +87,25 @@ public:
             const VirgilByteArray& digest, const VirgilByteArray& signature,
             const VirgilByteArray& publicKey);
 
+    /**
+     * @brief Create signature over pre-calculated hash.
+     * @param digest - hash digest of the data.
+     * @param privateKey - parsed private key to be used for signature operation.
+     * @return Signature.
+     */
+    VirgilByteArray signHash(const VirgilByteArray& digest, const VirgilPrivateKeyHandle& privateKey);
+
+    /**
+     * @brief Verify signature over pre-calculated hash.
+     * @param digest - hash digest of the data.
+     * @param signature - signature.
+     * @param publicKey - parsed public key to be used for signature verification.
+     * @return true if signature verification was successful, false - otherwise.
+     */
+    bool verifyHash(
+            const VirgilByteArray& digest, const VirgilByteArray& signature,
+            const VirgilPublicKeyHandle& publicKey);
+
 protected:
     /**
      * @brief Pack given signature to the ASN.1 structure.
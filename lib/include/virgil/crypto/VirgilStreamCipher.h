@@ -60,6 +60,19 @@ public:
      */
     void encrypt(VirgilDataSource& source, VirgilDataSink& sink, bool embedContentInfo = true);
 
+    /**
+     * @brief Return exact size of the data written by the following encryption of the data of the given size.
+     *
+     * Cipher state is not changed, but recipients' keys are encrypted with a dummy key to find out
+     *     the content info size, so this call takes about as long as building the content info.
+     *
+     * @param dataSize - size of the data to be read from the source.
+     * @param embedContentInfo - the same value MUST be given to the following encrypt() call.
+     * @note Recipients, custom parameters and the content encryption algorithm of the following encryption
+     *     MUST be the same.
+     */
+    size_t calculateEncryptedSize(size_t dataSize, bool embedContentInfo = true);
+
     /**
      * @brief Decrypt data read from given source for recipient defined by id and private key,
      *     and write it to the sink.
@@ -70,6 +83,16 @@ public:
             VirgilDataSource& source, VirgilDataSink& sink, const VirgilByteArray& recipientId,
             const VirgilByteArray& privateKey, const VirgilByteArray& privateKeyPassword = VirgilByteArray());
 
+    /**
+     * @brief Decrypt data read from given source for recipient defined by id and parsed private key,
+     *     and write it to the sink.
+     * @note Content info MUST be defined, if it was not embedded to the encrypted data.
+     * @see method setContentInfo().
+     */
+    void decryptWithKey(
+            VirgilDataSource& source, VirgilDataSink& sink, const VirgilByteArray& recipientId,
+            const VirgilPrivateKeyHandle& privateKey);
+
     /**
      * @brief Decrypt data read from given source for recipient defined by password,
      *     and write it to the sink.
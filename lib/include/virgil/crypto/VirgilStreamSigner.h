@@ -73,6 +73,18 @@ public:
      * @return true if sign is valid and data was not malformed.
      */
     bool verify(VirgilDataSource& source, const VirgilByteArray& sign, const VirgilByteArray& publicKey);
+
+    /**
+     * @brief Sign data provided by the source with given parsed private key.
+     * @return Virgil Security sign.
+     */
+    VirgilByteArray sign(VirgilDataSource& source, const VirgilPrivateKeyHandle& privateKey);
+
+    /**
+     * @brief Verify sign and data provided by the source to be conformed to the given parsed public key.
+     * @return true if sign is valid and data was not malformed.
+     */
+    bool verify(VirgilDataSource& source, const VirgilByteArray& sign, const VirgilPublicKeyHandle& publicKey);
 };
 
 }}
@@ -41,6 +41,9 @@
 #include <string>
 
 #include "VirgilByteArray.h"
+#include "VirgilPublicKeyHandle.h"
+#include "VirgilPrivateKeyHandle.h"
+#include "foundation/VirgilSymmetricCipher.h"
 
 namespace virgil { namespace crypto {
 
@@ -143,6 +146,19 @@ public:
      */
     explicit VirgilTinyCipher(size_t packageSize = PackageSize_Short_SMS);
 
+    /**
+     * @brief Init cipher with given maximum package size and symmetric algorithm.
+     *
+     * @param packageSize - maximum number of bytes in one package
+     * @param cipherAlgorithm - authenticated symmetric algorithm, i.e. AES-256-GCM (default) or ChaCha20-Poly1305
+     *
+     * @note Algorithm is not transferred within packages, so the same algorithm MUST be used for decryption.
+     *
+     * @throw std::logic_error - if given packageSize less then minimum value
+     * @throw VirgilCryptoException - if given algorithm is not an authenticated one
+     */
+    VirgilTinyCipher(size_t packageSize, foundation::VirgilSymmetricCipher::Algorithm cipherAlgorithm);
+
     /**
      * @brief Prepare cipher for the next encryption.
      *
@@ -185,6 +201,23 @@ public:
             const VirgilByteArray& senderPrivateKey,
             const VirgilByteArray& senderPrivateKeyPassword = VirgilByteArray());
 
+    /**
+     * @brief Encrypt data with given parsed public key
+     *
+     * @see encrypt(const VirgilByteArray&, const VirgilByteArray&)
+     */
+    void encrypt(const VirgilByteArray& data, const VirgilPublicKeyHandle& recipientPublicKey);
+
+    /**
+     * @brief Encrypt data with given parsed public key and sign package with given parsed private key
+     *
+     * @see encryptAndSign(const VirgilByteArray&, const VirgilByteArray&, const VirgilByteArray&,
+     *     const VirgilByteArray&)
+     */
+    void encryptAndSign(
+            const VirgilByteArray& data, const VirgilPublicKeyHandle& recipientPublicKey,
+            const VirgilPrivateKeyHandle& senderPrivateKey);
+
     /**
      * @brief Return total package count.
      *
@@ -262,6 +295,22 @@ public:
             const VirgilByteArray& senderPublicKey,
             const VirgilByteArray& recipientPrivateKey,
             const VirgilByteArray& recipientPrivateKeyPassword = VirgilByteArray());
+
+    /**
+     * @brief Decrypt accumulated packages with given parsed private key.
+     *
+     * @see decrypt(const VirgilByteArray&, const VirgilByteArray&)
+     */
+    VirgilByteArray decrypt(const VirgilPrivateKeyHandle& recipientPrivateKey);
+
+    /**
+     * @brief Verify accumulated packages with given parsed public key and then decrypt it
+     *     with given parsed private key.
+     *
+     * @see verifyAndDecrypt(const VirgilByteArray&, const VirgilByteArray&, const VirgilByteArray&)
+     */
+    VirgilByteArray verifyAndDecrypt(
+            const VirgilPublicKeyHandle& senderPublicKey, const VirgilPrivateKeyHandle& recipientPrivateKey);
     /// @}
 public:
     //! @cond Doxygen_Suppress
@@ -272,6 +321,21 @@ public:
     virtual ~VirgilTinyCipher() noexcept;
     //! @endcond
 
+private:
+    /**
+     * @brief Encrypt data for the recipient context and sign it with the sender context if it is given.
+     */
+    void doEncryptAndSign(
+            const VirgilByteArray& data, const foundation::VirgilAsymmetricCipher& recipientContext,
+            const foundation::VirgilAsymmetricCipher* senderContext);
+
+    /**
+     * @brief Verify packages with the sender context if it is given and then decrypt it with the recipient context.
+     */
+    VirgilByteArray doVerifyAndDecrypt(
+            const foundation::VirgilAsymmetricCipher* senderContext,
+            const foundation::VirgilAsymmetricCipher& recipientContext);
+
 private:
     class Impl;
 
@@ -73,7 +73,8 @@ public:
         AES_128_CBC, ///< Cipher algorithm: AES-128, mode: CBC
         AES_128_GCM, ///< Cipher algorithm: AES-128, mode: GCM
         AES_256_CBC, ///< Cipher algorithm: AES-256, mode: CBC
-        AES_256_GCM  ///< Cipher algorithm: AES-256, mode: GCM
+        AES_256_GCM, ///< Cipher algorithm: AES-256, mode: GCM
+        CHACHA20_POLY1305 ///< Cipher algorithm: ChaCha20, mode: Poly1305 AEAD (RFC 8439)
     };
     ///@}
 
@@ -93,13 +94,13 @@ public:
 
     /**
      * @brief Create object with given algorithm name.
-     * @note Name format: {ALG}-{LEN}-{MODE}, i.e AES-256-GCM.
+     * @note Name format: {ALG}-{LEN}-{MODE}, i.e AES-256-GCM, or CHACHA20-POLY1305.
      */
     explicit VirgilSymmetricCipher(const std::string& name);
 
     /**
      * @brief Create object with given algorithm name.
-     * @note Name format: {ALG}-{LEN}-{MODE}, i.e AES-256-GCM.
+     * @note Name format: {ALG}-{LEN}-{MODE}, i.e AES-256-GCM, or CHACHA20-POLY1305.
      */
     explicit VirgilSymmetricCipher(const char* name);
     ///@}
@@ -209,12 +210,25 @@ public:
 
     /**
      * @brief Add additional data (for AEAD ciphers).
-     * @note Currently only supported with GCM.
+     * @note Currently only supported with GCM and ChaCha20-Poly1305.
      * @note Must be called before reset().
      * @see isAuthMode()
      */
     void setAuthData(const virgil::crypto::VirgilByteArray& authData);
 
+    /**
+     * @brief Define number of threads used to decrypt large inputs, 1 by default.
+     *
+     * Currently it is used only by AES-CBC decryption, if single update() is given several megabytes.
+     * @note This parameter is preserved by clear().
+     */
+    void setDecryptionThreadsNum(size_t threadsNum);
+
+    /**
+     * @brief Return number of threads used to decrypt large inputs.
+     */
+    size_t getDecryptionThreadsNum() const;
+
     /**
      * @brief Finish preparation before encryption / decryption.
      */
@@ -268,6 +282,48 @@ public:
      */
     virgil::crypto::VirgilByteArray finish();
     ///@}
+    /**
+     * @name Sequence Encryption / Decryption to the caller provided buffer
+     *
+     * These methods do not allocate memory for the processed data,
+     *     so they are preferable for the processing of big data in a loop.
+     */
+    ///@{
+    /**
+     * @brief Return maximum number of bytes that can be written by the method update() for the given input size.
+     */
+    size_t updateOutputSizeMax(size_t inputSize) const;
+
+    /**
+     * @brief Return maximum number of bytes that can be written by the method finish().
+     */
+    size_t finishOutputSizeMax() const;
+
+    /**
+     * @brief Generic cipher update function.
+     *
+     * Encrypts or decrypts given data and writes result to the given output buffer.
+     * @param input - data to be encrypted / decrypted.
+     * @param inputSize - size of the data to be encrypted / decrypted.
+     * @param output - output buffer, MAY be the same as input for encryption in the authenticated mode.
+     * @param outputCapacity - size of the output buffer, MUST be at least @link updateOutputSizeMax() @endlink.
+     * @return Number of bytes written to the output buffer.
+     * @throw VirgilCryptoException with VirgilCryptoError::InvalidArgument, if output buffer is too small,
+     *     or in-place processing is not supported by the current mode.
+     */
+    size_t update(const unsigned char* input, size_t inputSize, unsigned char* output, size_t outputCapacity);
+
+    /**
+     * @brief Cipher finalization method.
+     *
+     * Writes the rest of encrypted / decrypted data to the given output buffer.
+     * @param output - output buffer.
+     * @param outputCapacity - size of the output buffer, MUST be at least @link finishOutputSizeMax() @endlink.
+     * @return Number of bytes written to the output buffer.
+     * @throw VirgilCryptoException with VirgilCryptoError::InvalidArgument, if output buffer is too small.
+     */
+    size_t finish(unsigned char* output, size_t outputCapacity);
+    ///@}
     /**
      * @name VirgilAsn1Compatible implementation
      */
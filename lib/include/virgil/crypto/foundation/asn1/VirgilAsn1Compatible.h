@@ -60,9 +60,22 @@ class VirgilAsn1Compatible {
 public:
     /**
      * @brief Save object state to the ASN.1 structure.
+     * @note Size of the structure is calculated first, so result is allocated once.
      */
     virgil::crypto::VirgilByteArray toAsn1() const;
 
+    /**
+     * @brief Save object state to the ASN.1 structure, that is written to the beginning of the given buffer.
+     * @return Written bytes count, it is equal to the calculateAsn1Size().
+     * @throw VirgilCryptoException with VirgilCryptoError::ExceededMaxSize, if buffer is too small.
+     */
+    size_t toAsn1(unsigned char* buffer, size_t bufferSize) const;
+
+    /**
+     * @brief Calculate size of the ASN.1 structure, that is returned by toAsn1(), without writing it.
+     */
+    size_t calculateAsn1Size() const;
+
     /**
      * @brief Restore object state from the ASN.1 structure.
      */
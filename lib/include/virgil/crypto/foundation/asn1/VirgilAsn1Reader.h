@@ -49,9 +49,24 @@ namespace virgil { namespace crypto { namespace foundation { namespace asn1 {
  *
  * @note All "read*" methods perform reading of ASN.1 structure sequentially.
  * @note Implementation is not complete yet, only minimum set of operations are supported.
+ * @note Reader either owns a copy of the given ASN.1 structure, or borrows it - see constructors.
  */
 class VirgilAsn1Reader {
 public:
+    /**
+     * @brief Non-owning reference to the bytes of the ASN.1 structure being read.
+     * @note View is valid while the buffer the reader was initialized with is alive and unchanged.
+     */
+    struct View {
+        const unsigned char* data;
+        size_t size;
+
+        /**
+         * @brief Copy referenced bytes.
+         */
+        virgil::crypto::VirgilByteArray toBytes() const;
+    };
+
     /**
      * @brief Initialize internal state.
      */
@@ -63,6 +78,12 @@ public:
      */
     explicit VirgilAsn1Reader(const virgil::crypto::VirgilByteArray& data);
 
+    /**
+     * @brief Initialize internal state with given ASN.1 structure without copying it.
+     * @note The same as sequence VirgilAsn1Reader() and reset(data, dataSize).
+     */
+    VirgilAsn1Reader(const unsigned char* data, size_t dataSize);
+
     /**
      * @brief Dispose internal resources.
      */
@@ -76,6 +97,14 @@ public:
      * @param data - ASN.1 structure to be read.
      */
     void reset(const virgil::crypto::VirgilByteArray& data);
+
+    /**
+     * @brief Reset all internal states and prepare to new ASN.1 reading operations.
+     * @param data - ASN.1 structure to be read, it is not copied.
+     * @param dataSize - ASN.1 structure size.
+     * @warning Given buffer MUST outlive the reader and all views returned by it.
+     */
+    void reset(const unsigned char* data, size_t dataSize);
     ///@}
     /**
      * @name Read Simple ASN.1 Types
@@ -140,6 +169,28 @@ public:
      */
     size_t readSet();
     ///@}
+    /**
+     * @name Read ASN.1 Types without copying
+     *
+     * Returned views point to the buffer being read.
+     * Use them to parse nested structures with another reader, or to skip unneeded values.
+     */
+    ///@{
+    /**
+     * @brief Read ASN.1 type: OCTET STRING.
+     */
+    View readOctetStringView();
+
+    /**
+     * @brief Read ASN.1 type: UTF8String.
+     */
+    View readUTF8StringView();
+
+    /**
+     * @brief Read preformatted ASN.1 structure.
+     */
+    View readDataView();
+    ///@}
 public:
     /**
      * @brief Delete copy constructor
@@ -49,7 +49,11 @@ namespace virgil { namespace crypto { namespace foundation { namespace asn1 {
  * @brief This class provides methods for writing ASN.1 data structure.
  *
  * @note All "write*" methods perform writing of ASN.1 structure sequentially.
+ * @note ASN.1 structure is written from the end to the beginning, so nested elements are written first.
  * @note Implementation is not complete yet, only minimum set of operations are supported.
+ *
+ * To write ASN.1 structure with a single allocation, calculate its exact size first:
+ *     run the same "write*" calls after resetSizing(), and then reset(size).
  */
 class VirgilAsn1Writer {
 public:
@@ -85,9 +89,36 @@ public:
      */
     void reset(size_t capacity);
 
+    /**
+     * @brief Reset all internal states and prepare to write ASN.1 structure to the given buffer.
+     *
+     * ASN.1 structure is written to the end of the buffer, and buffer is never relocated.
+     *
+     * @param buffer - buffer to write to, it is not owned.
+     * @param bufferSize - buffer size, if it is not enough exception is thrown on write.
+     * @warning Method finish() MUST not be called in this mode, use written bytes count instead.
+     */
+    void reset(unsigned char* buffer, size_t bufferSize);
+
+    /**
+     * @brief Reset all internal states and prepare to calculate size of the ASN.1 structure.
+     *
+     * Nothing is written in this mode, but all "write*" methods return exact count of bytes,
+     *     that would be written.
+     *
+     * @warning Method finish() MUST not be called in this mode.
+     */
+    void resetSizing();
+
+    /**
+     * @brief Return true if writer calculates size only.
+     */
+    bool isSizing() const;
+
     /**
      * @brief Returns the result ASN.1 structure.
      * @return ASN.1 structure that was written.
+     * @note If written structure occupies whole buffer, buffer is returned without copying.
      * @warning After call this method all attempts to write more data will cause exceptions.
      */
     virgil::crypto::VirgilByteArray finish();
@@ -123,6 +154,14 @@ public:
      */
     size_t writeOctetString(const virgil::crypto::VirgilByteArray& data);
 
+    /**
+     * @brief Write ASN.1 type: OCTET STRING.
+     * @param data - octet string to be written.
+     * @param dataSize - octet string size.
+     * @return Written bytes.
+     */
+    size_t writeOctetString(const unsigned char* data, size_t dataSize);
+
     /**
      * @brief Write ASN.1 type: UTF8String.
      * @param data - UTF8 string to be written.
@@ -130,6 +169,14 @@ public:
      */
     size_t writeUTF8String(const virgil::crypto::VirgilByteArray& data);
 
+    /**
+     * @brief Write ASN.1 type: UTF8String.
+     * @param data - UTF8 string to be written.
+     * @param dataSize - UTF8 string size.
+     * @return Written bytes.
+     */
+    size_t writeUTF8String(const unsigned char* data, size_t dataSize);
+
     /**
      * @brief Write ASN.1 type: TAG.
      * @param tag - custom tag.
@@ -145,6 +192,14 @@ public:
      */
     size_t writeData(const virgil::crypto::VirgilByteArray& data);
 
+    /**
+     * @brief Write preformatted ASN.1 structure.
+     * @param data - ASN.1 structure.
+     * @param dataSize - ASN.1 structure size.
+     * @return Written bytes.
+     */
+    size_t writeData(const unsigned char* data, size_t dataSize);
+
     /**
      * @brief Write ASN.1 type: OID.
      * @param oid - the OID to write.
@@ -169,37 +224,70 @@ public:
      * @return Written bytes.
      */
     size_t writeSet(const std::vector<virgil::crypto::VirgilByteArray>& set);
+
+    /**
+     * @brief Write ASN.1 type: SET OF ANY, which elements are encoded one after another in the single buffer.
+     * @param elements - concatenated ASN.1 structures, in any order.
+     * @param elementsSize - size of the concatenated ASN.1 structures.
+     * @return Written bytes.
+     */
+    size_t writeSet(const unsigned char* elements, size_t elementsSize);
+
+    /**
+     * @brief Write ASN.1 type: SET OF ANY, which elements are already written.
+     * @param len - set length in bytes.
+     * @return Written bytes.
+     * @warning Elements MUST be written in the DER order, it is always true when size is calculated.
+     */
+    size_t writeSet(size_t len);
+
+    /**
+     * @brief Write ASN.1 type: SET OF ANY, which elements are already written in any order.
+     *
+     * Written elements are put in the DER order in place, so they are not encoded twice.
+     *
+     * @param len - set length in bytes.
+     * @return Written bytes, elements are not counted.
+     */
+    size_t writeSortedSet(size_t len);
     ///@}
 private:
     /**
-     * @brief Logically pad the shorter DER encoding after the last octet with dummy octets,
-     *     that are smaller in value than any normal octet.
-     * @param asn1 - ASN.1 structure that will be padded.
-     * @param finalSize - ASN.1 structure size after padding.
+     * @brief Reference to the encoded element of the SET.
      */
-    static virgil::crypto::VirgilByteArray
-            makeComparePadding(const virgil::crypto::VirgilByteArray& asn1, size_t finalSize);
+    struct SetElement {
+        const unsigned char* data;
+        size_t size;
+    };
 
     /**
      * @brief Perform lexicographic ASN.1 comparison.
+     *
+     * The shorter DER encoding is logically padded after the last octet with dummy octets,
+     *     that are smaller in value than any normal octet.
      */
-    static bool compare(const virgil::crypto::VirgilByteArray& first, const virgil::crypto::VirgilByteArray& second);
+    static bool compare(const SetElement& first, const SetElement& second);
 
     /**
-     * @brief Perform ascending lexicographic order on the given set.
+     * @brief Split concatenated ASN.1 structures to the elements of the SET.
      */
-    static void makeOrderedSet(std::vector<virgil::crypto::VirgilByteArray>& set);
+    static std::vector<SetElement> splitSet(const unsigned char* elements, size_t elementsSize);
+
+    /**
+     * @brief Write given elements in the DER order and wrap them with SET.
+     */
+    size_t writeOrderedSet(std::vector<SetElement>& elements, size_t elementsSize);
 
 public:
     /**
-     * @brief Use default move constructor
+     * @brief Move constructor, other writer is left not initialized.
      */
-    VirgilAsn1Writer(VirgilAsn1Writer&& other) = default;
+    VirgilAsn1Writer(VirgilAsn1Writer&& other) noexcept;
 
     /**
-     * @brief Use default move operator
+     * @brief Move operator, other writer is left not initialized.
      */
-    VirgilAsn1Writer& operator=(VirgilAsn1Writer&& rhs) = default;
+    VirgilAsn1Writer& operator=(VirgilAsn1Writer&& rhs) noexcept;
 
 
 private:
@@ -229,11 +317,31 @@ private:
      */
     void ensureBufferEnough(size_t len);
 
+    /**
+     * @brief Write given bytes before already written data, or only count them if size is calculated.
+     * @return Written bytes.
+     */
+    size_t writeRaw(const unsigned char* data, size_t dataSize);
+
+    /**
+     * @brief Write ASN.1 tag and length.
+     * @return Written bytes.
+     */
+    size_t writeHeader(unsigned char tag, size_t len);
+
 private:
-    unsigned char* p_;
-    unsigned char* start_;
-    unsigned char* buf_;
+    enum class Mode {
+        None,
+        Owned,
+        External,
+        Sizing
+    };
+    Mode mode_;
+    virgil::crypto::VirgilByteArray buf_;
+    unsigned char* externalBuf_;
     size_t bufLen_;
+    size_t capacity_;
+    size_t writtenBytes_;
 };
 
 }}}}
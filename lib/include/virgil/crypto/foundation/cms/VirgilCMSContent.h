@@ -97,6 +97,21 @@ public:
     virtual void asn1Read(virgil::crypto::foundation::asn1::VirgilAsn1Reader& asn1Reader);
     ///@}
 private:
+    /**
+     * @brief Write structure, where the given object is written as the content of the given type.
+     * @note It allows to write content without intermediate serialization, see VirgilCMSContentInfo.
+     */
+    static size_t asn1WriteObject(
+            virgil::crypto::foundation::asn1::VirgilAsn1Writer& asn1Writer, VirgilCMSContent::Type contentType,
+            const virgil::crypto::foundation::asn1::VirgilAsn1Compatible& contentObject);
+
+    /**
+     * @brief Wrap already written content of the given type.
+     */
+    static size_t writeContentWrapper(
+            virgil::crypto::foundation::asn1::VirgilAsn1Writer& asn1Writer, VirgilCMSContent::Type contentType,
+            size_t contentLen);
+
     /**
      * @brief Convert given content type to the appropriate OID.
      */
@@ -106,6 +121,8 @@ private:
      * @brief Convert given OID to the appropriate content type.
      */
     static VirgilCMSContent::Type oidToContentType(const std::string& oid);
+
+    friend class VirgilCMSContentInfo;
 };
 
 }}}}
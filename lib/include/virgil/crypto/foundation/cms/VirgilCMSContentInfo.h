@@ -39,6 +39,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include "VirgilCMSContent.h"
 
@@ -47,6 +48,10 @@
 #include "../../VirgilCustomParams.h"
 #include "../../VirgilByteArray.h"
 
+namespace virgil { namespace crypto {
+class VirgilContentInfo;
+}}
+
 namespace virgil { namespace crypto { namespace foundation { namespace cms {
 
 /**
@@ -64,6 +69,12 @@ public:
      * @brief User defiend custom parameters.
      */
     virgil::crypto::VirgilCustomParams customParams;
+    /**
+     * @property algorithms
+     * @brief Algorithm identifiers that are referenced from the CMS content instead of being repeated.
+     * @note If not empty, content info is written in the compact version (v1).
+     */
+    std::vector<virgil::crypto::VirgilByteArray> algorithms;
 public:
     /**
      * @brief Read content info size as part of the data.
@@ -75,10 +86,15 @@ public:
      * @code
      * Marshalling format:
      *     VirgilCMSContentInfo ::= SEQUENCE {
-     *         version ::= INTEGER { v0(0) },
+     *         version ::= INTEGER { v0(0), v1(1) },
      *         cmsContent ContentInfo, -- Imports from RFC 5652
-     *         customParams [0] IMPLICIT VirgilCustomParams OPTIONAL
+     *         customParams [0] IMPLICIT VirgilCustomParams OPTIONAL,
+     *         algorithms [1] IMPLICIT SEQUENCE OF AlgorithmIdentifier OPTIONAL -- v1 only
      *     }
+     *
+     *     -- In v1 keyEncryptionAlgorithm of the KeyTransRecipientInfo and KeyAgreeRecipientInfo
+     *     -- can be replaced with the reference to the 'algorithms' element with the given index.
+     *     AlgorithmIdentifierRef ::= [1] IMPLICIT INTEGER
      * @endcode
      */
     ///@{
@@ -86,6 +102,17 @@ public:
 
     void asn1Read(asn1::VirgilAsn1Reader& asn1Reader) override;
     ///@}
+private:
+    /**
+     * @brief Write structure, where the given object is written as enveloped data content,
+     *     and the given algorithm identifiers are written in place of the algorithms field.
+     * @note It allows to write content without intermediate serialization, see VirgilContentInfo.
+     */
+    size_t asn1WriteEnvelopedData(
+            asn1::VirgilAsn1Writer& asn1Writer, const asn1::VirgilAsn1Compatible& envelopedData,
+            const std::vector<virgil::crypto::VirgilByteArray>& algorithmIdentifiers) const;
+
+    friend class virgil::crypto::VirgilContentInfo;
 };
 
 }}}}
@@ -37,11 +37,13 @@
 #ifndef VIRGIL_CRYPTO_VIRGIL_CMS_ENVELOPED_DATA_H
 #define VIRGIL_CRYPTO_VIRGIL_CMS_ENVELOPED_DATA_H
 
+#include <map>
 #include <vector>
 
 #include "../asn1/VirgilAsn1Compatible.h"
 
 #include "VirgilCMSKeyTransRecipient.h"
+#include "VirgilCMSKeyAgreeRecipient.h"
 #include "VirgilCMSPasswordRecipient.h"
 #include "VirgilCMSEncryptedContent.h"
 
@@ -54,11 +56,20 @@ namespace virgil { namespace crypto { namespace foundation { namespace cms {
  */
 class VirgilCMSEnvelopedData : public virgil::crypto::foundation::asn1::VirgilAsn1Compatible {
 public:
+    /**
+     * @brief Map of the key encryption algorithm identifier to the value, that is written in place of it.
+     */
+    using AlgorithmRefs = std::map<virgil::crypto::VirgilByteArray, virgil::crypto::VirgilByteArray>;
     /**
      * @property keyTransRecipients
      * @brief Set of recipients identified by key.
      */
     std::vector<VirgilCMSKeyTransRecipient> keyTransRecipients;
+    /**
+     * @property keyAgreeRecipients
+     * @brief Set of recipients identified by key, that share originator's public key.
+     */
+    std::vector<VirgilCMSKeyAgreeRecipient> keyAgreeRecipients;
     /**
      * @property passwordRecipients
      * @brief Set of recipients identified by password.
@@ -95,7 +106,7 @@ public:
      *
      *     RecipientInfo ::= CHOICE {
      *         ktri KeyTransRecipientInfo,
-     *         kari [1] KeyAgreeRecipientInfo, -- not supported
+     *         kari [1] KeyAgreeRecipientInfo,
      *         kekri [2] KEKRecipientInfo, -- not supported
      *         pwri [3] PasswordRecipientInfo,
      *         ori [4] OtherRecipientInfo -- not supported
@@ -109,7 +120,40 @@ public:
 
     virtual void asn1Read(virgil::crypto::foundation::asn1::VirgilAsn1Reader& asn1Reader);
     ///@}
+
+    /**
+     * @brief Write structure, where key encryption algorithms found in the given map are replaced with mapped values.
+     *
+     * Recipients are not modified, so structure can be written concurrently.
+     *
+     * @param asn1Writer - writer to write to.
+     * @param algorithmRefs - references to be written in place of the key encryption algorithms.
+     * @param childWrittenBytes - count of bytes that was written by subclasses.
+     * @return Written bytes count.
+     */
+    size_t asn1Write(
+            virgil::crypto::foundation::asn1::VirgilAsn1Writer& asn1Writer, const AlgorithmRefs& algorithmRefs,
+            size_t childWrittenBytes = 0) const;
+
+    using VirgilAsn1Compatible::fromAsn1;
+
+    /**
+     * @brief Read structure, but keep only key recipients with the given identifier.
+     *
+     * Other key recipients are skipped right after their identifiers are read,
+     *     so they are not materialized. Password recipients are read as usual.
+     *
+     * @param asn1 - DER encoded EnvelopedData.
+     * @param keyRecipientIdentifier - identifier of the key recipient to be kept.
+     */
+    void fromAsn1(
+            const virgil::crypto::VirgilByteArray& asn1,
+            const virgil::crypto::VirgilByteArray& keyRecipientIdentifier);
 private:
+    void read(
+            virgil::crypto::foundation::asn1::VirgilAsn1Reader& asn1Reader,
+            const virgil::crypto::VirgilByteArray* keyRecipientIdentifier);
+
     int defineVersion() const;
 };
 
@@ -0,0 +1,160 @@
+/**
+ * Copyright (C) 2015-2018 Virgil Security Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *     (3) Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+ */
+
+#ifndef VIRGIL_CRYPTO_VIRGIL_CMS_KEY_AGREE_RECIPIENT_H
+#define VIRGIL_CRYPTO_VIRGIL_CMS_KEY_AGREE_RECIPIENT_H
+
+#include <vector>
+
+#include "../../VirgilByteArray.h"
+#include "../asn1/VirgilAsn1Compatible.h"
+
+namespace virgil { namespace crypto { namespace foundation { namespace cms {
+
+/**
+ * @brief Data object that represent CMS structure: KeyAgreeRecipientInfo.
+ *
+ * All recipients within one structure share the same originator (ephemeral) public key.
+ *
+ * @see RFC 5652 section 6.2.2.
+ */
+class VirgilCMSKeyAgreeRecipient : public virgil::crypto::foundation::asn1::VirgilAsn1Compatible {
+public:
+    /**
+     * @brief Recipient's identifier and the content-encryption key encrypted for this recipient.
+     */
+    struct RecipientEncryptedKey {
+        virgil::crypto::VirgilByteArray recipientIdentifier;
+        virgil::crypto::VirgilByteArray encryptedKey;
+    };
+    /**
+     * @property originatorKey
+     * @brief Originator's public key in the SubjectPublicKeyInfo format.
+     */
+    virgil::crypto::VirgilByteArray originatorKey;
+    /**
+     * @property keyEncryptionAlgorithm
+     * @brief Identifies the key agreement algorithm, and the key wrap algorithm as its parameter.
+     */
+    virgil::crypto::VirgilByteArray keyEncryptionAlgorithm;
+    /**
+     * @property recipientEncryptedKeys
+     * @brief Recipients that share the originator's public key.
+     */
+    std::vector<RecipientEncryptedKey> recipientEncryptedKeys;
+public:
+    /**
+     * @name VirgilAsn1Compatible implementation
+     * @code
+     * Marshalling format:
+     *     KeyAgreeRecipientInfo ::= SEQUENCE {
+     *         version CMSVersion,  -- always set to 3
+     *         originator [0] EXPLICIT OriginatorIdentifierOrKey,
+     *         ukm [1] EXPLICIT UserKeyingMaterial OPTIONAL, -- not used
+     *         keyEncryptionAlgorithm KeyEncryptionAlgorithmIdentifier,
+     *         recipientEncryptedKeys RecipientEncryptedKeys
+     *     }
+     *
+     *     OriginatorIdentifierOrKey ::= CHOICE {
+     *         issuerAndSerialNumber IssuerAndSerialNumber, -- not supported
+     *         subjectKeyIdentifier [0] SubjectKeyIdentifier, -- not supported
+     *         originatorKey [1] OriginatorPublicKey
+     *     }
+     *
+     *     OriginatorPublicKey ::= SubjectPublicKeyInfo
+     *
+     *     RecipientEncryptedKeys ::= SEQUENCE OF RecipientEncryptedKey
+     *
+     *     RecipientEncryptedKey ::= SEQUENCE {
+     *         rid KeyAgreeRecipientIdentifier,
+     *         encryptedKey EncryptedKey
+     *     }
+     *
+     *     KeyAgreeRecipientIdentifier ::= CHOICE {
+     *         issuerAndSerialNumber IssuerAndSerialNumber, -- not supported
+     *         rKeyId [0] RecipientKeyIdentifier
+     *     }
+     *
+     *     RecipientKeyIdentifier ::= SEQUENCE {
+     *         subjectKeyIdentifier SubjectKeyIdentifier,
+     *         date GeneralizedTime OPTIONAL, -- not used
+     *         other OtherKeyAttribute OPTIONAL -- not used
+     *     }
+     *
+     *     EncryptedKey ::= OCTET STRING
+     *
+     *     SubjectKeyIdentifier ::= OCTET STRING
+     * @endcode
+     */
+    ///@{
+    virtual size_t asn1Write(
+            virgil::crypto::foundation::asn1::VirgilAsn1Writer& asn1Writer,
+            size_t childWrittenBytes = 0) const;
+
+    virtual void asn1Read(virgil::crypto::foundation::asn1::VirgilAsn1Reader& asn1Reader);
+    ///@}
+
+    /**
+     * @brief Write structure with the given value in place of the keyEncryptionAlgorithm field.
+     * @note It is used to write reference to the algorithm identifier, that is shared between recipients.
+     * @see VirgilCMSEnvelopedData::asn1Write()
+     */
+    size_t asn1Write(
+            virgil::crypto::foundation::asn1::VirgilAsn1Writer& asn1Writer,
+            const virgil::crypto::VirgilByteArray& keyEncryptionAlgorithmValue) const;
+
+    /**
+     * @brief Read structure, but keep only recipient encrypted keys with the given identifier.
+     *
+     * Other recipient encrypted keys are skipped right after their identifiers are read,
+     *     so they are not materialized.
+     *
+     * @param asn1Reader - reader positioned at the KeyAgreeRecipientInfo.
+     * @param recipientIdentifier - identifier of the recipient encrypted key to be kept.
+     */
+    void asn1Read(
+            virgil::crypto::foundation::asn1::VirgilAsn1Reader& asn1Reader,
+            const virgil::crypto::VirgilByteArray& recipientIdentifier);
+
+private:
+    void read(
+            virgil::crypto::foundation::asn1::VirgilAsn1Reader& asn1Reader,
+            const virgil::crypto::VirgilByteArray* recipientIdentifier);
+};
+
+}}}}
+
+#endif /* VIRGIL_CRYPTO_VIRGIL_CMS_KEY_AGREE_RECIPIENT_H */
@@ -96,6 +96,15 @@ public:
 
     virtual void asn1Read(virgil::crypto::foundation::asn1::VirgilAsn1Reader& asn1Reader);
     ///@}
+
+    /**
+     * @brief Write structure with the given value in place of the keyEncryptionAlgorithm field.
+     * @note It is used to write reference to the algorithm identifier, that is shared between recipients.
+     * @see VirgilCMSEnvelopedData::asn1Write()
+     */
+    size_t asn1Write(
+            virgil::crypto::foundation::asn1::VirgilAsn1Writer& asn1Writer,
+            const virgil::crypto::VirgilByteArray& keyEncryptionAlgorithmValue) const;
 };
 
 }}}}
@@ -114,6 +114,12 @@ public:
      */
     static VirgilOperationCipher getDefault();
 
+    /**
+     * @brief Return implementation based on the ChaCha20-Poly1305 algorithm.
+     * @note Preferable for the platforms that have no hardware AES support.
+     */
+    static VirgilOperationCipher getChaCha20Poly1305();
+
 private:
     struct Concept {
         virtual size_t doGetKeySize() const = 0;
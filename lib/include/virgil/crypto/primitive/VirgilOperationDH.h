@@ -38,6 +38,9 @@
 #define VIRGIL_CRYPTO_VIRGIL_DH_H
 
 #include "../VirgilByteArray.h"
+#include "../VirgilPublicKeyHandle.h"
+#include "../VirgilPrivateKeyHandle.h"
+#include "../foundation/VirgilAsymmetricCipher.h"
 
 #include <memory>
 
@@ -76,6 +79,17 @@ public:
         return self_->doCalculate(publicKey, privateKey, privateKeyPassword);
     }
 
+    /**
+     * @brief Compute shared key by using Diffie-Hellman algorithm.
+     * @param publicKey - parsed public key of the side 1.
+     * @param privateKey - parsed private key of the side 2.
+     * @return Shared key.
+     * @note If implementation does not handle parsed keys, then keys are exported and passed to it in DER format.
+     */
+    VirgilByteArray calculate(const VirgilPublicKeyHandle& publicKey, const VirgilPrivateKeyHandle& privateKey) const {
+        return self_->doCalculate(publicKey, privateKey);
+    }
+
     /**
      * @brief Return default implementation.
      */
@@ -88,6 +102,9 @@ private:
                 const VirgilByteArray& publicKey, const VirgilByteArray& privateKey,
                 const VirgilByteArray& privateKeyPassword) const = 0;
 
+        virtual VirgilByteArray doCalculate(
+                const VirgilPublicKeyHandle& publicKey, const VirgilPrivateKeyHandle& privateKey) const = 0;
+
         virtual ~Concept() noexcept = default;
     };
 
@@ -103,6 +120,30 @@ private:
             return impl_.calculate(publicKey, privateKey, privateKeyPassword);
         }
 
+        VirgilByteArray doCalculate(
+                const VirgilPublicKeyHandle& publicKey, const VirgilPrivateKeyHandle& privateKey) const override {
+
+            return calculateWithHandles(impl_, publicKey, privateKey, 0);
+        }
+
+    private:
+        template<class T>
+        static auto calculateWithHandles(
+                const T& impl, const VirgilPublicKeyHandle& publicKey, const VirgilPrivateKeyHandle& privateKey, int)
+                -> decltype(impl.calculate(publicKey, privateKey)) {
+
+            return impl.calculate(publicKey, privateKey);
+        }
+
+        template<class T>
+        static VirgilByteArray calculateWithHandles(
+                const T& impl, const VirgilPublicKeyHandle& publicKey, const VirgilPrivateKeyHandle& privateKey, long) {
+
+            return impl.calculate(
+                    publicKey.acquireCipher()->exportPublicKeyToDER(),
+                    privateKey.acquireCipher()->exportPrivateKeyToDER(), VirgilByteArray());
+        }
+
     private:
         Impl impl_;
     };
@@ -39,15 +39,18 @@
 
 #include "../VirgilByteArray.h"
 #include "../VirgilDataSource.h"
+#include "../VirgilSeekableDataSource.h"
 
 namespace virgil { namespace crypto { namespace stream {
 
 /**
- * @brief C++ Byte Array implementation of the VirgilDataSource class.
+ * @brief C++ Byte Array implementation of the VirgilDataSource and VirgilSeekableDataSource classes.
  *
  * @note This class CAN not be used in wrappers.
  */
-class VirgilBytesDataSource : public virgil::crypto::VirgilDataSource {
+class VirgilBytesDataSource :
+        public virgil::crypto::VirgilDataSource,
+        public virgil::crypto::VirgilSeekableDataSource {
 public:
     /**
      * @brief Creates data sink based on byte array.
@@ -72,6 +75,17 @@ public:
      */
     virtual virgil::crypto::VirgilByteArray read();
 
+    /**
+     * @brief Overriding of @link VirgilSeekableDataSource::size() @endlink method.
+     */
+    virtual size_t size();
+
+    /**
+     * @brief Overriding of @link VirgilSeekableDataSource::readAt() @endlink method.
+     * @note Does not affect data returned by @link read() @endlink method.
+     */
+    virtual virgil::crypto::VirgilByteArray readAt(size_t offset, size_t length);
+
     /**
      * @brief Reset internal state to initial.
      *
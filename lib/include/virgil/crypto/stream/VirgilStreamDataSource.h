@@ -41,15 +41,18 @@
 
 #include "../VirgilByteArray.h"
 #include "../VirgilDataSource.h"
+#include "../VirgilSeekableDataSource.h"
 
 namespace virgil { namespace crypto { namespace stream {
 
 /**
- * @brief C++ stream implementation of the VirgilDataSource class.
+ * @brief C++ stream implementation of the VirgilDataSource and VirgilSeekableDataSource classes.
  *
  * @note This class CAN not be used in wrappers.
  */
-class VirgilStreamDataSource : public virgil::crypto::VirgilDataSource {
+class VirgilStreamDataSource :
+        public virgil::crypto::VirgilDataSource,
+        public virgil::crypto::VirgilSeekableDataSource {
 public:
     /**
      * @brief Creates data sink based on std::istream object.
@@ -74,6 +77,19 @@ public:
      */
     virtual virgil::crypto::VirgilByteArray read();
 
+    /**
+     * @brief Overriding of @link VirgilSeekableDataSource::size() @endlink method.
+     * @note Underlying stream MUST support seeking.
+     */
+    virtual size_t size();
+
+    /**
+     * @brief Overriding of @link VirgilSeekableDataSource::readAt() @endlink method.
+     * @note Underlying stream MUST support seeking.
+     * @note Subsequent @link read() @endlink call continues reading from the end of the returned data.
+     */
+    virtual virgil::crypto::VirgilByteArray readAt(size_t offset, size_t length);
+
 private:
     std::istream& in_;
     size_t chunkSize_;
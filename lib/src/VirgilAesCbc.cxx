@@ -0,0 +1,307 @@
+/**
+ * Copyright (C) 2015-2018 Virgil Security Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *     (3) Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+ */
+
+#include "VirgilAesCbc.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include <virgil/crypto/VirgilCryptoError.h>
+
+#include "VirgilParallelFor.h"
+
+using virgil::crypto::VirgilCryptoError;
+using virgil::crypto::make_error;
+using virgil::crypto::foundation::internal::VirgilAesCbc;
+using virgil::crypto::internal::parallel_for;
+
+namespace virgil { namespace crypto { namespace foundation { namespace internal {
+
+static constexpr size_t kAes_ParallelBlocks = 8;
+// Inputs of this size and more are decrypted by several threads, if they are enabled.
+static constexpr size_t kAes_ThreadedDataSizeMin = 4 * 1024 * 1024;
+// Minimum portion of data that worth a separate thread.
+static constexpr size_t kAes_ThreadDataSizeMin = 1024 * 1024;
+
+#if VIRGIL_CRYPTO_X86_INTRINSICS
+
+/**
+ * @brief Convert encryption round keys to the decryption round keys for the Equivalent Inverse Cipher.
+ */
+VIRGIL_CRYPTO_AESNI_TARGET
+static void aes_decryption_keys(unsigned char* roundKeys, size_t rounds) {
+    __m128i rk[15];
+    for (size_t i = 0; i <= rounds; ++i) {
+        rk[i] = load128(roundKeys + i * kAesNi_BlockSize);
+    }
+    store128(roundKeys, rk[rounds]);
+    for (size_t i = 1; i < rounds; ++i) {
+        store128(roundKeys + i * kAesNi_BlockSize, _mm_aesimc_si128(rk[rounds - i]));
+    }
+    store128(roundKeys + rounds * kAesNi_BlockSize, rk[0]);
+    secure_zeroize(rk, sizeof(rk));
+}
+
+/**
+ * @brief Decrypt given number of blocks in CBC mode, chain holds previous cipher text block.
+ *
+ * Input and output MAY be the same.
+ */
+VIRGIL_CRYPTO_AESNI_TARGET
+static void cbc_decrypt_blocks(
+        const unsigned char* roundKeys, size_t rounds, unsigned char* chain,
+        const unsigned char* input, unsigned char* output, size_t blocksNum) {
+
+    __m128i rk[15];
+    for (size_t i = 0; i <= rounds; ++i) {
+        rk[i] = load128(roundKeys + i * kAesNi_BlockSize);
+    }
+    __m128i prev = load128(chain);
+
+    for (; blocksNum >= kAes_ParallelBlocks; blocksNum -= kAes_ParallelBlocks) {
+        __m128i in[kAes_ParallelBlocks];
+        __m128i blocks[kAes_ParallelBlocks];
+        VIRGIL_CRYPTO_UNROLL_BLOCKS
+        for (size_t i = 0; i < kAes_ParallelBlocks; ++i) {
+            in[i] = load128(input + i * kAesNi_BlockSize);
+            blocks[i] = _mm_xor_si128(in[i], rk[0]);
+        }
+        for (size_t r = 1; r < rounds; ++r) {
+            VIRGIL_CRYPTO_UNROLL_BLOCKS
+            for (size_t i = 0; i < kAes_ParallelBlocks; ++i) {
+                blocks[i] = _mm_aesdec_si128(blocks[i], rk[r]);
+            }
+        }
+        VIRGIL_CRYPTO_UNROLL_BLOCKS
+        for (size_t i = 0; i < kAes_ParallelBlocks; ++i) {
+            blocks[i] = _mm_aesdeclast_si128(blocks[i], rk[rounds]);
+            store128(output + i * kAesNi_BlockSize, _mm_xor_si128(blocks[i], prev));
+            prev = in[i];
+        }
+        input += kAes_ParallelBlocks * kAesNi_BlockSize;
+        output += kAes_ParallelBlocks * kAesNi_BlockSize;
+    }
+
+    for (; blocksNum > 0; --blocksNum) {
+        const __m128i in = load128(input);
+        __m128i block = _mm_xor_si128(in, rk[0]);
+        for (size_t r = 1; r < rounds; ++r) {
+            block = _mm_aesdec_si128(block, rk[r]);
+        }
+        block = _mm_aesdeclast_si128(block, rk[rounds]);
+        store128(output, _mm_xor_si128(block, prev));
+        prev = in;
+        input += kAesNi_BlockSize;
+        output += kAesNi_BlockSize;
+    }
+
+    store128(chain, prev);
+    secure_zeroize(rk, sizeof(rk));
+}
+
+#else
+
+static void aes_decryption_keys(unsigned char*, size_t) {
+    throw make_error(VirgilCryptoError::UnsupportedAlgorithm, "AES-NI is not supported by the target platform.");
+}
+
+static void cbc_decrypt_blocks(
+        const unsigned char*, size_t, unsigned char*, const unsigned char*, unsigned char*, size_t) {
+    throw make_error(VirgilCryptoError::UnsupportedAlgorithm, "AES-NI is not supported by the target platform.");
+}
+
+#endif // VIRGIL_CRYPTO_X86_INTRINSICS
+
+}}}}
+
+bool VirgilAesCbc::isSupported(size_t keySize) {
+    return (keySize == 16 || keySize == 32) && cpu_has_aesni_pclmul();
+}
+
+VirgilAesCbc::VirgilAesCbc() : threadsNum_(1) {
+    clear();
+}
+
+VirgilAesCbc::~VirgilAesCbc() noexcept {
+    clear();
+}
+
+void VirgilAesCbc::clear() noexcept {
+    secure_zeroize(roundKeys_.data(), roundKeys_.size());
+    secure_zeroize(chain_.data(), chain_.size());
+    secure_zeroize(buffer_.data(), buffer_.size());
+    rounds_ = 0;
+    bufferLen_ = 0;
+    hasPadding_ = false;
+    hasKey_ = false;
+    isStarted_ = false;
+}
+
+void VirgilAesCbc::setThreadsNum(size_t threadsNum) {
+    threadsNum_ = std::max<size_t>(threadsNum, 1);
+}
+
+void VirgilAesCbc::setKey(const unsigned char* key, size_t keySize) {
+    if (!isSupported(keySize)) {
+        throw make_error(VirgilCryptoError::InvalidArgument, "Bad key for symmetric cipher.");
+    }
+    rounds_ = aes_expand_key(key, keySize, roundKeys_.data());
+    aes_decryption_keys(roundKeys_.data(), rounds_);
+    hasKey_ = true;
+    isStarted_ = false;
+}
+
+void VirgilAesCbc::start(const unsigned char* iv, size_t ivSize, bool hasPadding) {
+    if (ivSize != kAesNi_BlockSize) {
+        throw make_error(VirgilCryptoError::InvalidArgument, "Bad input vector for symmetric cipher.");
+    }
+    if (!hasKey_) {
+        throw make_error(VirgilCryptoError::InvalidState, "Key must be set before decryption.");
+    }
+    std::memcpy(chain_.data(), iv, ivSize);
+    bufferLen_ = 0;
+    hasPadding_ = hasPadding;
+    isStarted_ = true;
+}
+
+size_t VirgilAesCbc::update(const unsigned char* input, size_t inputSize, unsigned char* output) {
+    checkStarted();
+    size_t writtenBytes = 0;
+    if (bufferLen_ > 0) {
+        const size_t fillSize = std::min(inputSize, buffer_.size() - bufferLen_);
+        std::memcpy(buffer_.data() + bufferLen_, input, fillSize);
+        bufferLen_ += fillSize;
+        input += fillSize;
+        inputSize -= fillSize;
+        // With padding the last full block is hold until finish.
+        if (bufferLen_ == buffer_.size() && (inputSize > 0 || !hasPadding_)) {
+            decryptBlocks(buffer_.data(), 1, output);
+            writtenBytes += kAesNi_BlockSize;
+            bufferLen_ = 0;
+        }
+    }
+
+    size_t blocksNum = inputSize / kAesNi_BlockSize;
+    if (hasPadding_ && blocksNum > 0 && inputSize % kAesNi_BlockSize == 0) {
+        --blocksNum;
+    }
+    if (blocksNum > 0) {
+        decryptBlocks(input, blocksNum, output + writtenBytes);
+        input += blocksNum * kAesNi_BlockSize;
+        inputSize -= blocksNum * kAesNi_BlockSize;
+        writtenBytes += blocksNum * kAesNi_BlockSize;
+    }
+
+    if (inputSize > 0) {
+        std::memcpy(buffer_.data(), input, inputSize);
+        bufferLen_ = inputSize;
+    }
+    return writtenBytes;
+}
+
+size_t VirgilAesCbc::finish(unsigned char* output) {
+    checkStarted();
+    isStarted_ = false;
+    if (!hasPadding_) {
+        if (bufferLen_ != 0) {
+            throw make_error(VirgilCryptoError::InvalidState, "Decrypted data is not aligned to the block size.");
+        }
+        return 0;
+    }
+    if (bufferLen_ != kAesNi_BlockSize) {
+        throw make_error(VirgilCryptoError::InvalidState, "Decrypted data is not aligned to the block size.");
+    }
+
+    unsigned char block[kAesNi_BlockSize];
+    decryptBlocks(buffer_.data(), 1, block);
+    bufferLen_ = 0;
+
+    // Check PKCS#7 padding in the constant time.
+    const unsigned char paddingLen = block[kAesNi_BlockSize - 1];
+    unsigned char bad = (paddingLen == 0) | (paddingLen > kAesNi_BlockSize);
+    for (size_t i = 0; i < kAesNi_BlockSize; ++i) {
+        const unsigned char isPadding = (unsigned char) (i >= kAesNi_BlockSize - paddingLen);
+        bad |= (unsigned char) ((block[i] ^ paddingLen) * isPadding);
+    }
+    if (bad != 0) {
+        secure_zeroize(block, sizeof(block));
+        throw make_error(VirgilCryptoError::InvalidState, "Invalid padding of the decrypted data.");
+    }
+
+    const size_t writtenBytes = kAesNi_BlockSize - paddingLen;
+    std::memcpy(output, block, writtenBytes);
+    secure_zeroize(block, sizeof(block));
+    return writtenBytes;
+}
+
+void VirgilAesCbc::checkStarted() const {
+    if (!isStarted_) {
+        throw make_error(VirgilCryptoError::InvalidState, "Cipher is not started.");
+    }
+}
+
+void VirgilAesCbc::decryptBlocks(const unsigned char* input, size_t blocksNum, unsigned char* output) {
+    const size_t dataSize = blocksNum * kAesNi_BlockSize;
+    const size_t threadsNum = dataSize < kAes_ThreadedDataSizeMin ? 1 :
+            std::min(threadsNum_, dataSize / kAes_ThreadDataSizeMin);
+    if (threadsNum <= 1) {
+        cbc_decrypt_blocks(roundKeys_.data(), rounds_, chain_.data(), input, output, blocksNum);
+        return;
+    }
+
+    // Each segment is chained with the last cipher text block of the previous segment,
+    // so chains are taken before decryption that can be done in place.
+    const size_t segmentBlocksNum = (blocksNum + threadsNum - 1) / threadsNum;
+    const size_t segmentsNum = (blocksNum + segmentBlocksNum - 1) / segmentBlocksNum;
+    std::vector<std::array<unsigned char, kAesNi_BlockSize>> chains(segmentsNum);
+    chains[0] = chain_;
+    for (size_t i = 1; i < segmentsNum; ++i) {
+        std::memcpy(chains[i].data(), input + (i * segmentBlocksNum - 1) * kAesNi_BlockSize, kAesNi_BlockSize);
+    }
+    std::memcpy(chain_.data(), input + dataSize - kAesNi_BlockSize, kAesNi_BlockSize);
+
+    const unsigned char* roundKeys = roundKeys_.data();
+    const size_t rounds = rounds_;
+    auto decryptSegment = [&](size_t i) {
+        const size_t offset = i * segmentBlocksNum;
+        const size_t segmentSize = std::min(segmentBlocksNum, blocksNum - offset);
+        cbc_decrypt_blocks(roundKeys, rounds, chains[i].data(),
+                input + offset * kAesNi_BlockSize, output + offset * kAesNi_BlockSize, segmentSize);
+    };
+
+    parallel_for(segmentsNum, threadsNum, decryptSegment);
+}
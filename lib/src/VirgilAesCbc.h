@@ -0,0 +1,136 @@
+/**
+ * Copyright (C) 2015-2018 Virgil Security Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *     (3) Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+ */
+
+#ifndef VIRGIL_CRYPTO_AES_CBC_H
+#define VIRGIL_CRYPTO_AES_CBC_H
+
+#include <array>
+#include <cstddef>
+
+#include "VirgilAesNi.h"
+
+namespace virgil { namespace crypto { namespace foundation { namespace internal {
+
+/**
+ * @brief AES-CBC decryption based on the AES-NI instructions.
+ *
+ * CBC decryption has no dependency between blocks, so 8 blocks are decrypted at once,
+ *     and large inputs can be split between several threads, see setThreadsNum().
+ *
+ * @note Use isSupported() to check whether this implementation can be used on the current CPU,
+ *     otherwise generic implementation of the underlying crypto library should be used.
+ *
+ * Usage: setKey(), start(), update() - any number of times, finish().
+ */
+class VirgilAesCbc {
+public:
+    /**
+     * @brief Return true if this implementation can be used on the current CPU for the given key size.
+     * @param keySize - key size in octets, 16 and 32 are supported.
+     */
+    static bool isSupported(size_t keySize);
+
+    VirgilAesCbc();
+
+    ~VirgilAesCbc() noexcept;
+
+    /**
+     * @brief Define number of threads used to decrypt large inputs, 1 by default.
+     * @note Threads are used only if single update() is given several megabytes.
+     */
+    void setThreadsNum(size_t threadsNum);
+
+    /**
+     * @brief Configure decryption key.
+     * @throw VirgilCryptoException with VirgilCryptoError::InvalidArgument, if key size is not supported.
+     */
+    void setKey(const unsigned char* key, size_t keySize);
+
+    /**
+     * @brief Start new decryption.
+     * @param hasPadding - if true, PKCS#7 padding is removed, otherwise input MUST be aligned to the block size.
+     * @throw VirgilCryptoException with VirgilCryptoError::InvalidArgument, if IV size is not equal to block size.
+     * @throw VirgilCryptoException with VirgilCryptoError::InvalidState, if key is not set.
+     */
+    void start(const unsigned char* iv, size_t ivSize, bool hasPadding);
+
+    /**
+     * @brief Decrypt given data.
+     *
+     * The last block is hold until finish() if padding is used.
+     *
+     * @param output - buffer at least of inputSize + block size octets.
+     * @return Number of written octets.
+     */
+    size_t update(const unsigned char* input, size_t inputSize, unsigned char* output);
+
+    /**
+     * @brief Decrypt the last block and remove padding.
+     * @param output - buffer at least of block size octets.
+     * @return Number of written octets.
+     * @throw VirgilCryptoException with VirgilCryptoError::InvalidState, if data is not aligned or padding is invalid.
+     */
+    size_t finish(unsigned char* output);
+
+    /**
+     * @brief Reset all data including key.
+     */
+    void clear() noexcept;
+
+    VirgilAesCbc(const VirgilAesCbc&) = delete;
+
+    VirgilAesCbc& operator=(const VirgilAesCbc&) = delete;
+
+private:
+    void checkStarted() const;
+
+    void decryptBlocks(const unsigned char* input, size_t blocksNum, unsigned char* output);
+
+private:
+    std::array<unsigned char, kAesNi_RoundKeysSizeMax> roundKeys_;
+    size_t rounds_;
+    std::array<unsigned char, kAesNi_BlockSize> chain_;
+    std::array<unsigned char, kAesNi_BlockSize> buffer_;
+    size_t bufferLen_;
+    bool hasPadding_;
+    bool hasKey_;
+    bool isStarted_;
+    size_t threadsNum_;
+};
+
+}}}}
+
+#endif /* VIRGIL_CRYPTO_AES_CBC_H */
@@ -0,0 +1,471 @@
+/**
+ * Copyright (C) 2015-2018 Virgil Security Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *     (3) Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+ */
+
+#include "VirgilAesGcm.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <virgil/crypto/VirgilCryptoError.h>
+
+#include "VirgilAesNi.h"
+
+using virgil::crypto::VirgilCryptoError;
+using virgil::crypto::make_error;
+using virgil::crypto::foundation::internal::VirgilAesGcm;
+
+constexpr size_t VirgilAesGcm::kTagSize;
+
+namespace virgil { namespace crypto { namespace foundation { namespace internal {
+
+static constexpr size_t kAes_ParallelBlocks = 8;
+// GCM limits plain text to 2^39 - 256 bits for one IV.
+static constexpr uint64_t kDataSizeMax = (uint64_t(1) << 36) - 32;
+
+static inline void store64_be(unsigned char* dst, uint64_t value) {
+    for (int i = 7; i >= 0; --i) {
+        dst[i] = (unsigned char) value;
+        value >>= 8;
+    }
+}
+
+#if VIRGIL_CRYPTO_X86_INTRINSICS
+
+/**
+ * @brief Accumulate carry-less product of a and b, without reduction.
+ */
+VIRGIL_CRYPTO_AESNI_TARGET
+static inline void clmul_accumulate(__m128i a, __m128i b, __m128i& lo, __m128i& mid, __m128i& hi) {
+    lo = _mm_xor_si128(lo, _mm_clmulepi64_si128(a, b, 0x00));
+    hi = _mm_xor_si128(hi, _mm_clmulepi64_si128(a, b, 0x11));
+    mid = _mm_xor_si128(mid, _mm_clmulepi64_si128(a, b, 0x10));
+    mid = _mm_xor_si128(mid, _mm_clmulepi64_si128(a, b, 0x01));
+}
+
+/**
+ * @brief Reduce accumulated 256-bit product modulo GCM polynomial (for the bit-reflected operands).
+ */
+VIRGIL_CRYPTO_AESNI_TARGET
+static inline __m128i ghash_reduce(__m128i lo, __m128i mid, __m128i hi) {
+    lo = _mm_xor_si128(lo, _mm_slli_si128(mid, 8));
+    hi = _mm_xor_si128(hi, _mm_srli_si128(mid, 8));
+
+    // Shift 256-bit value hi:lo left by 1 bit, because operands are bit-reflected.
+    __m128i carryLo = _mm_srli_epi32(lo, 31);
+    __m128i carryHi = _mm_srli_epi32(hi, 31);
+    lo = _mm_slli_epi32(lo, 1);
+    hi = _mm_slli_epi32(hi, 1);
+    const __m128i carryMid = _mm_srli_si128(carryLo, 12);
+    carryHi = _mm_slli_si128(carryHi, 4);
+    carryLo = _mm_slli_si128(carryLo, 4);
+    lo = _mm_or_si128(lo, carryLo);
+    hi = _mm_or_si128(hi, carryHi);
+    hi = _mm_or_si128(hi, carryMid);
+
+    // Reduce modulo x^128 + x^7 + x^2 + x + 1.
+    __m128i t1 = _mm_xor_si128(_mm_xor_si128(_mm_slli_epi32(lo, 31), _mm_slli_epi32(lo, 30)), _mm_slli_epi32(lo, 25));
+    const __m128i t2 = _mm_srli_si128(t1, 4);
+    t1 = _mm_slli_si128(t1, 12);
+    lo = _mm_xor_si128(lo, t1);
+    __m128i t3 = _mm_xor_si128(_mm_xor_si128(_mm_srli_epi32(lo, 1), _mm_srli_epi32(lo, 2)), _mm_srli_epi32(lo, 7));
+    t3 = _mm_xor_si128(t3, t2);
+    lo = _mm_xor_si128(lo, t3);
+    return _mm_xor_si128(hi, lo);
+}
+
+VIRGIL_CRYPTO_AESNI_TARGET
+static inline __m128i ghash_mul(__m128i a, __m128i b) {
+    __m128i lo = _mm_setzero_si128(), mid = _mm_setzero_si128(), hi = _mm_setzero_si128();
+    clmul_accumulate(a, b, lo, mid, hi);
+    return ghash_reduce(lo, mid, hi);
+}
+
+/**
+ * @brief Compute H = E(K, 0) and its powers H^1..H^8 in the bit-reflected form.
+ */
+VIRGIL_CRYPTO_AESNI_TARGET
+static void ghash_init(const unsigned char* roundKeys, size_t rounds, unsigned char* hPowers) {
+    unsigned char zero[kAesNi_BlockSize] = { 0 };
+    unsigned char h[kAesNi_BlockSize];
+    aes_encrypt_block(roundKeys, rounds, zero, h);
+    const __m128i h1 = bswap128(load128(h));
+    __m128i hi = h1;
+    store128(hPowers, hi);
+    for (size_t i = 1; i < kAes_ParallelBlocks; ++i) {
+        hi = ghash_mul(hi, h1);
+        store128(hPowers + i * kAesNi_BlockSize, hi);
+    }
+    secure_zeroize(h, sizeof(h));
+}
+
+/**
+ * @brief Absorb given number of full blocks to the GHASH accumulator.
+ */
+VIRGIL_CRYPTO_AESNI_TARGET
+static void ghash_blocks(const unsigned char* hPowers, unsigned char* ghash, const unsigned char* data, size_t blocksNum) {
+    __m128i x = load128(ghash);
+    const __m128i h1 = load128(hPowers);
+    if (blocksNum >= kAes_ParallelBlocks) {
+        __m128i h[kAes_ParallelBlocks];
+        VIRGIL_CRYPTO_UNROLL_BLOCKS
+        for (size_t i = 0; i < kAes_ParallelBlocks; ++i) {
+            h[i] = load128(hPowers + i * kAesNi_BlockSize);
+        }
+        // X = (X + C0) * H^8 + C1 * H^7 + ... + C7 * H
+        for (; blocksNum >= kAes_ParallelBlocks; blocksNum -= kAes_ParallelBlocks) {
+            __m128i lo = _mm_setzero_si128(), mid = _mm_setzero_si128(), hi = _mm_setzero_si128();
+            VIRGIL_CRYPTO_UNROLL_BLOCKS
+            for (size_t i = 0; i < kAes_ParallelBlocks; ++i) {
+                __m128i block = bswap128(load128(data + i * kAesNi_BlockSize));
+                if (i == 0) {
+                    block = _mm_xor_si128(block, x);
+                }
+                clmul_accumulate(block, h[kAes_ParallelBlocks - 1 - i], lo, mid, hi);
+            }
+            x = ghash_reduce(lo, mid, hi);
+            data += kAes_ParallelBlocks * kAesNi_BlockSize;
+        }
+    }
+    for (; blocksNum > 0; --blocksNum, data += kAesNi_BlockSize) {
+        x = ghash_mul(_mm_xor_si128(x, bswap128(load128(data))), h1);
+    }
+    store128(ghash, x);
+}
+
+/**
+ * @brief Encrypt or decrypt given number of full blocks in the counter mode and update GHASH accumulator.
+ *
+ * Counter blocks are encrypted by 8 at once, and GHASH for them is computed with single reduction.
+ */
+VIRGIL_CRYPTO_AESNI_TARGET
+static void gcm_crypt_blocks(
+        const unsigned char* roundKeys, size_t rounds, const unsigned char* hPowers,
+        unsigned char* counter, unsigned char* ghash,
+        const unsigned char* input, unsigned char* output, size_t blocksNum, bool isEncryption) {
+
+    __m128i rk[15];
+    for (size_t i = 0; i <= rounds; ++i) {
+        rk[i] = load128(roundKeys + i * kAesNi_BlockSize);
+    }
+    __m128i h[kAes_ParallelBlocks];
+    VIRGIL_CRYPTO_UNROLL_BLOCKS
+    for (size_t i = 0; i < kAes_ParallelBlocks; ++i) {
+        h[i] = load128(hPowers + i * kAesNi_BlockSize);
+    }
+    // Counter is a big-endian 32-bit number in the last 4 bytes, so after the byte swap it is the first lane.
+    __m128i ctr = bswap128(load128(counter));
+    __m128i x = load128(ghash);
+
+    for (; blocksNum >= kAes_ParallelBlocks; blocksNum -= kAes_ParallelBlocks) {
+        __m128i blocks[kAes_ParallelBlocks];
+        VIRGIL_CRYPTO_UNROLL_BLOCKS
+        for (size_t i = 0; i < kAes_ParallelBlocks; ++i) {
+            blocks[i] = _mm_xor_si128(bswap128(_mm_add_epi32(ctr, _mm_set_epi32(0, 0, 0, (int) i))), rk[0]);
+        }
+        ctr = _mm_add_epi32(ctr, _mm_set_epi32(0, 0, 0, (int) kAes_ParallelBlocks));
+        for (size_t r = 1; r < rounds; ++r) {
+            VIRGIL_CRYPTO_UNROLL_BLOCKS
+            for (size_t i = 0; i < kAes_ParallelBlocks; ++i) {
+                blocks[i] = _mm_aesenc_si128(blocks[i], rk[r]);
+            }
+        }
+
+        __m128i lo = _mm_setzero_si128(), mid = _mm_setzero_si128(), hi = _mm_setzero_si128();
+        VIRGIL_CRYPTO_UNROLL_BLOCKS
+        for (size_t i = 0; i < kAes_ParallelBlocks; ++i) {
+            const __m128i in = load128(input + i * kAesNi_BlockSize);
+            const __m128i out = _mm_xor_si128(in, _mm_aesenclast_si128(blocks[i], rk[rounds]));
+            store128(output + i * kAesNi_BlockSize, out);
+            __m128i cipherBlock = bswap128(isEncryption ? out : in);
+            if (i == 0) {
+                cipherBlock = _mm_xor_si128(cipherBlock, x);
+            }
+            clmul_accumulate(cipherBlock, h[kAes_ParallelBlocks - 1 - i], lo, mid, hi);
+        }
+        x = ghash_reduce(lo, mid, hi);
+
+        input += kAes_ParallelBlocks * kAesNi_BlockSize;
+        output += kAes_ParallelBlocks * kAesNi_BlockSize;
+    }
+
+    for (; blocksNum > 0; --blocksNum) {
+        const __m128i keyStream = aes_encrypt(rk, rounds, bswap128(ctr));
+        ctr = _mm_add_epi32(ctr, _mm_set_epi32(0, 0, 0, 1));
+        const __m128i in = load128(input);
+        const __m128i out = _mm_xor_si128(in, keyStream);
+        store128(output, out);
+        x = ghash_mul(_mm_xor_si128(x, bswap128(isEncryption ? out : in)), h[0]);
+        input += kAesNi_BlockSize;
+        output += kAesNi_BlockSize;
+    }
+
+    store128(counter, bswap128(ctr));
+    store128(ghash, x);
+    secure_zeroize(rk, sizeof(rk));
+}
+
+/**
+ * @brief Write E(K, counter) to the key stream and increment counter.
+ */
+VIRGIL_CRYPTO_AESNI_TARGET
+static void ctr_key_stream(
+        const unsigned char* roundKeys, size_t rounds, unsigned char* counter, unsigned char* keyStream) {
+    aes_encrypt_block(roundKeys, rounds, counter, keyStream);
+    const __m128i ctr = _mm_add_epi32(bswap128(load128(counter)), _mm_set_epi32(0, 0, 0, 1));
+    store128(counter, bswap128(ctr));
+}
+
+#else
+
+static void ghash_init(const unsigned char*, size_t, unsigned char*) {
+    throw make_error(VirgilCryptoError::UnsupportedAlgorithm, "AES-NI is not supported by the target platform.");
+}
+
+static void ghash_blocks(const unsigned char*, unsigned char*, const unsigned char*, size_t) {
+    throw make_error(VirgilCryptoError::UnsupportedAlgorithm, "AES-NI is not supported by the target platform.");
+}
+
+static void gcm_crypt_blocks(
+        const unsigned char*, size_t, const unsigned char*, unsigned char*, unsigned char*,
+        const unsigned char*, unsigned char*, size_t, bool) {
+    throw make_error(VirgilCryptoError::UnsupportedAlgorithm, "AES-NI is not supported by the target platform.");
+}
+
+static void ctr_key_stream(const unsigned char*, size_t, unsigned char*, unsigned char*) {
+    throw make_error(VirgilCryptoError::UnsupportedAlgorithm, "AES-NI is not supported by the target platform.");
+}
+
+#endif // VIRGIL_CRYPTO_X86_INTRINSICS
+
+}}}}
+
+bool VirgilAesGcm::isSupported(size_t keySize) {
+    return (keySize == 16 || keySize == 32) && cpu_has_aesni_pclmul();
+}
+
+VirgilAesGcm::VirgilAesGcm() {
+    clear();
+}
+
+VirgilAesGcm::~VirgilAesGcm() noexcept {
+    clear();
+}
+
+void VirgilAesGcm::clear() noexcept {
+    secure_zeroize(roundKeys_.data(), roundKeys_.size());
+    secure_zeroize(hPowers_.data(), hPowers_.size());
+    secure_zeroize(j0_.data(), j0_.size());
+    secure_zeroize(counter_.data(), counter_.size());
+    secure_zeroize(ghash_.data(), ghash_.size());
+    secure_zeroize(keyStream_.data(), keyStream_.size());
+    secure_zeroize(ghashBuffer_.data(), ghashBuffer_.size());
+    rounds_ = 0;
+    keyStreamPos_ = kAesNi_BlockSize;
+    ghashBufferLen_ = 0;
+    authDataSize_ = 0;
+    dataSize_ = 0;
+    hasKey_ = false;
+    hasIV_ = false;
+    isStarted_ = false;
+}
+
+void VirgilAesGcm::setKey(const unsigned char* key, size_t keySize) {
+    if (!isSupported(keySize)) {
+        throw make_error(VirgilCryptoError::InvalidArgument, "Bad key for symmetric cipher.");
+    }
+    rounds_ = aes_expand_key(key, keySize, roundKeys_.data());
+    ghash_init(roundKeys_.data(), rounds_, hPowers_.data());
+    hasKey_ = true;
+    hasIV_ = false;
+    isStarted_ = false;
+}
+
+void VirgilAesGcm::setIV(const unsigned char* iv, size_t ivSize) {
+    if (ivSize == 0) {
+        throw make_error(VirgilCryptoError::InvalidArgument, "Bad input vector for symmetric cipher.");
+    }
+    if (!hasKey_) {
+        throw make_error(VirgilCryptoError::InvalidState, "Key must be set before input vector.");
+    }
+    if (ivSize == 12) {
+        std::memcpy(j0_.data(), iv, ivSize);
+        j0_[12] = j0_[13] = j0_[14] = 0;
+        j0_[15] = 1;
+    } else {
+        // J0 = GHASH(IV || 0^s || [0]64 || [len(IV)]64)
+        ghash_.fill(0);
+        const size_t fullBlocksSize = ivSize - ivSize % kAesNi_BlockSize;
+        ghash_blocks(hPowers_.data(), ghash_.data(), iv, fullBlocksSize / kAesNi_BlockSize);
+        unsigned char block[kAesNi_BlockSize] = { 0 };
+        if (fullBlocksSize < ivSize) {
+            std::memcpy(block, iv + fullBlocksSize, ivSize - fullBlocksSize);
+            ghash_blocks(hPowers_.data(), ghash_.data(), block, 1);
+        }
+        std::memset(block, 0, sizeof(block));
+        store64_be(block + 8, uint64_t(ivSize) * 8);
+        ghash_blocks(hPowers_.data(), ghash_.data(), block, 1);
+        // Accumulator is kept in the byte reflected form.
+        std::reverse_copy(ghash_.begin(), ghash_.end(), j0_.begin());
+    }
+    hasIV_ = true;
+    isStarted_ = false;
+}
+
+void VirgilAesGcm::start(const unsigned char* authData, size_t authDataSize) {
+    if (!hasKey_ || !hasIV_) {
+        throw make_error(VirgilCryptoError::InvalidState, "Key and input vector must be set.");
+    }
+    counter_ = j0_;
+    // Data is encrypted starting from inc32(J0).
+    ctr_key_stream(roundKeys_.data(), rounds_, counter_.data(), keyStream_.data());
+    keyStreamPos_ = kAesNi_BlockSize;
+    ghash_.fill(0);
+    ghashBufferLen_ = 0;
+    authDataSize_ = authDataSize;
+    dataSize_ = 0;
+    isStarted_ = true;
+
+    ghashUpdate(authData, authDataSize);
+    ghashPad();
+}
+
+void VirgilAesGcm::encrypt(const unsigned char* input, size_t inputSize, unsigned char* output) {
+    crypt(input, inputSize, output, true);
+}
+
+void VirgilAesGcm::decrypt(const unsigned char* input, size_t inputSize, unsigned char* output) {
+    crypt(input, inputSize, output, false);
+}
+
+void VirgilAesGcm::finish(unsigned char* tag) {
+    checkStarted();
+    ghashPad();
+
+    unsigned char lengths[kAesNi_BlockSize];
+    store64_be(lengths, authDataSize_ * 8);
+    store64_be(lengths + 8, dataSize_ * 8);
+    ghash_blocks(hPowers_.data(), ghash_.data(), lengths, 1);
+
+    // T = E(K, J0) xor GHASH
+    unsigned char encryptedJ0[kAesNi_BlockSize];
+    aes_encrypt_block(roundKeys_.data(), rounds_, j0_.data(), encryptedJ0);
+    for (size_t i = 0; i < kTagSize; ++i) {
+        tag[i] = encryptedJ0[i] ^ ghash_[kAesNi_BlockSize - 1 - i];
+    }
+    secure_zeroize(encryptedJ0, sizeof(encryptedJ0));
+    isStarted_ = false;
+}
+
+void VirgilAesGcm::checkStarted() const {
+    if (!isStarted_) {
+        throw make_error(VirgilCryptoError::InvalidState, "Cipher is not started.");
+    }
+}
+
+void VirgilAesGcm::crypt(const unsigned char* input, size_t inputSize, unsigned char* output, bool isEncryption) {
+    checkStarted();
+    if (inputSize > kDataSizeMax - dataSize_) {
+        throw make_error(VirgilCryptoError::InvalidState, "Too much data is processed with the same input vector.");
+    }
+    dataSize_ += inputSize;
+
+    // Finish the previous partial block, it is aligned with partial GHASH block.
+    while (inputSize > 0 && keyStreamPos_ < kAesNi_BlockSize) {
+        const unsigned char in = *input++;
+        const unsigned char out = in ^ keyStream_[keyStreamPos_++];
+        ghashUpdate(isEncryption ? &out : &in, 1);
+        *output++ = out;
+        --inputSize;
+    }
+
+    const size_t blocksNum = inputSize / kAesNi_BlockSize;
+    if (blocksNum > 0) {
+        gcm_crypt_blocks(roundKeys_.data(), rounds_, hPowers_.data(), counter_.data(), ghash_.data(),
+                input, output, blocksNum, isEncryption);
+        input += blocksNum * kAesNi_BlockSize;
+        output += blocksNum * kAesNi_BlockSize;
+        inputSize -= blocksNum * kAesNi_BlockSize;
+    }
+
+    if (inputSize > 0) {
+        ctr_key_stream(roundKeys_.data(), rounds_, counter_.data(), keyStream_.data());
+        keyStreamPos_ = 0;
+        if (!isEncryption) {
+            ghashUpdate(input, inputSize);
+        }
+        for (size_t i = 0; i < inputSize; ++i) {
+            output[i] = input[i] ^ keyStream_[keyStreamPos_++];
+        }
+        if (isEncryption) {
+            ghashUpdate(output, inputSize);
+        }
+    }
+}
+
+void VirgilAesGcm::ghashUpdate(const unsigned char* data, size_t dataSize) {
+    if (ghashBufferLen_ > 0) {
+        const size_t fillSize = std::min(dataSize, ghashBuffer_.size() - ghashBufferLen_);
+        std::memcpy(ghashBuffer_.data() + ghashBufferLen_, data, fillSize);
+        ghashBufferLen_ += fillSize;
+        data += fillSize;
+        dataSize -= fillSize;
+        if (ghashBufferLen_ < ghashBuffer_.size()) {
+            return;
+        }
+        ghash_blocks(hPowers_.data(), ghash_.data(), ghashBuffer_.data(), 1);
+        ghashBufferLen_ = 0;
+    }
+
+    const size_t blocksNum = dataSize / kAesNi_BlockSize;
+    if (blocksNum > 0) {
+        ghash_blocks(hPowers_.data(), ghash_.data(), data, blocksNum);
+        data += blocksNum * kAesNi_BlockSize;
+        dataSize -= blocksNum * kAesNi_BlockSize;
+    }
+
+    if (dataSize > 0) {
+        std::memcpy(ghashBuffer_.data(), data, dataSize);
+        ghashBufferLen_ = dataSize;
+    }
+}
+
+void VirgilAesGcm::ghashPad() {
+    if (ghashBufferLen_ > 0) {
+        std::memset(ghashBuffer_.data() + ghashBufferLen_, 0, ghashBuffer_.size() - ghashBufferLen_);
+        ghash_blocks(hPowers_.data(), ghash_.data(), ghashBuffer_.data(), 1);
+        ghashBufferLen_ = 0;
+    }
+}
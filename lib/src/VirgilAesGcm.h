@@ -0,0 +1,145 @@
+/**
+ * Copyright (C) 2015-2018 Virgil Security Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *     (3) Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+ */
+
+#ifndef VIRGIL_CRYPTO_AES_GCM_H
+#define VIRGIL_CRYPTO_AES_GCM_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace virgil { namespace crypto { namespace foundation { namespace internal {
+
+/**
+ * @brief AES-GCM cipher based on the AES-NI and PCLMULQDQ instructions.
+ *
+ * Counter mode encrypts 8 blocks at once, so independent AES rounds are interleaved,
+ *     and GHASH is computed over 8 blocks with single reduction, using precomputed powers of H.
+ *
+ * @note Use isSupported() to check whether this implementation can be used on the current CPU,
+ *     otherwise generic implementation of the underlying crypto library should be used.
+ *
+ * Usage: setKey(), setIV(), start(), encrypt() / decrypt() - any number of times, finish().
+ */
+class VirgilAesGcm {
+public:
+    static constexpr size_t kTagSize = 16; ///< Authentication tag size in octets
+
+    /**
+     * @brief Return true if this implementation can be used on the current CPU for the given key size.
+     * @param keySize - key size in octets, 16 and 32 are supported.
+     */
+    static bool isSupported(size_t keySize);
+
+    VirgilAesGcm();
+
+    ~VirgilAesGcm() noexcept;
+
+    /**
+     * @brief Configure key and precompute GHASH key powers.
+     * @throw VirgilCryptoException with VirgilCryptoError::InvalidArgument, if key size is not supported.
+     */
+    void setKey(const unsigned char* key, size_t keySize);
+
+    /**
+     * @brief Configure initialization vector.
+     * @throw VirgilCryptoException with VirgilCryptoError::InvalidArgument, if IV is empty.
+     * @throw VirgilCryptoException with VirgilCryptoError::InvalidState, if key is not set.
+     */
+    void setIV(const unsigned char* iv, size_t ivSize);
+
+    /**
+     * @brief Start new encryption / decryption with given additional authenticated data.
+     * @throw VirgilCryptoException with VirgilCryptoError::InvalidState, if key or IV is not set.
+     */
+    void start(const unsigned char* authData, size_t authDataSize);
+
+    /**
+     * @brief Encrypt given data.
+     * @note Output MAY be the same as input.
+     */
+    void encrypt(const unsigned char* input, size_t inputSize, unsigned char* output);
+
+    /**
+     * @brief Decrypt given data.
+     * @note Output MAY be the same as input.
+     */
+    void decrypt(const unsigned char* input, size_t inputSize, unsigned char* output);
+
+    /**
+     * @brief Finish encryption / decryption and write authentication tag of kTagSize octets.
+     */
+    void finish(unsigned char* tag);
+
+    /**
+     * @brief Reset all data including key and IV.
+     */
+    void clear() noexcept;
+
+    VirgilAesGcm(const VirgilAesGcm&) = delete;
+
+    VirgilAesGcm& operator=(const VirgilAesGcm&) = delete;
+
+private:
+    void checkStarted() const;
+
+    void crypt(const unsigned char* input, size_t inputSize, unsigned char* output, bool isEncryption);
+
+    void ghashUpdate(const unsigned char* data, size_t dataSize);
+
+    void ghashPad();
+
+private:
+    std::array<unsigned char, 15 * 16> roundKeys_;
+    size_t rounds_;
+    std::array<unsigned char, 8 * 16> hPowers_;
+    std::array<unsigned char, 16> j0_;
+    std::array<unsigned char, 16> counter_;
+    std::array<unsigned char, 16> ghash_;
+    std::array<unsigned char, 16> keyStream_;
+    size_t keyStreamPos_;
+    std::array<unsigned char, 16> ghashBuffer_;
+    size_t ghashBufferLen_;
+    uint64_t authDataSize_;
+    uint64_t dataSize_;
+    bool hasKey_;
+    bool hasIV_;
+    bool isStarted_;
+};
+
+}}}}
+
+#endif /* VIRGIL_CRYPTO_AES_GCM_H */
@@ -0,0 +1,190 @@
+/**
+ * Copyright (C) 2015-2018 Virgil Security Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *     (3) Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+ */
+
+#ifndef VIRGIL_CRYPTO_AES_NI_H
+#define VIRGIL_CRYPTO_AES_NI_H
+
+#include <cstddef>
+
+#include <virgil/crypto/VirgilCryptoError.h>
+
+#include "VirgilCpuFeatures.h"
+
+#if VIRGIL_CRYPTO_X86_INTRINSICS
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief Ask compiler to unroll loop over parallel blocks, so blocks are kept in registers.
+ */
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 8)
+#define VIRGIL_CRYPTO_UNROLL_BLOCKS _Pragma("GCC unroll 8")
+#else
+#define VIRGIL_CRYPTO_UNROLL_BLOCKS
+#endif
+
+namespace virgil { namespace crypto { namespace foundation { namespace internal {
+
+//  Common AES-NI primitives shared by the built-in AES modes implementations.
+
+constexpr size_t kAesNi_BlockSize = 16;
+
+constexpr size_t kAesNi_RoundKeysSizeMax = 15 * kAesNi_BlockSize;
+
+/**
+ * @brief Zeroize memory, so it is not optimized out by compiler.
+ */
+inline void secure_zeroize(void* data, size_t dataSize) {
+    volatile unsigned char* p = static_cast<volatile unsigned char*>(data);
+    while (dataSize--) {
+        *p++ = 0;
+    }
+}
+
+#if VIRGIL_CRYPTO_X86_INTRINSICS
+
+#define VIRGIL_CRYPTO_AESNI_TARGET __attribute__((target("aes,pclmul,sse4.1")))
+
+VIRGIL_CRYPTO_AESNI_TARGET
+inline __m128i load128(const unsigned char* src) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+}
+
+VIRGIL_CRYPTO_AESNI_TARGET
+inline void store128(unsigned char* dst, __m128i value) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), value);
+}
+
+VIRGIL_CRYPTO_AESNI_TARGET
+inline __m128i bswap128(__m128i value) {
+    return _mm_shuffle_epi8(value, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+}
+
+VIRGIL_CRYPTO_AESNI_TARGET
+inline __m128i aes128_expand_step(__m128i key, __m128i keygened) {
+    keygened = _mm_shuffle_epi32(keygened, 0xff);
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    return _mm_xor_si128(key, keygened);
+}
+
+VIRGIL_CRYPTO_AESNI_TARGET
+inline __m128i aes256_expand_step_odd(__m128i key, __m128i prevKey) {
+    const __m128i keygened = _mm_shuffle_epi32(_mm_aeskeygenassist_si128(prevKey, 0x00), 0xaa);
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    return _mm_xor_si128(key, keygened);
+}
+
+/**
+ * @brief Expand AES key to the round keys and return number of rounds.
+ */
+VIRGIL_CRYPTO_AESNI_TARGET
+inline size_t aes_expand_key(const unsigned char* key, size_t keySize, unsigned char* roundKeys) {
+    __m128i rk[15];
+    if (keySize == 16) {
+        rk[0] = load128(key);
+        rk[1] = aes128_expand_step(rk[0], _mm_aeskeygenassist_si128(rk[0], 0x01));
+        rk[2] = aes128_expand_step(rk[1], _mm_aeskeygenassist_si128(rk[1], 0x02));
+        rk[3] = aes128_expand_step(rk[2], _mm_aeskeygenassist_si128(rk[2], 0x04));
+        rk[4] = aes128_expand_step(rk[3], _mm_aeskeygenassist_si128(rk[3], 0x08));
+        rk[5] = aes128_expand_step(rk[4], _mm_aeskeygenassist_si128(rk[4], 0x10));
+        rk[6] = aes128_expand_step(rk[5], _mm_aeskeygenassist_si128(rk[5], 0x20));
+        rk[7] = aes128_expand_step(rk[6], _mm_aeskeygenassist_si128(rk[6], 0x40));
+        rk[8] = aes128_expand_step(rk[7], _mm_aeskeygenassist_si128(rk[7], 0x80));
+        rk[9] = aes128_expand_step(rk[8], _mm_aeskeygenassist_si128(rk[8], 0x1b));
+        rk[10] = aes128_expand_step(rk[9], _mm_aeskeygenassist_si128(rk[9], 0x36));
+    } else {
+        rk[0] = load128(key);
+        rk[1] = load128(key + 16);
+        rk[2] = aes128_expand_step(rk[0], _mm_aeskeygenassist_si128(rk[1], 0x01));
+        rk[3] = aes256_expand_step_odd(rk[1], rk[2]);
+        rk[4] = aes128_expand_step(rk[2], _mm_aeskeygenassist_si128(rk[3], 0x02));
+        rk[5] = aes256_expand_step_odd(rk[3], rk[4]);
+        rk[6] = aes128_expand_step(rk[4], _mm_aeskeygenassist_si128(rk[5], 0x04));
+        rk[7] = aes256_expand_step_odd(rk[5], rk[6]);
+        rk[8] = aes128_expand_step(rk[6], _mm_aeskeygenassist_si128(rk[7], 0x08));
+        rk[9] = aes256_expand_step_odd(rk[7], rk[8]);
+        rk[10] = aes128_expand_step(rk[8], _mm_aeskeygenassist_si128(rk[9], 0x10));
+        rk[11] = aes256_expand_step_odd(rk[9], rk[10]);
+        rk[12] = aes128_expand_step(rk[10], _mm_aeskeygenassist_si128(rk[11], 0x20));
+        rk[13] = aes256_expand_step_odd(rk[11], rk[12]);
+        rk[14] = aes128_expand_step(rk[12], _mm_aeskeygenassist_si128(rk[13], 0x40));
+    }
+    const size_t rounds = keySize == 16 ? 10 : 14;
+    for (size_t i = 0; i <= rounds; ++i) {
+        store128(roundKeys + i * kAesNi_BlockSize, rk[i]);
+    }
+    secure_zeroize(rk, sizeof(rk));
+    return rounds;
+}
+
+VIRGIL_CRYPTO_AESNI_TARGET
+inline __m128i aes_encrypt(const __m128i* rk, size_t rounds, __m128i block) {
+    block = _mm_xor_si128(block, rk[0]);
+    for (size_t i = 1; i < rounds; ++i) {
+        block = _mm_aesenc_si128(block, rk[i]);
+    }
+    return _mm_aesenclast_si128(block, rk[rounds]);
+}
+
+VIRGIL_CRYPTO_AESNI_TARGET
+inline void aes_encrypt_block(
+        const unsigned char* roundKeys, size_t rounds, const unsigned char* input, unsigned char* output) {
+    __m128i rk[15];
+    for (size_t i = 0; i <= rounds; ++i) {
+        rk[i] = load128(roundKeys + i * kAesNi_BlockSize);
+    }
+    store128(output, aes_encrypt(rk, rounds, load128(input)));
+}
+
+#else
+
+inline size_t aes_expand_key(const unsigned char*, size_t, unsigned char*) {
+    throw make_error(VirgilCryptoError::UnsupportedAlgorithm, "AES-NI is not supported by the target platform.");
+}
+
+inline void aes_encrypt_block(const unsigned char*, size_t, const unsigned char*, unsigned char*) {
+    throw make_error(VirgilCryptoError::UnsupportedAlgorithm, "AES-NI is not supported by the target platform.");
+}
+
+#endif // VIRGIL_CRYPTO_X86_INTRINSICS
+
+}}}}
+
+#endif //VIRGIL_CRYPTO_AES_NI_H
@@ -0,0 +1,231 @@
+/**
+ * Copyright (C) 2015-2018 Virgil Security Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *     (3) Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+ */
+/**
+ * @file VirgilAlgorithmIdentifiers.h
+ *
+ * Precomputed DER encodings of the frequently used algorithm identifiers
+ */
+
+#ifndef VIRGIL_CRYPTO_VIRGIL_ALGORITHM_IDENTIFIERS_H
+#define VIRGIL_CRYPTO_VIRGIL_ALGORITHM_IDENTIFIERS_H
+
+#include <cstddef>
+#include <cstring>
+
+#include <mbedtls/cipher.h>
+#include <mbedtls/ecp.h>
+#include <mbedtls/md.h>
+#include <mbedtls/pk.h>
+
+namespace virgil { namespace crypto { namespace foundation { namespace asn1 { namespace internal {
+
+/**
+ * @brief DER encoding of the constant ASN.1 structure that corresponds to the given algorithm type.
+ */
+template<typename Type>
+struct DerAlgorithm {
+    Type type;
+    const unsigned char* der;
+    size_t size;
+};
+
+/**
+ * @name Hash AlgorithmIdentifier ::= SEQUENCE { algorithm OBJECT IDENTIFIER, parameters NULL }
+ */
+///@{
+static constexpr unsigned char kDer_MD5[] = {
+    0x30, 0x0C, 0x06, 0x08, 0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x02, 0x05, 0x05, 0x00
+};
+static constexpr unsigned char kDer_SHA1[] = {
+    0x30, 0x09, 0x06, 0x05, 0x2B, 0x0E, 0x03, 0x02, 0x1A, 0x05, 0x00
+};
+static constexpr unsigned char kDer_SHA224[] = {
+    0x30, 0x0D, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x04, 0x05, 0x00
+};
+static constexpr unsigned char kDer_SHA256[] = {
+    0x30, 0x0D, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x01, 0x05, 0x00
+};
+static constexpr unsigned char kDer_SHA384[] = {
+    0x30, 0x0D, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x02, 0x05, 0x00
+};
+static constexpr unsigned char kDer_SHA512[] = {
+    0x30, 0x0D, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x03, 0x05, 0x00
+};
+
+static constexpr DerAlgorithm<mbedtls_md_type_t> kDer_HashAlgorithms[] = {
+    { MBEDTLS_MD_SHA256, kDer_SHA256, sizeof(kDer_SHA256) },
+    { MBEDTLS_MD_SHA384, kDer_SHA384, sizeof(kDer_SHA384) },
+    { MBEDTLS_MD_SHA512, kDer_SHA512, sizeof(kDer_SHA512) },
+    { MBEDTLS_MD_SHA224, kDer_SHA224, sizeof(kDer_SHA224) },
+    { MBEDTLS_MD_SHA1, kDer_SHA1, sizeof(kDer_SHA1) },
+    { MBEDTLS_MD_MD5, kDer_MD5, sizeof(kDer_MD5) }
+};
+///@}
+
+/**
+ * @name Symmetric cipher OBJECT IDENTIFIER, parameters (IV) are variable
+ */
+///@{
+static constexpr unsigned char kDer_AES128_CBC[] = {
+    0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x01, 0x02
+};
+static constexpr unsigned char kDer_AES128_GCM[] = {
+    0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x01, 0x06
+};
+static constexpr unsigned char kDer_AES256_CBC[] = {
+    0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x01, 0x2A
+};
+static constexpr unsigned char kDer_AES256_GCM[] = {
+    0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x01, 0x2E
+};
+
+static constexpr DerAlgorithm<mbedtls_cipher_type_t> kDer_CipherOids[] = {
+    { MBEDTLS_CIPHER_AES_256_GCM, kDer_AES256_GCM, sizeof(kDer_AES256_GCM) },
+    { MBEDTLS_CIPHER_AES_256_CBC, kDer_AES256_CBC, sizeof(kDer_AES256_CBC) },
+    { MBEDTLS_CIPHER_AES_128_GCM, kDer_AES128_GCM, sizeof(kDer_AES128_GCM) },
+    { MBEDTLS_CIPHER_AES_128_CBC, kDer_AES128_CBC, sizeof(kDer_AES128_CBC) }
+};
+///@}
+
+/**
+ * @name Public key AlgorithmIdentifier ::= SEQUENCE { algorithm OBJECT IDENTIFIER, parameters ANY }
+ */
+///@{
+static constexpr unsigned char kDer_RSA[] = {
+    0x30, 0x0D, 0x06, 0x09, 0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01, 0x01, 0x01, 0x05, 0x00
+};
+
+static constexpr DerAlgorithm<mbedtls_pk_type_t> kDer_PublicKeyAlgorithms[] = {
+    { MBEDTLS_PK_RSA, kDer_RSA, sizeof(kDer_RSA) }
+};
+
+#define VIRGIL_DER_EC_KEY(curveOidLen) \
+    0x30, 0x09 + 2 + (curveOidLen), 0x06, 0x07, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x02, 0x01, 0x06, (curveOidLen)
+
+static constexpr unsigned char kDer_EC_SECP192R1[] = {
+    VIRGIL_DER_EC_KEY(8), 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x03, 0x01, 0x01
+};
+static constexpr unsigned char kDer_EC_SECP224R1[] = { VIRGIL_DER_EC_KEY(5), 0x2B, 0x81, 0x04, 0x00, 0x21 };
+static constexpr unsigned char kDer_EC_SECP256R1[] = {
+    VIRGIL_DER_EC_KEY(8), 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x03, 0x01, 0x07
+};
+static constexpr unsigned char kDer_EC_SECP384R1[] = { VIRGIL_DER_EC_KEY(5), 0x2B, 0x81, 0x04, 0x00, 0x22 };
+static constexpr unsigned char kDer_EC_SECP521R1[] = { VIRGIL_DER_EC_KEY(5), 0x2B, 0x81, 0x04, 0x00, 0x23 };
+static constexpr unsigned char kDer_EC_SECP192K1[] = { VIRGIL_DER_EC_KEY(5), 0x2B, 0x81, 0x04, 0x00, 0x1F };
+static constexpr unsigned char kDer_EC_SECP224K1[] = { VIRGIL_DER_EC_KEY(5), 0x2B, 0x81, 0x04, 0x00, 0x20 };
+static constexpr unsigned char kDer_EC_SECP256K1[] = { VIRGIL_DER_EC_KEY(5), 0x2B, 0x81, 0x04, 0x00, 0x0A };
+static constexpr unsigned char kDer_EC_BP256R1[] = {
+    VIRGIL_DER_EC_KEY(9), 0x2B, 0x24, 0x03, 0x03, 0x02, 0x08, 0x01, 0x01, 0x07
+};
+static constexpr unsigned char kDer_EC_BP384R1[] = {
+    VIRGIL_DER_EC_KEY(9), 0x2B, 0x24, 0x03, 0x03, 0x02, 0x08, 0x01, 0x01, 0x0B
+};
+static constexpr unsigned char kDer_EC_BP512R1[] = {
+    VIRGIL_DER_EC_KEY(9), 0x2B, 0x24, 0x03, 0x03, 0x02, 0x08, 0x01, 0x01, 0x0D
+};
+
+#undef VIRGIL_DER_EC_KEY
+
+/**
+ * @brief Algorithm identifiers of the MBEDTLS_PK_ECKEY keys, which parameters are the named curves.
+ */
+static constexpr DerAlgorithm<mbedtls_ecp_group_id> kDer_EcKeyAlgorithms[] = {
+    { MBEDTLS_ECP_DP_SECP256R1, kDer_EC_SECP256R1, sizeof(kDer_EC_SECP256R1) },
+    { MBEDTLS_ECP_DP_SECP384R1, kDer_EC_SECP384R1, sizeof(kDer_EC_SECP384R1) },
+    { MBEDTLS_ECP_DP_SECP521R1, kDer_EC_SECP521R1, sizeof(kDer_EC_SECP521R1) },
+    { MBEDTLS_ECP_DP_SECP256K1, kDer_EC_SECP256K1, sizeof(kDer_EC_SECP256K1) },
+    { MBEDTLS_ECP_DP_BP256R1, kDer_EC_BP256R1, sizeof(kDer_EC_BP256R1) },
+    { MBEDTLS_ECP_DP_BP384R1, kDer_EC_BP384R1, sizeof(kDer_EC_BP384R1) },
+    { MBEDTLS_ECP_DP_BP512R1, kDer_EC_BP512R1, sizeof(kDer_EC_BP512R1) },
+    { MBEDTLS_ECP_DP_SECP192R1, kDer_EC_SECP192R1, sizeof(kDer_EC_SECP192R1) },
+    { MBEDTLS_ECP_DP_SECP224R1, kDer_EC_SECP224R1, sizeof(kDer_EC_SECP224R1) },
+    { MBEDTLS_ECP_DP_SECP192K1, kDer_EC_SECP192K1, sizeof(kDer_EC_SECP192K1) },
+    { MBEDTLS_ECP_DP_SECP224K1, kDer_EC_SECP224K1, sizeof(kDer_EC_SECP224K1) }
+};
+///@}
+
+/**
+ * @name Key agreement AlgorithmIdentifier ::= SEQUENCE { algorithm OBJECT IDENTIFIER, parameters ANY }
+ */
+///@{
+/**
+ * @brief id-aes256-wrap, parameters are absent.
+ */
+static constexpr unsigned char kDer_AES256_Wrap[] = {
+    0x30, 0x0B, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x01, 0x2D
+};
+
+/**
+ * @brief dhSinglePass-stdDH-hkdf-sha256-scheme, parameters are id-aes256-wrap.
+ */
+static constexpr unsigned char kDer_DH_HKDF_SHA256_AES256_Wrap[] = {
+    0x30, 0x1A, 0x06, 0x0B, 0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01, 0x09, 0x10, 0x03, 0x13,
+    0x30, 0x0B, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x01, 0x2D
+};
+///@}
+
+/**
+ * @brief Find precomputed DER encoding of the given algorithm type.
+ * @return Found entry, or nullptr if algorithm is not precomputed.
+ */
+template<typename Type, size_t N>
+inline const DerAlgorithm<Type>* find_der_algorithm(const DerAlgorithm<Type> (& table)[N], Type type) noexcept {
+    for (const auto& entry : table) {
+        if (entry.type == type) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Find algorithm, which precomputed DER encoding is exactly equal to the given one.
+ * @return Found entry, or nullptr if given encoding is not precomputed.
+ */
+template<typename Type, size_t N>
+inline const DerAlgorithm<Type>* match_der_algorithm(
+        const DerAlgorithm<Type> (& table)[N], const unsigned char* der, size_t size) noexcept {
+    for (const auto& entry : table) {
+        if (entry.size == size && std::memcmp(entry.der, der, size) == 0) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+}}}}}
+
+#endif /* VIRGIL_CRYPTO_VIRGIL_ALGORITHM_IDENTIFIERS_H */
@@ -49,13 +49,36 @@ using virgil::crypto::foundation::asn1::VirgilAsn1Reader;
 using virgil::crypto::foundation::asn1::VirgilAsn1Writer;
 
 VirgilByteArray VirgilAsn1Compatible::toAsn1() const {
-    VirgilAsn1Writer asn1Writer;
+    const size_t asn1Size = calculateAsn1Size();
+    if (asn1Size == 0) {
+        return VirgilByteArray();
+    }
+    VirgilAsn1Writer asn1Writer(asn1Size);
     (void) asn1Write(asn1Writer);
     return asn1Writer.finish();
 }
 
+size_t VirgilAsn1Compatible::toAsn1(unsigned char* buffer, size_t bufferSize) const {
+    const size_t asn1Size = calculateAsn1Size();
+    if (asn1Size > bufferSize) {
+        throw make_error(VirgilCryptoError::ExceededMaxSize, "Given buffer is too small for the ASN.1 structure.");
+    }
+    if (asn1Size == 0) {
+        return 0;
+    }
+    VirgilAsn1Writer asn1Writer;
+    asn1Writer.reset(buffer, asn1Size);
+    return asn1Write(asn1Writer);
+}
+
+size_t VirgilAsn1Compatible::calculateAsn1Size() const {
+    VirgilAsn1Writer asn1Writer;
+    asn1Writer.resetSizing();
+    return asn1Write(asn1Writer);
+}
+
 void VirgilAsn1Compatible::fromAsn1(const VirgilByteArray& asn1) {
-    VirgilAsn1Reader asn1Reader(asn1);
+    VirgilAsn1Reader asn1Reader(asn1.data(), asn1.size());
     asn1Read(asn1Reader);
 }
 
@@ -50,6 +50,10 @@ VirgilAsn1Reader::VirgilAsn1Reader(const VirgilByteArray& data) : p_(0), end_(0)
     this->reset(data);
 }
 
+VirgilAsn1Reader::VirgilAsn1Reader(const unsigned char* data, size_t dataSize) : p_(0), end_(0), data_() {
+    this->reset(data, dataSize);
+}
+
 VirgilAsn1Reader::~VirgilAsn1Reader() noexcept {
     p_ = 0;
     end_ = 0;
@@ -61,6 +65,17 @@ void VirgilAsn1Reader::reset(const VirgilByteArray& data) {
     end_ = p_ + data_.size();
 }
 
+void VirgilAsn1Reader::reset(const unsigned char* data, size_t dataSize) {
+    VirgilByteArray().swap(data_);
+    // Underlying ASN.1 parser takes non-const pointer, but never modifies data.
+    p_ = const_cast<unsigned char*>(data);
+    end_ = data != nullptr ? data + dataSize : nullptr;
+}
+
+VirgilByteArray VirgilAsn1Reader::View::toBytes() const {
+    return VIRGIL_BYTE_ARRAY_FROM_PTR_AND_LEN(data, size);
+}
+
 int VirgilAsn1Reader::readInteger() {
     checkState();
     int result;
@@ -112,6 +127,18 @@ size_t VirgilAsn1Reader::readContextTag(unsigned char tag) {
 }
 
 VirgilByteArray VirgilAsn1Reader::readOctetString() {
+    return readOctetStringView().toBytes();
+}
+
+VirgilByteArray VirgilAsn1Reader::readUTF8String() {
+    return readUTF8StringView().toBytes();
+}
+
+VirgilByteArray VirgilAsn1Reader::readData() {
+    return readDataView().toBytes();
+}
+
+VirgilAsn1Reader::View VirgilAsn1Reader::readOctetStringView() {
     checkState();
     size_t len;
     system_crypto_handler(
@@ -119,10 +146,10 @@ VirgilByteArray VirgilAsn1Reader::readOctetString() {
             [](int){ std::throw_with_nested(make_error(VirgilCryptoError::InvalidFormat)); }
     );
     p_ += len;
-    return VIRGIL_BYTE_ARRAY_FROM_PTR_AND_LEN(p_ - len, len);
+    return View { p_ - len, len };
 }
 
-VirgilByteArray VirgilAsn1Reader::readUTF8String() {
+VirgilAsn1Reader::View VirgilAsn1Reader::readUTF8StringView() {
     checkState();
     size_t len;
     system_crypto_handler(
@@ -130,10 +157,10 @@ VirgilByteArray VirgilAsn1Reader::readUTF8String() {
             [](int){ std::throw_with_nested(make_error(VirgilCryptoError::InvalidFormat)); }
     );
     p_ += len;
-    return VIRGIL_BYTE_ARRAY_FROM_PTR_AND_LEN(p_ - len, len);
+    return View { p_ - len, len };
 }
 
-VirgilByteArray VirgilAsn1Reader::readData() {
+VirgilAsn1Reader::View VirgilAsn1Reader::readDataView() {
     checkState();
     size_t len;
     unsigned char* dataStart = p_;
@@ -143,7 +170,7 @@ VirgilByteArray VirgilAsn1Reader::readData() {
             [](int){ std::throw_with_nested(make_error(VirgilCryptoError::InvalidFormat)); }
     );
     p_ += len;
-    return VirgilByteArray(dataStart, p_);
+    return View { dataStart, static_cast<size_t>(p_ - dataStart) };
 }
 
 
@@ -36,7 +36,7 @@
 
 #include <virgil/crypto/foundation/asn1/VirgilAsn1Writer.h>
 
-#include <cmath>
+#include <algorithm>
 #include <cstring>
 
 #include <tinyformat/tinyformat.h>
@@ -54,26 +54,42 @@ using virgil::crypto::foundation::asn1::VirgilAsn1Writer;
 static const size_t kBufLenDefault = 128;
 
 static const size_t kAsn1TagValueSize = 1;
-static const size_t kAsn1LengthValueSize = 3;
+static const size_t kAsn1LengthValueSize = 5;
 static const size_t kAsn1IntegerValueSize = kAsn1TagValueSize + kAsn1LengthValueSize + 8;
-static const size_t kAsn1BoolValueSize = 3;
-static const size_t kAsn1NullValueSize = kAsn1TagValueSize + 1;
 static const size_t kAsn1SizeMax = 0xFFFFFFFF; // According to MbedTLS restriction on TAG: LENGTH
 static const size_t kAsn1ContextTagMax = 0x1E;
 
-#define RETURN_POINTER_DIFF_AFTER_INVOCATION(pointer, invocation) \
-do { \
-    unsigned char *before = pointer; \
-    do { invocation; } while (0); \
-    unsigned char *after = pointer; \
-    return (ptrdiff_t)(before - after); \
-} while(0);
+namespace {
 
-VirgilAsn1Writer::VirgilAsn1Writer() : p_(0), start_(0), buf_(0), bufLen_(0) {
+/**
+ * @brief Stack buffer for the small ASN.1 elements, that are written by the MbedTLS from the end.
+ */
+class SmallAsn1Buffer {
+public:
+    SmallAsn1Buffer() : p(buf + sizeof(buf)) {}
+
+    const unsigned char* data() const {
+        return p;
+    }
+
+    size_t size() const {
+        return (size_t) (buf + sizeof(buf) - p);
+    }
+
+public:
+    unsigned char buf[kAsn1IntegerValueSize];
+    unsigned char* p;
+};
+
+}
+
+VirgilAsn1Writer::VirgilAsn1Writer()
+        : mode_(Mode::None), buf_(), externalBuf_(0), bufLen_(0), capacity_(0), writtenBytes_(0) {
     this->reset();
 }
 
-VirgilAsn1Writer::VirgilAsn1Writer(size_t capacity) : p_(0), start_(0), buf_(0), bufLen_(0) {
+VirgilAsn1Writer::VirgilAsn1Writer(size_t capacity)
+        : mode_(Mode::None), buf_(), externalBuf_(0), bufLen_(0), capacity_(0), writtenBytes_(0) {
     this->reset(capacity);
 }
 
@@ -81,6 +97,25 @@ VirgilAsn1Writer::~VirgilAsn1Writer() noexcept {
     dispose();
 }
 
+VirgilAsn1Writer::VirgilAsn1Writer(VirgilAsn1Writer&& other) noexcept
+        : mode_(other.mode_), buf_(std::move(other.buf_)), externalBuf_(other.externalBuf_), bufLen_(other.bufLen_),
+          capacity_(other.capacity_), writtenBytes_(other.writtenBytes_) {
+    other.dispose();
+}
+
+VirgilAsn1Writer& VirgilAsn1Writer::operator=(VirgilAsn1Writer&& rhs) noexcept {
+    if (this != &rhs) {
+        mode_ = rhs.mode_;
+        buf_ = std::move(rhs.buf_);
+        externalBuf_ = rhs.externalBuf_;
+        bufLen_ = rhs.bufLen_;
+        capacity_ = rhs.capacity_;
+        writtenBytes_ = rhs.writtenBytes_;
+        rhs.dispose();
+    }
+    return *this;
+}
+
 void VirgilAsn1Writer::reset() {
     this->reset(kBufLenDefault);
 }
@@ -90,72 +125,90 @@ void VirgilAsn1Writer::reset(size_t capacity) {
         throw make_error(VirgilCryptoError::InvalidArgument);
     }
     dispose();
-    relocateBuffer(capacity);
+    // Buffer is allocated on the first write, so sizing and one-shot writers do not allocate twice.
+    capacity_ = capacity;
+    mode_ = Mode::Owned;
+}
+
+void VirgilAsn1Writer::reset(unsigned char* buffer, size_t bufferSize) {
+    if (buffer == nullptr || bufferSize == 0) {
+        throw make_error(VirgilCryptoError::InvalidArgument);
+    }
+    dispose();
+    externalBuf_ = buffer;
+    bufLen_ = bufferSize;
+    mode_ = Mode::External;
+}
+
+void VirgilAsn1Writer::resetSizing() {
+    dispose();
+    mode_ = Mode::Sizing;
+}
+
+bool VirgilAsn1Writer::isSizing() const {
+    return mode_ == Mode::Sizing;
 }
 
 VirgilByteArray VirgilAsn1Writer::finish() {
     checkState();
-    VirgilByteArray result = VIRGIL_BYTE_ARRAY_FROM_PTR_AND_LEN(p_, bufLen_ - (p_ - start_));
+    if (mode_ != Mode::Owned) {
+        throw make_error(VirgilCryptoError::InvalidState, "ASN.1 structure is not written to the owned buffer.");
+    }
+    VirgilByteArray result;
+    if (writtenBytes_ == buf_.size()) {
+        result.swap(buf_);
+    } else {
+        result.assign(buf_.end() - writtenBytes_, buf_.end());
+    }
     dispose();
     return result;
 }
 
 size_t VirgilAsn1Writer::writeInteger(int value) {
     checkState();
-    ensureBufferEnough(kAsn1IntegerValueSize);
-    RETURN_POINTER_DIFF_AFTER_INVOCATION(p_,
-            system_crypto_handler(
-                    mbedtls_asn1_write_int(&p_, start_, value)
-            )
+    SmallAsn1Buffer asn1;
+    system_crypto_handler(
+            mbedtls_asn1_write_int(&asn1.p, asn1.buf, value)
     );
+    return writeRaw(asn1.data(), asn1.size());
 }
 
 size_t VirgilAsn1Writer::writeBool(bool value) {
     checkState();
-    ensureBufferEnough(kAsn1BoolValueSize);
-    RETURN_POINTER_DIFF_AFTER_INVOCATION(p_,
-            system_crypto_handler(
-                    mbedtls_asn1_write_bool(&p_, start_, value)
-            )
+    SmallAsn1Buffer asn1;
+    system_crypto_handler(
+            mbedtls_asn1_write_bool(&asn1.p, asn1.buf, value)
     );
+    return writeRaw(asn1.data(), asn1.size());
 }
 
 size_t VirgilAsn1Writer::writeNull() {
     checkState();
-    ensureBufferEnough(kAsn1NullValueSize);
-    RETURN_POINTER_DIFF_AFTER_INVOCATION(p_,
-            system_crypto_handler(
-                    mbedtls_asn1_write_null(&p_, start_)
-            )
+    SmallAsn1Buffer asn1;
+    system_crypto_handler(
+            mbedtls_asn1_write_null(&asn1.p, asn1.buf)
     );
+    return writeRaw(asn1.data(), asn1.size());
 }
 
 size_t VirgilAsn1Writer::writeOctetString(const VirgilByteArray& data) {
+    return writeOctetString(data.data(), data.size());
+}
+
+size_t VirgilAsn1Writer::writeOctetString(const unsigned char* data, size_t dataSize) {
     checkState();
-    ensureBufferEnough(kAsn1TagValueSize + kAsn1LengthValueSize + data.size());
-    RETURN_POINTER_DIFF_AFTER_INVOCATION(p_,
-            system_crypto_handler(
-                    mbedtls_asn1_write_octet_string(&p_, start_, data.data(), data.size())
-            )
-    );
+    size_t len = writeRaw(data, dataSize);
+    return len + writeHeader(MBEDTLS_ASN1_OCTET_STRING, len);
 }
 
 size_t VirgilAsn1Writer::writeUTF8String(const VirgilByteArray& data) {
+    return writeUTF8String(data.data(), data.size());
+}
+
+size_t VirgilAsn1Writer::writeUTF8String(const unsigned char* data, size_t dataSize) {
     checkState();
-    ensureBufferEnough(kAsn1TagValueSize + kAsn1LengthValueSize + data.size());
-    RETURN_POINTER_DIFF_AFTER_INVOCATION(p_,
-            {
-                system_crypto_handler(
-                        mbedtls_asn1_write_raw_buffer(&p_, start_, data.data(), data.size())
-                );
-                system_crypto_handler(
-                        mbedtls_asn1_write_len(&p_, start_, data.size())
-                );
-                system_crypto_handler(
-                        mbedtls_asn1_write_tag(&p_, start_, MBEDTLS_ASN1_UTF8_STRING)
-                );
-            }
-    );
+    size_t len = writeRaw(data, dataSize);
+    return len + writeHeader(MBEDTLS_ASN1_UTF8_STRING, len);
 }
 
 size_t VirgilAsn1Writer::writeContextTag(unsigned char tag, size_t len) {
@@ -164,123 +217,134 @@ size_t VirgilAsn1Writer::writeContextTag(unsigned char tag, size_t len) {
         throw make_error(VirgilCryptoError::InvalidArgument,
                 tfm::format("ASN.1 context tag is too big %s, maximum is %s.", tag, kAsn1ContextTagMax));
     }
-    ensureBufferEnough(kAsn1TagValueSize + kAsn1LengthValueSize);
-    RETURN_POINTER_DIFF_AFTER_INVOCATION(p_,
-            {
-                system_crypto_handler(
-                        mbedtls_asn1_write_len(&p_, start_, len)
-                );
-                system_crypto_handler(
-                        mbedtls_asn1_write_tag(&p_, start_,
-                                MBEDTLS_ASN1_CONTEXT_SPECIFIC | MBEDTLS_ASN1_CONSTRUCTED | tag)
-                );
-            }
-    );
+    return writeHeader(MBEDTLS_ASN1_CONTEXT_SPECIFIC | MBEDTLS_ASN1_CONSTRUCTED | tag, len);
 }
 
 size_t VirgilAsn1Writer::writeData(const VirgilByteArray& data) {
+    return writeData(data.data(), data.size());
+}
+
+size_t VirgilAsn1Writer::writeData(const unsigned char* data, size_t dataSize) {
     checkState();
-    ensureBufferEnough(data.size());
-    RETURN_POINTER_DIFF_AFTER_INVOCATION(p_,
-            {
-                system_crypto_handler(
-                        mbedtls_asn1_write_raw_buffer(&p_, start_, data.data(), data.size())
-                );
-            }
-    );
+    return writeRaw(data, dataSize);
 }
 
 
 size_t VirgilAsn1Writer::writeOID(const std::string& oid) {
     checkState();
-    ensureBufferEnough(kAsn1TagValueSize + kAsn1LengthValueSize + oid.size());
-    RETURN_POINTER_DIFF_AFTER_INVOCATION(p_,
-            {
-                system_crypto_handler(
-                        mbedtls_asn1_write_oid(&p_, start_, oid.c_str(), oid.size())
-                );
-            }
-    );
+    size_t len = writeRaw(reinterpret_cast<const unsigned char*>(oid.data()), oid.size());
+    return len + writeHeader(MBEDTLS_ASN1_OID, len);
 }
 
 size_t VirgilAsn1Writer::writeSequence(size_t len) {
     checkState();
-    ensureBufferEnough(kAsn1TagValueSize + kAsn1LengthValueSize);
-    RETURN_POINTER_DIFF_AFTER_INVOCATION(p_,
-            {
-                system_crypto_handler(
-                        mbedtls_asn1_write_len(&p_, start_, len)
-                );
-                system_crypto_handler(
-                        mbedtls_asn1_write_tag(&p_, start_, MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE)
-                );
-            }
-    );
+    return writeHeader(MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE, len);
 }
 
 size_t VirgilAsn1Writer::writeSet(const std::vector<VirgilByteArray>& set) {
     checkState();
-
-    size_t setLength = 0;
-    for (std::vector<VirgilByteArray>::const_iterator it = set.begin(); it != set.end(); ++it) {
-        setLength += it->size();
+    // Elements are ordered by reference, so they are not copied.
+    std::vector<SetElement> elements;
+    elements.reserve(set.size());
+    size_t elementsSize = 0;
+    for (const auto& element : set) {
+        elements.push_back({ element.data(), element.size() });
+        elementsSize += element.size();
     }
-    ensureBufferEnough(kAsn1TagValueSize + kAsn1LengthValueSize + setLength);
-
-    std::vector<VirgilByteArray> orderedSet(set);
-    makeOrderedSet(orderedSet);
-    RETURN_POINTER_DIFF_AFTER_INVOCATION(p_,
-            {
-                for (std::vector<VirgilByteArray>::const_reverse_iterator it = orderedSet.rbegin();
-                     it != orderedSet.rend(); ++it) {
-                    system_crypto_handler(
-                            mbedtls_asn1_write_raw_buffer(&p_, start_, it->data(), it->size())
-                    );
-                }
-                system_crypto_handler(
-                        mbedtls_asn1_write_len(&p_, start_, setLength)
-                );
-                system_crypto_handler(
-                        mbedtls_asn1_write_tag(&p_, start_, MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SET)
-                );
-            }
-    );
+    return writeOrderedSet(elements, elementsSize);
+}
+
+size_t VirgilAsn1Writer::writeSet(const unsigned char* elements, size_t elementsSize) {
+    checkState();
+    std::vector<SetElement> splitElements = splitSet(elements, elementsSize);
+    return writeOrderedSet(splitElements, elementsSize);
 }
 
-VirgilByteArray VirgilAsn1Writer::makeComparePadding(const VirgilByteArray& asn1, size_t finalSize) {
-    VirgilByteArray result = asn1;
-    if (result.size() >= finalSize) {
-        return result;
+size_t VirgilAsn1Writer::writeSet(size_t len) {
+    checkState();
+    return writeHeader(MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SET, len);
+}
+
+size_t VirgilAsn1Writer::writeSortedSet(size_t len) {
+    checkState();
+    if (len > writtenBytes_) {
+        throw make_error(VirgilCryptoError::InvalidArgument, "SET elements are not written.");
     }
-    VirgilByteArray::value_type smallestByte = 0x00;
-    if (result.size() > 0) {
-        smallestByte = *std::min_element(result.begin(), result.end());
-        if (smallestByte != 0x00) {
-            --smallestByte;
+    if (mode_ != Mode::Sizing && len > 0) {
+        unsigned char* elements = (mode_ == Mode::External ? externalBuf_ : buf_.data()) + bufLen_ - writtenBytes_;
+        std::vector<SetElement> splitElements = splitSet(elements, len);
+        if (!std::is_sorted(splitElements.cbegin(), splitElements.cend(), VirgilAsn1Writer::compare)) {
+            std::sort(splitElements.begin(), splitElements.end(), VirgilAsn1Writer::compare);
+            VirgilByteArray orderedElements;
+            orderedElements.reserve(len);
+            for (const auto& element : splitElements) {
+                orderedElements.insert(orderedElements.end(), element.data, element.data + element.size);
+            }
+            std::memcpy(elements, orderedElements.data(), len);
         }
     }
-    result.resize(finalSize, smallestByte);
-    return result;
+    return writeSet(len);
 }
 
-bool VirgilAsn1Writer::compare(const VirgilByteArray& first, const VirgilByteArray& second) {
-    if (first.size() > second.size()) {
-        VirgilByteArray paddedSecond = makeComparePadding(second, first.size());
-        return std::lexicographical_compare(first.begin(), first.end(), paddedSecond.begin(), paddedSecond.end());
-    } else if (second.size() > first.size()) {
-        VirgilByteArray paddedFirst = makeComparePadding(first, second.size());
-        return std::lexicographical_compare(paddedFirst.begin(), paddedFirst.end(), second.begin(), second.end());
-    } else {
-        return std::lexicographical_compare(first.begin(), first.end(), second.begin(), second.end());
+std::vector<VirgilAsn1Writer::SetElement> VirgilAsn1Writer::splitSet(
+        const unsigned char* elements, size_t elementsSize) {
+    std::vector<SetElement> splitElements;
+    const unsigned char* const end = elements + elementsSize;
+    const unsigned char* element = elements;
+    while (element < end) {
+        // Underlying ASN.1 parser takes non-const pointer, but never modifies data.
+        unsigned char* p = const_cast<unsigned char*>(element) + kAsn1TagValueSize;
+        size_t len = 0;
+        system_crypto_handler(
+                mbedtls_asn1_get_len(&p, end, &len),
+                [](int) { std::throw_with_nested(make_error(VirgilCryptoError::InvalidArgument)); }
+        );
+        splitElements.push_back({ element, static_cast<size_t>(p - element) + len });
+        element = p + len;
     }
+    return splitElements;
 }
 
-void VirgilAsn1Writer::makeOrderedSet(std::vector<VirgilByteArray>& set) {
-    std::sort(set.begin(), set.end(), VirgilAsn1Writer::compare);
+size_t VirgilAsn1Writer::writeOrderedSet(std::vector<SetElement>& elements, size_t elementsSize) {
+    ensureBufferEnough(kAsn1TagValueSize + kAsn1LengthValueSize + elementsSize);
+    if (!isSizing()) {
+        std::sort(elements.begin(), elements.end(), VirgilAsn1Writer::compare);
+    }
+    for (auto it = elements.crbegin(); it != elements.crend(); ++it) {
+        (void) writeRaw(it->data, it->size);
+    }
+    return elementsSize + writeSet(elementsSize);
+}
+
+bool VirgilAsn1Writer::compare(const SetElement& first, const SetElement& second) {
+    const size_t commonSize = std::min(first.size, second.size);
+    auto mismatch = std::mismatch(first.data, first.data + commonSize, second.data);
+    if (mismatch.first != first.data + commonSize) {
+        return *mismatch.first < *mismatch.second;
+    }
+    if (first.size == second.size) {
+        return false;
+    }
+    const bool isFirstShorter = first.size < second.size;
+    const SetElement& shorter = isFirstShorter ? first : second;
+    const SetElement& longer = isFirstShorter ? second : first;
+    unsigned char padding = 0x00;
+    if (shorter.size > 0) {
+        padding = *std::min_element(shorter.data, shorter.data + shorter.size);
+        if (padding != 0x00) {
+            --padding;
+        }
+    }
+    auto differentOctet = std::find_if(longer.data + commonSize, longer.data + longer.size,
+            [padding](unsigned char octet) { return octet != padding; });
+    if (differentOctet == longer.data + longer.size) {
+        return false;
+    }
+    return isFirstShorter ? padding < *differentOctet : *differentOctet < padding;
 }
 
 void VirgilAsn1Writer::checkState() {
-    if (p_ == 0 || start_ == 0) {
+    if (mode_ == Mode::None) {
         throw make_error(VirgilCryptoError::NotInitialized);
     }
 }
@@ -289,42 +353,53 @@ void VirgilAsn1Writer::relocateBuffer(size_t newBufLen) {
     if (newBufLen < bufLen_) {
         throw make_error(VirgilCryptoError::InvalidArgument, "Required buffer size is less then current.");
     }
-    unsigned char* newBuf = new unsigned char[newBufLen];
-    size_t writtenBytes = 0;
-    if (buf_ && p_ && start_) {
-        writtenBytes = bufLen_ - (p_ - start_);
-        std::memcpy(newBuf + newBufLen - writtenBytes, p_, writtenBytes);
-        delete[] buf_;
-    }
-    buf_ = newBuf;
+    // Written data is kept at the end of the buffer.
+    buf_.insert(buf_.begin(), newBufLen - buf_.size(), 0x00);
     bufLen_ = newBufLen;
-    p_ = buf_ + bufLen_ - writtenBytes;
-    start_ = buf_;
 }
 
 void VirgilAsn1Writer::ensureBufferEnough(size_t len) {
     checkState();
-    size_t unusedSpace = (size_t) (p_ - start_);
-    if (len > unusedSpace) {
-        const size_t usedSpace = bufLen_ - unusedSpace;
-        const size_t requiredLenMin = len + usedSpace;
-       if (requiredLenMin > kAsn1SizeMax) {
-           throw make_error(VirgilCryptoError::ExceededMaxSize, "ASN.1 structure size limit was exceeded.");
-       }
-        const size_t requiredLenMax =
-                (size_t) 1 << (size_t) (std::ceil(std::log((double) requiredLenMin) / std::log(2.0)));
-        const size_t adjustedLen = requiredLenMax > kAsn1SizeMax ? kAsn1SizeMax : requiredLenMax;
-        relocateBuffer(adjustedLen);
+    const size_t requiredLenMin = len + writtenBytes_;
+    if (requiredLenMin > kAsn1SizeMax) {
+        throw make_error(VirgilCryptoError::ExceededMaxSize, "ASN.1 structure size limit was exceeded.");
+    }
+    if (requiredLenMin <= bufLen_ || mode_ == Mode::Sizing) {
+        return;
+    }
+    if (mode_ == Mode::External) {
+        throw make_error(VirgilCryptoError::ExceededMaxSize, "ASN.1 structure does not fit the given buffer.");
     }
+    const size_t grownLen = std::max(std::max(requiredLenMin, capacity_), 2 * bufLen_);
+    relocateBuffer(std::min(grownLen, kAsn1SizeMax));
 }
 
-void VirgilAsn1Writer::dispose() noexcept {
-    p_ = 0;
-    start_ = 0;
-    bufLen_ = 0;
-    if (buf_) {
-        delete[] buf_;
-        buf_ = 0;
+size_t VirgilAsn1Writer::writeRaw(const unsigned char* data, size_t dataSize) {
+    ensureBufferEnough(dataSize);
+    if (mode_ != Mode::Sizing && dataSize > 0) {
+        unsigned char* buf = mode_ == Mode::External ? externalBuf_ : buf_.data();
+        std::memcpy(buf + bufLen_ - writtenBytes_ - dataSize, data, dataSize);
     }
+    writtenBytes_ += dataSize;
+    return dataSize;
 }
 
+size_t VirgilAsn1Writer::writeHeader(unsigned char tag, size_t len) {
+    SmallAsn1Buffer asn1;
+    system_crypto_handler(
+            mbedtls_asn1_write_len(&asn1.p, asn1.buf, len)
+    );
+    system_crypto_handler(
+            mbedtls_asn1_write_tag(&asn1.p, asn1.buf, tag)
+    );
+    return writeRaw(asn1.data(), asn1.size());
+}
+
+void VirgilAsn1Writer::dispose() noexcept {
+    mode_ = Mode::None;
+    VirgilByteArray().swap(buf_);
+    externalBuf_ = 0;
+    bufLen_ = 0;
+    capacity_ = 0;
+    writtenBytes_ = 0;
+}
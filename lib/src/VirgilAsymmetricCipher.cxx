@@ -43,7 +43,6 @@
 #include <mbedtls/pk.h>
 #include <mbedtls/oid.h>
 #include <mbedtls/base64.h>
-#include <mbedtls/entropy.h>
 #include <mbedtls/ctr_drbg.h>
 #include <mbedtls/ecdh.h>
 #include <mbedtls/asn1write.h>
@@ -57,9 +56,11 @@
 #include <virgil/crypto/foundation/asn1/VirgilAsn1Writer.h>
 #include <virgil/crypto/foundation/asn1/VirgilAsn1Reader.h>
 #include "VirgilAsn1Alg.h"
+#include "VirgilAlgorithmIdentifiers.h"
 
 #include "utils.h"
 #include "mbedtls_context.h"
+#include "VirgilSharedRandom.h"
 
 using virgil::crypto::VirgilByteArray;
 using virgil::crypto::VirgilByteArrayUtils;
@@ -69,6 +70,10 @@ using virgil::crypto::foundation::VirgilAsymmetricCipher;
 using virgil::crypto::foundation::asn1::VirgilAsn1Writer;
 using virgil::crypto::foundation::asn1::VirgilAsn1Reader;
 using virgil::crypto::foundation::asn1::internal::VirgilAsn1Alg;
+using virgil::crypto::foundation::asn1::internal::find_der_algorithm;
+using virgil::crypto::foundation::asn1::internal::match_der_algorithm;
+using virgil::crypto::foundation::asn1::internal::kDer_EcKeyAlgorithms;
+using virgil::crypto::foundation::asn1::internal::kDer_PublicKeyAlgorithms;
 
 using virgil::crypto::foundation::internal::mbedtls_context;
 using virgil::crypto::foundation::internal::mbedtls_context_policy;
@@ -123,7 +128,7 @@ namespace virgil { namespace crypto { namespace foundation { namespace internal
  */
 void gen_key_pair(
         mbedtls_context<mbedtls_pk_context>& pk_ctx,
-        mbedtls_context<mbedtls_ctr_drbg_context>& ctr_drbg_ctx, unsigned int rsa_size, int rsa_exponent,
+        mbedtls_ctr_drbg_context* ctr_drbg_ctx, unsigned int rsa_size, int rsa_exponent,
         mbedtls_ecp_group_id ecp_group_id, mbedtls_fast_ec_type_t fast_ec_type) {
 
     if (rsa_size > 0) {
@@ -131,14 +136,14 @@ void gen_key_pair(
         system_crypto_handler(
                 mbedtls_rsa_gen_key(
                         mbedtls_pk_rsa(*(pk_ctx.get())), mbedtls_ctr_drbg_random,
-                        ctr_drbg_ctx.get(), rsa_size, rsa_exponent),
+                        ctr_drbg_ctx, rsa_size, rsa_exponent),
                 [](int) { std::throw_with_nested(make_error(VirgilCryptoError::UnsupportedAlgorithm)); });
     } else if (ecp_group_id != MBEDTLS_ECP_DP_NONE) {
         pk_ctx.clear().setup(MBEDTLS_PK_ECKEY);
         system_crypto_handler(
                 mbedtls_ecp_gen_key(
                         ecp_group_id, mbedtls_pk_ec(*(pk_ctx.get())),
-                        mbedtls_ctr_drbg_random, ctr_drbg_ctx.get()),
+                        mbedtls_ctr_drbg_random, ctr_drbg_ctx),
                 [](int) { std::throw_with_nested(make_error(VirgilCryptoError::UnsupportedAlgorithm)); });
     } else if (fast_ec_type != MBEDTLS_FAST_EC_NONE) {
         pk_ctx.clear().setup(mbedtls_pk_from_fast_ec_type(fast_ec_type));
@@ -152,7 +157,7 @@ void gen_key_pair(
         system_crypto_handler(
                 mbedtls_fast_ec_gen_key(
                         mbedtls_pk_fast_ec(*(pk_ctx.get())),
-                        mbedtls_ctr_drbg_random, ctr_drbg_ctx.get()),
+                        mbedtls_ctr_drbg_random, ctr_drbg_ctx),
                 [](int) { std::throw_with_nested(make_error(VirgilCryptoError::UnsupportedAlgorithm)); });
     }
 }
@@ -223,8 +228,6 @@ mbedtls_context<mbedtls_ctr_drbg_context> create_deterministic_rng_ctx(const Vir
 class VirgilAsymmetricCipher::Impl {
 public:
     internal::mbedtls_context <mbedtls_pk_context> pk_ctx;
-    mbedtls_context<mbedtls_entropy_context> entropy_ctx;
-    mbedtls_context<mbedtls_ctr_drbg_context> ctr_drbg_ctx;
 };
 
 VirgilAsymmetricCipher::VirgilAsymmetricCipher(VirgilAsymmetricCipher&& other) noexcept = default;
@@ -233,10 +236,7 @@ VirgilAsymmetricCipher& VirgilAsymmetricCipher::operator=(VirgilAsymmetricCipher
 
 VirgilAsymmetricCipher::~VirgilAsymmetricCipher() noexcept = default;
 
-VirgilAsymmetricCipher::VirgilAsymmetricCipher() : impl_(std::make_unique<Impl>()) {
-    constexpr const char pers[] = "VirgilAsymmetricCipher";
-    impl_->ctr_drbg_ctx.setup(mbedtls_entropy_func, impl_->entropy_ctx.get(), pers);
-}
+VirgilAsymmetricCipher::VirgilAsymmetricCipher() : impl_(std::make_unique<Impl>()) {}
 
 size_t VirgilAsymmetricCipher::keySize() const {
     checkState();
@@ -326,7 +326,7 @@ void VirgilAsymmetricCipher::genKeyPair(VirgilKeyPair::Type type) {
     mbedtls_ecp_group_id ecTypeId = MBEDTLS_ECP_DP_NONE;
     mbedtls_fast_ec_type_t fastEcType = MBEDTLS_FAST_EC_NONE;
     internal::key_type_set_params(type, &rsaSize, &ecTypeId, &fastEcType);
-    internal::gen_key_pair(impl_->pk_ctx, impl_->ctr_drbg_ctx, rsaSize, 65537, ecTypeId, fastEcType);
+    internal::gen_key_pair(impl_->pk_ctx, internal::shared_ctr_drbg(), rsaSize, 65537, ecTypeId, fastEcType);
 }
 
 void VirgilAsymmetricCipher::genKeyPairFromKeyMaterial(VirgilKeyPair::Type type, const VirgilByteArray& keyMaterial) {
@@ -343,7 +343,7 @@ void VirgilAsymmetricCipher::genKeyPairFromKeyMaterial(VirgilKeyPair::Type type,
     mbedtls_fast_ec_type_t fastEcType = MBEDTLS_FAST_EC_NONE;
     internal::key_type_set_params(type, &rsaSize, &ecTypeId, &fastEcType);
     auto deterministic_drbg_ctx = internal::create_deterministic_rng_ctx(keyMaterial);
-    internal::gen_key_pair(impl_->pk_ctx, deterministic_drbg_ctx, rsaSize, 65537, ecTypeId, fastEcType);
+    internal::gen_key_pair(impl_->pk_ctx, deterministic_drbg_ctx.get(), rsaSize, 65537, ecTypeId, fastEcType);
 }
 
 void VirgilAsymmetricCipher::genKeyPairFrom(const VirgilAsymmetricCipher& other) {
@@ -352,18 +352,18 @@ void VirgilAsymmetricCipher::genKeyPairFrom(const VirgilAsymmetricCipher& other)
 
     if (mbedtls_pk_can_do(other.impl_->pk_ctx.get(), MBEDTLS_PK_RSA)) {
         internal::gen_key_pair(
-                impl_->pk_ctx, impl_->ctr_drbg_ctx,
+                impl_->pk_ctx, internal::shared_ctr_drbg(),
                 mbedtls_pk_get_bitlen(other.impl_->pk_ctx.get()), 65537,
                 MBEDTLS_ECP_DP_NONE, MBEDTLS_FAST_EC_NONE);
     } else if (mbedtls_pk_can_do(other.impl_->pk_ctx.get(), MBEDTLS_PK_ECKEY)) {
         internal::gen_key_pair(
-                impl_->pk_ctx, impl_->ctr_drbg_ctx,
+                impl_->pk_ctx, internal::shared_ctr_drbg(),
                 0, 0, mbedtls_pk_ec(*(other.impl_->pk_ctx.get()))->grp.id,
                 MBEDTLS_FAST_EC_NONE);
     } else if (mbedtls_pk_can_do(other.impl_->pk_ctx.get(), MBEDTLS_PK_X25519) ||
                mbedtls_pk_can_do(other.impl_->pk_ctx.get(), MBEDTLS_PK_ED25519)) {
         internal::gen_key_pair(
-                impl_->pk_ctx, impl_->ctr_drbg_ctx,
+                impl_->pk_ctx, internal::shared_ctr_drbg(),
                 0, 0, MBEDTLS_ECP_DP_NONE,
                 mbedtls_fast_ec_get_type(mbedtls_pk_fast_ec(*(other.impl_->pk_ctx.get()))->info));
     } else {
@@ -413,7 +413,7 @@ VirgilByteArray VirgilAsymmetricCipher::computeShared(
         system_crypto_handler(
                 mbedtls_ecdh_calc_secret(
                         ecdh_ctx.get(), &sharedLen, shared.data(), shared.size(),
-                        mbedtls_ctr_drbg_random, publicContext.impl_->ctr_drbg_ctx.get()));
+                        mbedtls_ctr_drbg_random, internal::shared_ctr_drbg()));
     } else if (mbedtls_pk_can_do(publicContext.impl_->pk_ctx.get(), MBEDTLS_PK_X25519) &&
                mbedtls_pk_can_do(privateContext.impl_->pk_ctx.get(), MBEDTLS_PK_X25519)) {
 
@@ -498,13 +498,13 @@ VirgilByteArray VirgilAsymmetricCipher::exportPrivateKeyToPEM(const VirgilByteAr
 VirgilByteArray VirgilAsymmetricCipher::encrypt(const VirgilByteArray& in) const {
     checkState();
     return internal::processEncryptionDecryption(
-            mbedtls_pk_encrypt, impl_->pk_ctx.get(), impl_->ctr_drbg_ctx.get(), in);
+            mbedtls_pk_encrypt, impl_->pk_ctx.get(), internal::shared_ctr_drbg(), in);
 }
 
 VirgilByteArray VirgilAsymmetricCipher::decrypt(const VirgilByteArray& in) const {
     checkState();
     return internal::processEncryptionDecryption(
-            mbedtls_pk_decrypt, impl_->pk_ctx.get(), impl_->ctr_drbg_ctx.get(), in);
+            mbedtls_pk_decrypt, impl_->pk_ctx.get(), internal::shared_ctr_drbg(), in);
 }
 
 VirgilByteArray VirgilAsymmetricCipher::sign(const VirgilByteArray& digest, int hashType) const {
@@ -527,9 +527,11 @@ VirgilByteArray VirgilAsymmetricCipher::sign(const VirgilByteArray& digest, int
     true;
 #endif /* defined(MBEDTLS_ECDSA_DETERMINISTIC) */
 
+    // Random context is held until signing is finished.
+    auto sharedRandom = internal::shared_ctr_drbg();
     if (useRandom) {
         f_rng = mbedtls_ctr_drbg_random;
-        p_rng = impl_->ctr_drbg_ctx.get();
+        p_rng = sharedRandom;
     }
 
     system_crypto_handler(
@@ -617,23 +619,33 @@ void VirgilAsymmetricCipher::setPublicKeyBits(const VirgilByteArray& bits) {
 
 size_t VirgilAsymmetricCipher::asn1Write(VirgilAsn1Writer& asn1Writer, size_t childWrittenBytes) const {
     checkState();
+    const mbedtls_pk_type_t pkType = mbedtls_pk_get_type(impl_->pk_ctx.get());
+    const mbedtls_ecp_group_id ecGroupId =
+            pkType == MBEDTLS_PK_ECKEY ? mbedtls_pk_ec(*impl_->pk_ctx.get())->grp.id : MBEDTLS_ECP_DP_NONE;
+    if (ecGroupId != MBEDTLS_ECP_DP_NONE) {
+        auto derAlgorithm = find_der_algorithm(kDer_EcKeyAlgorithms, ecGroupId);
+        if (derAlgorithm != nullptr) {
+            return asn1Writer.writeData(derAlgorithm->der, derAlgorithm->size) + childWrittenBytes;
+        }
+    } else {
+        auto derAlgorithm = find_der_algorithm(kDer_PublicKeyAlgorithms, pkType);
+        if (derAlgorithm != nullptr) {
+            return asn1Writer.writeData(derAlgorithm->der, derAlgorithm->size) + childWrittenBytes;
+        }
+    }
     const char* oid = 0;
     size_t oidLen;
     size_t len = 0;
-    if (mbedtls_pk_get_type(impl_->pk_ctx.get()) == MBEDTLS_PK_ECKEY &&
-        mbedtls_pk_ec(*impl_->pk_ctx.get())->grp.id != MBEDTLS_ECP_DP_NONE) {
+    if (ecGroupId != MBEDTLS_ECP_DP_NONE) {
         system_crypto_handler(
-                mbedtls_oid_get_oid_by_ec_grp(mbedtls_pk_ec(*impl_->pk_ctx.get())->grp.id, &oid, &oidLen),
+                mbedtls_oid_get_oid_by_ec_grp(ecGroupId, &oid, &oidLen),
                 [](int) { std::throw_with_nested(make_error(VirgilCryptoError::UnsupportedAlgorithm)); });
         len += asn1Writer.writeOID(std::string(oid, oidLen));
     } else {
         len += asn1Writer.writeNull();
     }
     system_crypto_handler(
-            mbedtls_oid_get_oid_by_pk_alg(mbedtls_pk_get_type(impl_->pk_ctx.get()), &oid, &oidLen),
-            [](int) { std::throw_with_nested(make_error(VirgilCryptoError::UnsupportedAlgorithm)); });
-    system_crypto_handler(
-            mbedtls_oid_get_oid_by_pk_alg(mbedtls_pk_get_type(impl_->pk_ctx.get()), &oid, &oidLen),
+            mbedtls_oid_get_oid_by_pk_alg(pkType, &oid, &oidLen),
             [](int) { std::throw_with_nested(make_error(VirgilCryptoError::UnsupportedAlgorithm)); });
     len += asn1Writer.writeOID(std::string(oid, oidLen));
     len += asn1Writer.writeSequence(len);
@@ -641,9 +653,21 @@ size_t VirgilAsymmetricCipher::asn1Write(VirgilAsn1Writer& asn1Writer, size_t ch
 }
 
 void VirgilAsymmetricCipher::asn1Read(VirgilAsn1Reader& asn1Reader) {
-    asn1Reader.readSequence();
-    std::string oid = asn1Reader.readOID();
-    (void) asn1Reader.readData(); // Ignore params
+    auto algorithmAsn1 = asn1Reader.readDataView();
+    if (match_der_algorithm(kDer_EcKeyAlgorithms, algorithmAsn1.data, algorithmAsn1.size) != nullptr) {
+        impl_->pk_ctx.clear().setup(MBEDTLS_PK_ECKEY);
+        return;
+    }
+    auto derAlgorithm = match_der_algorithm(kDer_PublicKeyAlgorithms, algorithmAsn1.data, algorithmAsn1.size);
+    if (derAlgorithm != nullptr) {
+        impl_->pk_ctx.clear().setup(derAlgorithm->type);
+        return;
+    }
+
+    VirgilAsn1Reader algorithmAsn1Reader(algorithmAsn1.data, algorithmAsn1.size);
+    algorithmAsn1Reader.readSequence();
+    std::string oid = algorithmAsn1Reader.readOID();
+    (void) algorithmAsn1Reader.readDataView(); // Ignore params
 
     mbedtls_asn1_buf oidAsn1Buf;
     oidAsn1Buf.len = oid.size();
@@ -699,7 +723,8 @@ size_t VirgilAsymmetricCipher::calculateExportedPrivateKeySizeMaxPEM(size_t encr
 
 VirgilByteArray VirgilAsymmetricCipher::generateParametersPBES() const {
     return VirgilAsn1Alg::buildPKCS5(
-            internal::randomize(impl_->ctr_drbg_ctx, 16), internal::randomize(impl_->ctr_drbg_ctx, 3072, 8192));
+            internal::randomize(internal::shared_ctr_drbg(), 16),
+            internal::randomize(internal::shared_ctr_drbg(), 3072, 8192));
 }
 
 VirgilByteArray VirgilAsymmetricCipher::adjustBufferWithDER(const VirgilByteArray& buffer, int size) {
@@ -0,0 +1,126 @@
+/**
+ * Copyright (C) 2015-2018 Virgil Security Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *     (3) Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+ */
+
+#include "VirgilAsymmetricCipherPool.h"
+
+#include <virgil/crypto/VirgilByteArrayUtils.h>
+
+#include "utils.h"
+
+using virgil::crypto::VirgilByteArray;
+using virgil::crypto::VirgilByteArrayUtils;
+
+using virgil::crypto::foundation::VirgilAsymmetricCipher;
+
+using virgil::crypto::internal::VirgilAsymmetricCipherPool;
+
+/**
+ * @brief Max number of idle contexts that are kept by the pool.
+ */
+static constexpr size_t kIdleCiphersMax = 16;
+
+std::shared_ptr<VirgilAsymmetricCipherPool> VirgilAsymmetricCipherPool::createWithPublicKey(
+        const VirgilByteArray& publicKey) {
+
+    auto cipher = std::make_unique<VirgilAsymmetricCipher>();
+    cipher->setPublicKey(publicKey);
+    VirgilByteArray key = cipher->exportPublicKeyToDER();
+    return std::shared_ptr<VirgilAsymmetricCipherPool>(
+            new VirgilAsymmetricCipherPool(std::move(cipher), std::move(key), false));
+}
+
+std::shared_ptr<VirgilAsymmetricCipherPool> VirgilAsymmetricCipherPool::createWithPrivateKey(
+        const VirgilByteArray& privateKey, const VirgilByteArray& privateKeyPassword) {
+
+    auto cipher = std::make_unique<VirgilAsymmetricCipher>();
+    cipher->setPrivateKey(privateKey, privateKeyPassword);
+    VirgilByteArray key = cipher->exportPrivateKeyToDER();
+    return std::shared_ptr<VirgilAsymmetricCipherPool>(
+            new VirgilAsymmetricCipherPool(std::move(cipher), std::move(key), true));
+}
+
+VirgilAsymmetricCipherPool::VirgilAsymmetricCipherPool(CipherPtr cipher, VirgilByteArray key, bool isPrivateKey)
+        : key_(std::move(key)), isPrivateKey_(isPrivateKey), mutex_(), idleCiphers_() {
+    idleCiphers_.push_back(std::move(cipher));
+}
+
+VirgilAsymmetricCipherPool::~VirgilAsymmetricCipherPool() noexcept {
+    VirgilByteArrayUtils::zeroize(key_);
+}
+
+std::shared_ptr<const VirgilAsymmetricCipher> VirgilAsymmetricCipherPool::acquire() {
+    CipherPtr cipher;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!idleCiphers_.empty()) {
+            cipher = std::move(idleCiphers_.back());
+            idleCiphers_.pop_back();
+        }
+    }
+
+    if (!cipher) {
+        cipher = createCipher();
+    }
+
+    auto self = shared_from_this();
+    return std::shared_ptr<const VirgilAsymmetricCipher>(
+            cipher.release(),
+            [self](const VirgilAsymmetricCipher* releasedCipher) {
+                self->release(const_cast<VirgilAsymmetricCipher*>(releasedCipher));
+            });
+}
+
+VirgilAsymmetricCipherPool::CipherPtr VirgilAsymmetricCipherPool::createCipher() const {
+    auto cipher = std::make_unique<VirgilAsymmetricCipher>();
+    if (isPrivateKey_) {
+        cipher->setPrivateKey(key_);
+    } else {
+        cipher->setPublicKey(key_);
+    }
+    return cipher;
+}
+
+void VirgilAsymmetricCipherPool::release(VirgilAsymmetricCipher* cipher) noexcept {
+    CipherPtr releasedCipher(cipher);
+    try {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (idleCiphers_.size() < kIdleCiphersMax) {
+            idleCiphers_.push_back(std::move(releasedCipher));
+        }
+    } catch (...) {
+        // Context is simply destroyed if it can not be returned to the pool.
+    }
+}
@@ -0,0 +1,103 @@
+/**
+ * Copyright (C) 2015-2018 Virgil Security Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *     (3) Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+ */
+
+#ifndef VIRGIL_CRYPTO_ASYMMETRIC_CIPHER_POOL_H
+#define VIRGIL_CRYPTO_ASYMMETRIC_CIPHER_POOL_H
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <virgil/crypto/VirgilByteArray.h>
+#include <virgil/crypto/foundation/VirgilAsymmetricCipher.h>
+
+namespace virgil { namespace crypto { namespace internal {
+
+/**
+ * @brief Pool of asymmetric cipher contexts configured with the same key.
+ *
+ * Key is parsed once, then parsed contexts are reused by the pool clients.
+ * Each acquired context is owned by the single client until it is released,
+ *     so pool can be safely shared between threads.
+ */
+class VirgilAsymmetricCipherPool : public std::enable_shared_from_this<VirgilAsymmetricCipherPool> {
+public:
+    /**
+     * @brief Create pool for the given public key.
+     * @throw VirgilCryptoException with VirgilCryptoError::InvalidPublicKey, if public key is invalid.
+     */
+    static std::shared_ptr<VirgilAsymmetricCipherPool> createWithPublicKey(
+            const virgil::crypto::VirgilByteArray& publicKey);
+
+    /**
+     * @brief Create pool for the given private key.
+     * @throw VirgilCryptoException with VirgilCryptoError::InvalidPrivateKey, if private key is invalid.
+     * @throw VirgilCryptoException with VirgilCryptoError::InvalidPrivateKeyPassword, if password mismatch.
+     */
+    static std::shared_ptr<VirgilAsymmetricCipherPool> createWithPrivateKey(
+            const virgil::crypto::VirgilByteArray& privateKey,
+            const virgil::crypto::VirgilByteArray& privateKeyPassword);
+
+    /**
+     * @brief Return idle context or create new one if all contexts are in use.
+     * @note Context is returned back to the pool when returned object is destroyed.
+     */
+    std::shared_ptr<const virgil::crypto::foundation::VirgilAsymmetricCipher> acquire();
+
+    /**
+     * @brief Zeroize key.
+     */
+    ~VirgilAsymmetricCipherPool() noexcept;
+
+private:
+    using CipherPtr = std::unique_ptr<virgil::crypto::foundation::VirgilAsymmetricCipher>;
+
+    VirgilAsymmetricCipherPool(CipherPtr cipher, virgil::crypto::VirgilByteArray key, bool isPrivateKey);
+
+    CipherPtr createCipher() const;
+
+    void release(virgil::crypto::foundation::VirgilAsymmetricCipher* cipher) noexcept;
+
+private:
+    virgil::crypto::VirgilByteArray key_; ///< unencrypted key in DER format
+    const bool isPrivateKey_;
+    std::mutex mutex_;
+    std::vector<CipherPtr> idleCiphers_;
+};
+
+}}}
+
+#endif /* VIRGIL_CRYPTO_ASYMMETRIC_CIPHER_POOL_H */
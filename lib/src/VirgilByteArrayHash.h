@@ -0,0 +1,67 @@
+/**
+ * Copyright (C) 2015-2018 Virgil Security Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *     (3) Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+ */
+
+#ifndef VIRGIL_CRYPTO_BYTE_ARRAY_HASH_H
+#define VIRGIL_CRYPTO_BYTE_ARRAY_HASH_H
+
+#include <virgil/crypto/VirgilByteArray.h>
+
+#include <cstdint>
+#include <cstddef>
+
+namespace virgil { namespace crypto { namespace internal {
+
+/**
+ * @brief Hash function for VirgilByteArray to be used within unordered containers.
+ *
+ * Implements 64-bit FNV-1a.
+ *
+ * @warning It is NOT a cryptographic hash, use it only for non-secret data, i.e. identifiers.
+ */
+struct VirgilByteArrayHash {
+    size_t operator()(const VirgilByteArray& data) const noexcept {
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        for (const auto byte : data) {
+            hash ^= byte;
+            hash *= 0x100000001b3ULL;
+        }
+        return static_cast<size_t>(hash);
+    }
+};
+
+}}}
+
+#endif //VIRGIL_CRYPTO_BYTE_ARRAY_HASH_H
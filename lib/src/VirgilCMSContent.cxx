@@ -44,6 +44,7 @@
 #include "utils.h"
 
 using virgil::crypto::foundation::cms::VirgilCMSContent;
+using virgil::crypto::foundation::asn1::VirgilAsn1Compatible;
 using virgil::crypto::foundation::asn1::VirgilAsn1Reader;
 using virgil::crypto::foundation::asn1::VirgilAsn1Writer;
 
@@ -55,15 +56,24 @@ static const unsigned char kCMS_ContentTag = 0;
 ///@}
 
 size_t VirgilCMSContent::asn1Write(VirgilAsn1Writer& asn1Writer, size_t childWrittenBytes) const {
-    size_t len = 0;
-
     checkRequiredField(content);
-    len += asn1Writer.writeData(content);
+    const size_t contentLen = asn1Writer.writeData(content);
+    return writeContentWrapper(asn1Writer, contentType, contentLen) + childWrittenBytes;
+}
+
+size_t VirgilCMSContent::asn1WriteObject(
+        VirgilAsn1Writer& asn1Writer, VirgilCMSContent::Type contentType, const VirgilAsn1Compatible& contentObject) {
+    const size_t contentLen = contentObject.asn1Write(asn1Writer);
+    return writeContentWrapper(asn1Writer, contentType, contentLen);
+}
+
+size_t VirgilCMSContent::writeContentWrapper(
+        VirgilAsn1Writer& asn1Writer, VirgilCMSContent::Type contentType, size_t contentLen) {
+    size_t len = contentLen;
     len += asn1Writer.writeContextTag(kCMS_ContentTag, len);
     len += asn1Writer.writeOID(contentTypeToOID(contentType));
     len += asn1Writer.writeSequence(len);
-
-    return len + childWrittenBytes;
+    return len;
 }
 
 void VirgilCMSContent::asn1Read(VirgilAsn1Reader& asn1Reader) {
@@ -43,7 +43,9 @@
 #include <virgil/crypto/foundation/asn1/VirgilAsn1Writer.h>
 
 using virgil::crypto::VirgilByteArray;
+using virgil::crypto::foundation::cms::VirgilCMSContent;
 using virgil::crypto::foundation::cms::VirgilCMSContentInfo;
+using virgil::crypto::foundation::asn1::VirgilAsn1Compatible;
 using virgil::crypto::foundation::asn1::VirgilAsn1Reader;
 using virgil::crypto::foundation::asn1::VirgilAsn1Writer;
 
@@ -52,7 +54,9 @@ using virgil::crypto::foundation::asn1::VirgilAsn1Writer;
  */
 ///@{
 static const unsigned char kAsn1_CustomParamsTag = 0;
+static const unsigned char kAsn1_AlgorithmsTag = 1;
 static const int kAsn1_ContentInfoVersion = 0;
+static const int kAsn1_ContentInfoVersionCompact = 1;
 ///@}
 
 size_t VirgilCMSContentInfo::defineSize(const VirgilByteArray& data) {
@@ -78,34 +82,80 @@ size_t VirgilCMSContentInfo::defineSize(const VirgilByteArray& data) {
     // Validate ContentInfo version
     int version = 0;
     result = mbedtls_asn1_get_int(&p, p_end, &version);
-    if (result != 0 || version != kAsn1_ContentInfoVersion) {
+    if (result != 0 || (version != kAsn1_ContentInfoVersion && version != kAsn1_ContentInfoVersionCompact)) {
         return 0;
     }
     return size;
 }
 
-size_t VirgilCMSContentInfo::asn1Write(VirgilAsn1Writer& asn1Writer, size_t childWrittenBytes) const {
+/**
+ * @brief Write optional fields of the content info, that follow the CMS content.
+ */
+static size_t write_optional_fields(
+        VirgilAsn1Writer& asn1Writer, const virgil::crypto::VirgilCustomParams& customParams,
+        const std::vector<VirgilByteArray>& algorithms) {
     size_t len = 0;
+    if (!algorithms.empty()) {
+        size_t algorithmsLen = 0;
+        for (auto algorithm = algorithms.crbegin(); algorithm != algorithms.crend(); ++algorithm) {
+            algorithmsLen += asn1Writer.writeData(*algorithm);
+        }
+        algorithmsLen += asn1Writer.writeSequence(algorithmsLen);
+        len += algorithmsLen;
+        len += asn1Writer.writeContextTag(kAsn1_AlgorithmsTag, algorithmsLen);
+    }
+
     if (!customParams.isEmpty()) {
-        len += customParams.asn1Write(asn1Writer);
-        len += asn1Writer.writeContextTag(kAsn1_CustomParamsTag, len);
+        size_t customParamsLen = customParams.asn1Write(asn1Writer);
+        len += customParamsLen;
+        len += asn1Writer.writeContextTag(kAsn1_CustomParamsTag, customParamsLen);
     }
+    return len;
+}
 
-    len += cmsContent.asn1Write(asn1Writer);
-    len += asn1Writer.writeInteger(kAsn1_ContentInfoVersion);
+/**
+ * @brief Write version of the content info and wrap all written fields.
+ */
+static size_t write_header(VirgilAsn1Writer& asn1Writer, bool isCompact, size_t fieldsLen) {
+    size_t len = fieldsLen;
+    len += asn1Writer.writeInteger(isCompact ? kAsn1_ContentInfoVersionCompact : kAsn1_ContentInfoVersion);
     len += asn1Writer.writeSequence(len);
+    return len;
+}
 
-    return len + childWrittenBytes;
+size_t VirgilCMSContentInfo::asn1Write(VirgilAsn1Writer& asn1Writer, size_t childWrittenBytes) const {
+    size_t len = write_optional_fields(asn1Writer, customParams, algorithms);
+    len += cmsContent.asn1Write(asn1Writer);
+    return write_header(asn1Writer, !algorithms.empty(), len) + childWrittenBytes;
+}
+
+size_t VirgilCMSContentInfo::asn1WriteEnvelopedData(
+        VirgilAsn1Writer& asn1Writer, const VirgilAsn1Compatible& envelopedData,
+        const std::vector<VirgilByteArray>& algorithmIdentifiers) const {
+    size_t len = write_optional_fields(asn1Writer, customParams, algorithmIdentifiers);
+    len += VirgilCMSContent::asn1WriteObject(asn1Writer, VirgilCMSContent::Type::EnvelopedData, envelopedData);
+    return write_header(asn1Writer, !algorithmIdentifiers.empty(), len);
 }
 
 void VirgilCMSContentInfo::asn1Read(VirgilAsn1Reader& asn1Reader) {
     (void) asn1Reader.readSequence();
     const int version = asn1Reader.readInteger();
-    if (version != kAsn1_ContentInfoVersion) {
+    if (version != kAsn1_ContentInfoVersion && version != kAsn1_ContentInfoVersionCompact) {
         throw make_error(VirgilCryptoError::UnsupportedAlgorithm, "Unsupported version of CMS Content Info.");
     }
     cmsContent.asn1Read(asn1Reader);
     if (asn1Reader.readContextTag(kAsn1_CustomParamsTag) > 0) {
         customParams.asn1Read(asn1Reader);
     }
+    algorithms.clear();
+    if (version == kAsn1_ContentInfoVersionCompact && asn1Reader.readContextTag(kAsn1_AlgorithmsTag) > 0) {
+        size_t algorithmsLen = asn1Reader.readSequence();
+        while (algorithmsLen > 0) {
+            algorithms.push_back(asn1Reader.readData());
+            if (algorithms.back().size() > algorithmsLen) {
+                throw make_error(VirgilCryptoError::InvalidFormat, "Malformed algorithms of CMS Content Info.");
+            }
+            algorithmsLen -= algorithms.back().size();
+        }
+    }
 }
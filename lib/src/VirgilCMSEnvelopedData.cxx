@@ -40,8 +40,16 @@
 #include <virgil/crypto/foundation/asn1/VirgilAsn1Reader.h>
 #include <virgil/crypto/foundation/asn1/VirgilAsn1Writer.h>
 
+#include <algorithm>
 
+
+using virgil::crypto::VirgilByteArray;
+using virgil::crypto::VirgilCryptoError;
+using virgil::crypto::make_error;
 using virgil::crypto::foundation::cms::VirgilCMSEnvelopedData;
+using virgil::crypto::foundation::cms::VirgilCMSKeyTransRecipient;
+using virgil::crypto::foundation::cms::VirgilCMSKeyAgreeRecipient;
+using virgil::crypto::foundation::cms::VirgilCMSPasswordRecipient;
 using virgil::crypto::foundation::asn1::VirgilAsn1Reader;
 using virgil::crypto::foundation::asn1::VirgilAsn1Writer;
 /**
@@ -53,77 +61,154 @@ static const unsigned char kCMS_KeyAgreeRecipientTag = 1;
 static const unsigned char kCMS_KEKRecipientTag = 2;
 static const unsigned char kCMS_PasswordRecipientTag = 3;
 static const unsigned char kCMS_OtherRecipientTag = 4;
+static const unsigned char kCMS_SubjectKeyTag = 0;
+///@}
+
+/**
+ * @brief Return value to be written in place of the given key encryption algorithm.
+ */
+static const VirgilByteArray& algorithm_value(
+        const VirgilCMSEnvelopedData::AlgorithmRefs& algorithmRefs, const VirgilByteArray& algorithm) {
+    const auto ref = algorithmRefs.find(algorithm);
+    return ref != algorithmRefs.cend() ? ref->second : algorithm;
+}
+
+/**
+ * @name Write recipient info wrapped with the recipient specific context tag.
+ * @note KeyTransRecipientInfo is not wrapped, because it is the untagged choice.
+ */
+///@{
+static size_t write_recipient_info(
+        VirgilAsn1Writer& asn1Writer, const VirgilCMSKeyTransRecipient& recipient,
+        const VirgilCMSEnvelopedData::AlgorithmRefs& algorithmRefs) {
+    return recipient.asn1Write(asn1Writer, algorithm_value(algorithmRefs, recipient.keyEncryptionAlgorithm));
+}
+
+static size_t write_recipient_info(
+        VirgilAsn1Writer& asn1Writer, const VirgilCMSKeyAgreeRecipient& recipient,
+        const VirgilCMSEnvelopedData::AlgorithmRefs& algorithmRefs) {
+    size_t len = recipient.asn1Write(asn1Writer, algorithm_value(algorithmRefs, recipient.keyEncryptionAlgorithm));
+    return len + asn1Writer.writeContextTag(kCMS_KeyAgreeRecipientTag, len);
+}
+
+static size_t write_recipient_info(
+        VirgilAsn1Writer& asn1Writer, const VirgilCMSPasswordRecipient& recipient,
+        const VirgilCMSEnvelopedData::AlgorithmRefs&) {
+    size_t len = recipient.asn1Write(asn1Writer);
+    return len + asn1Writer.writeContextTag(kCMS_PasswordRecipientTag, len);
+}
 ///@}
 
 size_t VirgilCMSEnvelopedData::asn1Write(VirgilAsn1Writer& asn1Writer, size_t childWrittenBytes) const {
+    return asn1Write(asn1Writer, AlgorithmRefs(), childWrittenBytes);
+}
+
+size_t VirgilCMSEnvelopedData::asn1Write(
+        VirgilAsn1Writer& asn1Writer, const AlgorithmRefs& algorithmRefs, size_t childWrittenBytes) const {
     size_t len = 0;
     // encryptedContentInfo
-    len += asn1Writer.writeData(encryptedContent.toAsn1());
+    len += encryptedContent.asn1Write(asn1Writer);
     // recipientInfos
-    std::vector<VirgilByteArray> recipientInfos;
-    recipientInfos.reserve(keyTransRecipients.size() + passwordRecipients.size());
-
-    std::vector<VirgilCMSKeyTransRecipient>::const_iterator keyTransRecipientIt = keyTransRecipients.begin();
-    for (; keyTransRecipientIt != keyTransRecipients.end(); ++keyTransRecipientIt) {
-        recipientInfos.push_back(keyTransRecipientIt->toAsn1());
+    // Recipients are written in place, and then are put in the DER order, so each is encoded once.
+    size_t recipientInfosLen = 0;
+    for (const auto& recipient : keyTransRecipients) {
+        recipientInfosLen += write_recipient_info(asn1Writer, recipient, algorithmRefs);
     }
-
-    std::vector<VirgilCMSPasswordRecipient>::const_iterator passwordRecipientIt = passwordRecipients.begin();
-    for (; passwordRecipientIt != passwordRecipients.end(); ++passwordRecipientIt) {
-        VirgilAsn1Writer recipientAsn1Writer;
-        size_t recipientLen = recipientAsn1Writer.writeData(passwordRecipientIt->toAsn1());
-        recipientAsn1Writer.writeContextTag(kCMS_PasswordRecipientTag, recipientLen);
-        recipientInfos.push_back(recipientAsn1Writer.finish());
+    for (const auto& recipient : keyAgreeRecipients) {
+        recipientInfosLen += write_recipient_info(asn1Writer, recipient, algorithmRefs);
     }
-
-    len += asn1Writer.writeSet(recipientInfos);
+    for (const auto& recipient : passwordRecipients) {
+        recipientInfosLen += write_recipient_info(asn1Writer, recipient, algorithmRefs);
+    }
+    len += recipientInfosLen + asn1Writer.writeSortedSet(recipientInfosLen);
     len += asn1Writer.writeInteger(defineVersion());
     len += asn1Writer.writeSequence(len);
 
     return len + childWrittenBytes;
 }
 
+/**
+ * @brief Read only 'rid' field of the KeyTransRecipientInfo structure.
+ * @see VirgilCMSKeyTransRecipient
+ */
+static bool has_key_trans_recipient_identifier(
+        const VirgilAsn1Reader::View& recipientAsn1, const VirgilByteArray& recipientIdentifier) {
+    VirgilAsn1Reader asn1Reader(recipientAsn1.data, recipientAsn1.size);
+    (void) asn1Reader.readSequence();
+    (void) asn1Reader.readInteger();
+    if (asn1Reader.readContextTag(kCMS_SubjectKeyTag) > 0) {
+        auto rid = asn1Reader.readOctetStringView();
+        return rid.size == recipientIdentifier.size() &&
+                std::equal(rid.data, rid.data + rid.size, recipientIdentifier.begin());
+    }
+    throw make_error(VirgilCryptoError::InvalidFormat,
+            "KeyTransRecipientInfo structure is malformed. Parameter 'rid' is not defined.");
+}
+
 void VirgilCMSEnvelopedData::asn1Read(VirgilAsn1Reader& asn1Reader) {
+    read(asn1Reader, nullptr);
+}
+
+void VirgilCMSEnvelopedData::fromAsn1(const VirgilByteArray& asn1, const VirgilByteArray& keyRecipientIdentifier) {
+    VirgilAsn1Reader asn1Reader(asn1.data(), asn1.size());
+    read(asn1Reader, &keyRecipientIdentifier);
+}
+
+void VirgilCMSEnvelopedData::read(VirgilAsn1Reader& asn1Reader, const VirgilByteArray* keyRecipientIdentifier) {
     keyTransRecipients.clear();
+    keyAgreeRecipients.clear();
     passwordRecipients.clear();
 
     (void) asn1Reader.readSequence();
     (void) asn1Reader.readInteger(); // Ignore version
     if (asn1Reader.readContextTag(kCMS_OriginatorInfoTag) > 0) {
-        (void) asn1Reader.readData(); // Ignore originatorInfo
+        (void) asn1Reader.readDataView(); // Ignore originatorInfo
     }
 
     size_t setLen = asn1Reader.readSet();
     while (setLen != 0) {
-        VirgilByteArray recipientAsn1 = asn1Reader.readData();
-        VirgilAsn1Reader recipientAsn1Reader(recipientAsn1);
+        auto recipientAsn1 = asn1Reader.readDataView();
+        VirgilAsn1Reader recipientAsn1Reader(recipientAsn1.data, recipientAsn1.size);
 
         if (recipientAsn1Reader.readContextTag(kCMS_PasswordRecipientTag) > 0) {
             VirgilCMSPasswordRecipient recipient;
-            recipient.fromAsn1(recipientAsn1Reader.readData());
+            recipient.asn1Read(recipientAsn1Reader);
             passwordRecipients.push_back(recipient);
+        } else if (recipientAsn1Reader.readContextTag(kCMS_KeyAgreeRecipientTag) > 0) {
+            VirgilCMSKeyAgreeRecipient recipient;
+            if (keyRecipientIdentifier != nullptr) {
+                recipient.asn1Read(recipientAsn1Reader, *keyRecipientIdentifier);
+            } else {
+                recipient.asn1Read(recipientAsn1Reader);
+            }
+            if (!recipient.recipientEncryptedKeys.empty()) {
+                keyAgreeRecipients.push_back(std::move(recipient));
+            }
         } else {
             bool unsupportedRecipientInfoDefined =
-                    recipientAsn1Reader.readContextTag(kCMS_KeyAgreeRecipientTag) > 0 ||
-                            recipientAsn1Reader.readContextTag(kCMS_KEKRecipientTag) > 0 ||
+                    recipientAsn1Reader.readContextTag(kCMS_KEKRecipientTag) > 0 ||
                             recipientAsn1Reader.readContextTag(kCMS_OtherRecipientTag) > 0;
             if (unsupportedRecipientInfoDefined) {
                 throw make_error(VirgilCryptoError::UnsupportedAlgorithm, "Unsupported CMS RecipientInfo.");
-            } else {
+            } else if (keyRecipientIdentifier == nullptr ||
+                    has_key_trans_recipient_identifier(recipientAsn1, *keyRecipientIdentifier)) {
                 VirgilCMSKeyTransRecipient recipient;
-                recipient.fromAsn1(recipientAsn1);
-                keyTransRecipients.push_back(recipient);
+                recipientAsn1Reader.reset(recipientAsn1.data, recipientAsn1.size);
+                recipient.asn1Read(recipientAsn1Reader);
+                keyTransRecipients.push_back(std::move(recipient));
             }
         }
-        setLen = setLen > recipientAsn1.size() ? (setLen - recipientAsn1.size()) : 0;
+        setLen = setLen > recipientAsn1.size ? (setLen - recipientAsn1.size) : 0;
     }
-    encryptedContent.fromAsn1(asn1Reader.readData());
+    auto encryptedContentAsn1 = asn1Reader.readDataView();
+    VirgilAsn1Reader encryptedContentAsn1Reader(encryptedContentAsn1.data, encryptedContentAsn1.size);
+    encryptedContent.asn1Read(encryptedContentAsn1Reader);
 }
 
 int VirgilCMSEnvelopedData::defineVersion() const {
     if (passwordRecipients.size() > 0) {
         return 3;
-    } else if (keyTransRecipients.size() > 0) {
+    } else if (keyTransRecipients.size() > 0 || keyAgreeRecipients.size() > 0) {
         return 2;
     } else {
         return 0;
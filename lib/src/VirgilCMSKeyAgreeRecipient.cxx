@@ -0,0 +1,174 @@
+/**
+ * Copyright (C) 2015-2018 Virgil Security Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *     (3) Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+ */
+
+#include <virgil/crypto/foundation/cms/VirgilCMSKeyAgreeRecipient.h>
+
+#include <virgil/crypto/foundation/VirgilSystemCryptoError.h>
+#include <virgil/crypto/foundation/asn1/VirgilAsn1Reader.h>
+#include <virgil/crypto/foundation/asn1/VirgilAsn1Writer.h>
+
+#include "utils.h"
+
+#include <algorithm>
+
+using virgil::crypto::VirgilByteArray;
+using virgil::crypto::foundation::cms::VirgilCMSKeyAgreeRecipient;
+using virgil::crypto::foundation::asn1::VirgilAsn1Reader;
+using virgil::crypto::foundation::asn1::VirgilAsn1Writer;
+
+/**
+ * @name ASN.1 Constants for CMS
+ */
+///@{
+static const unsigned char kCMS_OriginatorTag = 0;
+static const unsigned char kCMS_OriginatorKeyTag = 1;
+static const unsigned char kCMS_UserKeyingMaterialTag = 1;
+static const unsigned char kCMS_RecipientKeyIdTag = 0;
+static const int kCMS_KeyAgreeRecipientVersion = 3;
+///@}
+
+size_t VirgilCMSKeyAgreeRecipient::asn1Write(VirgilAsn1Writer& asn1Writer, size_t childWrittenBytes) const {
+    return asn1Write(asn1Writer, keyEncryptionAlgorithm) + childWrittenBytes;
+}
+
+size_t VirgilCMSKeyAgreeRecipient::asn1Write(
+        VirgilAsn1Writer& asn1Writer, const VirgilByteArray& keyEncryptionAlgorithmValue) const {
+    size_t len = 0;
+
+    if (recipientEncryptedKeys.empty()) {
+        throw make_error(VirgilCryptoError::InvalidState,
+                "KeyAgreeRecipientInfo structure is malformed. Parameter 'recipientEncryptedKeys' is empty.");
+    }
+    size_t recipientEncryptedKeysLen = 0;
+    for (auto it = recipientEncryptedKeys.crbegin(); it != recipientEncryptedKeys.crend(); ++it) {
+        checkRequiredField(it->encryptedKey);
+        checkRequiredField(it->recipientIdentifier);
+
+        size_t recipientEncryptedKeyLen = asn1Writer.writeOctetString(it->encryptedKey);
+        size_t recipientKeyIdLen = asn1Writer.writeOctetString(it->recipientIdentifier);
+        recipientKeyIdLen += asn1Writer.writeSequence(recipientKeyIdLen);
+        recipientKeyIdLen += asn1Writer.writeContextTag(kCMS_RecipientKeyIdTag, recipientKeyIdLen);
+        recipientEncryptedKeyLen += recipientKeyIdLen;
+        recipientEncryptedKeyLen += asn1Writer.writeSequence(recipientEncryptedKeyLen);
+        recipientEncryptedKeysLen += recipientEncryptedKeyLen;
+    }
+    recipientEncryptedKeysLen += asn1Writer.writeSequence(recipientEncryptedKeysLen);
+    len += recipientEncryptedKeysLen;
+
+    checkRequiredField(keyEncryptionAlgorithmValue);
+    len += asn1Writer.writeData(keyEncryptionAlgorithmValue);
+
+    checkRequiredField(originatorKey);
+    size_t originatorLen = asn1Writer.writeData(originatorKey);
+    originatorLen += asn1Writer.writeContextTag(kCMS_OriginatorKeyTag, originatorLen);
+    originatorLen += asn1Writer.writeContextTag(kCMS_OriginatorTag, originatorLen);
+    len += originatorLen;
+
+    len += asn1Writer.writeInteger(kCMS_KeyAgreeRecipientVersion);
+    len += asn1Writer.writeSequence(len);
+
+    return len;
+}
+
+void VirgilCMSKeyAgreeRecipient::asn1Read(VirgilAsn1Reader& asn1Reader) {
+    read(asn1Reader, nullptr);
+}
+
+void VirgilCMSKeyAgreeRecipient::asn1Read(VirgilAsn1Reader& asn1Reader, const VirgilByteArray& recipientIdentifier) {
+    read(asn1Reader, &recipientIdentifier);
+}
+
+void VirgilCMSKeyAgreeRecipient::read(VirgilAsn1Reader& asn1Reader, const VirgilByteArray* recipientIdentifier) {
+    recipientEncryptedKeys.clear();
+
+    (void) asn1Reader.readSequence();
+    int version = asn1Reader.readInteger();
+    if (version != kCMS_KeyAgreeRecipientVersion) {
+        throw make_error(VirgilCryptoError::InvalidFormat,
+                "KeyAgreeRecipientInfo structure is malformed. Incorrect CMS version number.");
+    }
+
+    VirgilAsn1Reader::View originatorKeyView;
+    if (asn1Reader.readContextTag(kCMS_OriginatorTag) > 0 && asn1Reader.readContextTag(kCMS_OriginatorKeyTag) > 0) {
+        originatorKeyView = asn1Reader.readDataView();
+    } else {
+        throw make_error(VirgilCryptoError::InvalidFormat,
+                "KeyAgreeRecipientInfo structure is malformed. Parameter 'originatorKey' is not defined.");
+    }
+
+    if (asn1Reader.readContextTag(kCMS_UserKeyingMaterialTag) > 0) {
+        (void) asn1Reader.readOctetStringView(); // Ignore ukm
+    }
+
+    const auto keyEncryptionAlgorithmView = asn1Reader.readDataView();
+
+    size_t recipientEncryptedKeysLen = asn1Reader.readSequence();
+    while (recipientEncryptedKeysLen != 0) {
+        auto recipientEncryptedKeyAsn1 = asn1Reader.readDataView();
+        VirgilAsn1Reader recipientAsn1Reader(recipientEncryptedKeyAsn1.data, recipientEncryptedKeyAsn1.size);
+
+        (void) recipientAsn1Reader.readSequence();
+        VirgilAsn1Reader::View rid;
+        if (recipientAsn1Reader.readContextTag(kCMS_RecipientKeyIdTag) > 0) {
+            (void) recipientAsn1Reader.readSequence();
+            rid = recipientAsn1Reader.readOctetStringView();
+        } else {
+            throw make_error(VirgilCryptoError::InvalidFormat,
+                    "KeyAgreeRecipientInfo structure is malformed. Parameter 'rid' is not defined.");
+        }
+        const bool isKept = recipientIdentifier == nullptr ||
+                (rid.size == recipientIdentifier->size() &&
+                        std::equal(rid.data, rid.data + rid.size, recipientIdentifier->begin()));
+        if (isKept) {
+            RecipientEncryptedKey recipientEncryptedKey;
+            recipientEncryptedKey.recipientIdentifier = rid.toBytes();
+            recipientEncryptedKey.encryptedKey = recipientAsn1Reader.readOctetString();
+            recipientEncryptedKeys.push_back(std::move(recipientEncryptedKey));
+        }
+
+        recipientEncryptedKeysLen = recipientEncryptedKeysLen > recipientEncryptedKeyAsn1.size ?
+                (recipientEncryptedKeysLen - recipientEncryptedKeyAsn1.size) : 0;
+    }
+
+    // Shared fields are copied only if at least one recipient encrypted key is kept.
+    if (recipientIdentifier == nullptr || !recipientEncryptedKeys.empty()) {
+        originatorKey = originatorKeyView.toBytes();
+        keyEncryptionAlgorithm = keyEncryptionAlgorithmView.toBytes();
+    } else {
+        originatorKey.clear();
+        keyEncryptionAlgorithm.clear();
+    }
+}
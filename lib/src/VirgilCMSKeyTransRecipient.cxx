@@ -42,6 +42,7 @@
 
 #include "utils.h"
 
+using virgil::crypto::VirgilByteArray;
 using virgil::crypto::foundation::cms::VirgilCMSKeyTransRecipient;
 using virgil::crypto::foundation::asn1::VirgilAsn1Reader;
 using virgil::crypto::foundation::asn1::VirgilAsn1Writer;
@@ -55,13 +56,18 @@ static const int kCMS_KeyTransRecipientVersion = 2;
 ///@}
 
 size_t VirgilCMSKeyTransRecipient::asn1Write(VirgilAsn1Writer& asn1Writer, size_t childWrittenBytes) const {
+    return asn1Write(asn1Writer, keyEncryptionAlgorithm) + childWrittenBytes;
+}
+
+size_t VirgilCMSKeyTransRecipient::asn1Write(
+        VirgilAsn1Writer& asn1Writer, const VirgilByteArray& keyEncryptionAlgorithmValue) const {
     size_t len = 0;
 
     checkRequiredField(encryptedKey);
     len += asn1Writer.writeOctetString(encryptedKey);
 
-    checkRequiredField(keyEncryptionAlgorithm);
-    len += asn1Writer.writeData(keyEncryptionAlgorithm);
+    checkRequiredField(keyEncryptionAlgorithmValue);
+    len += asn1Writer.writeData(keyEncryptionAlgorithmValue);
 
     checkRequiredField(recipientIdentifier);
     size_t recipientIdentifierLen = asn1Writer.writeOctetString(recipientIdentifier);
@@ -71,7 +77,7 @@ size_t VirgilCMSKeyTransRecipient::asn1Write(VirgilAsn1Writer& asn1Writer, size_
     len += asn1Writer.writeInteger(kCMS_KeyTransRecipientVersion);
     len += asn1Writer.writeSequence(len);
 
-    return len + childWrittenBytes;
+    return len;
 }
 
 void VirgilCMSKeyTransRecipient::asn1Read(VirgilAsn1Reader& asn1Reader) {
@@ -0,0 +1,478 @@
+/**
+ * Copyright (C) 2015-2018 Virgil Security Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *     (3) Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+ */
+
+#include "VirgilChaCha20Poly1305.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <virgil/crypto/VirgilCryptoError.h>
+
+#include "VirgilCpuFeatures.h"
+
+#if VIRGIL_CRYPTO_X86_INTRINSICS
+#include <immintrin.h>
+#endif
+
+using virgil::crypto::VirgilCryptoError;
+using virgil::crypto::make_error;
+using virgil::crypto::foundation::internal::VirgilChaCha20Poly1305;
+
+constexpr size_t VirgilChaCha20Poly1305::kKeySize;
+constexpr size_t VirgilChaCha20Poly1305::kNonceSize;
+constexpr size_t VirgilChaCha20Poly1305::kTagSize;
+
+namespace virgil { namespace crypto { namespace foundation { namespace internal {
+
+static constexpr size_t kChaCha20_BlockSize = 64;
+static constexpr uint32_t kPoly1305_LimbMask = 0x3ffffff;
+// Block counter is 32-bit, so one nonce can protect at most 2^32 - 1 blocks (block 0 is used for MAC key).
+static constexpr uint64_t kDataSizeMax = uint64_t(0xffffffff) * kChaCha20_BlockSize;
+
+static inline uint32_t load32_le(const unsigned char* src) {
+    return uint32_t(src[0]) | (uint32_t(src[1]) << 8) | (uint32_t(src[2]) << 16) | (uint32_t(src[3]) << 24);
+}
+
+static inline void store32_le(unsigned char* dst, uint32_t value) {
+    dst[0] = (unsigned char) value;
+    dst[1] = (unsigned char) (value >> 8);
+    dst[2] = (unsigned char) (value >> 16);
+    dst[3] = (unsigned char) (value >> 24);
+}
+
+static inline void store64_le(unsigned char* dst, uint64_t value) {
+    store32_le(dst, (uint32_t) value);
+    store32_le(dst + 4, (uint32_t) (value >> 32));
+}
+
+static void secure_zeroize(void* data, size_t dataSize) {
+    volatile unsigned char* p = static_cast<volatile unsigned char*>(data);
+    while (dataSize--) {
+        *p++ = 0;
+    }
+}
+
+static inline uint32_t rotl32(uint32_t value, int shift) {
+    return (value << shift) | (value >> (32 - shift));
+}
+
+#define VIRGIL_CHACHA20_QUARTER_ROUND(a, b, c, d) \
+    a += b; d = rotl32(d ^ a, 16); \
+    c += d; b = rotl32(b ^ c, 12); \
+    a += b; d = rotl32(d ^ a, 8); \
+    c += d; b = rotl32(b ^ c, 7)
+
+/**
+ * @brief Produce one key stream block for the given state.
+ */
+static void chacha20_block(const uint32_t* state, unsigned char* block) {
+    uint32_t x[16];
+    std::memcpy(x, state, sizeof(x));
+    for (int i = 0; i < 10; ++i) {
+        VIRGIL_CHACHA20_QUARTER_ROUND(x[0], x[4], x[8], x[12]);
+        VIRGIL_CHACHA20_QUARTER_ROUND(x[1], x[5], x[9], x[13]);
+        VIRGIL_CHACHA20_QUARTER_ROUND(x[2], x[6], x[10], x[14]);
+        VIRGIL_CHACHA20_QUARTER_ROUND(x[3], x[7], x[11], x[15]);
+        VIRGIL_CHACHA20_QUARTER_ROUND(x[0], x[5], x[10], x[15]);
+        VIRGIL_CHACHA20_QUARTER_ROUND(x[1], x[6], x[11], x[12]);
+        VIRGIL_CHACHA20_QUARTER_ROUND(x[2], x[7], x[8], x[13]);
+        VIRGIL_CHACHA20_QUARTER_ROUND(x[3], x[4], x[9], x[14]);
+    }
+    for (size_t i = 0; i < 16; ++i) {
+        store32_le(block + 4 * i, x[i] + state[i]);
+    }
+    secure_zeroize(x, sizeof(x));
+}
+
+#undef VIRGIL_CHACHA20_QUARTER_ROUND
+
+#if VIRGIL_CRYPTO_X86_INTRINSICS
+
+#define VIRGIL_CHACHA20_AVX2_ROTL(v, n) \
+    _mm256_or_si256(_mm256_slli_epi32(v, n), _mm256_srli_epi32(v, 32 - (n)))
+
+#define VIRGIL_CHACHA20_AVX2_QUARTER_ROUND(a, b, c, d) \
+    a = _mm256_add_epi32(a, b); d = _mm256_shuffle_epi8(_mm256_xor_si256(d, a), rot16); \
+    c = _mm256_add_epi32(c, d); b = VIRGIL_CHACHA20_AVX2_ROTL(_mm256_xor_si256(b, c), 12); \
+    a = _mm256_add_epi32(a, b); d = _mm256_shuffle_epi8(_mm256_xor_si256(d, a), rot8); \
+    c = _mm256_add_epi32(c, d); b = VIRGIL_CHACHA20_AVX2_ROTL(_mm256_xor_si256(b, c), 7)
+
+/**
+ * @brief Transpose 8 vectors, where vector i holds word i of 8 blocks,
+ *     and XOR result blocks with the input at the given word offset.
+ */
+__attribute__((target("avx2")))
+static inline void chacha20_avx2_xor_words(
+        const __m256i* x, const unsigned char* input, unsigned char* output, size_t wordOffset) {
+
+    const __m256i t0 = _mm256_unpacklo_epi32(x[0], x[1]);
+    const __m256i t1 = _mm256_unpackhi_epi32(x[0], x[1]);
+    const __m256i t2 = _mm256_unpacklo_epi32(x[2], x[3]);
+    const __m256i t3 = _mm256_unpackhi_epi32(x[2], x[3]);
+    const __m256i t4 = _mm256_unpacklo_epi32(x[4], x[5]);
+    const __m256i t5 = _mm256_unpackhi_epi32(x[4], x[5]);
+    const __m256i t6 = _mm256_unpacklo_epi32(x[6], x[7]);
+    const __m256i t7 = _mm256_unpackhi_epi32(x[6], x[7]);
+
+    const __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+    const __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+    const __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+    const __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+    const __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+    const __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+    const __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+    const __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+
+    const __m256i blocks[8] = {
+            _mm256_permute2x128_si256(u0, u4, 0x20), _mm256_permute2x128_si256(u1, u5, 0x20),
+            _mm256_permute2x128_si256(u2, u6, 0x20), _mm256_permute2x128_si256(u3, u7, 0x20),
+            _mm256_permute2x128_si256(u0, u4, 0x31), _mm256_permute2x128_si256(u1, u5, 0x31),
+            _mm256_permute2x128_si256(u2, u6, 0x31), _mm256_permute2x128_si256(u3, u7, 0x31)
+    };
+
+    for (size_t i = 0; i < 8; ++i) {
+        const size_t offset = i * kChaCha20_BlockSize + wordOffset * 4;
+        const __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + offset));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + offset), _mm256_xor_si256(in, blocks[i]));
+    }
+}
+
+/**
+ * @brief Encrypt 8 consecutive blocks starting from the block counter defined in the state.
+ */
+__attribute__((target("avx2")))
+static void chacha20_avx2_xor_8blocks(const uint32_t* state, const unsigned char* input, unsigned char* output) {
+    const __m256i rot16 = _mm256_setr_epi8(
+            2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13,
+            2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+    const __m256i rot8 = _mm256_setr_epi8(
+            3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14,
+            3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14);
+
+    __m256i s[16];
+    for (size_t i = 0; i < 16; ++i) {
+        s[i] = _mm256_set1_epi32((int) state[i]);
+    }
+    s[12] = _mm256_add_epi32(s[12], _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+
+    __m256i x[16];
+    for (size_t i = 0; i < 16; ++i) {
+        x[i] = s[i];
+    }
+    for (int i = 0; i < 10; ++i) {
+        VIRGIL_CHACHA20_AVX2_QUARTER_ROUND(x[0], x[4], x[8], x[12]);
+        VIRGIL_CHACHA20_AVX2_QUARTER_ROUND(x[1], x[5], x[9], x[13]);
+        VIRGIL_CHACHA20_AVX2_QUARTER_ROUND(x[2], x[6], x[10], x[14]);
+        VIRGIL_CHACHA20_AVX2_QUARTER_ROUND(x[3], x[7], x[11], x[15]);
+        VIRGIL_CHACHA20_AVX2_QUARTER_ROUND(x[0], x[5], x[10], x[15]);
+        VIRGIL_CHACHA20_AVX2_QUARTER_ROUND(x[1], x[6], x[11], x[12]);
+        VIRGIL_CHACHA20_AVX2_QUARTER_ROUND(x[2], x[7], x[8], x[13]);
+        VIRGIL_CHACHA20_AVX2_QUARTER_ROUND(x[3], x[4], x[9], x[14]);
+    }
+    for (size_t i = 0; i < 16; ++i) {
+        x[i] = _mm256_add_epi32(x[i], s[i]);
+    }
+
+    chacha20_avx2_xor_words(x, input, output, 0);
+    chacha20_avx2_xor_words(x + 8, input, output, 8);
+}
+
+#undef VIRGIL_CHACHA20_AVX2_QUARTER_ROUND
+#undef VIRGIL_CHACHA20_AVX2_ROTL
+
+#endif // VIRGIL_CRYPTO_X86_INTRINSICS
+
+}}}}
+
+VirgilChaCha20Poly1305::VirgilChaCha20Poly1305() {
+    clear();
+}
+
+VirgilChaCha20Poly1305::~VirgilChaCha20Poly1305() noexcept {
+    clear();
+}
+
+void VirgilChaCha20Poly1305::clear() noexcept {
+    secure_zeroize(state_.data(), sizeof(state_));
+    secure_zeroize(keyStream_.data(), keyStream_.size());
+    secure_zeroize(macR_.data(), sizeof(macR_));
+    secure_zeroize(macH_.data(), sizeof(macH_));
+    secure_zeroize(macPad_.data(), sizeof(macPad_));
+    secure_zeroize(macBuffer_.data(), macBuffer_.size());
+    keyStreamPos_ = kChaCha20_BlockSize;
+    macBufferLen_ = 0;
+    authDataSize_ = 0;
+    dataSize_ = 0;
+    hasKey_ = false;
+    hasNonce_ = false;
+    isStarted_ = false;
+}
+
+void VirgilChaCha20Poly1305::setKey(const unsigned char* key, size_t keySize) {
+    if (keySize != kKeySize) {
+        throw make_error(VirgilCryptoError::InvalidArgument, "Bad key for symmetric cipher.");
+    }
+    state_[0] = 0x61707865;
+    state_[1] = 0x3320646e;
+    state_[2] = 0x79622d32;
+    state_[3] = 0x6b206574;
+    for (size_t i = 0; i < 8; ++i) {
+        state_[4 + i] = load32_le(key + 4 * i);
+    }
+    hasKey_ = true;
+    isStarted_ = false;
+}
+
+void VirgilChaCha20Poly1305::setNonce(const unsigned char* nonce, size_t nonceSize) {
+    if (nonceSize != kNonceSize) {
+        throw make_error(VirgilCryptoError::InvalidArgument, "Bad input vector for symmetric cipher.");
+    }
+    for (size_t i = 0; i < 3; ++i) {
+        state_[13 + i] = load32_le(nonce + 4 * i);
+    }
+    hasNonce_ = true;
+    isStarted_ = false;
+}
+
+void VirgilChaCha20Poly1305::start(const unsigned char* authData, size_t authDataSize) {
+    if (!hasKey_ || !hasNonce_) {
+        throw make_error(VirgilCryptoError::InvalidState, "Key and nonce must be set.");
+    }
+
+    // Block 0 is used to derive one-time Poly1305 key.
+    state_[12] = 0;
+    chacha20_block(state_.data(), keyStream_.data());
+    const unsigned char* macKey = keyStream_.data();
+    macR_[0] = load32_le(macKey + 0) & 0x3ffffff;
+    macR_[1] = (load32_le(macKey + 3) >> 2) & 0x3ffff03;
+    macR_[2] = (load32_le(macKey + 6) >> 4) & 0x3ffc0ff;
+    macR_[3] = (load32_le(macKey + 9) >> 6) & 0x3f03fff;
+    macR_[4] = (load32_le(macKey + 12) >> 8) & 0x00fffff;
+    for (size_t i = 0; i < 4; ++i) {
+        macPad_[i] = load32_le(macKey + 16 + 4 * i);
+    }
+    macH_.fill(0);
+    macBufferLen_ = 0;
+    secure_zeroize(keyStream_.data(), keyStream_.size());
+
+    state_[12] = 1;
+    keyStreamPos_ = kChaCha20_BlockSize;
+    authDataSize_ = authDataSize;
+    dataSize_ = 0;
+    isStarted_ = true;
+
+    macUpdate(authData, authDataSize);
+    macPad();
+}
+
+void VirgilChaCha20Poly1305::encrypt(const unsigned char* input, size_t inputSize, unsigned char* output) {
+    crypt(input, inputSize, output);
+    macUpdate(output, inputSize);
+}
+
+void VirgilChaCha20Poly1305::decrypt(const unsigned char* input, size_t inputSize, unsigned char* output) {
+    if (!isStarted_) {
+        throw make_error(VirgilCryptoError::InvalidState, "Cipher is not started.");
+    }
+    // Authenticate cipher text before it will be overwritten in case of in-place processing.
+    macUpdate(input, inputSize);
+    crypt(input, inputSize, output);
+}
+
+void VirgilChaCha20Poly1305::finish(unsigned char* tag) {
+    if (!isStarted_) {
+        throw make_error(VirgilCryptoError::InvalidState, "Cipher is not started.");
+    }
+    macPad();
+
+    unsigned char lengths[16];
+    store64_le(lengths, authDataSize_);
+    store64_le(lengths + 8, dataSize_);
+    macBlocks(lengths, sizeof(lengths));
+
+    // Fully carry h.
+    uint32_t h0 = macH_[0], h1 = macH_[1], h2 = macH_[2], h3 = macH_[3], h4 = macH_[4];
+    uint32_t c;
+    c = h1 >> 26; h1 &= kPoly1305_LimbMask;
+    h2 += c; c = h2 >> 26; h2 &= kPoly1305_LimbMask;
+    h3 += c; c = h3 >> 26; h3 &= kPoly1305_LimbMask;
+    h4 += c; c = h4 >> 26; h4 &= kPoly1305_LimbMask;
+    h0 += c * 5; c = h0 >> 26; h0 &= kPoly1305_LimbMask;
+    h1 += c;
+
+    // Compute h - p = h + 5 - 2^130 and select it if it is not negative, in the constant time.
+    uint32_t g0 = h0 + 5; c = g0 >> 26; g0 &= kPoly1305_LimbMask;
+    uint32_t g1 = h1 + c; c = g1 >> 26; g1 &= kPoly1305_LimbMask;
+    uint32_t g2 = h2 + c; c = g2 >> 26; g2 &= kPoly1305_LimbMask;
+    uint32_t g3 = h3 + c; c = g3 >> 26; g3 &= kPoly1305_LimbMask;
+    uint32_t g4 = h4 + c - (uint32_t(1) << 26);
+
+    uint32_t mask = (g4 >> 31) - 1;
+    h0 = (h0 & ~mask) | (g0 & mask);
+    h1 = (h1 & ~mask) | (g1 & mask);
+    h2 = (h2 & ~mask) | (g2 & mask);
+    h3 = (h3 & ~mask) | (g3 & mask);
+    h4 = (h4 & ~mask) | (g4 & mask);
+
+    // tag = (h + pad) mod 2^128
+    h0 = h0 | (h1 << 26);
+    h1 = (h1 >> 6) | (h2 << 20);
+    h2 = (h2 >> 12) | (h3 << 14);
+    h3 = (h3 >> 18) | (h4 << 8);
+
+    uint64_t f = uint64_t(h0) + macPad_[0];
+    store32_le(tag, (uint32_t) f);
+    f = uint64_t(h1) + macPad_[1] + (f >> 32);
+    store32_le(tag + 4, (uint32_t) f);
+    f = uint64_t(h2) + macPad_[2] + (f >> 32);
+    store32_le(tag + 8, (uint32_t) f);
+    f = uint64_t(h3) + macPad_[3] + (f >> 32);
+    store32_le(tag + 12, (uint32_t) f);
+
+    secure_zeroize(macH_.data(), sizeof(macH_));
+    isStarted_ = false;
+}
+
+void VirgilChaCha20Poly1305::crypt(const unsigned char* input, size_t inputSize, unsigned char* output) {
+    if (!isStarted_) {
+        throw make_error(VirgilCryptoError::InvalidState, "Cipher is not started.");
+    }
+    if (inputSize > kDataSizeMax - dataSize_) {
+        throw make_error(VirgilCryptoError::InvalidState, "Too much data is processed with the same nonce.");
+    }
+    dataSize_ += inputSize;
+
+    // Use the rest of the previous key stream block.
+    while (inputSize > 0 && keyStreamPos_ < kChaCha20_BlockSize) {
+        *output++ = *input++ ^ keyStream_[keyStreamPos_++];
+        --inputSize;
+    }
+
+#if VIRGIL_CRYPTO_X86_INTRINSICS
+    if (inputSize >= 8 * kChaCha20_BlockSize && cpu_has_avx2()) {
+        do {
+            chacha20_avx2_xor_8blocks(state_.data(), input, output);
+            state_[12] += 8;
+            input += 8 * kChaCha20_BlockSize;
+            output += 8 * kChaCha20_BlockSize;
+            inputSize -= 8 * kChaCha20_BlockSize;
+        } while (inputSize >= 8 * kChaCha20_BlockSize);
+    }
+#endif
+
+    while (inputSize > 0) {
+        chacha20_block(state_.data(), keyStream_.data());
+        ++state_[12];
+        const size_t blockSize = inputSize < kChaCha20_BlockSize ? inputSize : kChaCha20_BlockSize;
+        for (size_t i = 0; i < blockSize; ++i) {
+            output[i] = input[i] ^ keyStream_[i];
+        }
+        keyStreamPos_ = blockSize;
+        input += blockSize;
+        output += blockSize;
+        inputSize -= blockSize;
+    }
+}
+
+void VirgilChaCha20Poly1305::macUpdate(const unsigned char* data, size_t dataSize) {
+    if (macBufferLen_ > 0) {
+        const size_t fillSize = std::min(dataSize, macBuffer_.size() - macBufferLen_);
+        std::memcpy(macBuffer_.data() + macBufferLen_, data, fillSize);
+        macBufferLen_ += fillSize;
+        data += fillSize;
+        dataSize -= fillSize;
+        if (macBufferLen_ < macBuffer_.size()) {
+            return;
+        }
+        macBlocks(macBuffer_.data(), macBuffer_.size());
+        macBufferLen_ = 0;
+    }
+
+    const size_t blocksSize = dataSize & ~size_t(15);
+    if (blocksSize > 0) {
+        macBlocks(data, blocksSize);
+        data += blocksSize;
+        dataSize -= blocksSize;
+    }
+
+    if (dataSize > 0) {
+        std::memcpy(macBuffer_.data(), data, dataSize);
+        macBufferLen_ = dataSize;
+    }
+}
+
+void VirgilChaCha20Poly1305::macPad() {
+    if (macBufferLen_ > 0) {
+        std::memset(macBuffer_.data() + macBufferLen_, 0, macBuffer_.size() - macBufferLen_);
+        macBlocks(macBuffer_.data(), macBuffer_.size());
+        macBufferLen_ = 0;
+    }
+}
+
+void VirgilChaCha20Poly1305::macBlocks(const unsigned char* data, size_t dataSize) {
+    const uint32_t hibit = uint32_t(1) << 24;
+    const uint32_t r0 = macR_[0], r1 = macR_[1], r2 = macR_[2], r3 = macR_[3], r4 = macR_[4];
+    const uint32_t s1 = r1 * 5, s2 = r2 * 5, s3 = r3 * 5, s4 = r4 * 5;
+    uint32_t h0 = macH_[0], h1 = macH_[1], h2 = macH_[2], h3 = macH_[3], h4 = macH_[4];
+
+    for (; dataSize >= 16; data += 16, dataSize -= 16) {
+        h0 += load32_le(data + 0) & kPoly1305_LimbMask;
+        h1 += (load32_le(data + 3) >> 2) & kPoly1305_LimbMask;
+        h2 += (load32_le(data + 6) >> 4) & kPoly1305_LimbMask;
+        h3 += (load32_le(data + 9) >> 6) & kPoly1305_LimbMask;
+        h4 += (load32_le(data + 12) >> 8) | hibit;
+
+        uint64_t d0 = uint64_t(h0) * r0 + uint64_t(h1) * s4 + uint64_t(h2) * s3 + uint64_t(h3) * s2 + uint64_t(h4) * s1;
+        uint64_t d1 = uint64_t(h0) * r1 + uint64_t(h1) * r0 + uint64_t(h2) * s4 + uint64_t(h3) * s3 + uint64_t(h4) * s2;
+        uint64_t d2 = uint64_t(h0) * r2 + uint64_t(h1) * r1 + uint64_t(h2) * r0 + uint64_t(h3) * s4 + uint64_t(h4) * s3;
+        uint64_t d3 = uint64_t(h0) * r3 + uint64_t(h1) * r2 + uint64_t(h2) * r1 + uint64_t(h3) * r0 + uint64_t(h4) * s4;
+        uint64_t d4 = uint64_t(h0) * r4 + uint64_t(h1) * r3 + uint64_t(h2) * r2 + uint64_t(h3) * r1 + uint64_t(h4) * r0;
+
+        uint32_t c = (uint32_t) (d0 >> 26); h0 = (uint32_t) d0 & kPoly1305_LimbMask;
+        d1 += c; c = (uint32_t) (d1 >> 26); h1 = (uint32_t) d1 & kPoly1305_LimbMask;
+        d2 += c; c = (uint32_t) (d2 >> 26); h2 = (uint32_t) d2 & kPoly1305_LimbMask;
+        d3 += c; c = (uint32_t) (d3 >> 26); h3 = (uint32_t) d3 & kPoly1305_LimbMask;
+        d4 += c; c = (uint32_t) (d4 >> 26); h4 = (uint32_t) d4 & kPoly1305_LimbMask;
+        h0 += c * 5; c = h0 >> 26; h0 &= kPoly1305_LimbMask;
+        h1 += c;
+    }
+
+    macH_[0] = h0;
+    macH_[1] = h1;
+    macH_[2] = h2;
+    macH_[3] = h3;
+    macH_[4] = h4;
+}
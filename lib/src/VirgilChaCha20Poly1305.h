@@ -0,0 +1,136 @@
+/**
+ * Copyright (C) 2015-2018 Virgil Security Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *     (3) Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+ */
+
+#ifndef VIRGIL_CRYPTO_CHACHA20_POLY1305_H
+#define VIRGIL_CRYPTO_CHACHA20_POLY1305_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace virgil { namespace crypto { namespace foundation { namespace internal {
+
+/**
+ * @brief ChaCha20-Poly1305 AEAD cipher, as defined in RFC 8439.
+ *
+ * The underlying crypto library does not provide this algorithm, so it is implemented here.
+ * Key stream generation uses AVX2 instructions if they are supported by the CPU,
+ *     otherwise portable implementation is used.
+ *
+ * Usage: setKey(), setNonce(), start(), encrypt() / decrypt() - any number of times, finish().
+ */
+class VirgilChaCha20Poly1305 {
+public:
+    static constexpr size_t kKeySize = 32; ///< Key size in octets
+    static constexpr size_t kNonceSize = 12; ///< Nonce size in octets
+    static constexpr size_t kTagSize = 16; ///< Authentication tag size in octets
+
+    VirgilChaCha20Poly1305();
+
+    ~VirgilChaCha20Poly1305() noexcept;
+
+    /**
+     * @brief Configure key.
+     * @throw VirgilCryptoException with VirgilCryptoError::InvalidArgument, if key size is not kKeySize.
+     */
+    void setKey(const unsigned char* key, size_t keySize);
+
+    /**
+     * @brief Configure nonce.
+     * @throw VirgilCryptoException with VirgilCryptoError::InvalidArgument, if nonce size is not kNonceSize.
+     */
+    void setNonce(const unsigned char* nonce, size_t nonceSize);
+
+    /**
+     * @brief Start new encryption / decryption with given additional authenticated data.
+     * @throw VirgilCryptoException with VirgilCryptoError::InvalidState, if key or nonce is not set.
+     */
+    void start(const unsigned char* authData, size_t authDataSize);
+
+    /**
+     * @brief Encrypt given data.
+     * @note Output MAY be the same as input.
+     */
+    void encrypt(const unsigned char* input, size_t inputSize, unsigned char* output);
+
+    /**
+     * @brief Decrypt given data.
+     * @note Output MAY be the same as input.
+     */
+    void decrypt(const unsigned char* input, size_t inputSize, unsigned char* output);
+
+    /**
+     * @brief Finish encryption / decryption and write authentication tag of kTagSize octets.
+     */
+    void finish(unsigned char* tag);
+
+    /**
+     * @brief Reset all data including key and nonce.
+     */
+    void clear() noexcept;
+
+    VirgilChaCha20Poly1305(const VirgilChaCha20Poly1305&) = delete;
+
+    VirgilChaCha20Poly1305& operator=(const VirgilChaCha20Poly1305&) = delete;
+
+private:
+    void crypt(const unsigned char* input, size_t inputSize, unsigned char* output);
+
+    void macUpdate(const unsigned char* data, size_t dataSize);
+
+    void macBlocks(const unsigned char* data, size_t dataSize);
+
+    void macPad();
+
+private:
+    std::array<uint32_t, 16> state_;
+    std::array<unsigned char, 64> keyStream_;
+    size_t keyStreamPos_;
+    bool hasKey_;
+    bool hasNonce_;
+    bool isStarted_;
+    uint64_t authDataSize_;
+    uint64_t dataSize_;
+    std::array<uint32_t, 5> macR_;
+    std::array<uint32_t, 5> macH_;
+    std::array<uint32_t, 4> macPad_;
+    std::array<unsigned char, 16> macBuffer_;
+    size_t macBufferLen_;
+};
+
+}}}}
+
+#endif /* VIRGIL_CRYPTO_CHACHA20_POLY1305_H */
@@ -36,11 +36,19 @@
 
 #include <virgil/crypto/VirgilChunkCipher.h>
 
+#include <algorithm>
 #include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include <virgil/crypto/VirgilByteArrayUtils.h>
 #include <virgil/crypto/VirgilCryptoError.h>
+#include <virgil/crypto/VirgilCryptoException.h>
 #include <virgil/crypto/foundation/VirgilSymmetricCipher.h>
 #include <virgil/crypto/foundation/VirgilAsymmetricCipher.h>
 
@@ -49,18 +57,38 @@
 using virgil::crypto::VirgilByteArray;
 using virgil::crypto::VirgilByteArrayUtils;
 using virgil::crypto::VirgilChunkCipher;
+using virgil::crypto::VirgilCryptoError;
+using virgil::crypto::VirgilCryptoException;
+using virgil::crypto::VirgilCustomParams;
 using virgil::crypto::VirgilDataSource;
 using virgil::crypto::VirgilDataSink;
+using virgil::crypto::VirgilSeekableDataSource;
+using virgil::crypto::VirgilPrivateKeyHandle;
 using virgil::crypto::foundation::VirgilAsymmetricCipher;
 using virgil::crypto::foundation::VirgilSymmetricCipher;
+using virgil::crypto::make_error;
 
 /**
  * @name Contsants
  */
 ///@{
 static const char* const kCustomParameterKey_ChunkSize = "chunkSize";
+static const char* const kCustomParameterKey_ChunkNonce = "chunkNonce";
+static const int kChunkNonce_Indexed = 1;
+static const size_t kContentInfoReadSize = 4096;
 ///@}
 
+/**
+ * @brief Store chunk size and the way chunk nonce is derived to the given custom parameters.
+ */
+static void store_chunk_params(VirgilCustomParams& customParams, size_t chunkSize) {
+    if (chunkSize > static_cast<size_t>(std::numeric_limits<int>::max())) {
+        throw make_error(VirgilCryptoError::InvalidArgument, "Chunk size is too big.");
+    }
+    customParams.setInteger(kCustomParameterKey_ChunkSize, static_cast<int>(chunkSize));
+    customParams.setInteger(kCustomParameterKey_ChunkNonce, kChunkNonce_Indexed);
+}
+
 namespace virgil { namespace crypto { namespace internal {
 
 static size_t adjustEncryptionChunkSize(size_t preferredChunkSize, size_t cipherBlockSize, bool isSupportPadding) {
@@ -105,6 +133,210 @@ static VirgilByteArray make_unique_nonce(const VirgilByteArray& nonce, const Vir
     return xor_octets(nonce, counter);
 }
 
+static VirgilByteArray make_nonce_counter(size_t counterSize, size_t index) {
+    VirgilByteArray counter(counterSize);
+    for (VirgilByteArray::reverse_iterator it = counter.rbegin(); it != counter.rend() && index != 0; ++it) {
+        *it = static_cast<unsigned char>(index & 0xFF);
+        index >>= 8;
+    }
+    return counter;
+}
+
+static void process_chunk(
+        VirgilSymmetricCipher& symmetricCipher, const VirgilByteArray& nonce, const VirgilByteArray& chunk,
+        VirgilByteArray& processedChunk) {
+    symmetricCipher.setIV(nonce);
+    symmetricCipher.reset();
+    processedChunk.resize(symmetricCipher.updateOutputSizeMax(chunk.size()) + symmetricCipher.finishOutputSizeMax());
+    size_t writtenBytes = symmetricCipher.update(
+            chunk.data(), chunk.size(), processedChunk.data(), processedChunk.size());
+    writtenBytes += symmetricCipher.finish(processedChunk.data() + writtenBytes, processedChunk.size() - writtenBytes);
+    processedChunk.resize(writtenBytes);
+}
+
+/**
+ * @brief Read seekable source sequentially starting from the given position.
+ */
+class SeekableSourceReader : public VirgilDataSource {
+public:
+    SeekableSourceReader(VirgilSeekableDataSource& source, size_t position, size_t portionSize)
+            : source_(source), position_(position), size_(source.size()), portionSize_(portionSize) {}
+
+    bool hasData() override {
+        return position_ < size_;
+    }
+
+    VirgilByteArray read() override {
+        VirgilByteArray portion = source_.readAt(position_, std::min(portionSize_, size_ - position_));
+        if (portion.empty()) {
+            throw make_error(VirgilCryptoError::InvalidState, "Seekable source returned less data than expected.");
+        }
+        position_ += portion.size();
+        return portion;
+    }
+
+private:
+    VirgilSeekableDataSource& source_;
+    size_t position_;
+    const size_t size_;
+    const size_t portionSize_;
+};
+
+/**
+ * @brief Pass to the underlying sink only bytes within range [offset, offset + length).
+ */
+class RangeDataSink : public VirgilDataSink {
+public:
+    RangeDataSink(VirgilDataSink& sink, size_t offset, size_t length)
+            : sink_(sink), skipBytes_(offset), leftBytes_(length) {}
+
+    bool isGood() override {
+        return sink_.isGood();
+    }
+
+    void write(const VirgilByteArray& data) override {
+        const size_t skipBytes = std::min(skipBytes_, data.size());
+        skipBytes_ -= skipBytes;
+        const size_t writeBytes = std::min(leftBytes_, data.size() - skipBytes);
+        leftBytes_ -= writeBytes;
+        if (writeBytes > 0) {
+            VirgilDataSink::safeWrite(sink_,
+                    VirgilByteArray(data.cbegin() + skipBytes, data.cbegin() + skipBytes + writeBytes));
+        }
+    }
+
+private:
+    VirgilDataSink& sink_;
+    size_t skipBytes_;
+    size_t leftBytes_;
+};
+
+/**
+ * @brief Process chunks with a pool of worker threads and write results to the sink in the original order.
+ *
+ * Every worker owns its symmetric cipher.
+ * Sink is accessed from the caller thread only.
+ */
+class ChunkWorkers {
+public:
+    ChunkWorkers(std::vector<VirgilSymmetricCipher> ciphers, VirgilDataSink& sink)
+            : sink_(sink), maxPendingJobs_(2 * ciphers.size()), ciphers_(std::move(ciphers)) {
+        try {
+            for (auto& cipher : ciphers_) {
+                threads_.emplace_back(&ChunkWorkers::run, this, std::ref(cipher));
+            }
+        } catch (...) {
+            stop();
+            throw;
+        }
+    }
+
+    ~ChunkWorkers() noexcept {
+        stop();
+    }
+
+    /**
+     * @brief Schedule chunk processing, blocks while too many chunks are pending.
+     */
+    void push(VirgilByteArray nonce, VirgilByteArray chunk) {
+        while (pendingJobs_.size() >= maxPendingJobs_) {
+            writeFirstPendingJob();
+        }
+
+        std::shared_ptr<Job> job(new Job{ std::move(nonce), std::move(chunk), VirgilByteArray(), nullptr, false });
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pendingJobs_.push_back(job);
+            queuedJobs_.push_back(job);
+        }
+        jobQueued_.notify_one();
+    }
+
+    /**
+     * @brief Wait until all scheduled chunks are processed and written.
+     */
+    void finish() {
+        while (!pendingJobs_.empty()) {
+            writeFirstPendingJob();
+        }
+    }
+
+private:
+    struct Job {
+        VirgilByteArray nonce;
+        VirgilByteArray input;
+        VirgilByteArray output;
+        std::exception_ptr error;
+        bool isDone;
+    };
+
+    void run(VirgilSymmetricCipher& symmetricCipher) {
+        for (;;) {
+            std::shared_ptr<Job> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                jobQueued_.wait(lock, [this]() { return isStopped_ || !queuedJobs_.empty(); });
+                if (isStopped_) {
+                    return;
+                }
+                job = std::move(queuedJobs_.front());
+                queuedJobs_.pop_front();
+            }
+
+            try {
+                process_chunk(symmetricCipher, job->nonce, job->input, job->output);
+            } catch (...) {
+                job->error = std::current_exception();
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                job->isDone = true;
+            }
+            jobDone_.notify_all();
+        }
+    }
+
+    void writeFirstPendingJob() {
+        std::shared_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            job = pendingJobs_.front();
+            jobDone_.wait(lock, [&job]() { return job->isDone; });
+            pendingJobs_.pop_front();
+        }
+
+        if (job->error) {
+            std::rethrow_exception(job->error);
+        }
+        VirgilDataSink::safeWrite(sink_, job->output);
+    }
+
+    void stop() noexcept {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            isStopped_ = true;
+        }
+        jobQueued_.notify_all();
+        for (auto& thread : threads_) {
+            thread.join();
+        }
+        threads_.clear();
+    }
+
+private:
+    VirgilDataSink& sink_;
+    const size_t maxPendingJobs_;
+    std::vector<VirgilSymmetricCipher> ciphers_;
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable jobQueued_;
+    std::condition_variable jobDone_;
+    std::deque<std::shared_ptr<Job>> pendingJobs_;
+    std::deque<std::shared_ptr<Job>> queuedJobs_;
+    bool isStopped_ = false;
+};
+
 }}}
 
 void VirgilChunkCipher::encrypt(
@@ -114,14 +346,7 @@ void VirgilChunkCipher::encrypt(
         clear();
     });
 
-    initEncryption();
-
-    buildContentInfo();
-
-    const size_t actualChunkSize = internal::adjustEncryptionChunkSize(preferredChunkSize,
-            getSymmetricCipher().blockSize(), getSymmetricCipher().isSupportPadding());
-
-    storeChunkSize(actualChunkSize);
+    const size_t actualChunkSize = prepareChunkEncryption(preferredChunkSize);
 
     if (embedContentInfo) {
         VirgilDataSink::safeWrite(sink, getContentInfo());
@@ -130,6 +355,23 @@ void VirgilChunkCipher::encrypt(
     process(source, sink, actualChunkSize);
 }
 
+size_t VirgilChunkCipher::calculateEncryptedSize(size_t dataSize, bool embedContentInfo, size_t preferredChunkSize) {
+    const VirgilSymmetricCipher symmetricCipher(getContentEncryptionAlgorithm());
+    const size_t actualChunkSize = internal::adjustEncryptionChunkSize(preferredChunkSize,
+            symmetricCipher.blockSize(), symmetricCipher.isSupportPadding());
+
+    size_t contentInfoSize = 0;
+    if (embedContentInfo) {
+        contentInfoSize = predictContentInfoSize([actualChunkSize](VirgilCustomParams& customParams) {
+            store_chunk_params(customParams, actualChunkSize);
+        });
+    }
+    const size_t lastChunkSize = dataSize % actualChunkSize;
+    return contentInfoSize +
+            (dataSize / actualChunkSize) * calculateEncryptedPayloadSize(actualChunkSize) +
+            (lastChunkSize > 0 ? calculateEncryptedPayloadSize(lastChunkSize) : 0);
+}
+
 void VirgilChunkCipher::decryptWithKey(
         VirgilDataSource& source, VirgilDataSink& sink, const VirgilByteArray& recipientId,
         const VirgilByteArray& privateKey, const VirgilByteArray& privateKeyPassword) {
@@ -143,6 +385,19 @@ void VirgilChunkCipher::decryptWithKey(
     process(source, sink, 0);
 }
 
+void VirgilChunkCipher::decryptWithKey(
+        VirgilDataSource& source, VirgilDataSink& sink, const VirgilByteArray& recipientId,
+        const VirgilPrivateKeyHandle& privateKey) {
+
+    auto disposer = ScopeGuard([this]() {
+        clear();
+    });
+
+    initDecryptionWithKey(recipientId, privateKey);
+
+    process(source, sink, 0);
+}
+
 void VirgilChunkCipher::decryptWithPassword(
         VirgilDataSource& source, VirgilDataSink& sink, const VirgilByteArray& pwd) {
 
@@ -155,15 +410,63 @@ void VirgilChunkCipher::decryptWithPassword(
     process(source, sink, 0);
 }
 
+void VirgilChunkCipher::decryptRangeWithKey(
+        VirgilSeekableDataSource& source, VirgilDataSink& sink, size_t offset, size_t length,
+        const VirgilByteArray& recipientId, const VirgilByteArray& privateKey,
+        const VirgilByteArray& privateKeyPassword) {
+
+    auto disposer = ScopeGuard([this]() {
+        clear();
+    });
+
+    initDecryptionWithKey(recipientId, privateKey, privateKeyPassword);
+
+    processRange(source, sink, offset, length);
+}
+
+void VirgilChunkCipher::decryptRangeWithKey(
+        VirgilSeekableDataSource& source, VirgilDataSink& sink, size_t offset, size_t length,
+        const VirgilByteArray& recipientId, const VirgilPrivateKeyHandle& privateKey) {
+
+    auto disposer = ScopeGuard([this]() {
+        clear();
+    });
+
+    initDecryptionWithKey(recipientId, privateKey);
+
+    processRange(source, sink, offset, length);
+}
+
+void VirgilChunkCipher::decryptRangeWithPassword(
+        VirgilSeekableDataSource& source, VirgilDataSink& sink, size_t offset, size_t length,
+        const VirgilByteArray& pwd) {
+
+    auto disposer = ScopeGuard([this]() {
+        clear();
+    });
+
+    initDecryptionWithPassword(pwd);
+
+    processRange(source, sink, offset, length);
+}
+
 void VirgilChunkCipher::storeChunkSize(size_t chunkSize) {
-    if (chunkSize > std::numeric_limits<int>::max()) {
-        throw make_error(VirgilCryptoError::InvalidArgument, "Chunk size is too big.");
+    store_chunk_params(customParams(), chunkSize);
+}
+
+void VirgilChunkCipher::setThreadsNum(size_t threadsNum) {
+    threadsNum_ = threadsNum;
+}
+
+size_t VirgilChunkCipher::getThreadsNum() const {
+    if (threadsNum_ == kThreadsNumAuto) {
+        return std::max(std::thread::hardware_concurrency(), 1u);
     }
-    customParams().setInteger(str2bytes(kCustomParameterKey_ChunkSize), static_cast<int>(chunkSize));
+    return threadsNum_;
 }
 
 size_t VirgilChunkCipher::retrieveChunkSize() const {
-    const int chunkSize = customParams().getInteger(str2bytes(kCustomParameterKey_ChunkSize));
+    const int chunkSize = customParams().getInteger(kCustomParameterKey_ChunkSize);
     if (chunkSize < 0) {
         throw make_error(VirgilCryptoError::InvalidFormat, "Retrieved chunk size is negative.");
     }
@@ -171,6 +474,24 @@ size_t VirgilChunkCipher::retrieveChunkSize() const {
 }
 
 
+bool VirgilChunkCipher::isChunkNonceIndexed() const {
+    return customParams().hasInteger(kCustomParameterKey_ChunkNonce) &&
+            customParams().getInteger(kCustomParameterKey_ChunkNonce) == kChunkNonce_Indexed;
+}
+
+size_t VirgilChunkCipher::prepareChunkEncryption(size_t preferredChunkSize) {
+    initEncryption();
+
+    buildContentInfo();
+
+    const size_t actualChunkSize = internal::adjustEncryptionChunkSize(preferredChunkSize,
+            getSymmetricCipher().blockSize(), getSymmetricCipher().isSupportPadding());
+
+    storeChunkSize(actualChunkSize);
+
+    return actualChunkSize;
+}
+
 void VirgilChunkCipher::process(VirgilDataSource& source, VirgilDataSink& sink, size_t actualChunkSize) {
 
     VirgilByteArray data;
@@ -190,9 +511,30 @@ void VirgilChunkCipher::process(VirgilDataSource& source, VirgilDataSink& sink,
             symmetricCipher.authTagLength());
     }
 
+    // Setup workers
+    std::unique_ptr<internal::ChunkWorkers> workers;
+    const size_t threadsNum = getThreadsNum();
+    if (threadsNum > 1) {
+        std::vector<VirgilSymmetricCipher> ciphers;
+        ciphers.reserve(threadsNum);
+        for (size_t i = 0; i < threadsNum; ++i) {
+            ciphers.push_back(createSymmetricCipher());
+        }
+        workers.reset(new internal::ChunkWorkers(std::move(ciphers), sink));
+    }
+
+    const bool isNonceIndexed = isReadyForEncryption() || isChunkNonceIndexed();
+    VirgilByteArray nonce = symmetricCipher.iv();
+    VirgilByteArray nonceCounter(symmetricCipher.ivSize());
+    VirgilByteArray lastNonce = nonce;
+    VirgilByteArray processedChunk;
+
     do {
-        VirgilByteArray nonceCounter(symmetricCipher.ivSize());
-        const VirgilByteArray nonce = symmetricCipher.iv();
+        if (!isNonceIndexed) {
+            // Previous versions restart counter from the last used nonce for every collected portion of chunks.
+            nonce = lastNonce;
+            nonceCounter.assign(nonceCounter.size(), 0);
+        }
 
         // Collect data for full chunk
         while (source.hasData() && data.size() < actualChunkSize) {
@@ -200,15 +542,82 @@ void VirgilChunkCipher::process(VirgilDataSource& source, VirgilDataSink& sink,
         }
         // Process (encrypt/decrypt)
         while (data.size() >= actualChunkSize || (!data.empty() && !source.hasData())) {
-            // Reconfigure symmetric cipher
-            symmetricCipher.setIV(internal::make_unique_nonce(nonce, nonceCounter));
-            symmetricCipher.reset();
-            const VirgilByteArray chunk = VirgilByteArrayUtils::popBytes(data, actualChunkSize);
-            VirgilByteArray processedChunk;
-            VirgilByteArrayUtils::append(processedChunk, symmetricCipher.update(chunk));
-            VirgilByteArrayUtils::append(processedChunk, symmetricCipher.finish());
+            lastNonce = internal::make_unique_nonce(nonce, nonceCounter);
+            VirgilByteArray chunk = VirgilByteArrayUtils::popBytes(data, actualChunkSize);
             internal::increment_octets(nonceCounter);
-            VirgilDataSink::safeWrite(sink, processedChunk);
+            if (workers) {
+                workers->push(lastNonce, std::move(chunk));
+            } else {
+                internal::process_chunk(symmetricCipher, lastNonce, chunk, processedChunk);
+                VirgilDataSink::safeWrite(sink, processedChunk);
+            }
         }
     } while (source.hasData());
+
+    if (workers) {
+        workers->finish();
+    }
+}
+
+void VirgilChunkCipher::processRange(
+        VirgilSeekableDataSource& source, VirgilDataSink& sink, size_t offset, size_t length) {
+
+    const size_t sourceSize = source.size();
+
+    // Read until Content Info fully read.
+    size_t position = 0;
+    VirgilByteArray data;
+    do {
+        VirgilByteArray portion = source.readAt(position, std::min(kContentInfoReadSize, sourceSize - position));
+        position += portion.size();
+        data = filterAndSetupContentInfo(portion, position >= sourceSize || portion.empty());
+    } while (!isReadyForDecryption() && position < sourceSize);
+
+    const size_t encryptedDataOffset = position - data.size();
+
+    auto& symmetricCipher = getSymmetricCipher();
+    const size_t chunkSize = retrieveChunkSize();
+    const size_t encryptedChunkSize = internal::adjustDecryptionChunkSize(chunkSize,
+            symmetricCipher.blockSize(), symmetricCipher.isSupportPadding(),
+            symmetricCipher.authTagLength());
+
+    if (length == 0 || encryptedDataOffset >= sourceSize) {
+        return;
+    }
+
+    if (chunkSize == 0) {
+        throw make_error(VirgilCryptoError::InvalidFormat, "Retrieved chunk size is zero.");
+    }
+
+    if (!isChunkNonceIndexed()) {
+        internal::SeekableSourceReader reader(source, encryptedDataOffset, encryptedChunkSize);
+        internal::RangeDataSink rangeSink(sink, offset, length);
+        process(reader, rangeSink, 0);
+        return;
+    }
+
+    const size_t chunksNum = (sourceSize - encryptedDataOffset + encryptedChunkSize - 1) / encryptedChunkSize;
+    const size_t firstChunkIndex = offset / chunkSize;
+    if (firstChunkIndex >= chunksNum) {
+        return;
+    }
+    const size_t rangeEnd = length > std::numeric_limits<size_t>::max() - offset ?
+            std::numeric_limits<size_t>::max() : offset + length;
+    const size_t lastChunkIndex = std::min((rangeEnd - 1) / chunkSize, chunksNum - 1);
+
+    const VirgilByteArray nonce = symmetricCipher.iv();
+    VirgilByteArray processedChunk;
+    internal::RangeDataSink rangeSink(sink, offset - firstChunkIndex * chunkSize, length);
+    for (size_t chunkIndex = firstChunkIndex; chunkIndex <= lastChunkIndex; ++chunkIndex) {
+        const size_t chunkOffset = encryptedDataOffset + chunkIndex * encryptedChunkSize;
+        const size_t chunkLength = std::min(encryptedChunkSize, sourceSize - chunkOffset);
+        const VirgilByteArray chunk = source.readAt(chunkOffset, chunkLength);
+        if (chunk.size() != chunkLength) {
+            throw make_error(VirgilCryptoError::InvalidState, "Seekable source returned less data than expected.");
+        }
+        const VirgilByteArray chunkNonce = internal::make_unique_nonce(
+                nonce, internal::make_nonce_counter(nonce.size(), chunkIndex));
+        internal::process_chunk(symmetricCipher, chunkNonce, chunk, processedChunk);
+        rangeSink.write(processedChunk);
+    }
 }
@@ -42,10 +42,13 @@
 
 #include "ScopeGuard.h"
 
+#include <cstring>
+
 using virgil::crypto::VirgilCipher;
 using virgil::crypto::VirgilCryptoError;
 using virgil::crypto::VirgilByteArray;
 using virgil::crypto::VirgilByteArrayUtils;
+using virgil::crypto::VirgilPrivateKeyHandle;
 using virgil::crypto::foundation::VirgilSymmetricCipher;
 
 using virgil::crypto::make_error;
@@ -58,21 +61,78 @@ VirgilByteArray VirgilCipher::encrypt(const VirgilByteArray& data, bool embedCon
 
     initEncryption();
 
-    VirgilByteArray encryptedData;
-
     buildContentInfo();
 
+    const size_t payloadOffset = embedContentInfo ? calculateContentInfoSize() : 0;
+    VirgilByteArray encryptedData(payloadOffset + calculateEncryptedPayloadSize(data.size()));
     if (embedContentInfo) {
-        VirgilByteArray contentInfo = getContentInfo();
-        encryptedData.swap(contentInfo);
+        writeContentInfo(encryptedData.data(), payloadOffset);
     }
 
-    VirgilByteArrayUtils::append(encryptedData, getSymmetricCipher().update(data));
-    VirgilByteArrayUtils::append(encryptedData, getSymmetricCipher().finish());
+    const size_t writtenBytes = encryptPayload(
+            data.data(), data.size(), encryptedData.data() + payloadOffset, encryptedData.size() - payloadOffset);
+    encryptedData.resize(payloadOffset + writtenBytes);
 
     return encryptedData;
 }
 
+size_t VirgilCipher::calculateEncryptedSize(size_t dataSize, bool embedContentInfo) {
+    const size_t contentInfoSize = embedContentInfo ? predictContentInfoSize() : 0;
+    return contentInfoSize + calculateEncryptedPayloadSize(dataSize);
+}
+
+size_t VirgilCipher::encrypt(
+        const unsigned char* data, size_t dataSize, unsigned char* encryptedData, size_t encryptedDataCapacity,
+        bool embedContentInfo) {
+
+    auto disposer = ScopeGuard([this]() {
+        clear();
+    });
+
+    initEncryption();
+
+    buildContentInfo();
+
+    size_t writtenBytes = 0;
+    if (embedContentInfo) {
+        const size_t contentInfoSize = calculateContentInfoSize();
+        if (encryptedDataCapacity < contentInfoSize + calculateEncryptedPayloadSize(dataSize)) {
+            throw make_error(VirgilCryptoError::InvalidArgument, "Output buffer is too small.");
+        }
+        writtenBytes += writeContentInfo(encryptedData, contentInfoSize);
+    }
+
+    writtenBytes += encryptPayload(data, dataSize, encryptedData + writtenBytes, encryptedDataCapacity - writtenBytes);
+    return writtenBytes;
+}
+
+size_t VirgilCipher::encryptPayload(
+        const unsigned char* data, size_t dataSize, unsigned char* encryptedData, size_t encryptedDataCapacity) {
+
+    if (encryptedDataCapacity < calculateEncryptedPayloadSize(dataSize)) {
+        throw make_error(VirgilCryptoError::InvalidArgument, "Output buffer is too small.");
+    }
+
+    // Whole blocks are encrypted directly to the output buffer, the rest with padding
+    // is encrypted to the small buffer, because update() and finish() require room for the whole block.
+    auto& symmetricCipher = getSymmetricCipher();
+    const size_t directSize =
+            symmetricCipher.isAuthMode() ? dataSize : dataSize - dataSize % symmetricCipher.blockSize();
+    size_t writtenBytes = symmetricCipher.update(data, directSize, encryptedData, encryptedDataCapacity);
+
+    const size_t tailSize = dataSize - directSize;
+    VirgilByteArray tail(symmetricCipher.updateOutputSizeMax(tailSize) + symmetricCipher.finishOutputSizeMax());
+    size_t tailWrittenBytes = symmetricCipher.update(data + directSize, tailSize, tail.data(), tail.size());
+    tailWrittenBytes += symmetricCipher.finish(tail.data() + tailWrittenBytes, tail.size() - tailWrittenBytes);
+    if (writtenBytes + tailWrittenBytes > encryptedDataCapacity) {
+        throw make_error(VirgilCryptoError::InvalidArgument, "Output buffer is too small.");
+    }
+    std::memcpy(encryptedData + writtenBytes, tail.data(), tailWrittenBytes);
+    writtenBytes += tailWrittenBytes;
+
+    return writtenBytes;
+}
+
 VirgilByteArray VirgilCipher::decryptWithKey(
         const VirgilByteArray& encryptedData,
         const VirgilByteArray& recipientId, const VirgilByteArray& privateKey,
@@ -83,6 +143,15 @@ VirgilByteArray VirgilCipher::decryptWithKey(
     return decrypt(encryptedData);
 }
 
+VirgilByteArray VirgilCipher::decryptWithKey(
+        const VirgilByteArray& encryptedData,
+        const VirgilByteArray& recipientId, const VirgilPrivateKeyHandle& privateKey) {
+
+    initDecryptionWithKey(recipientId, privateKey);
+
+    return decrypt(encryptedData);
+}
+
 VirgilByteArray VirgilCipher::decryptWithPassword(const VirgilByteArray& encryptedData, const VirgilByteArray& pwd) {
 
     initDecryptionWithPassword(pwd);
@@ -97,14 +166,83 @@ VirgilByteArray VirgilCipher::decrypt(const VirgilByteArray& encryptedData) {
         clear();
     });
 
-    auto payload = filterAndSetupContentInfo(encryptedData, true);
+    // Payload is decrypted in place, only bytes held by the content info filter are decrypted separately.
+    VirgilByteArray bufferedPayload;
+    const size_t contentInfoSize =
+            filterAndSetupContentInfo(encryptedData.data(), encryptedData.size(), true, bufferedPayload);
+    const unsigned char* payload = encryptedData.data() + contentInfoSize;
+    const size_t payloadSize = encryptedData.size() - contentInfoSize;
+
+    auto& symmetricCipher = getSymmetricCipher();
+    VirgilByteArray decryptedData(
+            symmetricCipher.updateOutputSizeMax(bufferedPayload.size() + payloadSize) +
+                    symmetricCipher.finishOutputSizeMax());
+
+    size_t writtenBytes = symmetricCipher.update(
+            bufferedPayload.data(), bufferedPayload.size(), decryptedData.data(), decryptedData.size());
+    writtenBytes += symmetricCipher.update(
+            payload, payloadSize, decryptedData.data() + writtenBytes, decryptedData.size() - writtenBytes);
+    writtenBytes += symmetricCipher.finish(decryptedData.data() + writtenBytes, decryptedData.size() - writtenBytes);
+    decryptedData.resize(writtenBytes);
+
+    return decryptedData;
+}
+
+
+VirgilByteArray VirgilCipher::encryptCompact(const VirgilByteArray& data) {
+
+    auto disposer = ScopeGuard([this]() {
+        clear();
+    });
+
+    VirgilByteArray encryptedData = initCompactEncryption();
+
+    const size_t payloadOffset = encryptedData.size();
+    encryptedData.resize(payloadOffset + calculateEncryptedPayloadSize(data.size()));
+
+    const size_t writtenBytes = encryptPayload(
+            data.data(), data.size(), encryptedData.data() + payloadOffset, encryptedData.size() - payloadOffset);
+    encryptedData.resize(payloadOffset + writtenBytes);
+
+    return encryptedData;
+}
+
+VirgilByteArray VirgilCipher::decryptCompactWithKey(
+        const VirgilByteArray& encryptedData,
+        const VirgilByteArray& recipientId, const VirgilByteArray& privateKey,
+        const VirgilByteArray& privateKeyPassword) {
+
+    initDecryptionWithKey(recipientId, privateKey, privateKeyPassword);
+
+    return decryptCompact(encryptedData);
+}
+
+VirgilByteArray VirgilCipher::decryptCompactWithKey(
+        const VirgilByteArray& encryptedData,
+        const VirgilByteArray& recipientId, const VirgilPrivateKeyHandle& privateKey) {
+
+    initDecryptionWithKey(recipientId, privateKey);
+
+    return decryptCompact(encryptedData);
+}
+
+VirgilByteArray VirgilCipher::decryptCompact(const VirgilByteArray& encryptedData) {
+
+    auto disposer = ScopeGuard([this]() {
+        clear();
+    });
 
-    size_t payloadSize = payload.size();
+    const size_t headerSize = initCompactDecryption(encryptedData.data(), encryptedData.size());
+    const unsigned char* payload = encryptedData.data() + headerSize;
+    const size_t payloadSize = encryptedData.size() - headerSize;
 
-    auto decryptedData = getSymmetricCipher().update(payload);
-    auto decryptedDataEnd = getSymmetricCipher().finish();
+    auto& symmetricCipher = getSymmetricCipher();
+    VirgilByteArray decryptedData(
+            symmetricCipher.updateOutputSizeMax(payloadSize) + symmetricCipher.finishOutputSizeMax());
 
-    VirgilByteArrayUtils::append(decryptedData, decryptedDataEnd);
+    size_t writtenBytes = symmetricCipher.update(payload, payloadSize, decryptedData.data(), decryptedData.size());
+    writtenBytes += symmetricCipher.finish(decryptedData.data() + writtenBytes, decryptedData.size() - writtenBytes);
+    decryptedData.resize(writtenBytes);
 
     return decryptedData;
 }
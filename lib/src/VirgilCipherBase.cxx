@@ -42,25 +42,46 @@
 #include <virgil/crypto/foundation/VirgilRandom.h>
 #include <virgil/crypto/foundation/VirgilSymmetricCipher.h>
 #include <virgil/crypto/foundation/VirgilAsymmetricCipher.h>
+#include <virgil/crypto/foundation/VirgilHash.h>
 #include <virgil/crypto/foundation/VirgilPBE.h>
 
 #include "utils.h"
+#include "ScopeGuard.h"
+#include "VirgilCompactEnvelope.h"
 #include "VirgilContentInfoFilter.h"
+#include "VirgilKeyAgreement.h"
+#include "VirgilPBES2.h"
+#include "VirgilParallelFor.h"
+
+#include <cstdint>
+#include <initializer_list>
+#include <mutex>
+#include <vector>
 
 using virgil::crypto::VirgilByteArray;
 using virgil::crypto::VirgilByteArrayUtils;
 using virgil::crypto::VirgilCipherBase;
+using virgil::crypto::VirgilContentKeyCache;
 using virgil::crypto::VirgilCustomParams;
 using virgil::crypto::VirgilCryptoError;
 using virgil::crypto::VirgilContentInfo;
+using virgil::crypto::VirgilKeyPair;
+using virgil::crypto::VirgilPublicKeyHandle;
+using virgil::crypto::VirgilPrivateKeyHandle;
 using virgil::crypto::make_error;
 
 using virgil::crypto::foundation::VirgilRandom;
 using virgil::crypto::foundation::VirgilSymmetricCipher;
 using virgil::crypto::foundation::VirgilAsymmetricCipher;
+using virgil::crypto::foundation::VirgilHash;
 using virgil::crypto::foundation::VirgilPBE;
 
+using virgil::crypto::foundation::internal::VirgilKeyAgreement;
+using virgil::crypto::foundation::internal::VirgilPBES2;
+
+using virgil::crypto::internal::VirgilCompactEnvelope;
 using virgil::crypto::internal::VirgilContentInfoFilter;
+using virgil::crypto::internal::parallel_for;
 
 namespace virgil { namespace crypto {
 
@@ -71,18 +92,29 @@ class VirgilCipherBase::Impl {
 public:
     Impl() noexcept :
             random(VirgilByteArrayUtils::stringToBytes(std::string("virgil::VirgilCipherBase"))),
+            contentEncryptionAlgorithm(VirgilSymmetricCipher::Algorithm::AES_256_GCM),
             symmetricCipher(), symmetricCipherKey(), contentInfo(), contentInfoFilter(),
-            recipientId(), privateKey(), pwd(), isInited(false) {}
+            recipientId(), privateKey(), privateKeyHandle(), pwd(), recipientsThreadsNum(1), decryptionThreadsNum(1),
+            isSharedEphemeralKeyEnabled(false), isKeyRecipientFilterEnabled(false), contentKeyCache(),
+            contentInfoDigest(), isInited(false) {}
 
 public:
     VirgilRandom random;
+    VirgilSymmetricCipher::Algorithm contentEncryptionAlgorithm;
     VirgilSymmetricCipher symmetricCipher;
     VirgilByteArray symmetricCipherKey;
     VirgilContentInfo contentInfo;
     VirgilContentInfoFilter contentInfoFilter;
     VirgilByteArray recipientId;
     VirgilByteArray privateKey;
+    std::unique_ptr<VirgilPrivateKeyHandle> privateKeyHandle;
     VirgilByteArray pwd;
+    size_t recipientsThreadsNum;
+    size_t decryptionThreadsNum;
+    bool isSharedEphemeralKeyEnabled;
+    bool isKeyRecipientFilterEnabled;
+    std::unique_ptr<VirgilContentKeyCache> contentKeyCache;
+    VirgilByteArray contentInfoDigest;
     bool isInited;
 };
 
@@ -94,10 +126,26 @@ public:
 ///@{
 static constexpr VirgilSymmetricCipher::Padding
         kSymmetricCipher_Padding = VirgilSymmetricCipher::Padding::PKCS7;
-static constexpr VirgilSymmetricCipher::Algorithm
-        kSymmetricCipher_Algorithm = VirgilSymmetricCipher::Algorithm::AES_256_GCM;
+static constexpr VirgilHash::Algorithm kContentKeyCache_HashAlgorithm = VirgilHash::Algorithm::SHA256;
 ///@}
 
+/**
+ * @brief Hash given parts, each part is prefixed with its length to make concatenation unambiguous.
+ */
+static VirgilByteArray hash_parts(std::initializer_list<const VirgilByteArray*> parts) {
+    VirgilHash hash(kContentKeyCache_HashAlgorithm);
+    hash.start();
+    for (const auto part : parts) {
+        VirgilByteArray partSize(8);
+        for (size_t i = 0; i < partSize.size(); ++i) {
+            partSize[partSize.size() - 1 - i] = static_cast<unsigned char>(uint64_t(part->size()) >> (8 * i));
+        }
+        hash.update(partSize);
+        hash.update(*part);
+    }
+    return hash.finish();
+}
+
 VirgilCipherBase::VirgilCipherBase() : impl_(std::make_unique<Impl>()) {}
 
 VirgilCipherBase::VirgilCipherBase(VirgilCipherBase&& rhs) noexcept = default;
@@ -107,7 +155,10 @@ VirgilCipherBase& VirgilCipherBase::operator=(VirgilCipherBase&& rhs) noexcept =
 VirgilCipherBase::~VirgilCipherBase() noexcept = default;
 
 void VirgilCipherBase::addKeyRecipient(const VirgilByteArray& recipientId, const VirgilByteArray& publicKey) {
-    VirgilAsymmetricCipher::checkPublicKey(publicKey);
+    addKeyRecipient(recipientId, VirgilPublicKeyHandle(publicKey));
+}
+
+void VirgilCipherBase::addKeyRecipient(const VirgilByteArray& recipientId, const VirgilPublicKeyHandle& publicKey) {
     impl_->contentInfo.addKeyRecipient(recipientId, publicKey);
 }
 
@@ -139,8 +190,17 @@ VirgilByteArray VirgilCipherBase::getContentInfo() const {
     return impl_->contentInfo.toAsn1();
 }
 
+size_t VirgilCipherBase::calculateContentInfoSize() const {
+    return impl_->contentInfo.calculateAsn1Size();
+}
+
+size_t VirgilCipherBase::writeContentInfo(unsigned char* buffer, size_t bufferSize) const {
+    return impl_->contentInfo.toAsn1(buffer, bufferSize);
+}
+
 void VirgilCipherBase::setContentInfo(const VirgilByteArray& contentInfo) {
     impl_->contentInfo.fromAsn1(contentInfo);
+    impl_->contentInfoDigest = impl_->contentKeyCache ? hash_parts({ &contentInfo }) : VirgilByteArray();
 }
 
 VirgilCustomParams& VirgilCipherBase::customParams() {
@@ -151,6 +211,68 @@ const VirgilCustomParams& VirgilCipherBase::customParams() const {
     return impl_->contentInfo.customParams();
 }
 
+void VirgilCipherBase::setContentEncryptionAlgorithm(VirgilSymmetricCipher::Algorithm algorithm) {
+    impl_->contentEncryptionAlgorithm = algorithm;
+}
+
+VirgilSymmetricCipher::Algorithm VirgilCipherBase::getContentEncryptionAlgorithm() const {
+    return impl_->contentEncryptionAlgorithm;
+}
+
+void VirgilCipherBase::setRecipientsThreadsNum(size_t threadsNum) {
+    impl_->recipientsThreadsNum = threadsNum;
+}
+
+size_t VirgilCipherBase::getRecipientsThreadsNum() const {
+    if (impl_->recipientsThreadsNum == kThreadsNumAuto) {
+        return internal::hardware_threads_num();
+    }
+    return impl_->recipientsThreadsNum;
+}
+
+void VirgilCipherBase::setDecryptionThreadsNum(size_t threadsNum) {
+    impl_->decryptionThreadsNum = threadsNum;
+}
+
+size_t VirgilCipherBase::getDecryptionThreadsNum() const {
+    if (impl_->decryptionThreadsNum == kThreadsNumAuto) {
+        return internal::hardware_threads_num();
+    }
+    return impl_->decryptionThreadsNum;
+}
+
+void VirgilCipherBase::setSharedEphemeralKeyEnabled(bool enabled) {
+    impl_->isSharedEphemeralKeyEnabled = enabled;
+}
+
+bool VirgilCipherBase::isSharedEphemeralKeyEnabled() const {
+    return impl_->isSharedEphemeralKeyEnabled;
+}
+
+void VirgilCipherBase::setCompactContentInfoEnabled(bool enabled) {
+    impl_->contentInfo.setCompactEncodingEnabled(enabled);
+}
+
+bool VirgilCipherBase::isCompactContentInfoEnabled() const {
+    return impl_->contentInfo.isCompactEncodingEnabled();
+}
+
+void VirgilCipherBase::setKeyRecipientFilterEnabled(bool enabled) {
+    impl_->isKeyRecipientFilterEnabled = enabled;
+}
+
+bool VirgilCipherBase::isKeyRecipientFilterEnabled() const {
+    return impl_->isKeyRecipientFilterEnabled;
+}
+
+void VirgilCipherBase::setContentKeyCache(const VirgilContentKeyCache& contentKeyCache) {
+    impl_->contentKeyCache = std::make_unique<VirgilContentKeyCache>(contentKeyCache);
+}
+
+void VirgilCipherBase::removeContentKeyCache() {
+    impl_->contentKeyCache.reset();
+}
+
 size_t VirgilCipherBase::defineContentInfoSize(const VirgilByteArray& data) {
     return VirgilContentInfo::defineSize(data);
 }
@@ -166,17 +288,40 @@ VirgilByteArray VirgilCipherBase::computeShared(
     return VirgilAsymmetricCipher::computeShared(publicContext, privateContext);
 }
 
+VirgilByteArray VirgilCipherBase::computeShared(
+        const VirgilPublicKeyHandle& publicKey, const VirgilPrivateKeyHandle& privateKey) {
 
-VirgilByteArray VirgilCipherBase::filterAndSetupContentInfo(const VirgilByteArray& encryptedData, bool isLastChunk) {
+    return VirgilAsymmetricCipher::computeShared(*publicKey.acquireCipher(), *privateKey.acquireCipher());
+}
 
-    size_t encryptedDataSize = encryptedData.size();
+
+VirgilByteArray VirgilCipherBase::filterAndSetupContentInfo(const VirgilByteArray& encryptedData, bool isLastChunk) {
 
     if (impl_->contentInfoFilter.isDone()) {
         return encryptedData;
     }
 
+    VirgilByteArray payload;
+    const size_t consumedSize =
+            filterAndSetupContentInfo(encryptedData.data(), encryptedData.size(), isLastChunk, payload);
+    payload.insert(payload.end(), encryptedData.begin() + consumedSize, encryptedData.end());
+    return payload;
+}
+
+
+size_t VirgilCipherBase::filterAndSetupContentInfo(
+        const unsigned char* encryptedData, size_t encryptedDataSize, bool isLastChunk,
+        VirgilByteArray& bufferedPayload) {
+
+    bufferedPayload.clear();
+
+    if (impl_->contentInfoFilter.isDone()) {
+        return 0;
+    }
+
+    size_t consumedSize = 0;
     if (impl_->contentInfoFilter.isWaitingData()) {
-        impl_->contentInfoFilter.filterData(encryptedData);
+        consumedSize = impl_->contentInfoFilter.filterData(encryptedData, encryptedDataSize);
     }
 
     if (isLastChunk) {
@@ -186,13 +331,19 @@ VirgilByteArray VirgilCipherBase::filterAndSetupContentInfo(const VirgilByteArra
     if (impl_->contentInfoFilter.isContentInfoAbsent()) {
         impl_->contentInfoFilter.finish();
         accomplishInitDecryption();
-        return impl_->contentInfoFilter.popEncryptedData();
+        bufferedPayload = impl_->contentInfoFilter.popEncryptedData();
 
     } else if (impl_->contentInfoFilter.isContentInfoFound()) {
-        setContentInfo(impl_->contentInfoFilter.popContentInfo());
+        if (impl_->isKeyRecipientFilterEnabled && !impl_->recipientId.empty()) {
+            const VirgilByteArray contentInfo = impl_->contentInfoFilter.popContentInfo();
+            impl_->contentInfo.fromAsn1(contentInfo, impl_->recipientId);
+            impl_->contentInfoDigest = impl_->contentKeyCache ? hash_parts({ &contentInfo }) : VirgilByteArray();
+        } else {
+            setContentInfo(impl_->contentInfoFilter.popContentInfo());
+        }
         impl_->contentInfoFilter.finish();
         accomplishInitDecryption();
-        return impl_->contentInfoFilter.popEncryptedData();
+        bufferedPayload = impl_->contentInfoFilter.popEncryptedData();
 
     } else if (impl_->contentInfoFilter.isContentInfoBroken()) {
         throw make_error(VirgilCryptoError::InvalidArgument,
@@ -202,14 +353,13 @@ VirgilByteArray VirgilCipherBase::filterAndSetupContentInfo(const VirgilByteArra
         accomplishInitDecryption();
     }
 
-    //  Still waiting for data to be filtered.
-    return VirgilByteArray();
+    return consumedSize;
 }
 
 
 void VirgilCipherBase::initEncryption() {
 
-    impl_->symmetricCipher = VirgilSymmetricCipher(kSymmetricCipher_Algorithm);
+    impl_->symmetricCipher = VirgilSymmetricCipher(impl_->contentEncryptionAlgorithm);
     impl_->symmetricCipherKey = impl_->random.randomize(impl_->symmetricCipher.keyLength());
     auto symmetricCipherIV = impl_->random.randomize(impl_->symmetricCipher.ivSize());
     impl_->symmetricCipher.setEncryptionKey(impl_->symmetricCipherKey);
@@ -224,23 +374,104 @@ void VirgilCipherBase::initEncryption() {
 }
 
 
-void VirgilCipherBase::accomplishInitDecryption() {
-    VirgilByteArray contentEncryptionKey;
+size_t VirgilCipherBase::predictContentInfoSize(
+        const std::function<void(VirgilCustomParams&)>& setupCustomParams) {
 
+    VirgilSymmetricCipher symmetricCipher(impl_->contentEncryptionAlgorithm);
+    const VirgilByteArray symmetricCipherKey(symmetricCipher.keyLength(), 0x00);
+    symmetricCipher.setEncryptionKey(symmetricCipherKey);
+    symmetricCipher.setIV(VirgilByteArray(symmetricCipher.ivSize(), 0x00));
+
+    VirgilContentInfo contentInfo(impl_->contentInfo);
+    encryptContentEncryptionKey(contentInfo, symmetricCipherKey);
+    contentInfo.setContentEncryptionAlgorithm(symmetricCipher.toAsn1());
+    if (setupCustomParams) {
+        setupCustomParams(contentInfo.customParams());
+    }
+    return contentInfo.calculateAsn1Size();
+}
+
+
+size_t VirgilCipherBase::calculateEncryptedPayloadSize(size_t dataSize) const {
+    const auto size_for = [dataSize](const VirgilSymmetricCipher& symmetricCipher) -> size_t {
+        if (symmetricCipher.isAuthMode()) {
+            return dataSize + symmetricCipher.authTagLength();
+        }
+        if (symmetricCipher.isSupportPadding()) {
+            return (dataSize / symmetricCipher.blockSize() + 1) * symmetricCipher.blockSize();
+        }
+        return dataSize;
+    };
+
+    if (isReadyForEncryption()) {
+        return size_for(impl_->symmetricCipher);
+    }
+    return size_for(VirgilSymmetricCipher(impl_->contentEncryptionAlgorithm));
+}
+
+
+void VirgilCipherBase::accomplishInitDecryption() {
     if (!impl_->contentInfo.isReadyForDecryption()) {
         throw make_error(VirgilCryptoError::InvalidState,
             "Content info is absent. It can be provided manually,"
             " or extracted as a part of encrypted data if it was embedded during encryption.");
     }
 
+    VirgilByteArray contentEncryptionKey = acquireContentEncryptionKey();
+
+    impl_->symmetricCipher = VirgilSymmetricCipher();
+    impl_->symmetricCipher.fromAsn1(impl_->contentInfo.getContentEncryptionAlgorithm());
+    impl_->symmetricCipher.setDecryptionThreadsNum(getDecryptionThreadsNum());
+    impl_->symmetricCipher.setDecryptionKey(contentEncryptionKey);
+
+    if (impl_->symmetricCipher.isSupportPadding()) {
+        impl_->symmetricCipher.setPadding(kSymmetricCipher_Padding);
+    }
+
+    impl_->symmetricCipher.reset();
+    impl_->symmetricCipherKey = std::move(contentEncryptionKey);
+}
+
+
+VirgilByteArray VirgilCipherBase::acquireContentEncryptionKey() {
+    VirgilByteArray contentEncryptionKey;
+    if (impl_->contentKeyCache) {
+        const VirgilByteArray entryId = defineContentKeyCacheEntryId();
+        contentEncryptionKey = impl_->contentKeyCache->find(entryId);
+        if (contentEncryptionKey.empty()) {
+            contentEncryptionKey = decryptContentEncryptionKey();
+            impl_->contentKeyCache->insert(entryId, contentEncryptionKey);
+        }
+    } else {
+        contentEncryptionKey = decryptContentEncryptionKey();
+    }
+    return contentEncryptionKey;
+}
+
+
+VirgilByteArray VirgilCipherBase::decryptContentEncryptionKey() {
+    VirgilByteArray contentEncryptionKey;
+
     if (impl_->recipientId.empty()) {
         // Password decryption.
+        // Every recipient has its own random salt, so key is derived from the password for each of them.
         contentEncryptionKey = impl_->contentInfo.decryptPasswordRecipient(
                 [&, this](
-                        const VirgilByteArray& keyEncryptionAlgorithm,
-                        const VirgilByteArray& encryptedKey) -> VirgilByteArray {
-                    return doDecryptWithPassword(encryptedKey, keyEncryptionAlgorithm, impl_->pwd);
-                }
+                        const VirgilByteArray& keyEncryptionAlgorithm, const VirgilByteArray& encryptedKey,
+                        VirgilByteArray& key) -> bool {
+                    VirgilPBES2 pbes2;
+                    if (!pbes2.parse(keyEncryptionAlgorithm)) {
+                        // Not PBES2, i.e. PKCS#12, so wrong password is reported with exception.
+                        key = doDecryptWithPassword(encryptedKey, keyEncryptionAlgorithm, impl_->pwd);
+                        return true;
+                    }
+                    VirgilByteArray derivedKey;
+                    const bool isDecrypted = pbes2.deriveKey(impl_->pwd, derivedKey) &&
+                            pbes2.decrypt(derivedKey, encryptedKey, key);
+                    VirgilByteArrayUtils::zeroize(derivedKey);
+                    return isDecrypted;
+                },
+                getRecipientsThreadsNum()
         );
 
         if (contentEncryptionKey.empty()) {
@@ -252,24 +483,158 @@ void VirgilCipherBase::accomplishInitDecryption() {
         contentEncryptionKey = impl_->contentInfo.decryptKeyRecipient(
                 impl_->recipientId,
                 [&, this](const VirgilByteArray& algorithm, const VirgilByteArray& encryptedKey) -> VirgilByteArray {
+                    if (impl_->privateKeyHandle) {
+                        return impl_->privateKeyHandle->acquireCipher()->decrypt(encryptedKey);
+                    }
                     return doDecryptWithKey(algorithm, encryptedKey, impl_->privateKey, impl_->pwd);
                 }
         );
 
+        if (contentEncryptionKey.empty()) {
+            contentEncryptionKey = impl_->contentInfo.decryptKeyAgreeRecipient(
+                    impl_->recipientId,
+                    [&, this](
+                            const VirgilByteArray& originatorKey, const VirgilByteArray& algorithm,
+                            const VirgilByteArray& encryptedKey) -> VirgilByteArray {
+                        VirgilAsymmetricCipher originatorPublicKey;
+                        originatorPublicKey.setPublicKey(originatorKey);
+                        if (impl_->privateKeyHandle) {
+                            return VirgilKeyAgreement::decryptKey(
+                                    algorithm, originatorPublicKey, *impl_->privateKeyHandle->acquireCipher(),
+                                    encryptedKey);
+                        }
+                        VirgilAsymmetricCipher privateKey;
+                        privateKey.setPrivateKey(impl_->privateKey, impl_->pwd);
+                        return VirgilKeyAgreement::decryptKey(algorithm, originatorPublicKey, privateKey, encryptedKey);
+                    }
+            );
+        }
+
         if (contentEncryptionKey.empty()) {
             throw make_error(VirgilCryptoError::NotFoundKeyRecipient);
         }
     }
 
-    impl_->symmetricCipher = VirgilSymmetricCipher();
-    impl_->symmetricCipher.fromAsn1(impl_->contentInfo.getContentEncryptionAlgorithm());
-    impl_->symmetricCipher.setDecryptionKey(contentEncryptionKey);
+    return contentEncryptionKey;
+}
 
-    if (impl_->symmetricCipher.isSupportPadding()) {
-        impl_->symmetricCipher.setPadding(kSymmetricCipher_Padding);
+
+VirgilByteArray VirgilCipherBase::defineContentKeyCacheEntryId() {
+    if (impl_->contentInfoDigest.empty()) {
+        // Content info was given before cache was set, or was built locally.
+        const VirgilByteArray contentInfo = impl_->contentInfo.toAsn1();
+        impl_->contentInfoDigest = hash_parts({ &contentInfo });
+    }
+
+    if (impl_->recipientId.empty()) {
+        return hash_parts({ &impl_->contentInfoDigest, &impl_->recipientId, &impl_->pwd });
+    }
+
+    if (impl_->privateKeyHandle) {
+        const VirgilByteArray publicKey = impl_->privateKeyHandle->acquireCipher()->exportPublicKeyToDER();
+        return hash_parts({ &impl_->contentInfoDigest, &impl_->recipientId, &publicKey });
+    }
+
+    return hash_parts({ &impl_->contentInfoDigest, &impl_->recipientId, &impl_->privateKey, &impl_->pwd });
+}
+
+
+VirgilByteArray VirgilCipherBase::initCompactEncryption() {
+    const auto& contentInfo = impl_->contentInfo;
+    if (contentInfo.hasPasswordRecipients()) {
+        throw make_error(VirgilCryptoError::InvalidState, "Compact envelope does not support password recipients.");
     }
+    if (!contentInfo.customParams().isEmpty()) {
+        throw make_error(VirgilCryptoError::InvalidState, "Compact envelope does not support custom parameters.");
+    }
+
+    std::vector<VirgilCompactEnvelope::RecipientSlot> recipientSlots;
+    std::vector<const VirgilPublicKeyHandle*> publicKeys;
+    contentInfo.forEachKeyRecipient(
+            [&recipientSlots, &publicKeys](const VirgilByteArray& recipientId, const VirgilPublicKeyHandle& publicKey) {
+                recipientSlots.push_back(VirgilCompactEnvelope::RecipientSlot { recipientId, VirgilByteArray() });
+                publicKeys.push_back(&publicKey);
+            }
+    );
+    if (publicKeys.empty()) {
+        throw make_error(VirgilCryptoError::InvalidState, "Compact envelope requires at least one key recipient.");
+    }
+
+    const auto keyType = publicKeys.front()->acquireCipher()->getKeyType();
+    if (!VirgilKeyAgreement::isSupported(keyType)) {
+        throw make_error(VirgilCryptoError::InvalidState,
+                "Compact envelope requires recipients' keys that support key agreement.");
+    }
+    for (const auto publicKey : publicKeys) {
+        if (publicKey->acquireCipher()->getKeyType() != keyType) {
+            throw make_error(VirgilCryptoError::InvalidState,
+                    "Compact envelope requires recipients' keys of the same type.");
+        }
+    }
+
+    impl_->symmetricCipher = VirgilSymmetricCipher(impl_->contentEncryptionAlgorithm);
+    if (!impl_->symmetricCipher.isAuthMode()) {
+        throw make_error(VirgilCryptoError::UnsupportedAlgorithm,
+                "Compact envelope supports only AEAD content encryption algorithms.");
+    }
+    impl_->symmetricCipherKey = impl_->random.randomize(impl_->symmetricCipher.keyLength());
+    const VirgilByteArray nonce = impl_->random.randomize(impl_->symmetricCipher.ivSize());
+
+    VirgilAsymmetricCipher ephemeralKey;
+    ephemeralKey.genKeyPair(keyType);
+    const auto& symmetricCipherKey = impl_->symmetricCipherKey;
+    parallel_for(publicKeys.size(), getRecipientsThreadsNum(), [&](size_t i) {
+        recipientSlots[i].encryptedKey = VirgilKeyAgreement::encryptKey(
+                *publicKeys[i]->acquireCipher(), ephemeralKey, symmetricCipherKey);
+    });
+
+    VirgilByteArray header = VirgilCompactEnvelope::writeHeader(
+            impl_->contentEncryptionAlgorithm, ephemeralKey.exportPublicKeyToDER(), recipientSlots, nonce);
 
+    impl_->symmetricCipher.setEncryptionKey(symmetricCipherKey);
+    impl_->symmetricCipher.setIV(nonce);
+    impl_->symmetricCipher.setAuthData(header);
     impl_->symmetricCipher.reset();
+    impl_->isInited = true;
+
+    return header;
+}
+
+
+size_t VirgilCipherBase::initCompactDecryption(const unsigned char* encryptedData, size_t encryptedDataSize) {
+    if (impl_->recipientId.empty()) {
+        throw make_error(VirgilCryptoError::InvalidState, "Compact envelope can be decrypted only with a key.");
+    }
+
+    VirgilCompactEnvelope::Header header;
+    const size_t headerSize =
+            VirgilCompactEnvelope::readHeader(encryptedData, encryptedDataSize, impl_->recipientId, header);
+    if (header.encryptedKey.empty()) {
+        throw make_error(VirgilCryptoError::NotFoundKeyRecipient);
+    }
+
+    VirgilAsymmetricCipher originatorPublicKey;
+    originatorPublicKey.setPublicKey(header.originatorKey);
+    VirgilByteArray contentEncryptionKey;
+    if (impl_->privateKeyHandle) {
+        contentEncryptionKey = VirgilKeyAgreement::decryptKey(
+                VirgilKeyAgreement::algorithm(), originatorPublicKey, *impl_->privateKeyHandle->acquireCipher(),
+                header.encryptedKey);
+    } else {
+        VirgilAsymmetricCipher privateKey;
+        privateKey.setPrivateKey(impl_->privateKey, impl_->pwd);
+        contentEncryptionKey = VirgilKeyAgreement::decryptKey(
+                VirgilKeyAgreement::algorithm(), originatorPublicKey, privateKey, header.encryptedKey);
+    }
+
+    impl_->symmetricCipher = VirgilSymmetricCipher(header.algorithm);
+    impl_->symmetricCipher.setDecryptionKey(contentEncryptionKey);
+    impl_->symmetricCipher.setIV(header.nonce);
+    impl_->symmetricCipher.setAuthData(VirgilByteArray(encryptedData, encryptedData + headerSize));
+    impl_->symmetricCipher.reset();
+    impl_->symmetricCipherKey = std::move(contentEncryptionKey);
+
+    return headerSize;
 }
 
 
@@ -297,42 +662,150 @@ void VirgilCipherBase::initDecryptionWithKey(
 
     impl_->recipientId = recipientId;
     impl_->privateKey = privateKey;
+    impl_->privateKeyHandle.reset();
     impl_->pwd = privateKeyPassword;
     impl_->isInited = true;
 }
 
 
+void VirgilCipherBase::initDecryptionWithKey(
+        const VirgilByteArray& recipientId, const VirgilPrivateKeyHandle& privateKey) {
+
+    if (recipientId.empty()) {
+        throw make_error(VirgilCryptoError::InvalidArgument, "Can not decrypt with empty 'recipientId'");
+    }
+
+    impl_->recipientId = recipientId;
+    impl_->privateKeyHandle = std::make_unique<VirgilPrivateKeyHandle>(privateKey);
+    impl_->isInited = true;
+}
+
+
 void VirgilCipherBase::buildContentInfo() {
-    const auto& symmetricCipherKey = impl_->symmetricCipherKey;
+    impl_->contentInfoDigest.clear();
+
+    encryptContentEncryptionKey(impl_->contentInfo, impl_->symmetricCipherKey);
+
+    impl_->contentInfo.setContentEncryptionAlgorithm(impl_->symmetricCipher.toAsn1());
+}
+
+
+void VirgilCipherBase::encryptContentEncryptionKey(
+        VirgilContentInfo& contentInfo, const VirgilByteArray& symmetricCipherKey) {
     auto& random = impl_->random;
+    std::mutex randomMutex;
+    const size_t threadsNum = getRecipientsThreadsNum();
+
+    if (impl_->isSharedEphemeralKeyEnabled) {
+        contentInfo.encryptKeyAgreeRecipients(
+                [&symmetricCipherKey](VirgilKeyPair::Type keyType) -> std::shared_ptr<VirgilContentInfo::KeyAgreement> {
+                    if (!VirgilKeyAgreement::isSupported(keyType)) {
+                        return nullptr;
+                    }
+                    auto ephemeralKey = std::make_shared<VirgilAsymmetricCipher>();
+                    ephemeralKey->genKeyPair(keyType);
+
+                    auto keyAgreement = std::make_shared<VirgilContentInfo::KeyAgreement>();
+                    keyAgreement->originatorKey = ephemeralKey->exportPublicKeyToDER();
+                    keyAgreement->keyEncryptionAlgorithm = VirgilKeyAgreement::algorithm();
+                    keyAgreement->encrypt =
+                            [ephemeralKey, &symmetricCipherKey](const VirgilPublicKeyHandle& publicKey) {
+                                return VirgilKeyAgreement::encryptKey(
+                                        *publicKey.acquireCipher(), *ephemeralKey, symmetricCipherKey);
+                            };
+                    return keyAgreement;
+                },
+                threadsNum
+        );
+    }
 
-    impl_->contentInfo.encryptKeyRecipients(
-            [&symmetricCipherKey](const VirgilByteArray& publicKey) -> VirgilContentInfo::EncryptionResult {
-                VirgilAsymmetricCipher asymmetricCipher;
-                asymmetricCipher.setPublicKey(publicKey);
-                return { asymmetricCipher.toAsn1(), asymmetricCipher.encrypt(symmetricCipherKey) };
-            }
+    contentInfo.encryptKeyRecipients(
+            [&symmetricCipherKey](const VirgilPublicKeyHandle& publicKey) -> VirgilContentInfo::EncryptionResult {
+                const auto asymmetricCipher = publicKey.acquireCipher();
+                return { asymmetricCipher->toAsn1(), asymmetricCipher->encrypt(symmetricCipherKey) };
+            },
+            threadsNum
     );
 
-    impl_->contentInfo.encryptPasswordRecipients(
-            [&symmetricCipherKey, &random](const VirgilByteArray& password) -> VirgilContentInfo::EncryptionResult {
-                const VirgilByteArray salt = random.randomize(16);
-                const size_t iterationCount = random.randomize(3072, 8192);
+    contentInfo.encryptPasswordRecipients(
+            [&symmetricCipherKey, &random, &randomMutex](
+                    const VirgilByteArray& password) -> VirgilContentInfo::EncryptionResult {
+                VirgilByteArray salt;
+                size_t iterationCount = 0;
+                {
+                    std::lock_guard<std::mutex> lock(randomMutex);
+                    salt = random.randomize(16);
+                    iterationCount = random.randomize(3072, 8192);
+                }
 
                 VirgilPBE pbe(VirgilPBE::Algorithm::PKCS5, salt, iterationCount);
 
                 return { pbe.toAsn1(), pbe.encrypt(symmetricCipherKey, password) };
-            }
+            },
+            threadsNum
     );
+}
 
-    impl_->contentInfo.setContentEncryptionAlgorithm(impl_->symmetricCipher.toAsn1());
+
+VirgilByteArray VirgilCipherBase::rekeyWithKey(
+        const VirgilByteArray& recipientId, const VirgilByteArray& privateKey,
+        const VirgilByteArray& privateKeyPassword) {
+
+    auto disposer = ScopeGuard([this]() {
+        clear();
+    });
+
+    initDecryptionWithKey(recipientId, privateKey, privateKeyPassword);
+
+    return rekey();
+}
+
+
+VirgilByteArray VirgilCipherBase::rekeyWithKey(
+        const VirgilByteArray& recipientId, const VirgilPrivateKeyHandle& privateKey) {
+
+    auto disposer = ScopeGuard([this]() {
+        clear();
+    });
+
+    initDecryptionWithKey(recipientId, privateKey);
+
+    return rekey();
+}
+
+
+VirgilByteArray VirgilCipherBase::rekeyWithPassword(const VirgilByteArray& pwd) {
+
+    auto disposer = ScopeGuard([this]() {
+        clear();
+    });
+
+    initDecryptionWithPassword(pwd);
+
+    return rekey();
+}
+
+
+VirgilByteArray VirgilCipherBase::rekey() {
+    if (!impl_->contentInfo.isReadyForDecryption()) {
+        throw make_error(VirgilCryptoError::InvalidState, "Content info is absent. It MUST be set before re-keying.");
+    }
+
+    impl_->symmetricCipherKey = acquireContentEncryptionKey();
+    impl_->contentInfoDigest.clear();
+
+    encryptContentEncryptionKey(impl_->contentInfo, impl_->symmetricCipherKey);
+
+    return getContentInfo();
 }
 
 void VirgilCipherBase::clear() {
     impl_->isInited = false;
     impl_->symmetricCipher.clear();
     impl_->recipientId.clear();
+    impl_->privateKeyHandle.reset();
     impl_->contentInfoFilter.reset();
+    impl_->contentInfoDigest.clear();
 
     VirgilByteArrayUtils::zeroize(impl_->symmetricCipherKey);
     VirgilByteArrayUtils::zeroize(impl_->privateKey);
@@ -364,6 +837,29 @@ VirgilSymmetricCipher& VirgilCipherBase::getSymmetricCipher() {
 }
 
 
+VirgilSymmetricCipher VirgilCipherBase::createSymmetricCipher() const {
+    if (!isReadyForEncryption() && !isReadyForDecryption()) {
+        throw make_error(VirgilCryptoError::InvalidState, "Symmetric cipher is not initialized.");
+    }
+
+    VirgilSymmetricCipher symmetricCipher;
+    symmetricCipher.fromAsn1(impl_->symmetricCipher.toAsn1());
+
+    if (impl_->symmetricCipher.isEncryptionMode()) {
+        symmetricCipher.setEncryptionKey(impl_->symmetricCipherKey);
+    } else {
+        symmetricCipher.setDecryptionKey(impl_->symmetricCipherKey);
+    }
+
+    if (symmetricCipher.isSupportPadding()) {
+        symmetricCipher.setPadding(kSymmetricCipher_Padding);
+    }
+
+    symmetricCipher.reset();
+    return symmetricCipher;
+}
+
+
 VirgilByteArray VirgilCipherBase::doDecryptWithKey(
         const VirgilByteArray& algorithm, const VirgilByteArray& encryptedKey,
         const VirgilByteArray& privateKey, const VirgilByteArray& privateKeyPassword) const {
@@ -0,0 +1,198 @@
+/**
+ * Copyright (C) 2015-2018 Virgil Security Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *     (3) Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+ */
+#include "VirgilCompactEnvelope.h"
+
+#include <virgil/crypto/VirgilCryptoError.h>
+
+#include "VirgilConstantTime.h"
+
+#include <cstdint>
+#include <limits>
+
+using virgil::crypto::VirgilByteArray;
+using virgil::crypto::VirgilCryptoError;
+using virgil::crypto::make_error;
+using virgil::crypto::foundation::VirgilSymmetricCipher;
+using virgil::crypto::internal::VirgilCompactEnvelope;
+
+/**
+ * @name Layout constants.
+ */
+///@{
+static constexpr unsigned char kCompactEnvelope_Marker = 0xCE;
+static constexpr unsigned char kCompactEnvelope_Version = 1;
+static constexpr size_t kCompactEnvelope_FixedHeaderSize = 6;
+static constexpr size_t kCompactEnvelope_KeyWrapOverhead = 8;
+static constexpr size_t kCompactEnvelope_RecipientsMax = std::numeric_limits<unsigned char>::max();
+static constexpr size_t kCompactEnvelope_RecipientIdSizeMax = std::numeric_limits<unsigned char>::max();
+static constexpr size_t kCompactEnvelope_OriginatorKeySizeMax = std::numeric_limits<uint16_t>::max();
+///@}
+
+/**
+ * @brief Content encryption algorithm supported by the compact envelope.
+ */
+struct CompactAlgorithm {
+    unsigned char code;
+    VirgilSymmetricCipher::Algorithm algorithm;
+    size_t keySize;
+    size_t nonceSize;
+};
+
+static constexpr CompactAlgorithm kCompactEnvelope_Algorithms[] = {
+    { 1, VirgilSymmetricCipher::Algorithm::AES_256_GCM, 32, 12 },
+    { 2, VirgilSymmetricCipher::Algorithm::CHACHA20_POLY1305, 32, 12 },
+    { 3, VirgilSymmetricCipher::Algorithm::AES_128_GCM, 16, 12 }
+};
+
+static const CompactAlgorithm& find_algorithm(VirgilSymmetricCipher::Algorithm algorithm) {
+    for (const auto& compactAlgorithm : kCompactEnvelope_Algorithms) {
+        if (compactAlgorithm.algorithm == algorithm) {
+            return compactAlgorithm;
+        }
+    }
+    throw make_error(VirgilCryptoError::UnsupportedAlgorithm,
+            "Compact envelope supports only AEAD content encryption algorithms.");
+}
+
+static const CompactAlgorithm& find_algorithm(unsigned char code) {
+    for (const auto& compactAlgorithm : kCompactEnvelope_Algorithms) {
+        if (compactAlgorithm.code == code) {
+            return compactAlgorithm;
+        }
+    }
+    throw make_error(VirgilCryptoError::InvalidFormat, "Compact envelope has unknown content encryption algorithm.");
+}
+
+bool VirgilCompactEnvelope::isCompactEnvelope(const unsigned char* data, size_t dataSize) {
+    return dataSize >= kCompactEnvelope_FixedHeaderSize &&
+            data[0] == kCompactEnvelope_Marker && data[1] == kCompactEnvelope_Version;
+}
+
+VirgilByteArray VirgilCompactEnvelope::writeHeader(
+        VirgilSymmetricCipher::Algorithm algorithm, const VirgilByteArray& originatorKey,
+        const std::vector<RecipientSlot>& recipientSlots, const VirgilByteArray& nonce) {
+
+    const CompactAlgorithm& compactAlgorithm = find_algorithm(algorithm);
+    if (recipientSlots.empty() || recipientSlots.size() > kCompactEnvelope_RecipientsMax) {
+        throw make_error(VirgilCryptoError::InvalidArgument, "Compact envelope supports from 1 to 255 recipients.");
+    }
+    if (originatorKey.empty() || originatorKey.size() > kCompactEnvelope_OriginatorKeySizeMax) {
+        throw make_error(VirgilCryptoError::InvalidArgument, "Compact envelope originator key size is invalid.");
+    }
+    if (nonce.size() != compactAlgorithm.nonceSize) {
+        throw make_error(VirgilCryptoError::InvalidArgument, "Compact envelope nonce size is invalid.");
+    }
+
+    const size_t encryptedKeySize = compactAlgorithm.keySize + kCompactEnvelope_KeyWrapOverhead;
+    size_t headerSize = kCompactEnvelope_FixedHeaderSize + originatorKey.size() + nonce.size();
+    for (const auto& recipientSlot : recipientSlots) {
+        const size_t recipientIdSize = recipientSlot.recipientId.size();
+        if (recipientIdSize == 0 || recipientIdSize > kCompactEnvelope_RecipientIdSizeMax) {
+            throw make_error(VirgilCryptoError::InvalidArgument,
+                    "Compact envelope supports recipient identifiers from 1 to 255 bytes.");
+        }
+        if (recipientSlot.encryptedKey.size() != encryptedKeySize) {
+            throw make_error(VirgilCryptoError::InvalidArgument, "Compact envelope encrypted key size is invalid.");
+        }
+        headerSize += 1 + recipientIdSize + encryptedKeySize;
+    }
+
+    VirgilByteArray header;
+    header.reserve(headerSize);
+    header.push_back(kCompactEnvelope_Marker);
+    header.push_back(kCompactEnvelope_Version);
+    header.push_back(compactAlgorithm.code);
+    header.push_back(static_cast<unsigned char>(recipientSlots.size()));
+    header.push_back(static_cast<unsigned char>(originatorKey.size() >> 8));
+    header.push_back(static_cast<unsigned char>(originatorKey.size() & 0xFF));
+    header.insert(header.end(), originatorKey.cbegin(), originatorKey.cend());
+    for (const auto& recipientSlot : recipientSlots) {
+        header.push_back(static_cast<unsigned char>(recipientSlot.recipientId.size()));
+        header.insert(header.end(), recipientSlot.recipientId.cbegin(), recipientSlot.recipientId.cend());
+        header.insert(header.end(), recipientSlot.encryptedKey.cbegin(), recipientSlot.encryptedKey.cend());
+    }
+    header.insert(header.end(), nonce.cbegin(), nonce.cend());
+    return header;
+}
+
+size_t VirgilCompactEnvelope::readHeader(
+        const unsigned char* data, size_t dataSize, const VirgilByteArray& recipientId, Header& header) {
+
+    if (!isCompactEnvelope(data, dataSize)) {
+        throw make_error(VirgilCryptoError::InvalidFormat, "Given data is not a compact envelope.");
+    }
+
+    const CompactAlgorithm& compactAlgorithm = find_algorithm(data[2]);
+    const size_t recipientsCount = data[3];
+    const size_t originatorKeySize = (size_t(data[4]) << 8) | data[5];
+    const size_t encryptedKeySize = compactAlgorithm.keySize + kCompactEnvelope_KeyWrapOverhead;
+    auto ensureAvailable = [dataSize](size_t offset, size_t size) {
+        if (size > dataSize || offset > dataSize - size) {
+            throw make_error(VirgilCryptoError::InvalidFormat, "Compact envelope is truncated.");
+        }
+    };
+
+    size_t offset = kCompactEnvelope_FixedHeaderSize;
+    ensureAvailable(offset, originatorKeySize);
+    const size_t originatorKeyOffset = offset;
+    offset += originatorKeySize;
+
+    // Every slot is visited and compared, the found one is selected without branching.
+    size_t foundKeyOffset = 0;
+    size_t isFound = 0;
+    for (size_t i = 0; i < recipientsCount; ++i) {
+        ensureAvailable(offset, 1);
+        const size_t slotIdSize = data[offset];
+        ensureAvailable(offset + 1, slotIdSize + encryptedKeySize);
+        const bool isSameSize = slotIdSize == recipientId.size();
+        const size_t isMatch = isSameSize && foundation::internal::constant_time_equal(
+                data + offset + 1, recipientId.data(), slotIdSize) ? 1 : 0;
+        const size_t matchMask = size_t(0) - (isMatch & (isFound ^ 1));
+        foundKeyOffset = ((offset + 1 + slotIdSize) & matchMask) | (foundKeyOffset & ~matchMask);
+        isFound |= isMatch;
+        offset += 1 + slotIdSize + encryptedKeySize;
+    }
+
+    ensureAvailable(offset, compactAlgorithm.nonceSize);
+    header.algorithm = compactAlgorithm.algorithm;
+    header.originatorKey.assign(data + originatorKeyOffset, data + originatorKeyOffset + originatorKeySize);
+    header.nonce.assign(data + offset, data + offset + compactAlgorithm.nonceSize);
+    header.encryptedKey.clear();
+    if (isFound) {
+        header.encryptedKey.assign(data + foundKeyOffset, data + foundKeyOffset + encryptedKeySize);
+    }
+    return offset + compactAlgorithm.nonceSize;
+}
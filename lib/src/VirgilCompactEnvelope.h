@@ -0,0 +1,118 @@
+/**
+ * Copyright (C) 2015-2018 Virgil Security Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *     (3) Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+ */
+#ifndef VIRGIL_CRYPTO_COMPACT_ENVELOPE_H
+#define VIRGIL_CRYPTO_COMPACT_ENVELOPE_H
+
+#include <virgil/crypto/VirgilByteArray.h>
+#include <virgil/crypto/foundation/VirgilSymmetricCipher.h>
+
+#include <vector>
+
+namespace virgil { namespace crypto { namespace internal {
+
+/**
+ * Fixed layout envelope, that replaces content info for the small messages.
+ *
+ * All recipients share one ephemeral key, and each recipient slot holds content encryption key
+ *     wrapped with the key agreement (see VirgilKeyAgreement).
+ * Whole header is given to the content encryption algorithm as additional authenticated data.
+ *
+ * Layout (multibyte integers are big-endian):
+ *
+ *     marker             1 byte   - 0xCE, it is never ASN.1 SEQUENCE, so it is not confused with content info
+ *     version            1 byte   - 1
+ *     algorithm          1 byte   - content encryption algorithm: 1 - AES-256-GCM, 2 - ChaCha20-Poly1305,
+ *                                   3 - AES-128-GCM
+ *     recipients count   1 byte   - 1..255
+ *     originator size    2 bytes
+ *     originator key     originator size bytes - ephemeral public key in DER format
+ *     recipient slots    recipients count times:
+ *         id size        1 byte   - 1..255
+ *         id             id size bytes
+ *         encrypted key  content encryption key size + 8 bytes
+ *     nonce              nonce size of the content encryption algorithm
+ *     encrypted content  followed by the authentication tag
+ */
+class VirgilCompactEnvelope {
+public:
+    struct RecipientSlot {
+        VirgilByteArray recipientId;
+        VirgilByteArray encryptedKey;
+    };
+
+    struct Header {
+        foundation::VirgilSymmetricCipher::Algorithm algorithm;
+        VirgilByteArray originatorKey;
+        VirgilByteArray encryptedKey; ///< key of the found recipient, or empty if recipient is absent
+        VirgilByteArray nonce;
+    };
+
+    /**
+     * Return true if given data begins with compact envelope marker and supported version.
+     */
+    static bool isCompactEnvelope(const unsigned char* data, size_t dataSize);
+
+    /**
+     * Build envelope header.
+     *
+     * @throw VirgilCryptoException with VirgilCryptoError::UnsupportedAlgorithm, if algorithm is not AEAD.
+     * @throw VirgilCryptoException with VirgilCryptoError::InvalidArgument, if sizes do not fit the layout.
+     */
+    static VirgilByteArray writeHeader(
+            foundation::VirgilSymmetricCipher::Algorithm algorithm, const VirgilByteArray& originatorKey,
+            const std::vector<RecipientSlot>& recipientSlots, const VirgilByteArray& nonce);
+
+    /**
+     * Read envelope header and take encrypted key of the recipient with given identifier.
+     *
+     * All recipient slots are compared with the given identifier,
+     *     so time does not depend on the position of the found slot.
+     *
+     * @return Header size, encrypted content follows it.
+     * @throw VirgilCryptoException with VirgilCryptoError::InvalidFormat, if header is malformed or truncated.
+     */
+    static size_t readHeader(
+            const unsigned char* data, size_t dataSize, const VirgilByteArray& recipientId, Header& header);
+
+private:
+    VirgilCompactEnvelope();
+};
+
+} // namespace internal
+} // namespace crypto
+} // namespace virgil
+
+#endif // VIRGIL_CRYPTO_COMPACT_ENVELOPE_H
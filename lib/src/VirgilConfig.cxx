@@ -49,3 +49,7 @@ bool VirgilConfig::hasFeaturePythiaImpl() {
 bool VirgilConfig::hasFeaturePythiaMultiThread() {
     return VIRGIL_CRYPTO_FEATURE_PYTHIA_MT;
 }
+
+bool VirgilConfig::hasFeatureThreadLocal() {
+    return VIRGIL_CRYPTO_FEATURE_THREAD_LOCAL;
+}
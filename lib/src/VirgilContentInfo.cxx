@@ -36,22 +36,36 @@
 
 #include <virgil/crypto/VirgilContentInfo.h>
 
+#include <virgil/crypto/VirgilByteArrayUtils.h>
 #include <virgil/crypto/VirgilCryptoError.h>
 #include <virgil/crypto/foundation/cms/VirgilCMSContent.h>
 #include <virgil/crypto/foundation/cms/VirgilCMSContentInfo.h>
 #include <virgil/crypto/foundation/cms/VirgilCMSEnvelopedData.h>
+#include <virgil/crypto/foundation/VirgilAsymmetricCipher.h>
 #include <virgil/crypto/foundation/asn1/VirgilAsn1Reader.h>
 #include <virgil/crypto/foundation/asn1/VirgilAsn1Writer.h>
 
 #include "utils.h"
+#include "VirgilByteArrayHash.h"
+#include "VirgilParallelFor.h"
 
 #include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <mutex>
 #include <set>
+#include <unordered_map>
+#include <vector>
 
 
 using virgil::crypto::VirgilContentInfo;
 
 using virgil::crypto::VirgilByteArray;
+using virgil::crypto::VirgilByteArrayUtils;
+using virgil::crypto::VirgilKeyPair;
+using virgil::crypto::VirgilPublicKeyHandle;
 using virgil::crypto::VirgilCustomParams;
 using virgil::crypto::VirgilCryptoError;
 using virgil::crypto::make_error;
@@ -60,10 +74,124 @@ using virgil::crypto::foundation::cms::VirgilCMSContent;
 using virgil::crypto::foundation::cms::VirgilCMSContentInfo;
 using virgil::crypto::foundation::cms::VirgilCMSEnvelopedData;
 using virgil::crypto::foundation::cms::VirgilCMSKeyTransRecipient;
+using virgil::crypto::foundation::cms::VirgilCMSKeyAgreeRecipient;
 using virgil::crypto::foundation::cms::VirgilCMSPasswordRecipient;
 using virgil::crypto::foundation::asn1::VirgilAsn1Reader;
 using virgil::crypto::foundation::asn1::VirgilAsn1Writer;
 
+/**
+ * @name ASN.1 Constants
+ */
+///@{
+static const unsigned char kAsn1_AlgorithmRefTag = 0x81; ///< [1] IMPLICIT INTEGER
+static const size_t kAlgorithmRef_MinRepeats = 2;
+///@}
+
+/**
+ * @brief Encode reference to the algorithm identifier with the given index.
+ * @see VirgilCMSContentInfo
+ */
+static VirgilByteArray make_algorithm_ref(size_t index) {
+    VirgilByteArray value;
+    do {
+        value.insert(value.begin(), static_cast<unsigned char>(index & 0xFF));
+        index >>= 8;
+    } while (index != 0);
+    if (value.front() & 0x80) {
+        value.insert(value.begin(), 0x00);
+    }
+    VirgilByteArray ref { kAsn1_AlgorithmRefTag, static_cast<unsigned char>(value.size()) };
+    VirgilByteArrayUtils::append(ref, value);
+    return ref;
+}
+
+/**
+ * @brief Replace reference to the algorithm identifier with the referenced one, other values are left as is.
+ */
+static void resolve_algorithm_ref(VirgilByteArray& algorithm, const std::vector<VirgilByteArray>& algorithms) {
+    if (algorithm.empty() || algorithm.front() != kAsn1_AlgorithmRefTag) {
+        return;
+    }
+    if (algorithm.size() < 3 || algorithm.size() > 2 + sizeof(size_t) || algorithm[1] != algorithm.size() - 2) {
+        throw make_error(VirgilCryptoError::InvalidFormat, "Malformed reference to the algorithm identifier.");
+    }
+    size_t index = 0;
+    for (auto it = algorithm.cbegin() + 2; it != algorithm.cend(); ++it) {
+        index = (index << 8) | *it;
+    }
+    if (index >= algorithms.size()) {
+        throw make_error(VirgilCryptoError::InvalidFormat, "Reference to the undefined algorithm identifier.");
+    }
+    algorithm = algorithms[index];
+}
+
+/**
+ * @brief Map key encryption algorithms that are repeated within key recipients to references.
+ * @param envelopedData - enveloped data, that is not modified.
+ * @param algorithms - output, referenced algorithm identifiers.
+ * @note Password recipients are skipped, because their algorithms contain random salt, so they are never repeated.
+ */
+static VirgilCMSEnvelopedData::AlgorithmRefs make_algorithm_refs(
+        const VirgilCMSEnvelopedData& envelopedData, std::vector<VirgilByteArray>& algorithms) {
+    std::unordered_map<VirgilByteArray, size_t, virgil::crypto::internal::VirgilByteArrayHash> repeats;
+    for (const auto& recipient : envelopedData.keyTransRecipients) {
+        ++repeats[recipient.keyEncryptionAlgorithm];
+    }
+    for (const auto& recipient : envelopedData.keyAgreeRecipients) {
+        ++repeats[recipient.keyEncryptionAlgorithm];
+    }
+
+    algorithms.clear();
+    VirgilCMSEnvelopedData::AlgorithmRefs refs;
+    const auto add_ref = [&](const VirgilByteArray& algorithm) {
+        if (repeats[algorithm] >= kAlgorithmRef_MinRepeats && refs.count(algorithm) == 0) {
+            refs.emplace(algorithm, make_algorithm_ref(algorithms.size()));
+            algorithms.push_back(algorithm);
+        }
+    };
+    for (const auto& recipient : envelopedData.keyTransRecipients) {
+        add_ref(recipient.keyEncryptionAlgorithm);
+    }
+    for (const auto& recipient : envelopedData.keyAgreeRecipients) {
+        add_ref(recipient.keyEncryptionAlgorithm);
+    }
+    return refs;
+}
+
+/**
+ * @brief Write enveloped data with references in place of the key encryption algorithms.
+ * @see make_algorithm_refs()
+ */
+class EnvelopedDataWriter : public virgil::crypto::foundation::asn1::VirgilAsn1Compatible {
+public:
+    EnvelopedDataWriter(
+            const VirgilCMSEnvelopedData& envelopedData, const VirgilCMSEnvelopedData::AlgorithmRefs& algorithmRefs)
+            : envelopedData_(envelopedData), algorithmRefs_(algorithmRefs) {}
+
+    size_t asn1Write(VirgilAsn1Writer& asn1Writer, size_t childWrittenBytes = 0) const override {
+        return envelopedData_.asn1Write(asn1Writer, algorithmRefs_, childWrittenBytes);
+    }
+
+    void asn1Read(VirgilAsn1Reader&) override {
+        throw make_error(VirgilCryptoError::InvalidState, "Enveloped data writer can not be read.");
+    }
+
+private:
+    const VirgilCMSEnvelopedData& envelopedData_;
+    const VirgilCMSEnvelopedData::AlgorithmRefs& algorithmRefs_;
+};
+
+/**
+ * @brief Replace references made by make_algorithm_refs() with the referenced algorithm identifiers.
+ */
+static void resolve_algorithms(VirgilCMSEnvelopedData& envelopedData, const std::vector<VirgilByteArray>& algorithms) {
+    for (auto& recipient : envelopedData.keyTransRecipients) {
+        resolve_algorithm_ref(recipient.keyEncryptionAlgorithm, algorithms);
+    }
+    for (auto& recipient : envelopedData.keyAgreeRecipients) {
+        resolve_algorithm_ref(recipient.keyEncryptionAlgorithm, algorithms);
+    }
+}
 
 namespace virgil { namespace crypto {
 
@@ -71,11 +199,85 @@ namespace virgil { namespace crypto {
  * @brief Handle class fields.
  */
 class VirgilContentInfo::Impl {
+public:
+    /**
+     * @brief Location of the key recipient within CMS representation.
+     */
+    struct KeyRecipientRef {
+        const VirgilCMSKeyTransRecipient* keyTransRecipient;
+        const VirgilCMSKeyAgreeRecipient* keyAgreeRecipient;
+        const VirgilCMSKeyAgreeRecipient::RecipientEncryptedKey* recipientEncryptedKey;
+    };
+
+    using KeyRecipientsIndex = std::unordered_map<VirgilByteArray, KeyRecipientRef, internal::VirgilByteArrayHash>;
+
+    Impl() : isCompactEncodingEnabled(false), isKeyRecipientsIndexValid(false) {}
+
+    /**
+     * @brief Copy recipients and parameters, index is rebuilt on demand, because it points to the source.
+     */
+    Impl(const Impl& rhs)
+            : cmsContentInfo(rhs.cmsContentInfo), cmsEnvelopedData(rhs.cmsEnvelopedData),
+              keyRecipients(rhs.keyRecipients), passwordRecipients(rhs.passwordRecipients),
+              isCompactEncodingEnabled(rhs.isCompactEncodingEnabled), isKeyRecipientsIndexValid(false) {}
+
+    /**
+     * @brief Return index of the key recipients within CMS representation, build it if needed.
+     * @note If recipient identifier is duplicated, the first recipient is indexed.
+     * @note Index is built under the lock, so concurrent const calls are safe.
+     */
+    const KeyRecipientsIndex& keyRecipientsIndex() const {
+        std::lock_guard<std::mutex> lock(cmsKeyRecipientsIndexMutex);
+        if (isKeyRecipientsIndexValid) {
+            return cmsKeyRecipientsIndex;
+        }
+        cmsKeyRecipientsIndex.clear();
+        cmsKeyRecipientsIndex.reserve(cmsEnvelopedData.keyTransRecipients.size());
+        for (const auto& keyTransRecipient : cmsEnvelopedData.keyTransRecipients) {
+            cmsKeyRecipientsIndex.emplace(
+                    keyTransRecipient.recipientIdentifier, KeyRecipientRef { &keyTransRecipient, nullptr, nullptr });
+        }
+        for (const auto& keyAgreeRecipient : cmsEnvelopedData.keyAgreeRecipients) {
+            for (const auto& recipientEncryptedKey : keyAgreeRecipient.recipientEncryptedKeys) {
+                cmsKeyRecipientsIndex.emplace(
+                        recipientEncryptedKey.recipientIdentifier,
+                        KeyRecipientRef { nullptr, &keyAgreeRecipient, &recipientEncryptedKey });
+            }
+        }
+        isKeyRecipientsIndexValid = true;
+        return cmsKeyRecipientsIndex;
+    }
+
+    /**
+     * @brief Find key recipient within CMS representation.
+     * @return Found recipient location, or nullptr.
+     */
+    const KeyRecipientRef* findKeyRecipient(const VirgilByteArray& recipientId) const {
+        const auto& index = keyRecipientsIndex();
+        const auto found = index.find(recipientId);
+        return found != index.cend() ? &found->second : nullptr;
+    }
+
+    /**
+     * @brief Call it whenever key recipients within CMS representation are changed.
+     */
+    void invalidateKeyRecipientsIndex() {
+        std::lock_guard<std::mutex> lock(cmsKeyRecipientsIndexMutex);
+        isKeyRecipientsIndexValid = false;
+        cmsKeyRecipientsIndex.clear();
+    }
+
 public:
     VirgilCMSContentInfo cmsContentInfo;
     VirgilCMSEnvelopedData cmsEnvelopedData;
-    std::map<VirgilByteArray, VirgilByteArray> keyRecipients; ///< recipient id -> public key
+    std::map<VirgilByteArray, VirgilPublicKeyHandle> keyRecipients; ///< recipient id -> public key
     std::set<VirgilByteArray> passwordRecipients; ///< passwords
+    bool isCompactEncodingEnabled;
+
+private:
+    mutable KeyRecipientsIndex cmsKeyRecipientsIndex; ///< recipient id -> CMS recipient
+    mutable bool isKeyRecipientsIndexValid;
+    mutable std::mutex cmsKeyRecipientsIndexMutex;
 };
 
 }}
@@ -88,6 +290,14 @@ VirgilContentInfo& VirgilContentInfo::operator=(VirgilContentInfo&& rhs) noexcep
 
 VirgilContentInfo::~VirgilContentInfo() noexcept = default;
 
+VirgilContentInfo::VirgilContentInfo(const VirgilContentInfo& rhs) : impl_(std::make_unique<Impl>(*rhs.impl_)) {}
+
+VirgilContentInfo& VirgilContentInfo::operator=(const VirgilContentInfo& rhs) {
+    auto tmp = VirgilContentInfo(rhs);
+    *this = std::move(tmp);
+    return *this;
+}
+
 void VirgilContentInfo::addKeyRecipient(const VirgilByteArray& recipientId, const VirgilByteArray& publicKey) {
     if (recipientId.empty()) {
         throw make_error(VirgilCryptoError::InvalidArgument);
@@ -95,10 +305,17 @@ void VirgilContentInfo::addKeyRecipient(const VirgilByteArray& recipientId, cons
     if (publicKey.empty()) {
         throw make_error(VirgilCryptoError::InvalidArgument);
     }
+    addKeyRecipient(recipientId, VirgilPublicKeyHandle(publicKey));
+}
+
+void VirgilContentInfo::addKeyRecipient(const VirgilByteArray& recipientId, const VirgilPublicKeyHandle& publicKey) {
+    if (recipientId.empty()) {
+        throw make_error(VirgilCryptoError::InvalidArgument);
+    }
     if (hasKeyRecipient(recipientId)) {
         throw make_error(VirgilCryptoError::InvalidArgument);
     }
-    impl_->keyRecipients[recipientId] = publicKey;
+    impl_->keyRecipients.emplace(recipientId, publicKey);
 }
 
 bool VirgilContentInfo::hasKeyRecipient(const VirgilByteArray& recipientId) const {
@@ -107,13 +324,7 @@ bool VirgilContentInfo::hasKeyRecipient(const VirgilByteArray& recipientId) cons
         return true;
     }
     // 2. Search within CMS representation
-    return std::find_if(
-            impl_->cmsEnvelopedData.keyTransRecipients.cbegin(),
-            impl_->cmsEnvelopedData.keyTransRecipients.cend(),
-            [&recipientId](const VirgilCMSKeyTransRecipient& keyTransRecipient) {
-                return keyTransRecipient.recipientIdentifier == recipientId;
-            }
-    ) != impl_->cmsEnvelopedData.keyTransRecipients.cend();
+    return impl_->findKeyRecipient(recipientId) != nullptr;
 }
 
 void VirgilContentInfo::removeKeyRecipient(const VirgilByteArray& recipientId) {
@@ -131,6 +342,25 @@ void VirgilContentInfo::removeKeyRecipient(const VirgilByteArray& recipientId) {
     if (found != impl_->cmsEnvelopedData.keyTransRecipients.end()) {
         impl_->cmsEnvelopedData.keyTransRecipients.erase(found);
     }
+    auto& keyAgreeRecipients = impl_->cmsEnvelopedData.keyAgreeRecipients;
+    for (auto& keyAgreeRecipient : keyAgreeRecipients) {
+        auto& recipientEncryptedKeys = keyAgreeRecipient.recipientEncryptedKeys;
+        recipientEncryptedKeys.erase(
+                std::remove_if(
+                        recipientEncryptedKeys.begin(), recipientEncryptedKeys.end(),
+                        [&recipientId](const VirgilCMSKeyAgreeRecipient::RecipientEncryptedKey& recipient) {
+                            return recipient.recipientIdentifier == recipientId;
+                        }),
+                recipientEncryptedKeys.end());
+    }
+    keyAgreeRecipients.erase(
+            std::remove_if(
+                    keyAgreeRecipients.begin(), keyAgreeRecipients.end(),
+                    [](const VirgilCMSKeyAgreeRecipient& recipient) {
+                        return recipient.recipientEncryptedKeys.empty();
+                    }),
+            keyAgreeRecipients.end());
+    impl_->invalidateKeyRecipientsIndex();
 }
 
 void VirgilContentInfo::removeKeyRecipients() {
@@ -138,6 +368,8 @@ void VirgilContentInfo::removeKeyRecipients() {
     impl_->keyRecipients.clear();
     // Remove from the CMS representation
     impl_->cmsEnvelopedData.keyTransRecipients.clear();
+    impl_->cmsEnvelopedData.keyAgreeRecipients.clear();
+    impl_->invalidateKeyRecipientsIndex();
 }
 
 void VirgilContentInfo::addPasswordRecipient(const VirgilByteArray& pwd) {
@@ -185,65 +417,187 @@ VirgilByteArray VirgilContentInfo::decryptKeyRecipient(const VirgilByteArray& re
     if (!decrypt) {
         throw make_error(VirgilCryptoError::InvalidArgument);
     }
-    for (const auto& keyRecipient: impl_->cmsEnvelopedData.keyTransRecipients) {
-        if (keyRecipient.recipientIdentifier == recipientId) {
-            return decrypt(keyRecipient.keyEncryptionAlgorithm, keyRecipient.encryptedKey);
-        }
+    const auto keyRecipient = impl_->findKeyRecipient(recipientId);
+    if (keyRecipient != nullptr && keyRecipient->keyTransRecipient != nullptr) {
+        return decrypt(
+                keyRecipient->keyTransRecipient->keyEncryptionAlgorithm, keyRecipient->keyTransRecipient->encryptedKey);
+    }
+    return VirgilByteArray();
+}
+
+VirgilByteArray VirgilContentInfo::decryptKeyAgreeRecipient(const VirgilByteArray& recipientId,
+        std::function<VirgilByteArray(
+                const VirgilByteArray&, const VirgilByteArray&, const VirgilByteArray&)> decrypt) const {
+
+    if (!decrypt) {
+        throw make_error(VirgilCryptoError::InvalidArgument);
+    }
+    const auto keyRecipient = impl_->findKeyRecipient(recipientId);
+    if (keyRecipient != nullptr && keyRecipient->keyAgreeRecipient != nullptr) {
+        return decrypt(
+                keyRecipient->keyAgreeRecipient->originatorKey, keyRecipient->keyAgreeRecipient->keyEncryptionAlgorithm,
+                keyRecipient->recipientEncryptedKey->encryptedKey);
     }
     return VirgilByteArray();
 }
 
 VirgilByteArray VirgilContentInfo::decryptPasswordRecipient(
-        std::function<VirgilByteArray(const VirgilByteArray&, const VirgilByteArray&)> decrypt) const {
+        std::function<bool(const VirgilByteArray&, const VirgilByteArray&, VirgilByteArray&)> decrypt,
+        size_t threadsNum) const {
     if (!decrypt) {
         throw make_error(VirgilCryptoError::InvalidArgument);
     }
-    for (const auto& passwordRecipient: impl_->cmsEnvelopedData.passwordRecipients) {
+    const auto& passwordRecipients = impl_->cmsEnvelopedData.passwordRecipients;
+    std::vector<VirgilByteArray> keys(passwordRecipients.size());
+    std::atomic<size_t> foundIndex(passwordRecipients.size());
+    internal::parallel_for(passwordRecipients.size(), threadsNum, [&](size_t i) {
+        if (i > foundIndex) {
+            return; // Preceding recipient is already found.
+        }
+        bool isDecrypted = false;
         try {
-            return decrypt(passwordRecipient.keyEncryptionAlgorithm, passwordRecipient.encryptedKey);
+            isDecrypted = decrypt(passwordRecipients[i].keyEncryptionAlgorithm, passwordRecipients[i].encryptedKey,
+                    keys[i]);
         } catch (...) {
-            // Possible wrong password, so try next one.
+            // Malformed or unsupported recipient, so try next one.
+        }
+        if (!isDecrypted) {
+            return;
+        }
+        size_t currentIndex = foundIndex;
+        while (i < currentIndex && !foundIndex.compare_exchange_weak(currentIndex, i)) {}
+    });
+
+    VirgilByteArray key;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (i == foundIndex.load()) {
+            key.swap(keys[i]);
+        } else {
+            VirgilByteArrayUtils::zeroize(keys[i]);
         }
     }
-    return VirgilByteArray();
+    return key;
 }
 
-void VirgilContentInfo::encryptKeyRecipients(std::function<EncryptionResult(const VirgilByteArray&)> encrypt) {
+void VirgilContentInfo::encryptKeyRecipients(
+        std::function<EncryptionResult(const VirgilPublicKeyHandle&)> encrypt, size_t threadsNum) {
     if (!encrypt) {
         throw make_error(VirgilCryptoError::InvalidArgument);
     }
+    std::vector<const std::pair<const VirgilByteArray, VirgilPublicKeyHandle>*> keyRecipients;
+    keyRecipients.reserve(impl_->keyRecipients.size());
     for (const auto& keyRecipient : impl_->keyRecipients) {
-        const auto& recipientId = keyRecipient.first;
-        const auto& publicKey = keyRecipient.second;
+        keyRecipients.push_back(&keyRecipient);
+    }
 
-        auto encryptionResult = encrypt(publicKey);
+    std::vector<VirgilCMSKeyTransRecipient> recipients(keyRecipients.size());
+    internal::parallel_for(keyRecipients.size(), threadsNum, [&](size_t i) {
+        auto encryptionResult = encrypt(keyRecipients[i]->second);
 
-        VirgilCMSKeyTransRecipient recipient;
-        recipient.recipientIdentifier = recipientId;
-        recipient.keyEncryptionAlgorithm = encryptionResult.encryptionAlgorithm;
-        recipient.encryptedKey = encryptionResult.encryptedContent;
+        VirgilCMSKeyTransRecipient& recipient = recipients[i];
+        recipient.recipientIdentifier = keyRecipients[i]->first;
+        recipient.keyEncryptionAlgorithm = std::move(encryptionResult.encryptionAlgorithm);
+        recipient.encryptedKey = std::move(encryptionResult.encryptedContent);
+    });
 
-        impl_->cmsEnvelopedData.keyTransRecipients.push_back(recipient);
-    }
+    auto& keyTransRecipients = impl_->cmsEnvelopedData.keyTransRecipients;
+    std::move(recipients.begin(), recipients.end(), std::back_inserter(keyTransRecipients));
     impl_->keyRecipients.clear();
+    impl_->invalidateKeyRecipientsIndex();
 }
 
-void VirgilContentInfo::encryptPasswordRecipients(std::function<EncryptionResult(const VirgilByteArray&)> encrypt) {
+void VirgilContentInfo::encryptKeyAgreeRecipients(
+        std::function<std::shared_ptr<KeyAgreement>(VirgilKeyPair::Type)> agree, size_t threadsNum) {
+    if (!agree) {
+        throw make_error(VirgilCryptoError::InvalidArgument);
+    }
+    struct Group {
+        std::shared_ptr<KeyAgreement> keyAgreement;
+        std::vector<std::map<VirgilByteArray, VirgilPublicKeyHandle>::const_iterator> keyRecipients;
+    };
+    constexpr size_t kGroupNone = std::numeric_limits<size_t>::max();
+
+    std::vector<Group> groups;
+    std::map<VirgilKeyPair::Type, size_t> groupIndices; ///< key type -> index within groups
+    const auto& keyRecipients = impl_->keyRecipients;
+    for (auto keyRecipient = keyRecipients.cbegin(); keyRecipient != keyRecipients.cend(); ++keyRecipient) {
+        const auto keyType = keyRecipient->second.acquireCipher()->getKeyType();
+        auto groupIndex = groupIndices.find(keyType);
+        if (groupIndex == groupIndices.end()) {
+            auto keyAgreement = agree(keyType);
+            groupIndex = groupIndices.emplace(keyType, keyAgreement ? groups.size() : kGroupNone).first;
+            if (keyAgreement) {
+                groups.push_back(Group { std::move(keyAgreement), {} });
+            }
+        }
+        if (groupIndex->second != kGroupNone) {
+            groups[groupIndex->second].keyRecipients.push_back(keyRecipient);
+        }
+    }
+
+    std::vector<VirgilCMSKeyAgreeRecipient> recipients(groups.size());
+    for (size_t groupIndex = 0; groupIndex < groups.size(); ++groupIndex) {
+        const Group& group = groups[groupIndex];
+        VirgilCMSKeyAgreeRecipient& recipient = recipients[groupIndex];
+        recipient.originatorKey = group.keyAgreement->originatorKey;
+        recipient.keyEncryptionAlgorithm = group.keyAgreement->keyEncryptionAlgorithm;
+        recipient.recipientEncryptedKeys.resize(group.keyRecipients.size());
+        internal::parallel_for(group.keyRecipients.size(), threadsNum, [&](size_t i) {
+            auto& recipientEncryptedKey = recipient.recipientEncryptedKeys[i];
+            recipientEncryptedKey.recipientIdentifier = group.keyRecipients[i]->first;
+            recipientEncryptedKey.encryptedKey = group.keyAgreement->encrypt(group.keyRecipients[i]->second);
+        });
+    }
+
+    auto& keyAgreeRecipients = impl_->cmsEnvelopedData.keyAgreeRecipients;
+    std::move(recipients.begin(), recipients.end(), std::back_inserter(keyAgreeRecipients));
+    impl_->invalidateKeyRecipientsIndex();
+    for (const auto& group : groups) {
+        for (const auto& keyRecipient : group.keyRecipients) {
+            impl_->keyRecipients.erase(keyRecipient);
+        }
+    }
+}
+
+void VirgilContentInfo::encryptPasswordRecipients(
+        std::function<EncryptionResult(const VirgilByteArray&)> encrypt, size_t threadsNum) {
     if (!encrypt) {
         throw make_error(VirgilCryptoError::InvalidArgument);
     }
+    std::vector<const VirgilByteArray*> passwords;
+    passwords.reserve(impl_->passwordRecipients.size());
     for (const auto& password : impl_->passwordRecipients) {
-        auto encryptionResult = encrypt(password);
+        passwords.push_back(&password);
+    }
 
-        VirgilCMSPasswordRecipient recipient;
-        recipient.keyEncryptionAlgorithm = encryptionResult.encryptionAlgorithm;
-        recipient.encryptedKey = encryptionResult.encryptedContent;
+    std::vector<VirgilCMSPasswordRecipient> recipients(passwords.size());
+    internal::parallel_for(passwords.size(), threadsNum, [&](size_t i) {
+        auto encryptionResult = encrypt(*passwords[i]);
 
-        impl_->cmsEnvelopedData.passwordRecipients.push_back(recipient);
-    }
+        VirgilCMSPasswordRecipient& recipient = recipients[i];
+        recipient.keyEncryptionAlgorithm = std::move(encryptionResult.encryptionAlgorithm);
+        recipient.encryptedKey = std::move(encryptionResult.encryptedContent);
+    });
+
+    auto& passwordRecipients = impl_->cmsEnvelopedData.passwordRecipients;
+    std::move(recipients.begin(), recipients.end(), std::back_inserter(passwordRecipients));
     impl_->passwordRecipients.clear();
 }
 
+void VirgilContentInfo::forEachKeyRecipient(
+        std::function<void(const VirgilByteArray&, const VirgilPublicKeyHandle&)> visit) const {
+    if (!visit) {
+        throw make_error(VirgilCryptoError::InvalidArgument);
+    }
+    for (const auto& keyRecipient : impl_->keyRecipients) {
+        visit(keyRecipient.first, keyRecipient.second);
+    }
+}
+
+bool VirgilContentInfo::hasPasswordRecipients() const {
+    return !impl_->passwordRecipients.empty();
+}
+
 void VirgilContentInfo::setContentEncryptionAlgorithm(const VirgilByteArray& contentEncryptionAlgorithm) {
     impl_->cmsEnvelopedData.encryptedContent.contentEncryptionAlgorithm = contentEncryptionAlgorithm;
 }
@@ -257,25 +611,56 @@ size_t VirgilContentInfo::defineSize(const VirgilByteArray& contentInfoData) {
 }
 
 size_t VirgilContentInfo::asn1Write(VirgilAsn1Writer& asn1Writer, size_t childWrittenBytes) const {
-    impl_->cmsContentInfo.cmsContent.contentType = VirgilCMSContent::Type::EnvelopedData;
-    impl_->cmsContentInfo.cmsContent.content = impl_->cmsEnvelopedData.toAsn1();
-    return impl_->cmsContentInfo.asn1Write(asn1Writer, childWrittenBytes);
+    // Stored structures are not modified, so content info can be written concurrently.
+    std::vector<VirgilByteArray> algorithms;
+    VirgilCMSEnvelopedData::AlgorithmRefs algorithmRefs;
+    if (impl_->isCompactEncodingEnabled) {
+        algorithmRefs = make_algorithm_refs(impl_->cmsEnvelopedData, algorithms);
+    }
+    // Enveloped data is written in place, so it is not serialized to the intermediate buffer.
+    EnvelopedDataWriter envelopedDataWriter(impl_->cmsEnvelopedData, algorithmRefs);
+    return impl_->cmsContentInfo.asn1WriteEnvelopedData(asn1Writer, envelopedDataWriter, algorithms) +
+            childWrittenBytes;
 }
 
 void VirgilContentInfo::asn1Read(VirgilAsn1Reader& asn1Reader) {
+    impl_->invalidateKeyRecipientsIndex();
     impl_->cmsContentInfo.asn1Read(asn1Reader);
     if (impl_->cmsContentInfo.cmsContent.contentType == foundation::cms::VirgilCMSContent::Type::EnvelopedData) {
         impl_->cmsEnvelopedData.fromAsn1(impl_->cmsContentInfo.cmsContent.content);
+        resolve_algorithms(impl_->cmsEnvelopedData, impl_->cmsContentInfo.algorithms);
+    } else {
+        throw make_error(VirgilCryptoError::InvalidFormat);
+    }
+}
+
+void VirgilContentInfo::fromAsn1(const VirgilByteArray& data, const VirgilByteArray& keyRecipientId) {
+    impl_->invalidateKeyRecipientsIndex();
+    VirgilAsn1Reader asn1Reader(data.data(), data.size());
+    impl_->cmsContentInfo.asn1Read(asn1Reader);
+    if (impl_->cmsContentInfo.cmsContent.contentType == foundation::cms::VirgilCMSContent::Type::EnvelopedData) {
+        impl_->cmsEnvelopedData.fromAsn1(impl_->cmsContentInfo.cmsContent.content, keyRecipientId);
+        resolve_algorithms(impl_->cmsEnvelopedData, impl_->cmsContentInfo.algorithms);
     } else {
         throw make_error(VirgilCryptoError::InvalidFormat);
     }
 }
 
+void VirgilContentInfo::setCompactEncodingEnabled(bool enabled) {
+    impl_->isCompactEncodingEnabled = enabled;
+}
+
+bool VirgilContentInfo::isCompactEncodingEnabled() const {
+    return impl_->isCompactEncodingEnabled;
+}
+
 bool VirgilContentInfo::isReadyForEncryption() {
     return !impl_->passwordRecipients.empty() || !impl_->keyRecipients.empty();
 }
 
 bool VirgilContentInfo::isReadyForDecryption() {
-    return !impl_->cmsEnvelopedData.keyTransRecipients.empty() || !impl_->cmsEnvelopedData.passwordRecipients.empty();
+    return !impl_->cmsEnvelopedData.keyTransRecipients.empty() ||
+            !impl_->cmsEnvelopedData.keyAgreeRecipients.empty() ||
+            !impl_->cmsEnvelopedData.passwordRecipients.empty();
 }
 
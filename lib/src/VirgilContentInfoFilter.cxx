@@ -43,6 +43,8 @@
 
 #include "utils.h"
 
+#include <algorithm>
+
 using virgil::crypto::VirgilByteArray;
 using virgil::crypto::VirgilByteArrayUtils;
 using virgil::crypto::VirgilContentInfo;
@@ -89,6 +91,7 @@ void VirgilContentInfoFilter::reset() {
     impl_->state = State::WaitingPreamble;
     impl_->contentInfoData.clear();
     impl_->encryptedData.clear();
+    impl_->expectedContentInfoSize = 0;
 }
 
 void VirgilContentInfoFilter::finish() {
@@ -125,46 +128,57 @@ void VirgilContentInfoFilter::tellLastChunk() {
 }
 
 void VirgilContentInfoFilter::filterData(const VirgilByteArray& encryptedData) {
+    const size_t consumedSize = filterData(encryptedData.data(), encryptedData.size());
+    impl_->encryptedData.insert(impl_->encryptedData.end(), encryptedData.begin() + consumedSize, encryptedData.end());
+}
+
+size_t VirgilContentInfoFilter::filterData(const unsigned char* encryptedData, size_t encryptedDataSize) {
     if (!isWaitingData()) {
         throw make_error(VirgilCryptoError::InvalidState, "VirgilContentInfoFilter::filterData()");
     }
 
-    // Append new data.
-    VirgilByteArrayUtils::append(impl_->contentInfoData, encryptedData);
+    size_t consumedSize = 0;
 
-    // Check preamble size.
-    if (impl_->contentInfoData.size() < kContentInfoPreambleSize) {
-        return;
-    }
+    // Collect preamble.
+    if (impl_->state == State::WaitingPreamble) {
+        consumedSize = std::min(kContentInfoPreambleSize - impl_->contentInfoData.size(), encryptedDataSize);
+        impl_->contentInfoData.insert(impl_->contentInfoData.end(), encryptedData, encryptedData + consumedSize);
+        if (impl_->contentInfoData.size() < kContentInfoPreambleSize) {
+            return consumedSize;
+        }
 
-    // Define content info first time.
-    if (impl_->expectedContentInfoSize == 0) {
         impl_->expectedContentInfoSize = VirgilContentInfo::defineSize(impl_->contentInfoData);
-    }
 
-    // If content info size still zero, then it is not a content info.
-    if (impl_->expectedContentInfoSize == 0) {
-        impl_->encryptedData.swap(impl_->contentInfoData);
-        impl_->state = State::NotFound;
-        return;
+        // If content info size is zero, then it is not a content info.
+        if (impl_->expectedContentInfoSize == 0) {
+            impl_->encryptedData.swap(impl_->contentInfoData);
+            impl_->state = State::NotFound;
+            return consumedSize;
+        }
+
+        // Preamble can be longer than a tiny content info.
+        if (impl_->contentInfoData.size() > impl_->expectedContentInfoSize) {
+            impl_->encryptedData.assign(
+                    impl_->contentInfoData.begin() + impl_->expectedContentInfoSize, impl_->contentInfoData.end());
+            impl_->contentInfoData.resize(impl_->expectedContentInfoSize);
+        }
+
+        impl_->contentInfoData.reserve(impl_->expectedContentInfoSize);
+        impl_->state = State::WaitingBody;
     }
 
-    // Check if content info fully extracted.
-    if (impl_->contentInfoData.size() >= impl_->expectedContentInfoSize) {
-        size_t contentInfoDataSize = impl_->contentInfoData.size();
-        size_t encryptedDataSize = impl_->encryptedData.size();
+    // Collect body, and leave the rest.
+    const size_t bodySize = std::min(
+            impl_->expectedContentInfoSize - impl_->contentInfoData.size(), encryptedDataSize - consumedSize);
+    impl_->contentInfoData.insert(
+            impl_->contentInfoData.end(), encryptedData + consumedSize, encryptedData + consumedSize + bodySize);
+    consumedSize += bodySize;
 
-        impl_->encryptedData.insert(impl_->encryptedData.end(),
-                impl_->contentInfoData.begin() + impl_->expectedContentInfoSize, impl_->contentInfoData.end());
-        impl_->contentInfoData.resize(impl_->expectedContentInfoSize);
+    if (impl_->contentInfoData.size() == impl_->expectedContentInfoSize) {
         impl_->state = State::Found;
-
-        encryptedDataSize = impl_->encryptedData.size();
-        contentInfoDataSize = impl_->contentInfoData.size();
-        return;
     }
 
-    impl_->state = State::WaitingBody;
+    return consumedSize;
 }
 
 bool VirgilContentInfoFilter::isWaitingData() const {
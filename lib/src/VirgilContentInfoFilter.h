@@ -108,6 +108,20 @@ public:
      */
     void filterData(const VirgilByteArray& encryptedData);
 
+    /**
+     * Filter given encrypted data to define Content Info, but do not take payload that follows it.
+     *
+     * Content info is consumed incrementally, so it can be split to the chunks of any size.
+     * Only bytes that belong to the content info (or its preamble) are copied.
+     *
+     * @param encryptedData - data to be filtered.
+     * @param encryptedDataSize - size of the data to be filtered.
+     * @return Number of consumed bytes, the rest of the given data is a payload.
+     *
+     * Note, if content info is absent, consumed preamble is returned by @link popEncryptedData() @endlink.
+     */
+    size_t filterData(const unsigned char* encryptedData, size_t encryptedDataSize);
+
     /**
      * Return true if filter needs more data for analyzing.
      */
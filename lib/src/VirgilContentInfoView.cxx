@@ -0,0 +1,416 @@
+/**
+ * Copyright (C) 2015-2018 Virgil Security Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *     (3) Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+ */
+
+#include <virgil/crypto/VirgilContentInfoView.h>
+
+#include <virgil/crypto/VirgilCryptoError.h>
+#include <virgil/crypto/foundation/VirgilSystemCryptoError.h>
+
+#include <mbedtls/asn1.h>
+
+#include <cstring>
+
+#include "VirgilOID.h"
+
+using virgil::crypto::VirgilByteArray;
+using virgil::crypto::VirgilContentInfoView;
+using virgil::crypto::VirgilCryptoError;
+using virgil::crypto::make_error;
+using virgil::crypto::foundation::system_crypto_handler;
+
+/**
+ * @name ASN.1 Constants
+ */
+///@{
+static const int kAsn1_ContentInfoVersion = 0;
+static const int kAsn1_ContentInfoVersionCompact = 1;
+static const unsigned char kAsn1_CustomParamsTag = 0;
+static const unsigned char kAsn1_AlgorithmsTag = 1;
+static const unsigned char kAsn1_AlgorithmRefTag = 1;
+static const unsigned char kCMS_ContentTag = 0;
+static const unsigned char kCMS_OriginatorInfoTag = 0;
+static const unsigned char kCMS_SubjectKeyTag = 0;
+static const unsigned char kCMS_OriginatorTag = 0;
+static const unsigned char kCMS_OriginatorKeyTag = 1;
+static const unsigned char kCMS_UserKeyingMaterialTag = 1;
+static const unsigned char kCMS_RecipientKeyIdTag = 0;
+static const unsigned char kCMS_KeyAgreeRecipientTag = 1;
+static const unsigned char kCMS_KEKRecipientTag = 2;
+static const unsigned char kCMS_PasswordRecipientTag = 3;
+static const unsigned char kCMS_OtherRecipientTag = 4;
+static const unsigned char kCMS_KeyDerivationAlgorithmTag = 0;
+static const unsigned char kCMS_IntegerValueTag = 0;
+static const unsigned char kCMS_StringValueTag = 1;
+static const unsigned char kCMS_DataValueTag = 2;
+///@}
+
+namespace virgil { namespace crypto { namespace internal {
+
+using Bytes = VirgilContentInfoView::Bytes;
+
+/**
+ * @brief Minimal forward-only DER reader over the viewed buffer.
+ */
+class Asn1Cursor {
+public:
+    Asn1Cursor(const unsigned char* begin, const unsigned char* end) : p_(begin), end_(end) {}
+
+    explicit Asn1Cursor(const Bytes& bytes) : p_(bytes.data), end_(bytes.data + bytes.size) {}
+
+    bool atEnd() const {
+        return p_ >= end_;
+    }
+
+    const unsigned char* position() const {
+        return p_;
+    }
+
+    /**
+     * @brief Read tag and length, and return content of the element.
+     */
+    Bytes readTag(int tag) {
+        Bytes content { nullptr, 0 };
+        if (!readOptionalTag(tag, content)) {
+            throw make_error(VirgilCryptoError::InvalidFormat);
+        }
+        return content;
+    }
+
+    /**
+     * @brief Read tag and length if tag is equal to the expected one.
+     */
+    bool readOptionalTag(int tag, Bytes& content) {
+        if (atEnd()) {
+            return false;
+        }
+        unsigned char* p = const_cast<unsigned char*>(p_);
+        size_t len = 0;
+        const int result = mbedtls_asn1_get_tag(&p, end_, &len, tag);
+        if (result == MBEDTLS_ERR_ASN1_UNEXPECTED_TAG) {
+            return false;
+        }
+        system_crypto_handler(
+                result, [](int) { std::throw_with_nested(make_error(VirgilCryptoError::InvalidFormat)); });
+        content = Bytes { p, len };
+        p_ = p + len;
+        return true;
+    }
+
+    bool readOptionalContextTag(unsigned char tag, Bytes& content) {
+        return readOptionalTag(MBEDTLS_ASN1_CONTEXT_SPECIFIC | MBEDTLS_ASN1_CONSTRUCTED | tag, content);
+    }
+
+    Bytes readContextTag(unsigned char tag) {
+        return readTag(MBEDTLS_ASN1_CONTEXT_SPECIFIC | MBEDTLS_ASN1_CONSTRUCTED | tag);
+    }
+
+    Bytes readSequence() {
+        return readTag(MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE);
+    }
+
+    Bytes readOctetString() {
+        return readTag(MBEDTLS_ASN1_OCTET_STRING);
+    }
+
+    int readInteger() {
+        unsigned char* p = const_cast<unsigned char*>(p_);
+        int value = 0;
+        system_crypto_handler(
+                mbedtls_asn1_get_int(&p, end_, &value),
+                [](int) { std::throw_with_nested(make_error(VirgilCryptoError::InvalidFormat)); });
+        p_ = p;
+        return value;
+    }
+
+    /**
+     * @brief Return whole element (tag, length and content) and skip it.
+     */
+    Bytes readElement() {
+        if (atEnd()) {
+            throw make_error(VirgilCryptoError::InvalidFormat);
+        }
+        const unsigned char* begin = p_;
+        unsigned char* p = const_cast<unsigned char*>(p_) + 1;
+        size_t len = 0;
+        system_crypto_handler(
+                mbedtls_asn1_get_len(&p, end_, &len),
+                [](int) { std::throw_with_nested(make_error(VirgilCryptoError::InvalidFormat)); });
+        p_ = p + len;
+        return Bytes { begin, static_cast<size_t>(p_ - begin) };
+    }
+
+private:
+    const unsigned char* p_;
+    const unsigned char* end_;
+};
+
+}}}
+
+using virgil::crypto::internal::Asn1Cursor;
+
+bool VirgilContentInfoView::Bytes::equals(const VirgilByteArray& other) const {
+    return equals(Bytes { other.data(), other.size() });
+}
+
+bool VirgilContentInfoView::Bytes::equals(const Bytes& other) const {
+    return size == other.size && (size == 0 || std::memcmp(data, other.data, size) == 0);
+}
+
+VirgilContentInfoView::VirgilContentInfoView(const VirgilByteArray& contentInfo)
+        : VirgilContentInfoView(contentInfo.data(), contentInfo.size()) {}
+
+VirgilContentInfoView::VirgilContentInfoView(const unsigned char* data, size_t size)
+        : contentInfo_ { data, 0 }, recipientInfos_ { nullptr, 0 }, customParams_ { nullptr, 0 },
+          algorithms_ { nullptr, 0 } {
+
+    if (data == nullptr || size == 0) {
+        throw make_error(VirgilCryptoError::InvalidFormat);
+    }
+
+    // VirgilContentInfo
+    Asn1Cursor cursor(data, data + size);
+    Asn1Cursor contentInfo(cursor.readSequence());
+    contentInfo_.size = static_cast<size_t>(cursor.position() - data);
+    const int version = contentInfo.readInteger();
+    if (version != kAsn1_ContentInfoVersion && version != kAsn1_ContentInfoVersionCompact) {
+        throw make_error(VirgilCryptoError::UnsupportedAlgorithm, "Unsupported version of CMS Content Info.");
+    }
+
+    // ContentInfo
+    Asn1Cursor cmsContent(contentInfo.readSequence());
+    const Bytes contentType = cmsContent.readTag(MBEDTLS_ASN1_OID);
+    const std::string envelopedDataOID = OID_TO_STD_STRING(OID_PKCS7_ENVELOPED_DATA);
+    if (contentType.size != envelopedDataOID.size() ||
+            std::memcmp(contentType.data, envelopedDataOID.data(), contentType.size) != 0) {
+        throw make_error(VirgilCryptoError::InvalidFormat);
+    }
+    Asn1Cursor content(cmsContent.readContextTag(kCMS_ContentTag));
+
+    // EnvelopedData
+    Asn1Cursor envelopedData(content.readSequence());
+    (void) envelopedData.readInteger();
+    Bytes originatorInfo { nullptr, 0 };
+    (void) envelopedData.readOptionalContextTag(kCMS_OriginatorInfoTag, originatorInfo);
+    recipientInfos_ = envelopedData.readTag(MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SET);
+
+    // VirgilCustomParams
+    if (contentInfo.readOptionalContextTag(kAsn1_CustomParamsTag, customParams_)) {
+        customParams_ = Asn1Cursor(customParams_).readTag(MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SET);
+    }
+
+    // Algorithms referenced by recipients
+    if (version == kAsn1_ContentInfoVersionCompact &&
+            contentInfo.readOptionalContextTag(kAsn1_AlgorithmsTag, algorithms_)) {
+        algorithms_ = Asn1Cursor(algorithms_).readSequence();
+    }
+}
+
+size_t VirgilContentInfoView::size() const {
+    return contentInfo_.size;
+}
+
+void VirgilContentInfoView::visitRecipients(bool (* visit)(void*, const Recipient&), void* ctx) const {
+    Asn1Cursor recipientInfos(recipientInfos_);
+    while (!recipientInfos.atEnd()) {
+        Recipient recipient {};
+        Bytes recipientInfo { nullptr, 0 };
+        if (recipientInfos.readOptionalContextTag(kCMS_PasswordRecipientTag, recipientInfo)) {
+            Asn1Cursor passwordRecipient(Asn1Cursor(recipientInfo).readSequence());
+            (void) passwordRecipient.readInteger();
+            Bytes keyDerivationAlgorithm { nullptr, 0 };
+            (void) passwordRecipient.readOptionalContextTag(kCMS_KeyDerivationAlgorithmTag, keyDerivationAlgorithm);
+            recipient.type = RecipientType::Password;
+            recipient.keyEncryptionAlgorithm = passwordRecipient.readElement();
+            recipient.encryptedKey = passwordRecipient.readOctetString();
+            if (!visit(ctx, recipient)) {
+                return;
+            }
+        } else if (recipientInfos.readOptionalContextTag(kCMS_KeyAgreeRecipientTag, recipientInfo)) {
+            Asn1Cursor keyAgreeRecipient(Asn1Cursor(recipientInfo).readSequence());
+            (void) keyAgreeRecipient.readInteger();
+            Asn1Cursor originator(keyAgreeRecipient.readContextTag(kCMS_OriginatorTag));
+            recipient.type = RecipientType::KeyAgree;
+            recipient.originatorKey = Asn1Cursor(originator.readContextTag(kCMS_OriginatorKeyTag)).readElement();
+            Bytes userKeyingMaterial { nullptr, 0 };
+            (void) keyAgreeRecipient.readOptionalContextTag(kCMS_UserKeyingMaterialTag, userKeyingMaterial);
+            recipient.keyEncryptionAlgorithm = resolveAlgorithm(keyAgreeRecipient.readElement());
+            Asn1Cursor recipientEncryptedKeys(keyAgreeRecipient.readSequence());
+            while (!recipientEncryptedKeys.atEnd()) {
+                Asn1Cursor recipientEncryptedKey(recipientEncryptedKeys.readSequence());
+                Asn1Cursor recipientKeyId(recipientEncryptedKey.readContextTag(kCMS_RecipientKeyIdTag));
+                recipient.recipientId = Asn1Cursor(recipientKeyId.readSequence()).readOctetString();
+                recipient.encryptedKey = recipientEncryptedKey.readOctetString();
+                if (!visit(ctx, recipient)) {
+                    return;
+                }
+            }
+        } else if (recipientInfos.readOptionalContextTag(kCMS_KEKRecipientTag, recipientInfo) ||
+                recipientInfos.readOptionalContextTag(kCMS_OtherRecipientTag, recipientInfo)) {
+            continue; // Ignore unsupported recipient types
+        } else {
+            Asn1Cursor keyTransRecipient(recipientInfos.readSequence());
+            (void) keyTransRecipient.readInteger();
+            recipient.type = RecipientType::KeyTrans;
+            recipient.recipientId = Asn1Cursor(keyTransRecipient.readContextTag(kCMS_SubjectKeyTag)).readOctetString();
+            recipient.keyEncryptionAlgorithm = resolveAlgorithm(keyTransRecipient.readElement());
+            recipient.encryptedKey = keyTransRecipient.readOctetString();
+            if (!visit(ctx, recipient)) {
+                return;
+            }
+        }
+    }
+}
+
+VirgilContentInfoView::Bytes VirgilContentInfoView::resolveAlgorithm(const Bytes& algorithm) const {
+    Bytes indexBytes { nullptr, 0 };
+    if (!Asn1Cursor(algorithm).readOptionalTag(MBEDTLS_ASN1_CONTEXT_SPECIFIC | kAsn1_AlgorithmRefTag, indexBytes)) {
+        return algorithm;
+    }
+    if (indexBytes.empty() || indexBytes.size > sizeof(size_t)) {
+        throw make_error(VirgilCryptoError::InvalidFormat);
+    }
+    size_t index = 0;
+    for (size_t i = 0; i < indexBytes.size; ++i) {
+        index = (index << 8) | indexBytes.data[i];
+    }
+    Asn1Cursor algorithms(algorithms_);
+    for (; index > 0; --index) {
+        (void) algorithms.readElement();
+    }
+    return algorithms.readElement();
+}
+
+bool VirgilContentInfoView::findRecipient(const VirgilByteArray& recipientId, Recipient* recipient) const {
+    struct Context {
+        const VirgilByteArray& recipientId;
+        Recipient* recipient;
+        bool isFound;
+    } context { recipientId, recipient, false };
+
+    visitRecipients(
+            [](void* ctx, const Recipient& current) -> bool {
+                auto& context = *static_cast<Context*>(ctx);
+                if (current.type == RecipientType::Password || !current.recipientId.equals(context.recipientId)) {
+                    return true;
+                }
+                if (context.recipient != nullptr) {
+                    *context.recipient = current;
+                }
+                context.isFound = true;
+                return false;
+            },
+            &context);
+
+    return context.isFound;
+}
+
+/**
+ * @brief Return view of the given key.
+ */
+///@{
+static VirgilContentInfoView::Bytes key_view(const VirgilByteArray& key) {
+    return { key.data(), key.size() };
+}
+
+static VirgilContentInfoView::Bytes key_view(const char* key) {
+    return { reinterpret_cast<const unsigned char*>(key), std::strlen(key) };
+}
+///@}
+
+bool VirgilContentInfoView::findCustomParam(const Bytes& key, unsigned char valueTag, Bytes& value) const {
+    Asn1Cursor keyValues(customParams_);
+    while (!keyValues.atEnd()) {
+        Asn1Cursor keyValue(keyValues.readSequence());
+        if (!keyValue.readTag(MBEDTLS_ASN1_UTF8_STRING).equals(key)) {
+            continue;
+        }
+        if (keyValue.readOptionalContextTag(valueTag, value)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool VirgilContentInfoView::getCustomInteger(const VirgilByteArray& key, int& value) const {
+    return getCustomInteger(key_view(key), value);
+}
+
+bool VirgilContentInfoView::getCustomInteger(const char* key, int& value) const {
+    return getCustomInteger(key_view(key), value);
+}
+
+bool VirgilContentInfoView::getCustomInteger(const Bytes& key, int& value) const {
+    Bytes valueAsn1 { nullptr, 0 };
+    if (!findCustomParam(key, kCMS_IntegerValueTag, valueAsn1)) {
+        return false;
+    }
+    value = Asn1Cursor(valueAsn1).readInteger();
+    return true;
+}
+
+bool VirgilContentInfoView::getCustomString(const VirgilByteArray& key, Bytes& value) const {
+    return getCustomString(key_view(key), value);
+}
+
+bool VirgilContentInfoView::getCustomString(const char* key, Bytes& value) const {
+    return getCustomString(key_view(key), value);
+}
+
+bool VirgilContentInfoView::getCustomString(const Bytes& key, Bytes& value) const {
+    Bytes valueAsn1 { nullptr, 0 };
+    if (!findCustomParam(key, kCMS_StringValueTag, valueAsn1)) {
+        return false;
+    }
+    value = Asn1Cursor(valueAsn1).readTag(MBEDTLS_ASN1_UTF8_STRING);
+    return true;
+}
+
+bool VirgilContentInfoView::getCustomData(const VirgilByteArray& key, Bytes& value) const {
+    return getCustomData(key_view(key), value);
+}
+
+bool VirgilContentInfoView::getCustomData(const char* key, Bytes& value) const {
+    return getCustomData(key_view(key), value);
+}
+
+bool VirgilContentInfoView::getCustomData(const Bytes& key, Bytes& value) const {
+    Bytes valueAsn1 { nullptr, 0 };
+    if (!findCustomParam(key, kCMS_DataValueTag, valueAsn1)) {
+        return false;
+    }
+    value = Asn1Cursor(valueAsn1).readOctetString();
+    return true;
+}
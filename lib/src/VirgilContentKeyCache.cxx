@@ -0,0 +1,153 @@
+/**
+ * Copyright (C) 2015-2018 Virgil Security Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *     (3) Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+ */
+
+#include <virgil/crypto/VirgilContentKeyCache.h>
+
+#include <virgil/crypto/VirgilByteArrayUtils.h>
+#include <virgil/crypto/VirgilCryptoError.h>
+
+#include "VirgilByteArrayHash.h"
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+using virgil::crypto::VirgilByteArray;
+using virgil::crypto::VirgilByteArrayUtils;
+using virgil::crypto::VirgilContentKeyCache;
+using virgil::crypto::VirgilCryptoError;
+using virgil::crypto::make_error;
+
+using virgil::crypto::internal::VirgilByteArrayHash;
+
+namespace virgil { namespace crypto {
+
+/**
+ * @brief Handle class fields.
+ *
+ * Entries are kept in the list ordered from the most to the least recently used one,
+ *     and the map gives access to them by the entry identifier.
+ */
+class VirgilContentKeyCache::Impl {
+public:
+    using Entry = std::pair<VirgilByteArray, VirgilByteArray>;
+    using EntryList = std::list<Entry>;
+
+    explicit Impl(size_t capacity) : capacity(capacity) {}
+
+    ~Impl() noexcept {
+        clear();
+    }
+
+    void clear() noexcept {
+        for (auto& entry : entries) {
+            VirgilByteArrayUtils::zeroize(entry.second);
+        }
+        index.clear();
+        entries.clear();
+    }
+
+public:
+    const size_t capacity;
+    std::mutex mutex;
+    EntryList entries;
+    std::unordered_map<VirgilByteArray, EntryList::iterator, VirgilByteArrayHash> index;
+};
+
+}}
+
+VirgilContentKeyCache::VirgilContentKeyCache(size_t capacity) {
+    if (capacity == 0) {
+        throw make_error(VirgilCryptoError::InvalidArgument, "Content key cache capacity can not be zero.");
+    }
+    impl_ = std::make_shared<Impl>(capacity);
+}
+
+VirgilContentKeyCache::VirgilContentKeyCache(const VirgilContentKeyCache& rhs) = default;
+
+VirgilContentKeyCache& VirgilContentKeyCache::operator=(const VirgilContentKeyCache& rhs) = default;
+
+VirgilContentKeyCache::VirgilContentKeyCache(VirgilContentKeyCache&& rhs) noexcept = default;
+
+VirgilContentKeyCache& VirgilContentKeyCache::operator=(VirgilContentKeyCache&& rhs) noexcept = default;
+
+VirgilContentKeyCache::~VirgilContentKeyCache() noexcept = default;
+
+size_t VirgilContentKeyCache::capacity() const {
+    return impl_->capacity;
+}
+
+size_t VirgilContentKeyCache::size() const {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    return impl_->entries.size();
+}
+
+void VirgilContentKeyCache::clear() {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    impl_->clear();
+}
+
+VirgilByteArray VirgilContentKeyCache::find(const VirgilByteArray& entryId) const {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    auto indexIt = impl_->index.find(entryId);
+    if (indexIt == impl_->index.end()) {
+        return VirgilByteArray();
+    }
+    impl_->entries.splice(impl_->entries.begin(), impl_->entries, indexIt->second);
+    return indexIt->second->second;
+}
+
+void VirgilContentKeyCache::insert(const VirgilByteArray& entryId, const VirgilByteArray& key) {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    auto indexIt = impl_->index.find(entryId);
+    if (indexIt != impl_->index.end()) {
+        VirgilByteArrayUtils::zeroize(indexIt->second->second);
+        indexIt->second->second = key;
+        impl_->entries.splice(impl_->entries.begin(), impl_->entries, indexIt->second);
+        return;
+    }
+
+    if (impl_->entries.size() >= impl_->capacity) {
+        auto& leastRecentlyUsed = impl_->entries.back();
+        VirgilByteArrayUtils::zeroize(leastRecentlyUsed.second);
+        impl_->index.erase(leastRecentlyUsed.first);
+        impl_->entries.pop_back();
+    }
+
+    impl_->entries.emplace_front(entryId, key);
+    impl_->index.emplace(entryId, impl_->entries.begin());
+}
@@ -0,0 +1,90 @@
+/**
+ * Copyright (C) 2015-2018 Virgil Security Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *     (3) Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+ */
+
+#ifndef VIRGIL_CRYPTO_CPU_FEATURES_H
+#define VIRGIL_CRYPTO_CPU_FEATURES_H
+
+/**
+ * @brief Defined to 1 if x86 intrinsics with per function target attributes can be used.
+ */
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define VIRGIL_CRYPTO_X86_INTRINSICS 1
+#else
+#define VIRGIL_CRYPTO_X86_INTRINSICS 0
+#endif
+
+namespace virgil { namespace crypto { namespace foundation { namespace internal {
+
+#if VIRGIL_CRYPTO_X86_INTRINSICS
+
+/**
+ * @brief Return true if CPU supports AVX2 instructions.
+ */
+inline bool cpu_has_avx2() {
+    static const bool hasFeature = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+    }();
+    return hasFeature;
+}
+
+/**
+ * @brief Return true if CPU supports AES-NI and PCLMULQDQ instructions.
+ */
+inline bool cpu_has_aesni_pclmul() {
+    static const bool hasFeature = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("aes") != 0 && __builtin_cpu_supports("pclmul") != 0 &&
+                __builtin_cpu_supports("sse4.1") != 0;
+    }();
+    return hasFeature;
+}
+
+#else
+
+inline bool cpu_has_avx2() {
+    return false;
+}
+
+inline bool cpu_has_aesni_pclmul() {
+    return false;
+}
+
+#endif // VIRGIL_CRYPTO_X86_INTRINSICS
+
+}}}}
+
+#endif /* VIRGIL_CRYPTO_CPU_FEATURES_H */
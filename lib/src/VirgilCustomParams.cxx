@@ -36,6 +36,9 @@
 
 #include <virgil/crypto/VirgilCustomParams.h>
 
+#include <algorithm>
+#include <cstring>
+
 #include <tinyformat/tinyformat.h>
 
 #include <virgil/crypto/VirgilCryptoError.h>
@@ -59,135 +62,300 @@ static const unsigned char kCMS_StringValueTag = 1;
 static const unsigned char kCMS_DataValueTag = 2;
 ///@}
 
+static const unsigned char* key_data(const VirgilByteArray& key) {
+    return key.data();
+}
+
+static const unsigned char* key_data(const char* key) {
+    return reinterpret_cast<const unsigned char*>(key);
+}
+
+static int compare_bytes(const unsigned char* first, size_t firstSize, const unsigned char* second, size_t secondSize) {
+    const int result = std::memcmp(first, second, std::min(firstSize, secondSize));
+    if (result != 0) {
+        return result;
+    }
+    return firstSize < secondSize ? -1 : (firstSize > secondSize ? 1 : 0);
+}
+
 bool VirgilCustomParams::isEmpty() const {
-    return intValues_.empty() && stringValues_.empty() && dataValues_.empty();
+    return entries_.empty();
 }
 
 void VirgilCustomParams::setInteger(const VirgilByteArray& key, int value) {
-    intValues_[key] = value;
+    set(ValueType::Integer, key_data(key), key.size(), nullptr, 0, value);
+}
+
+void VirgilCustomParams::setInteger(const char* key, int value) {
+    set(ValueType::Integer, key_data(key), std::strlen(key), nullptr, 0, value);
 }
 
 int VirgilCustomParams::getInteger(const VirgilByteArray& key) const {
-    std::map<VirgilByteArray, int>::const_iterator keyValue = intValues_.find(key);
-    if (keyValue != intValues_.end()) {
-        return keyValue->second;
-    } else {
-        throw make_error(VirgilCryptoError::InvalidFormat);
-    }
+    return get(ValueType::Integer, key_data(key), key.size()).intValue;
+}
+
+int VirgilCustomParams::getInteger(const char* key) const {
+    return get(ValueType::Integer, key_data(key), std::strlen(key)).intValue;
+}
+
+bool VirgilCustomParams::hasInteger(const VirgilByteArray& key) const {
+    return find(ValueType::Integer, key_data(key), key.size()) != nullptr;
+}
+
+bool VirgilCustomParams::hasInteger(const char* key) const {
+    return find(ValueType::Integer, key_data(key), std::strlen(key)) != nullptr;
 }
 
 void VirgilCustomParams::removeInteger(const VirgilByteArray& key) {
-    intValues_.erase(key);
+    remove(ValueType::Integer, key_data(key), key.size());
 }
 
 void VirgilCustomParams::setString(const VirgilByteArray& key, const VirgilByteArray& value) {
-    stringValues_[key] = value;
+    set(ValueType::String, key_data(key), key.size(), value.data(), value.size(), 0);
 }
 
 VirgilByteArray VirgilCustomParams::getString(const VirgilByteArray& key) const {
-    std::map<VirgilByteArray, VirgilByteArray>::const_iterator keyValue = stringValues_.find(key);
-    if (keyValue != stringValues_.end()) {
-        return keyValue->second;
-    } else {
-        throw make_error(VirgilCryptoError::InvalidFormat);
-    }
+    return value(get(ValueType::String, key_data(key), key.size()));
+}
+
+VirgilByteArray VirgilCustomParams::getString(const char* key) const {
+    return value(get(ValueType::String, key_data(key), std::strlen(key)));
+}
+
+bool VirgilCustomParams::hasString(const VirgilByteArray& key) const {
+    return find(ValueType::String, key_data(key), key.size()) != nullptr;
+}
+
+bool VirgilCustomParams::hasString(const char* key) const {
+    return find(ValueType::String, key_data(key), std::strlen(key)) != nullptr;
 }
 
 void VirgilCustomParams::removeString(const VirgilByteArray& key) {
-    stringValues_.erase(key);
+    remove(ValueType::String, key_data(key), key.size());
 }
 
 void VirgilCustomParams::setData(const VirgilByteArray& key, const VirgilByteArray& value) {
-    dataValues_[key] = value;
+    set(ValueType::Data, key_data(key), key.size(), value.data(), value.size(), 0);
 }
 
 VirgilByteArray VirgilCustomParams::getData(const VirgilByteArray& key) const {
-    std::map<VirgilByteArray, VirgilByteArray>::const_iterator keyValue = dataValues_.find(key);
-    if (keyValue != dataValues_.end()) {
-        return keyValue->second;
-    } else {
-        throw make_error(VirgilCryptoError::InvalidFormat);
-    }
+    return value(get(ValueType::Data, key_data(key), key.size()));
+}
+
+VirgilByteArray VirgilCustomParams::getData(const char* key) const {
+    return value(get(ValueType::Data, key_data(key), std::strlen(key)));
+}
+
+bool VirgilCustomParams::hasData(const VirgilByteArray& key) const {
+    return find(ValueType::Data, key_data(key), key.size()) != nullptr;
+}
+
+bool VirgilCustomParams::hasData(const char* key) const {
+    return find(ValueType::Data, key_data(key), std::strlen(key)) != nullptr;
 }
 
 void VirgilCustomParams::removeData(const VirgilByteArray& key) {
-    dataValues_.erase(key);
+    remove(ValueType::Data, key_data(key), key.size());
 }
 
 void VirgilCustomParams::clear() {
-    intValues_.clear();
-    stringValues_.clear();
-    dataValues_.clear();
+    entries_.clear();
+    storage_.clear();
+    unusedStorageSize_ = 0;
 }
 
-size_t VirgilCustomParams::asn1Write(VirgilAsn1Writer& asn1Writer, size_t childWrittenBytes) const {
-    std::vector<VirgilByteArray> keyValues;
+std::vector<VirgilCustomParams::Entry>::const_iterator VirgilCustomParams::lowerBound(
+        ValueType type, const unsigned char* key, size_t keySize) const {
+    return std::lower_bound(entries_.cbegin(), entries_.cend(), type,
+            [this, key, keySize](const Entry& entry, ValueType searchedType) {
+                if (entry.type != searchedType) {
+                    return entry.type < searchedType;
+                }
+                return compare_bytes(storage_.data() + entry.keyOffset, entry.keySize, key, keySize) < 0;
+            });
+}
 
-    for (std::map<VirgilByteArray, int>::const_iterator it = intValues_.begin();
-         it != intValues_.end(); ++it) {
+const VirgilCustomParams::Entry* VirgilCustomParams::find(
+        ValueType type, const unsigned char* key, size_t keySize) const {
+    auto it = lowerBound(type, key, keySize);
+    if (it != entries_.cend() && it->type == type &&
+            compare_bytes(storage_.data() + it->keyOffset, it->keySize, key, keySize) == 0) {
+        return &(*it);
+    }
+    return nullptr;
+}
 
-        VirgilAsn1Writer keyValueAsn1Writer;
-        size_t len = 0;
-        len += keyValueAsn1Writer.writeInteger(it->second);
-        len += keyValueAsn1Writer.writeContextTag(kCMS_IntegerValueTag, len);
-        len += keyValueAsn1Writer.writeUTF8String(it->first);
-        len += keyValueAsn1Writer.writeSequence(len);
+const VirgilCustomParams::Entry& VirgilCustomParams::get(
+        ValueType type, const unsigned char* key, size_t keySize) const {
+    const Entry* entry = find(type, key, keySize);
+    if (entry == nullptr) {
+        throw make_error(VirgilCryptoError::InvalidFormat);
+    }
+    return *entry;
+}
 
-        keyValues.push_back(keyValueAsn1Writer.finish());
+void VirgilCustomParams::set(
+        ValueType type, const unsigned char* key, size_t keySize, const unsigned char* value, size_t valueSize,
+        int intValue) {
+    auto it = entries_.begin() + (lowerBound(type, key, keySize) - entries_.cbegin());
+    const bool exists = it != entries_.end() && it->type == type &&
+            compare_bytes(storage_.data() + it->keyOffset, it->keySize, key, keySize) == 0;
+    if (exists) {
+        // Key is kept in place, value is replaced.
+        if (valueSize <= it->valueSize) {
+            std::copy(value, value + valueSize, storage_.begin() + it->valueOffset);
+            unusedStorageSize_ += it->valueSize - valueSize;
+        } else {
+            unusedStorageSize_ += it->valueSize;
+            it->valueOffset = storage_.size();
+            storage_.insert(storage_.end(), value, value + valueSize);
+        }
+        it->valueSize = valueSize;
+        it->intValue = intValue;
+    } else {
+        Entry entry { type, storage_.size(), keySize, storage_.size() + keySize, valueSize, intValue };
+        storage_.insert(storage_.end(), key, key + keySize);
+        storage_.insert(storage_.end(), value, value + valueSize);
+        entries_.insert(it, entry);
     }
+    compact();
+}
 
-    for (std::map<VirgilByteArray, VirgilByteArray>::const_iterator it = stringValues_.begin();
-         it != stringValues_.end(); ++it) {
+void VirgilCustomParams::remove(ValueType type, const unsigned char* key, size_t keySize) {
+    const Entry* entry = find(type, key, keySize);
+    if (entry != nullptr) {
+        unusedStorageSize_ += entry->keySize + entry->valueSize;
+        entries_.erase(entries_.begin() + (entry - entries_.data()));
+        compact();
+    }
+}
 
-        VirgilAsn1Writer keyValueAsn1Writer;
-        size_t len = 0;
-        len += keyValueAsn1Writer.writeUTF8String(it->second);
-        len += keyValueAsn1Writer.writeContextTag(kCMS_StringValueTag, len);
-        len += keyValueAsn1Writer.writeUTF8String(it->first);
-        len += keyValueAsn1Writer.writeSequence(len);
+VirgilByteArray VirgilCustomParams::value(const Entry& entry) const {
+    auto valueBegin = storage_.cbegin() + entry.valueOffset;
+    return VirgilByteArray(valueBegin, valueBegin + entry.valueSize);
+}
 
-        keyValues.push_back(keyValueAsn1Writer.finish());
+void VirgilCustomParams::compact() {
+    if (entries_.empty()) {
+        clear();
+        return;
     }
+    if (unusedStorageSize_ <= storage_.size() / 2) {
+        return;
+    }
+    VirgilByteArray storage;
+    storage.reserve(storage_.size() - unusedStorageSize_);
+    for (auto& entry : entries_) {
+        auto keyBegin = storage_.cbegin() + entry.keyOffset;
+        auto valueBegin = storage_.cbegin() + entry.valueOffset;
+        entry.keyOffset = storage.size();
+        storage.insert(storage.end(), keyBegin, keyBegin + entry.keySize);
+        entry.valueOffset = storage.size();
+        storage.insert(storage.end(), valueBegin, valueBegin + entry.valueSize);
+    }
+    storage_.swap(storage);
+    unusedStorageSize_ = 0;
+}
 
-    for (std::map<VirgilByteArray, VirgilByteArray>::const_iterator it = dataValues_.begin();
-         it != dataValues_.end(); ++it) {
-
-        VirgilAsn1Writer keyValueAsn1Writer;
-        size_t len = 0;
-        len += keyValueAsn1Writer.writeOctetString(it->second);
-        len += keyValueAsn1Writer.writeContextTag(kCMS_DataValueTag, len);
-        len += keyValueAsn1Writer.writeUTF8String(it->first);
-        len += keyValueAsn1Writer.writeSequence(len);
+size_t VirgilCustomParams::writeEntry(VirgilAsn1Writer& asn1Writer, const Entry& entry) const {
+    const unsigned char* value = storage_.data() + entry.valueOffset;
+    size_t len = 0;
+    switch (entry.type) {
+        case ValueType::Integer:
+            len += asn1Writer.writeInteger(entry.intValue);
+            len += asn1Writer.writeContextTag(kCMS_IntegerValueTag, len);
+            break;
+        case ValueType::String:
+            len += asn1Writer.writeUTF8String(value, entry.valueSize);
+            len += asn1Writer.writeContextTag(kCMS_StringValueTag, len);
+            break;
+        case ValueType::Data:
+            len += asn1Writer.writeOctetString(value, entry.valueSize);
+            len += asn1Writer.writeContextTag(kCMS_DataValueTag, len);
+            break;
+    }
+    len += asn1Writer.writeUTF8String(storage_.data() + entry.keyOffset, entry.keySize);
+    len += asn1Writer.writeSequence(len);
+    return len;
+}
 
-        keyValues.push_back(keyValueAsn1Writer.finish());
+size_t VirgilCustomParams::asn1Write(VirgilAsn1Writer& asn1Writer, size_t childWrittenBytes) const {
+    // Order of the key-values does not affect the size, so they are sized in place.
+    if (asn1Writer.isSizing()) {
+        size_t keyValuesLen = 0;
+        for (const auto& entry : entries_) {
+            keyValuesLen += writeEntry(asn1Writer, entry);
+        }
+        return keyValuesLen + asn1Writer.writeSet(keyValuesLen) + childWrittenBytes;
     }
 
-    size_t len = asn1Writer.writeSet(keyValues);
-    return len + childWrittenBytes;
+    // Key-values are written one after another to the single buffer of the exact size, and then ordered.
+    VirgilAsn1Writer keyValuesAsn1Writer;
+    keyValuesAsn1Writer.resetSizing();
+    size_t keyValuesLen = 0;
+    for (const auto& entry : entries_) {
+        keyValuesLen += writeEntry(keyValuesAsn1Writer, entry);
+    }
+    keyValuesAsn1Writer.reset(keyValuesLen);
+    for (const auto& entry : entries_) {
+        (void) writeEntry(keyValuesAsn1Writer, entry);
+    }
+    const VirgilByteArray keyValues = keyValuesAsn1Writer.finish();
+    return asn1Writer.writeSet(keyValues.data(), keyValues.size()) + childWrittenBytes;
 }
 
 void VirgilCustomParams::asn1Read(VirgilAsn1Reader& asn1Reader) {
-    intValues_.clear();
-    stringValues_.clear();
-    dataValues_.clear();
+    clear();
 
     size_t setLen = asn1Reader.readSet();
+    // Keys and values can not be longer than the SET itself.
+    storage_.reserve(setLen);
     while (setLen != 0) {
-        VirgilByteArray keyValueAsn1 = asn1Reader.readData();
-        VirgilAsn1Reader keyValueAsn1Reader(keyValueAsn1);
+        auto keyValueAsn1 = asn1Reader.readDataView();
+        VirgilAsn1Reader keyValueAsn1Reader(keyValueAsn1.data, keyValueAsn1.size);
 
         (void) keyValueAsn1Reader.readSequence();
-        VirgilByteArray key = keyValueAsn1Reader.readUTF8String();
+        auto key = keyValueAsn1Reader.readUTF8StringView();
 
+        Entry entry { ValueType::Integer, storage_.size(), key.size, storage_.size() + key.size, 0, 0 };
+        VirgilAsn1Reader::View value { nullptr, 0 };
         if (keyValueAsn1Reader.readContextTag(kCMS_IntegerValueTag) > 0) {
-            intValues_[key] = keyValueAsn1Reader.readInteger();
+            entry.intValue = keyValueAsn1Reader.readInteger();
         } else if (keyValueAsn1Reader.readContextTag(kCMS_StringValueTag) > 0) {
-            stringValues_[key] = keyValueAsn1Reader.readUTF8String();
+            entry.type = ValueType::String;
+            value = keyValueAsn1Reader.readUTF8StringView();
         } else if (keyValueAsn1Reader.readContextTag(kCMS_DataValueTag) > 0) {
-            dataValues_[key] = keyValueAsn1Reader.readOctetString();
+            entry.type = ValueType::Data;
+            value = keyValueAsn1Reader.readOctetStringView();
         } else {
             throw make_error(VirgilCryptoError::InvalidFormat);
         }
-        setLen = setLen > keyValueAsn1.size() ? (setLen - keyValueAsn1.size()) : 0;
+        entry.valueSize = value.size;
+        storage_.insert(storage_.end(), key.data, key.data + key.size);
+        storage_.insert(storage_.end(), value.data, value.data + value.size);
+        entries_.push_back(entry);
+
+        setLen = setLen > keyValueAsn1.size ? (setLen - keyValueAsn1.size) : 0;
+    }
+
+    // Order parameters, so the last of the duplicated keys wins.
+    auto less = [this](const Entry& first, const Entry& second) {
+        if (first.type != second.type) {
+            return first.type < second.type;
+        }
+        return compare_bytes(storage_.data() + first.keyOffset, first.keySize,
+                storage_.data() + second.keyOffset, second.keySize) < 0;
+    };
+    std::stable_sort(entries_.begin(), entries_.end(), less);
+    auto last = entries_.begin();
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+        auto next = it + 1;
+        if (next != entries_.end() && !less(*it, *next)) {
+            unusedStorageSize_ += it->keySize + it->valueSize;
+            continue;
+        }
+        *last++ = *it;
     }
+    entries_.erase(last, entries_.end());
+    compact();
 }
@@ -45,6 +45,7 @@
 #include <virgil/crypto/foundation/asn1/VirgilAsn1Writer.h>
 
 #include "utils.h"
+#include "VirgilAlgorithmIdentifiers.h"
 #include "mbedtls_context.h"
 #include "mbedtls_type_utils.h"
 
@@ -56,6 +57,9 @@ using virgil::crypto::foundation::VirgilHash;
 using virgil::crypto::foundation::asn1::VirgilAsn1Compatible;
 using virgil::crypto::foundation::asn1::VirgilAsn1Reader;
 using virgil::crypto::foundation::asn1::VirgilAsn1Writer;
+using virgil::crypto::foundation::asn1::internal::find_der_algorithm;
+using virgil::crypto::foundation::asn1::internal::match_der_algorithm;
+using virgil::crypto::foundation::asn1::internal::kDer_HashAlgorithms;
 
 namespace virgil { namespace crypto { namespace foundation {
 
@@ -239,6 +243,10 @@ void VirgilHash::checkState() const {
 
 size_t VirgilHash::asn1Write(VirgilAsn1Writer& asn1Writer, size_t childWrittenBytes) const {
     checkState();
+    auto derAlgorithm = find_der_algorithm(kDer_HashAlgorithms, impl_->info.type());
+    if (derAlgorithm != nullptr) {
+        return asn1Writer.writeData(derAlgorithm->der, derAlgorithm->size) + childWrittenBytes;
+    }
     const char* oid = 0;
     size_t oidLen;
     system_crypto_handler(
@@ -253,20 +261,27 @@ size_t VirgilHash::asn1Write(VirgilAsn1Writer& asn1Writer, size_t childWrittenBy
 }
 
 void VirgilHash::asn1Read(VirgilAsn1Reader& asn1Reader) {
-    asn1Reader.readSequence();
-    VirgilByteArray oid = VirgilByteArrayUtils::stringToBytes(asn1Reader.readOID());
-
-    mbedtls_asn1_buf oidAsn1Buf;
-    oidAsn1Buf.len = oid.size();
-    oidAsn1Buf.p = oid.data();
-
+    auto algorithmAsn1 = asn1Reader.readDataView();
     mbedtls_md_type_t type = MBEDTLS_MD_NONE;
-    system_crypto_handler(
-            mbedtls_oid_get_md_alg(&oidAsn1Buf, &type),
-            [](int) { std::throw_with_nested(make_error(VirgilCryptoError::UnsupportedAlgorithm)); }
-    );
-
-    asn1Reader.readNull();
+    auto derAlgorithm = match_der_algorithm(kDer_HashAlgorithms, algorithmAsn1.data, algorithmAsn1.size);
+    if (derAlgorithm != nullptr) {
+        type = derAlgorithm->type;
+    } else {
+        VirgilAsn1Reader algorithmAsn1Reader(algorithmAsn1.data, algorithmAsn1.size);
+        algorithmAsn1Reader.readSequence();
+        VirgilByteArray oid = VirgilByteArrayUtils::stringToBytes(algorithmAsn1Reader.readOID());
+
+        mbedtls_asn1_buf oidAsn1Buf;
+        oidAsn1Buf.len = oid.size();
+        oidAsn1Buf.p = oid.data();
+
+        system_crypto_handler(
+                mbedtls_oid_get_md_alg(&oidAsn1Buf, &type),
+                [](int) { std::throw_with_nested(make_error(VirgilCryptoError::UnsupportedAlgorithm)); }
+        );
+
+        algorithmAsn1Reader.readNull();
+    }
     auto impl = std::make_unique<Impl>();
     impl->setup(type);
     this->impl_ = std::move(impl);
@@ -0,0 +1,264 @@
+/**
+ * Copyright (C) 2015-2018 Virgil Security Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *     (3) Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+ */
+
+#include "VirgilKeyAgreement.h"
+
+#include <virgil/crypto/VirgilByteArrayUtils.h>
+#include <virgil/crypto/foundation/VirgilHKDF.h>
+#include <virgil/crypto/foundation/VirgilSystemCryptoError.h>
+#include <virgil/crypto/foundation/asn1/VirgilAsn1Reader.h>
+#include <virgil/crypto/foundation/asn1/VirgilAsn1Writer.h>
+
+#include "mbedtls_context.h"
+#include "VirgilOID.h"
+#include "VirgilAlgorithmIdentifiers.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <iterator>
+
+using virgil::crypto::VirgilByteArray;
+using virgil::crypto::VirgilByteArrayUtils;
+using virgil::crypto::VirgilKeyPair;
+using virgil::crypto::foundation::VirgilAsymmetricCipher;
+using virgil::crypto::foundation::VirgilHash;
+using virgil::crypto::foundation::VirgilHKDF;
+using virgil::crypto::foundation::asn1::VirgilAsn1Reader;
+using virgil::crypto::foundation::asn1::VirgilAsn1Writer;
+using virgil::crypto::foundation::asn1::internal::kDer_AES256_Wrap;
+using virgil::crypto::foundation::asn1::internal::kDer_DH_HKDF_SHA256_AES256_Wrap;
+using virgil::crypto::foundation::internal::VirgilKeyAgreement;
+
+namespace virgil { namespace crypto { namespace foundation { namespace internal {
+
+/**
+ * @name Configuration constants.
+ */
+///@{
+static constexpr size_t kKeyWrap_KeySize = 32;
+static constexpr size_t kKeyWrap_SemiblockSize = 8;
+static constexpr size_t kKeyWrap_Rounds = 6;
+static constexpr unsigned char kKeyWrap_IV = 0xA6;
+static constexpr unsigned char kCMS_SuppPubInfoTag = 2;
+///@}
+
+/**
+ * @brief Build DER encoded ECC-CMS-SharedInfo.
+ *
+ * @code
+ *     ECC-CMS-SharedInfo ::= SEQUENCE {
+ *         keyInfo AlgorithmIdentifier,
+ *         entityUInfo [0] EXPLICIT OCTET STRING OPTIONAL, -- not used
+ *         suppPubInfo [2] EXPLICIT OCTET STRING -- key encryption key size in bits, 32-bit big-endian
+ *     }
+ * @endcode
+ */
+static VirgilByteArray build_shared_info() {
+    constexpr size_t keyBits = kKeyWrap_KeySize * 8;
+    const VirgilByteArray suppPubInfo {
+            (unsigned char) (keyBits >> 24), (unsigned char) (keyBits >> 16),
+            (unsigned char) (keyBits >> 8), (unsigned char) keyBits
+    };
+    VirgilAsn1Writer asn1Writer;
+    size_t suppPubInfoLen = asn1Writer.writeOctetString(suppPubInfo);
+    size_t len = suppPubInfoLen + asn1Writer.writeContextTag(kCMS_SuppPubInfoTag, suppPubInfoLen);
+    len += asn1Writer.writeData(kDer_AES256_Wrap, sizeof(kDer_AES256_Wrap));
+    asn1Writer.writeSequence(len);
+    return asn1Writer.finish();
+}
+
+static VirgilByteArray derive_key_encryption_key(
+        const VirgilAsymmetricCipher& publicKey, const VirgilAsymmetricCipher& privateKey) {
+    static const VirgilByteArray sharedInfo = build_shared_info();
+    VirgilByteArray shared = VirgilAsymmetricCipher::computeShared(publicKey, privateKey);
+    VirgilByteArray keyEncryptionKey =
+            VirgilHKDF(VirgilHash::Algorithm::SHA256).derive(shared, VirgilByteArray(), sharedInfo, kKeyWrap_KeySize);
+    VirgilByteArrayUtils::zeroize(shared);
+    return keyEncryptionKey;
+}
+
+static void xor_counter(unsigned char* semiblock, size_t counter) {
+    for (size_t i = kKeyWrap_SemiblockSize; i > 0 && counter != 0; --i, counter >>= 8) {
+        semiblock[i - 1] ^= static_cast<unsigned char>(counter & 0xFF);
+    }
+}
+
+/**
+ * @brief AES key wrap.
+ * @see RFC 3394 section 2.2.1
+ */
+static VirgilByteArray key_wrap(const VirgilByteArray& keyEncryptionKey, const VirgilByteArray& key) {
+    if (key.size() < 2 * kKeyWrap_SemiblockSize || key.size() % kKeyWrap_SemiblockSize != 0) {
+        throw make_error(VirgilCryptoError::InvalidArgument, "Key size is not supported by AES key wrap.");
+    }
+    mbedtls_context<mbedtls_aes_context> aes_ctx;
+    system_crypto_handler(
+            mbedtls_aes_setkey_enc(aes_ctx.get(), keyEncryptionKey.data(), (unsigned int) keyEncryptionKey.size() * 8)
+    );
+
+    const size_t n = key.size() / kKeyWrap_SemiblockSize;
+    VirgilByteArray result(kKeyWrap_SemiblockSize + key.size());
+    std::memset(result.data(), kKeyWrap_IV, kKeyWrap_SemiblockSize);
+    std::memcpy(result.data() + kKeyWrap_SemiblockSize, key.data(), key.size());
+
+    VirgilByteArray block(2 * kKeyWrap_SemiblockSize);
+    for (size_t j = 0; j < kKeyWrap_Rounds; ++j) {
+        for (size_t i = 1; i <= n; ++i) {
+            unsigned char* r = result.data() + i * kKeyWrap_SemiblockSize;
+            std::memcpy(block.data(), result.data(), kKeyWrap_SemiblockSize);
+            std::memcpy(block.data() + kKeyWrap_SemiblockSize, r, kKeyWrap_SemiblockSize);
+            system_crypto_handler(
+                    mbedtls_aes_crypt_ecb(aes_ctx.get(), MBEDTLS_AES_ENCRYPT, block.data(), block.data()));
+            std::memcpy(result.data(), block.data(), kKeyWrap_SemiblockSize);
+            xor_counter(result.data(), n * j + i);
+            std::memcpy(r, block.data() + kKeyWrap_SemiblockSize, kKeyWrap_SemiblockSize);
+        }
+    }
+    VirgilByteArrayUtils::zeroize(block);
+    return result;
+}
+
+/**
+ * @brief AES key unwrap.
+ * @see RFC 3394 section 2.2.2
+ */
+static VirgilByteArray key_unwrap(const VirgilByteArray& keyEncryptionKey, const VirgilByteArray& wrappedKey) {
+    if (wrappedKey.size() < 3 * kKeyWrap_SemiblockSize || wrappedKey.size() % kKeyWrap_SemiblockSize != 0) {
+        throw make_error(VirgilCryptoError::InvalidFormat, "Wrapped key has invalid size.");
+    }
+    mbedtls_context<mbedtls_aes_context> aes_ctx;
+    system_crypto_handler(
+            mbedtls_aes_setkey_dec(aes_ctx.get(), keyEncryptionKey.data(), (unsigned int) keyEncryptionKey.size() * 8)
+    );
+
+    const size_t n = wrappedKey.size() / kKeyWrap_SemiblockSize - 1;
+    std::array<unsigned char, kKeyWrap_SemiblockSize> a;
+    std::memcpy(a.data(), wrappedKey.data(), kKeyWrap_SemiblockSize);
+    VirgilByteArray key(wrappedKey.begin() + kKeyWrap_SemiblockSize, wrappedKey.end());
+
+    VirgilByteArray block(2 * kKeyWrap_SemiblockSize);
+    for (size_t j = kKeyWrap_Rounds; j > 0; --j) {
+        for (size_t i = n; i > 0; --i) {
+            unsigned char* r = key.data() + (i - 1) * kKeyWrap_SemiblockSize;
+            xor_counter(a.data(), n * (j - 1) + i);
+            std::memcpy(block.data(), a.data(), kKeyWrap_SemiblockSize);
+            std::memcpy(block.data() + kKeyWrap_SemiblockSize, r, kKeyWrap_SemiblockSize);
+            system_crypto_handler(
+                    mbedtls_aes_crypt_ecb(aes_ctx.get(), MBEDTLS_AES_DECRYPT, block.data(), block.data()));
+            std::memcpy(a.data(), block.data(), kKeyWrap_SemiblockSize);
+            std::memcpy(r, block.data() + kKeyWrap_SemiblockSize, kKeyWrap_SemiblockSize);
+        }
+    }
+    VirgilByteArrayUtils::zeroize(block);
+
+    unsigned char diff = 0;
+    for (unsigned char byte : a) {
+        diff |= byte ^ kKeyWrap_IV;
+    }
+    if (diff != 0) {
+        VirgilByteArrayUtils::zeroize(key);
+        throw make_error(VirgilCryptoError::InvalidAuth, "Key integrity check failed.");
+    }
+    return key;
+}
+
+}}}}
+
+bool VirgilKeyAgreement::isSupported(VirgilKeyPair::Type keyType) {
+    switch (keyType) {
+        case VirgilKeyPair::Type::EC_SECP192R1:
+        case VirgilKeyPair::Type::EC_SECP224R1:
+        case VirgilKeyPair::Type::EC_SECP256R1:
+        case VirgilKeyPair::Type::EC_SECP384R1:
+        case VirgilKeyPair::Type::EC_SECP521R1:
+        case VirgilKeyPair::Type::EC_BP256R1:
+        case VirgilKeyPair::Type::EC_BP384R1:
+        case VirgilKeyPair::Type::EC_BP512R1:
+        case VirgilKeyPair::Type::EC_SECP192K1:
+        case VirgilKeyPair::Type::EC_SECP224K1:
+        case VirgilKeyPair::Type::EC_SECP256K1:
+        case VirgilKeyPair::Type::EC_CURVE25519:
+        case VirgilKeyPair::Type::FAST_EC_X25519:
+            return true;
+        default:
+            return false;
+    }
+}
+
+VirgilByteArray VirgilKeyAgreement::algorithm() {
+    return VirgilByteArray(
+            std::begin(kDer_DH_HKDF_SHA256_AES256_Wrap), std::end(kDer_DH_HKDF_SHA256_AES256_Wrap));
+}
+
+VirgilByteArray VirgilKeyAgreement::encryptKey(
+        const VirgilAsymmetricCipher& recipientPublicKey, const VirgilAsymmetricCipher& originatorPrivateKey,
+        const VirgilByteArray& key) {
+
+    VirgilByteArray keyEncryptionKey = derive_key_encryption_key(recipientPublicKey, originatorPrivateKey);
+    VirgilByteArray encryptedKey = key_wrap(keyEncryptionKey, key);
+    VirgilByteArrayUtils::zeroize(keyEncryptionKey);
+    return encryptedKey;
+}
+
+VirgilByteArray VirgilKeyAgreement::decryptKey(
+        const VirgilByteArray& algorithm, const VirgilAsymmetricCipher& originatorPublicKey,
+        const VirgilAsymmetricCipher& recipientPrivateKey, const VirgilByteArray& encryptedKey) {
+
+    const bool isPrecomputed = algorithm.size() == sizeof(kDer_DH_HKDF_SHA256_AES256_Wrap) &&
+            std::equal(algorithm.cbegin(), algorithm.cend(), kDer_DH_HKDF_SHA256_AES256_Wrap);
+    if (!isPrecomputed) {
+        VirgilAsn1Reader asn1Reader(algorithm.data(), algorithm.size());
+        (void) asn1Reader.readSequence();
+        const bool isAgreementSupported = compareOID(
+                asn1Reader.readOID(), OID_TO_STD_STRING(OID_PKCS9_SMIME_ALG_DH_HKDF_SHA256));
+        (void) asn1Reader.readSequence();
+        const bool isKeyWrapSupported = compareOID(asn1Reader.readOID(), OID_TO_STD_STRING(OID_NIST_AES256_WRAP));
+        if (!isAgreementSupported || !isKeyWrapSupported) {
+            throw make_error(VirgilCryptoError::UnsupportedAlgorithm, "Key agreement algorithm is not supported.");
+        }
+    }
+
+    VirgilByteArray keyEncryptionKey = derive_key_encryption_key(originatorPublicKey, recipientPrivateKey);
+    try {
+        VirgilByteArray key = key_unwrap(keyEncryptionKey, encryptedKey);
+        VirgilByteArrayUtils::zeroize(keyEncryptionKey);
+        return key;
+    } catch (...) {
+        VirgilByteArrayUtils::zeroize(keyEncryptionKey);
+        throw;
+    }
+}
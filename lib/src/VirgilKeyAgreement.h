@@ -0,0 +1,93 @@
+/**
+ * Copyright (C) 2015-2018 Virgil Security Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *     (3) Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+ */
+
+#ifndef VIRGIL_CRYPTO_KEY_AGREEMENT_H
+#define VIRGIL_CRYPTO_KEY_AGREEMENT_H
+
+#include <virgil/crypto/VirgilByteArray.h>
+#include <virgil/crypto/VirgilKeyPair.h>
+#include <virgil/crypto/foundation/VirgilAsymmetricCipher.h>
+
+namespace virgil { namespace crypto { namespace foundation { namespace internal {
+
+/**
+ * @brief Single-pass Diffie-Hellman key agreement that is used to encrypt content encryption key.
+ *
+ * Key encryption key is derived from the shared secret with HKDF-SHA256 and ECC-CMS-SharedInfo,
+ *     then content encryption key is wrapped with AES-256 key wrap.
+ * The same originator (ephemeral) key can be used for many recipients of the same key type.
+ *
+ * @see RFC 8418 (dhSinglePass-stdDH-hkdf-sha256-scheme), RFC 5753 (ECC-CMS-SharedInfo), RFC 3394 (AES key wrap).
+ */
+class VirgilKeyAgreement {
+public:
+    /**
+     * @brief Return true if keys of the given type can be used for the key agreement.
+     */
+    static bool isSupported(VirgilKeyPair::Type keyType);
+
+    /**
+     * @brief Return KeyEncryptionAlgorithmIdentifier of this key agreement scheme in the DER format.
+     */
+    static VirgilByteArray algorithm();
+
+    /**
+     * @brief Encrypt given key for the recipient.
+     * @param recipientPublicKey - recipient's public key.
+     * @param originatorPrivateKey - originator's private key of the same type as recipient's key.
+     * @param key - key to be encrypted, size MUST be multiple of 8 and at least 16 octets.
+     */
+    static VirgilByteArray encryptKey(
+            const VirgilAsymmetricCipher& recipientPublicKey, const VirgilAsymmetricCipher& originatorPrivateKey,
+            const VirgilByteArray& key);
+
+    /**
+     * @brief Decrypt key encrypted with encryptKey().
+     * @param algorithm - KeyEncryptionAlgorithmIdentifier taken from the recipient info.
+     * @throw VirgilCryptoException with VirgilCryptoError::UnsupportedAlgorithm, if algorithm is not supported.
+     * @throw VirgilCryptoException with VirgilCryptoError::InvalidAuth, if key integrity check failed.
+     */
+    static VirgilByteArray decryptKey(
+            const VirgilByteArray& algorithm, const VirgilAsymmetricCipher& originatorPublicKey,
+            const VirgilAsymmetricCipher& recipientPrivateKey, const VirgilByteArray& encryptedKey);
+
+private:
+    VirgilKeyAgreement();
+};
+
+}}}}
+
+#endif /* VIRGIL_CRYPTO_KEY_AGREEMENT_H */
@@ -65,6 +65,14 @@
  * PKCS#9 OIDs
  */
 #define OID_PKCS9_AUTHENTICATED_DATA MBEDTLS_OID_PKCS9 "\x0F\x01\x02" ///< ct-authData ::= { pkcs-9 smime(16) ct(1) ct-authData(2) }
+#define OID_PKCS9_SMIME_ALG MBEDTLS_OID_PKCS9 "\x10\x03" ///< id-alg ::= { pkcs-9 smime(16) alg(3) }
+#define OID_PKCS9_SMIME_ALG_DH_HKDF_SHA256 OID_PKCS9_SMIME_ALG "\x13" ///< dhSinglePass-stdDH-hkdf-sha256-scheme ::= { id-alg 19 }
+
+/**
+ * NIST algorithms OIDs
+ */
+#define OID_NIST_AES "\x60\x86\x48\x01\x65\x03\x04\x01" ///< aes ::= { 2 16 840 1 101 3 4 1 }
+#define OID_NIST_AES256_WRAP OID_NIST_AES "\x2D" ///< id-aes256-wrap ::= { aes 45 }
 
 /**
  * @brief Translate low-level oid to std::string
@@ -0,0 +1,177 @@
+/**
+ * Copyright (C) 2015-2018 Virgil Security Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *     (3) Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+ */
+
+#include "VirgilPBES2.h"
+
+#include <virgil/crypto/VirgilByteArrayUtils.h>
+
+#include <mbedtls/asn1.h>
+#include <mbedtls/oid.h>
+#include <mbedtls/pkcs5.h>
+
+#include "utils.h"
+#include "mbedtls_context.h"
+
+#include <limits>
+
+using virgil::crypto::VirgilByteArray;
+using virgil::crypto::VirgilByteArrayUtils;
+
+using virgil::crypto::foundation::internal::VirgilPBES2;
+using virgil::crypto::foundation::internal::mbedtls_context;
+
+static const unsigned char kAsn1_SequenceTag = MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE;
+
+VirgilPBES2::VirgilPBES2()
+        : salt_(), iterationCount_(0), mdType_(MBEDTLS_MD_NONE),
+          cipherType_(MBEDTLS_CIPHER_NONE), iv_() {}
+
+bool VirgilPBES2::parse(const VirgilByteArray& pbeAlgId) {
+    VirgilByteArray algId = pbeAlgId;
+    unsigned char* p = algId.data();
+    const unsigned char* end = p + algId.size();
+
+    // PBES2 AlgorithmIdentifier
+    mbedtls_asn1_buf pbeOid, pbeParams;
+    if (mbedtls_asn1_get_alg(&p, end, &pbeOid, &pbeParams) != 0 || MBEDTLS_OID_CMP(MBEDTLS_OID_PKCS5_PBES2, &pbeOid) ||
+            pbeParams.tag != kAsn1_SequenceTag) {
+        return false;
+    }
+    p = pbeParams.p;
+    end = p + pbeParams.len;
+
+    // PBKDF2 AlgorithmIdentifier
+    mbedtls_asn1_buf kdfOid, kdfParams;
+    if (mbedtls_asn1_get_alg(&p, end, &kdfOid, &kdfParams) != 0 || MBEDTLS_OID_CMP(MBEDTLS_OID_PKCS5_PBKDF2, &kdfOid) ||
+            kdfParams.tag != kAsn1_SequenceTag) {
+        return false;
+    }
+
+    // Encryption scheme AlgorithmIdentifier
+    mbedtls_asn1_buf encOid, encParams;
+    mbedtls_cipher_type_t cipherType = MBEDTLS_CIPHER_NONE;
+    if (mbedtls_asn1_get_alg(&p, end, &encOid, &encParams) != 0 ||
+            mbedtls_oid_get_cipher_alg(&encOid, &cipherType) != 0 || encParams.tag != MBEDTLS_ASN1_OCTET_STRING) {
+        return false;
+    }
+    const mbedtls_cipher_info_t* cipherInfo = mbedtls_cipher_info_from_type(cipherType);
+    if (cipherInfo == nullptr || encParams.len != cipherInfo->iv_size) {
+        return false;
+    }
+
+    // PBKDF2-params
+    unsigned char* q = kdfParams.p;
+    const unsigned char* kdfEnd = q + kdfParams.len;
+    size_t saltLen = 0;
+    if (mbedtls_asn1_get_tag(&q, kdfEnd, &saltLen, MBEDTLS_ASN1_OCTET_STRING) != 0) {
+        return false;
+    }
+    const unsigned char* salt = q;
+    q += saltLen;
+    int iterationCount = 0;
+    if (mbedtls_asn1_get_int(&q, kdfEnd, &iterationCount) != 0 || iterationCount <= 0) {
+        return false;
+    }
+    if (q < kdfEnd && *q == MBEDTLS_ASN1_INTEGER) {
+        int keyLength = 0;
+        if (mbedtls_asn1_get_int(&q, kdfEnd, &keyLength) != 0 ||
+                static_cast<unsigned int>(keyLength) != cipherInfo->key_bitlen / 8) {
+            return false;
+        }
+    }
+    mbedtls_md_type_t mdType = MBEDTLS_MD_SHA1;
+    if (q < kdfEnd) {
+        mbedtls_asn1_buf prfOid;
+        if (mbedtls_asn1_get_alg_null(&q, kdfEnd, &prfOid) != 0 || mbedtls_oid_get_md_hmac(&prfOid, &mdType) != 0) {
+            return false;
+        }
+    }
+
+    salt_.assign(salt, salt + saltLen);
+    iterationCount_ = static_cast<unsigned int>(iterationCount);
+    mdType_ = mdType;
+    cipherType_ = cipherType;
+    iv_.assign(encParams.p, encParams.p + encParams.len);
+
+    return true;
+}
+
+bool VirgilPBES2::deriveKey(const VirgilByteArray& pwd, VirgilByteArray& key) const {
+    const mbedtls_cipher_info_t* cipherInfo = mbedtls_cipher_info_from_type(cipherType_);
+    const mbedtls_md_info_t* mdInfo = mbedtls_md_info_from_type(mdType_);
+    if (cipherInfo == nullptr || mdInfo == nullptr) {
+        return false;
+    }
+
+    mbedtls_context<mbedtls_md_context_t> hmacContext;
+    if (mbedtls_md_setup(hmacContext.get(), mdInfo, 1) != 0) {
+        return false;
+    }
+
+    key.resize(cipherInfo->key_bitlen / 8);
+    if (mbedtls_pkcs5_pbkdf2_hmac(hmacContext.get(), pwd.data(), pwd.size(), salt_.data(), salt_.size(),
+            iterationCount_, static_cast<uint32_t>(key.size()), key.data()) != 0) {
+        VirgilByteArrayUtils::zeroize(key);
+        key.clear();
+        return false;
+    }
+    return true;
+}
+
+bool VirgilPBES2::decrypt(const VirgilByteArray& key, const VirgilByteArray& data, VirgilByteArray& output) const {
+    const mbedtls_cipher_info_t* cipherInfo = mbedtls_cipher_info_from_type(cipherType_);
+    if (cipherInfo == nullptr || key.size() * 8 != cipherInfo->key_bitlen) {
+        return false;
+    }
+
+    mbedtls_context<mbedtls_cipher_context_t> cipherContext;
+    if (mbedtls_cipher_setup(cipherContext.get(), cipherInfo) != 0 ||
+            mbedtls_cipher_setkey(cipherContext.get(), key.data(), static_cast<int>(cipherInfo->key_bitlen),
+                    MBEDTLS_DECRYPT) != 0) {
+        return false;
+    }
+
+    output.resize(data.size() + cipherInfo->block_size);
+    size_t outputLen = 0;
+    if (mbedtls_cipher_crypt(cipherContext.get(), iv_.data(), iv_.size(), data.data(), data.size(),
+            output.data(), &outputLen) != 0) {
+        VirgilByteArrayUtils::zeroize(output);
+        output.clear();
+        return false;
+    }
+    output.resize(outputLen);
+    return true;
+}
@@ -0,0 +1,87 @@
+/**
+ * Copyright (C) 2015-2018 Virgil Security Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *     (3) Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+ */
+
+#ifndef VIRGIL_CRYPTO_PBES2_H
+#define VIRGIL_CRYPTO_PBES2_H
+
+#include <virgil/crypto/VirgilByteArray.h>
+
+#include <mbedtls/cipher.h>
+#include <mbedtls/md.h>
+
+namespace virgil { namespace crypto { namespace foundation { namespace internal {
+
+/**
+ * @brief PKCS#5 PBES2 decryption with PBKDF2 step separated from the cipher step.
+ *
+ * In contrast to the VirgilPBE, wrong password and malformed parameters are reported with return value,
+ *     so many passwords or recipients can be checked without exceptions being thrown.
+ *
+ * @see RFC 8018
+ */
+class VirgilPBES2 {
+public:
+    VirgilPBES2();
+
+    /**
+     * @brief Parse PBE algorithm identifier.
+     * @return false if algorithm is not PBES2 with PBKDF2 and supported cipher, or if it is malformed.
+     */
+    bool parse(const VirgilByteArray& pbeAlgId);
+
+    /**
+     * @brief Derive key encryption key from the password with PBKDF2.
+     * @return false if key derivation failed.
+     */
+    bool deriveKey(const VirgilByteArray& pwd, VirgilByteArray& key) const;
+
+    /**
+     * @brief Decrypt data with the key returned by deriveKey().
+     * @return false if key does not match (padding is broken) or data is malformed.
+     */
+    bool decrypt(const VirgilByteArray& key, const VirgilByteArray& data, VirgilByteArray& output) const;
+
+private:
+    VirgilByteArray salt_;
+    unsigned int iterationCount_;
+    mbedtls_md_type_t mdType_;
+    mbedtls_cipher_type_t cipherType_;
+    VirgilByteArray iv_;
+};
+
+}}}}
+
+#endif //VIRGIL_CRYPTO_PBES2_H
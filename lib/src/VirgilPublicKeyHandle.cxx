@@ -0,0 +1,78 @@
+/**
+ * Copyright (C) 2015-2018 Virgil Security Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *     (3) Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+ */
+
+#include <virgil/crypto/VirgilPublicKeyHandle.h>
+
+#include <virgil/crypto/foundation/VirgilAsymmetricCipher.h>
+
+#include "VirgilAsymmetricCipherPool.h"
+
+using virgil::crypto::VirgilByteArray;
+using virgil::crypto::VirgilPublicKeyHandle;
+
+using virgil::crypto::foundation::VirgilAsymmetricCipher;
+
+using virgil::crypto::internal::VirgilAsymmetricCipherPool;
+
+namespace virgil { namespace crypto {
+
+/**
+ * @brief Handle class fields.
+ */
+class VirgilPublicKeyHandle::Impl {
+public:
+    std::shared_ptr<VirgilAsymmetricCipherPool> cipherPool;
+};
+
+}}
+
+VirgilPublicKeyHandle::VirgilPublicKeyHandle(const VirgilByteArray& publicKey) : impl_(std::make_shared<Impl>()) {
+    impl_->cipherPool = VirgilAsymmetricCipherPool::createWithPublicKey(publicKey);
+}
+
+VirgilPublicKeyHandle::VirgilPublicKeyHandle(const VirgilPublicKeyHandle& rhs) = default;
+
+VirgilPublicKeyHandle& VirgilPublicKeyHandle::operator=(const VirgilPublicKeyHandle& rhs) = default;
+
+VirgilPublicKeyHandle::VirgilPublicKeyHandle(VirgilPublicKeyHandle&& rhs) noexcept = default;
+
+VirgilPublicKeyHandle& VirgilPublicKeyHandle::operator=(VirgilPublicKeyHandle&& rhs) noexcept = default;
+
+VirgilPublicKeyHandle::~VirgilPublicKeyHandle() noexcept = default;
+
+std::shared_ptr<const VirgilAsymmetricCipher> VirgilPublicKeyHandle::acquireCipher() const {
+    return impl_->cipherPool->acquire();
+}
@@ -36,14 +36,15 @@
 
 #include <virgil/crypto/foundation/VirgilRandom.h>
 
-#include <mbedtls/entropy.h>
 #include <mbedtls/ctr_drbg.h>
+#include <mbedtls/md.h>
 
 #include <virgil/crypto/VirgilByteArrayUtils.h>
 #include <virgil/crypto/foundation/VirgilSystemCryptoError.h>
 
 #include "utils.h"
 #include "mbedtls_context.h"
+#include "VirgilSharedRandom.h"
 
 
 using virgil::crypto::VirgilByteArray;
@@ -54,8 +55,7 @@ using virgil::crypto::foundation::VirgilRandom;
 class VirgilRandom::Impl {
 public:
     VirgilByteArray personalInfo;
-    internal::mbedtls_context <mbedtls_ctr_drbg_context> ctr_drbg_ctx;
-    internal::mbedtls_context <mbedtls_entropy_context> entropy_ctx;
+    VirgilByteArray additionalInput;
 };
 
 VirgilRandom::VirgilRandom(const VirgilByteArray& personalInfo) : impl_(std::make_unique<Impl>()) {
@@ -87,17 +87,27 @@ VirgilRandom& VirgilRandom::operator=(const VirgilRandom& rhs) {
 }
 
 VirgilByteArray VirgilRandom::randomize(size_t bytesNum) {
-    return internal::randomize(impl_->ctr_drbg_ctx, bytesNum);
+    return internal::randomize(internal::shared_ctr_drbg(), bytesNum, impl_->additionalInput);
 }
 
 size_t VirgilRandom::randomize() {
-    return internal::randomize(impl_->ctr_drbg_ctx);
+    return internal::randomize(internal::shared_ctr_drbg(), impl_->additionalInput);
 }
 
 size_t VirgilRandom::randomize(size_t min, size_t max) {
-    return internal::randomize(impl_->ctr_drbg_ctx, min, max);
+    return internal::randomize(internal::shared_ctr_drbg(), min, max, impl_->additionalInput);
 }
 
 void VirgilRandom::init() {
-    impl_->ctr_drbg_ctx.setup(mbedtls_entropy_func, impl_->entropy_ctx.get(), impl_->personalInfo);
+    // Random context is shared within the thread, so personal info is mixed into every request instead.
+    if (impl_->personalInfo.size() <= MBEDTLS_CTR_DRBG_MAX_INPUT) {
+        impl_->additionalInput = impl_->personalInfo;
+        return;
+    }
+
+    const mbedtls_md_info_t* mdInfo = mbedtls_md_info_from_type(MBEDTLS_MD_SHA256);
+    impl_->additionalInput.resize(mbedtls_md_get_size(mdInfo));
+    system_crypto_handler(
+            mbedtls_md(mdInfo, impl_->personalInfo.data(), impl_->personalInfo.size(),
+                    impl_->additionalInput.data()));
 }
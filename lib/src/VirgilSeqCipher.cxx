@@ -46,6 +46,7 @@ using virgil::crypto::VirgilSeqCipher;
 using virgil::crypto::VirgilCryptoError;
 using virgil::crypto::VirgilByteArray;
 using virgil::crypto::VirgilByteArrayUtils;
+using virgil::crypto::VirgilPrivateKeyHandle;
 using virgil::crypto::foundation::VirgilSymmetricCipher;
 
 using virgil::crypto::make_error;
@@ -68,6 +69,13 @@ void VirgilSeqCipher::startDecryptionWithKey(
 }
 
 
+void VirgilSeqCipher::startDecryptionWithKey(
+        const VirgilByteArray& recipientId, const VirgilPrivateKeyHandle& privateKey) {
+
+    initDecryptionWithKey(recipientId, privateKey);
+}
+
+
 void VirgilSeqCipher::startDecryptionWithPassword(const VirgilByteArray& pwd) {
     initDecryptionWithPassword(pwd);
 }
@@ -38,6 +38,8 @@
 
 using virgil::crypto::VirgilByteArray;
 using virgil::crypto::VirgilSeqSigner;
+using virgil::crypto::VirgilPublicKeyHandle;
+using virgil::crypto::VirgilPrivateKeyHandle;
 
 using virgil::crypto::foundation::VirgilHash;
 
@@ -86,3 +88,24 @@ bool VirgilSeqSigner::verify(const VirgilByteArray& publicKey) {
     // Verify signature
     return verifyHash(digest, unpackedSignature_, publicKey);
 }
+
+
+VirgilByteArray VirgilSeqSigner::sign(const VirgilPrivateKeyHandle& privateKey) {
+    // Get digest
+    const auto digest = hash_.finish();
+
+    // Sign digest
+    const auto signature = signHash(digest, privateKey);
+
+    // Pack signature
+    return packSignature(signature);
+}
+
+
+bool VirgilSeqSigner::verify(const VirgilPublicKeyHandle& publicKey) {
+    // Get digest
+    const auto digest = hash_.finish();
+
+    // Verify signature
+    return verifyHash(digest, unpackedSignature_, publicKey);
+}
@@ -0,0 +1,111 @@
+/**
+ * Copyright (C) 2015-2018 Virgil Security Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *     (3) Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+ */
+
+#include "VirgilSharedRandom.h"
+
+#include <mbedtls/entropy.h>
+
+#include "mbedtls_context.h"
+#include "VirgilConfig.h"
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+using virgil::crypto::foundation::internal::mbedtls_context;
+
+namespace virgil { namespace crypto { namespace foundation { namespace internal {
+
+constexpr const char kSharedRandomPersonalInfo[] = "virgil::crypto::SharedRandom";
+
+constexpr int kSharedRandomReseedInterval = 4096;
+
+#if defined(_WIN32)
+using process_id_t = int;
+
+static process_id_t current_process_id() {
+    // There is no fork() on Windows, so process identifier never changes for the given context.
+    return 0;
+}
+#else
+using process_id_t = pid_t;
+
+static process_id_t current_process_id() {
+    return getpid();
+}
+#endif
+
+class SharedRandom {
+public:
+    SharedRandom() : pid_(current_process_id()) {
+        ctr_drbg_ctx_.setup(mbedtls_entropy_func, entropy_ctx_.get(), kSharedRandomPersonalInfo);
+        mbedtls_ctr_drbg_set_reseed_interval(ctr_drbg_ctx_.get(), kSharedRandomReseedInterval);
+    }
+
+    mbedtls_ctr_drbg_context* get() {
+        const process_id_t pid = current_process_id();
+        if (pid != pid_) {
+            system_crypto_handler(
+                    mbedtls_ctr_drbg_reseed(
+                            ctr_drbg_ctx_.get(), reinterpret_cast<const unsigned char*>(&pid), sizeof(pid)));
+            pid_ = pid;
+        }
+        return ctr_drbg_ctx_.get();
+    }
+
+private:
+    mbedtls_context<mbedtls_entropy_context> entropy_ctx_;
+    mbedtls_context<mbedtls_ctr_drbg_context> ctr_drbg_ctx_;
+    process_id_t pid_;
+};
+
+#if VIRGIL_CRYPTO_FEATURE_THREAD_LOCAL
+SharedRandomContext shared_ctr_drbg() {
+    static thread_local SharedRandom sharedRandom;
+    return SharedRandomContext(sharedRandom.get(), std::unique_lock<std::recursive_mutex>());
+}
+#else
+SharedRandomContext shared_ctr_drbg() {
+    // Thread local storage is not available, so one context is shared by all threads.
+    // Lock is recursive, because one expression can acquire context more than once.
+    static std::recursive_mutex sharedRandomMutex;
+    std::unique_lock<std::recursive_mutex> lock(sharedRandomMutex);
+    static SharedRandom sharedRandom;
+    return SharedRandomContext(sharedRandom.get(), std::move(lock));
+}
+#endif
+
+}}}}
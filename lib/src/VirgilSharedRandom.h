@@ -0,0 +1,83 @@
+/**
+ * Copyright (C) 2015-2018 Virgil Security Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *     (3) Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+ */
+
+#ifndef VIRGIL_CRYPTO_SHARED_RANDOM_H
+#define VIRGIL_CRYPTO_SHARED_RANDOM_H
+
+#include <mbedtls/ctr_drbg.h>
+
+#include <mutex>
+#include <utility>
+
+namespace virgil { namespace crypto { namespace foundation { namespace internal {
+
+/**
+ * @brief Shared random context, that is used exclusively by the calling thread while this object is alive.
+ *
+ * Object is converted to the context pointer, so pass shared_ctr_drbg() directly to the function
+ *     that uses random, then context is released when the function returns.
+ */
+class SharedRandomContext {
+public:
+    SharedRandomContext(mbedtls_ctr_drbg_context* ctr_drbg_ctx, std::unique_lock<std::recursive_mutex> lock)
+            : ctr_drbg_ctx_(ctr_drbg_ctx), lock_(std::move(lock)) {}
+
+    operator mbedtls_ctr_drbg_context*() const {
+        return ctr_drbg_ctx_;
+    }
+
+private:
+    mbedtls_ctr_drbg_context* ctr_drbg_ctx_;
+    std::unique_lock<std::recursive_mutex> lock_; ///< not locked, if context is thread local
+};
+
+/**
+ * @brief Return random context that is shared by all crypto objects within the calling thread.
+ *
+ * Context is seeded from the system entropy source on the first call within the thread,
+ * it is reseeded periodically
+ * and right after the process was forked, so child and parent never share random stream.
+ *
+ * If thread local storage is not available, one context is shared by all threads,
+ *     and it is locked while returned object is alive.
+ *
+ * @note Returned object MUST NOT be passed to another thread.
+ */
+SharedRandomContext shared_ctr_drbg();
+
+}}}}
+
+#endif /* VIRGIL_CRYPTO_SHARED_RANDOM_H */
@@ -42,6 +42,8 @@
 
 using virgil::crypto::VirgilSigner;
 using virgil::crypto::VirgilByteArray;
+using virgil::crypto::VirgilPublicKeyHandle;
+using virgil::crypto::VirgilPrivateKeyHandle;
 
 using virgil::crypto::foundation::VirgilHash;
 
@@ -70,3 +72,29 @@ bool VirgilSigner::verify(const VirgilByteArray& data, const VirgilByteArray& si
     // Verify signature
     return verifyHash(digest, signature, publicKey);
 }
+
+VirgilByteArray VirgilSigner::sign(const VirgilByteArray& data, const VirgilPrivateKeyHandle& privateKey) {
+
+    // Calculate data digest
+    const auto digest = VirgilHash(getHashAlgorithm()).hash(data);
+
+    // Sign digest
+    const auto signature = signHash(digest, privateKey);
+
+    // Pack signature
+    return packSignature(signature);
+}
+
+bool VirgilSigner::verify(
+        const VirgilByteArray& data, const VirgilByteArray& sign, const VirgilPublicKeyHandle& publicKey) {
+
+    // Unpack signature
+    const auto signature = unpackSignature(sign); // MUST be before getHashAlgorithm()
+
+    // Calculate data digest
+    VirgilHash hash(getHashAlgorithm());
+    const auto digest = hash.hash(data);
+
+    // Verify signature
+    return verifyHash(digest, signature, publicKey);
+}
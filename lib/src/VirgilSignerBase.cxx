@@ -42,6 +42,8 @@
 
 using virgil::crypto::VirgilSignerBase;
 using virgil::crypto::VirgilByteArray;
+using virgil::crypto::VirgilPublicKeyHandle;
+using virgil::crypto::VirgilPrivateKeyHandle;
 
 using virgil::crypto::foundation::VirgilHash;
 using virgil::crypto::foundation::VirgilAsymmetricCipher;
@@ -67,17 +69,32 @@ bool VirgilSignerBase::verifyHash(
     return doVerifyHash(digest, signature, publicKey);
 }
 
+VirgilByteArray VirgilSignerBase::signHash(const VirgilByteArray& digest, const VirgilPrivateKeyHandle& privateKey) {
+    return privateKey.acquireCipher()->sign(digest, hash_.type());
+}
+
+bool VirgilSignerBase::verifyHash(
+        const VirgilByteArray& digest, const VirgilByteArray& signature, const VirgilPublicKeyHandle& publicKey) {
+    return publicKey.acquireCipher()->verify(digest, signature, hash_.type());
+}
+
 VirgilByteArray VirgilSignerBase::packSignature(const VirgilByteArray& signature) const {
+    const VirgilHash hash(getHashAlgorithm());
+    auto writePacked = [&](VirgilAsn1Writer& asn1Writer) -> size_t {
+        size_t asn1Len = 0;
+        asn1Len += asn1Writer.writeOctetString(signature);
+        asn1Len += hash.asn1Write(asn1Writer);
+        return asn1Len + asn1Writer.writeSequence(asn1Len);
+    };
     VirgilAsn1Writer asn1Writer;
-    size_t asn1Len = 0;
-    asn1Len += asn1Writer.writeOctetString(signature);
-    asn1Len += VirgilHash(getHashAlgorithm()).asn1Write(asn1Writer);
-    (void) asn1Writer.writeSequence(asn1Len);
+    asn1Writer.resetSizing();
+    asn1Writer.reset(writePacked(asn1Writer));
+    (void) writePacked(asn1Writer);
     return asn1Writer.finish();
 }
 
 VirgilByteArray VirgilSignerBase::unpackSignature(const VirgilByteArray& packedSignature) {
-    VirgilAsn1Reader asn1Reader(packedSignature);
+    VirgilAsn1Reader asn1Reader(packedSignature.data(), packedSignature.size());
     asn1Reader.readSequence();
     VirgilHash hash;
     hash.asn1Read(asn1Reader);
@@ -46,11 +46,44 @@ using virgil::crypto::VirgilStreamCipher;
 using virgil::crypto::VirgilByteArray;
 using virgil::crypto::VirgilDataSource;
 using virgil::crypto::VirgilDataSink;
+using virgil::crypto::VirgilPrivateKeyHandle;
 
 using virgil::crypto::foundation::VirgilKDF;
 using virgil::crypto::foundation::VirgilSymmetricCipher;
 using virgil::crypto::foundation::VirgilAsymmetricCipher;
 
+namespace virgil { namespace crypto { namespace internal {
+
+/**
+ * @brief Process data and write result to the sink, reuse given buffer for the result.
+ */
+static void update_and_write(
+        VirgilSymmetricCipher& symmetricCipher, const unsigned char* data, size_t dataSize, VirgilByteArray& buffer,
+        VirgilDataSink& sink) {
+
+    buffer.resize(symmetricCipher.updateOutputSizeMax(dataSize));
+    buffer.resize(symmetricCipher.update(data, dataSize, buffer.data(), buffer.size()));
+    VirgilDataSink::safeWrite(sink, buffer);
+}
+
+static void update_and_write(
+        VirgilSymmetricCipher& symmetricCipher, const VirgilByteArray& data, VirgilByteArray& buffer,
+        VirgilDataSink& sink) {
+
+    update_and_write(symmetricCipher, data.data(), data.size(), buffer, sink);
+}
+
+/**
+ * @brief Finish processing and write result to the sink, reuse given buffer for the result.
+ */
+static void finish_and_write(VirgilSymmetricCipher& symmetricCipher, VirgilByteArray& buffer, VirgilDataSink& sink) {
+    buffer.resize(symmetricCipher.finishOutputSizeMax());
+    buffer.resize(symmetricCipher.finish(buffer.data(), buffer.size()));
+    VirgilDataSink::safeWrite(sink, buffer);
+}
+
+}}}
+
 void VirgilStreamCipher::encrypt(VirgilDataSource& source, VirgilDataSink& sink, bool embedContentInfo) {
 
     auto disposer = ScopeGuard([this]() {
@@ -65,14 +98,21 @@ void VirgilStreamCipher::encrypt(VirgilDataSource& source, VirgilDataSink& sink,
         VirgilDataSink::safeWrite(sink, getContentInfo());
     }
 
+    auto& symmetricCipher = getSymmetricCipher();
+    VirgilByteArray buffer;
     while (source.hasData() && sink.isGood()) {
-        VirgilDataSink::safeWrite(sink, getSymmetricCipher().update(source.read()));
+        internal::update_and_write(symmetricCipher, source.read(), buffer, sink);
     }
 
-    VirgilDataSink::safeWrite(sink, getSymmetricCipher().finish());
+    internal::finish_and_write(symmetricCipher, buffer, sink);
 }
 
 
+size_t VirgilStreamCipher::calculateEncryptedSize(size_t dataSize, bool embedContentInfo) {
+    const size_t contentInfoSize = embedContentInfo ? predictContentInfoSize() : 0;
+    return contentInfoSize + calculateEncryptedPayloadSize(dataSize);
+}
+
 void VirgilStreamCipher::decryptWithKey(
         VirgilDataSource& source, VirgilDataSink& sink,
         const VirgilByteArray& recipientId, const VirgilByteArray& privateKey,
@@ -84,6 +124,16 @@ void VirgilStreamCipher::decryptWithKey(
 }
 
 
+void VirgilStreamCipher::decryptWithKey(
+        VirgilDataSource& source, VirgilDataSink& sink,
+        const VirgilByteArray& recipientId, const VirgilPrivateKeyHandle& privateKey) {
+
+    initDecryptionWithKey(recipientId, privateKey);
+
+    decrypt(source, sink);
+}
+
+
 void VirgilStreamCipher::decryptWithPassword(
         VirgilDataSource& source, VirgilDataSink& sink,
         const VirgilByteArray& pwd) {
@@ -100,15 +150,23 @@ void VirgilStreamCipher::decrypt(VirgilDataSource& source, VirgilDataSink& sink)
         clear();
     });
 
+    // Content info is consumed from the read data, and payload that follows it is decrypted in place.
+    VirgilByteArray buffer;
+    VirgilByteArray bufferedPayload;
     while (source.hasData() && sink.isGood()) {
-        VirgilByteArray payload = filterAndSetupContentInfo(source.read(), false);
+        const VirgilByteArray data = source.read();
+        const size_t consumedSize = filterAndSetupContentInfo(data.data(), data.size(), false, bufferedPayload);
 
         if (isReadyForDecryption()) {
-            VirgilDataSink::safeWrite(sink, getSymmetricCipher().update(payload));
+            if (!bufferedPayload.empty()) {
+                internal::update_and_write(getSymmetricCipher(), bufferedPayload, buffer, sink);
+            }
+            internal::update_and_write(
+                    getSymmetricCipher(), data.data() + consumedSize, data.size() - consumedSize, buffer, sink);
         }
     }
 
-    VirgilByteArray payload = filterAndSetupContentInfo(VirgilByteArray(), true);
-    VirgilDataSink::safeWrite(sink, getSymmetricCipher().update(payload));
-    VirgilDataSink::safeWrite(sink, getSymmetricCipher().finish());
+    (void) filterAndSetupContentInfo(nullptr, 0, true, bufferedPayload);
+    internal::update_and_write(getSymmetricCipher(), bufferedPayload, buffer, sink);
+    internal::finish_and_write(getSymmetricCipher(), buffer, sink);
 }
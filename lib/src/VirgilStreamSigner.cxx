@@ -39,6 +39,8 @@
 using virgil::crypto::VirgilByteArray;
 using virgil::crypto::VirgilDataSource;
 using virgil::crypto::VirgilStreamSigner;
+using virgil::crypto::VirgilPublicKeyHandle;
+using virgil::crypto::VirgilPrivateKeyHandle;
 
 using virgil::crypto::foundation::VirgilHash;
 
@@ -78,3 +80,38 @@ bool VirgilStreamSigner::verify(
     // Verify signature
     return verifyHash(digest, signature, publicKey);
 }
+
+VirgilByteArray VirgilStreamSigner::sign(VirgilDataSource& source, const VirgilPrivateKeyHandle& privateKey) {
+
+    // Calculate data digest
+    VirgilHash hash(getHashAlgorithm());
+    hash.start();
+    while (source.hasData()) {
+        hash.update(source.read());
+    }
+    const auto digest = hash.finish();
+
+    // Sign digest
+    const auto signature = signHash(digest, privateKey);
+
+    // Pack signature
+    return packSignature(signature);
+}
+
+bool VirgilStreamSigner::verify(
+        VirgilDataSource& source, const VirgilByteArray& sign, const VirgilPublicKeyHandle& publicKey) {
+
+    // Unpack signature
+    const auto signature = unpackSignature(sign); // MUST be before getHashAlgorithm()
+
+    // Calculate data digest
+    VirgilHash hash(getHashAlgorithm());
+    hash.start();
+    while (source.hasData()) {
+        hash.update(source.read());
+    }
+    const auto digest = hash.finish();
+
+    // Verify signature
+    return verifyHash(digest, signature, publicKey);
+}
@@ -36,6 +36,9 @@
 
 #include <virgil/crypto/foundation/VirgilSymmetricCipher.h>
 
+#include <algorithm>
+#include <cstring>
+
 #include <mbedtls/cipher.h>
 #include <mbedtls/oid.h>
 
@@ -47,6 +50,11 @@
 #include "utils.h"
 #include "mbedtls_context.h"
 #include "VirgilTagFilter.h"
+#include "VirgilChaCha20Poly1305.h"
+#include "VirgilAesGcm.h"
+#include "VirgilAesCbc.h"
+#include "VirgilAlgorithmIdentifiers.h"
+#include "VirgilConstantTime.h"
 
 using virgil::crypto::VirgilByteArray;
 using virgil::crypto::VirgilByteArrayUtils;
@@ -55,7 +63,13 @@ using virgil::crypto::foundation::VirgilSymmetricCipher;
 using virgil::crypto::foundation::asn1::VirgilAsn1Compatible;
 using virgil::crypto::foundation::asn1::VirgilAsn1Reader;
 using virgil::crypto::foundation::asn1::VirgilAsn1Writer;
+using virgil::crypto::foundation::asn1::internal::find_der_algorithm;
+using virgil::crypto::foundation::asn1::internal::match_der_algorithm;
+using virgil::crypto::foundation::asn1::internal::kDer_CipherOids;
 using virgil::crypto::foundation::internal::VirgilTagFilter;
+using virgil::crypto::foundation::internal::VirgilChaCha20Poly1305;
+using virgil::crypto::foundation::internal::VirgilAesGcm;
+using virgil::crypto::foundation::internal::VirgilAesCbc;
 
 
 namespace virgil { namespace crypto { namespace foundation { namespace internal {
@@ -64,11 +78,130 @@ namespace virgil { namespace crypto { namespace foundation { namespace internal
  */
 mbedtls_cipher_padding_t convert_padding(VirgilSymmetricCipher::Padding padding) noexcept;
 
+/**
+ * @brief Name of the ChaCha20-Poly1305 algorithm, that is not provided by the underlying crypto library.
+ */
+static constexpr char kChaCha20Poly1305_Name[] = "CHACHA20-POLY1305";
+
+/**
+ * @brief OID of the ChaCha20-Poly1305 algorithm: id-alg-AEADChaCha20Poly1305 (RFC 8103).
+ */
+static constexpr char kChaCha20Poly1305_Oid[] = "\x2A\x86\x48\x86\xF7\x0D\x01\x09\x10\x03\x12";
+
+/**
+ * @brief Process data with the built-in AEAD implementation, decrypted data is released without the tag.
+ */
+template<typename Aead>
+size_t aead_update(
+        Aead& aead, VirgilTagFilter& tagFilter, bool isEncryption,
+        const unsigned char* input, size_t inputSize, unsigned char* output) {
+    if (isEncryption) {
+        aead.encrypt(input, inputSize, output);
+        return inputSize;
+    }
+    size_t writtenBytes = 0;
+    tagFilter.process(input, inputSize, [&](const unsigned char* data, size_t dataSize) {
+        aead.decrypt(data, dataSize, output + writtenBytes);
+        writtenBytes += dataSize;
+    });
+    return writtenBytes;
+}
+
+/**
+ * @brief Write tag on encryption, or check tag collected by the tag filter on decryption.
+ */
+template<typename Aead>
+size_t aead_finish(Aead& aead, VirgilTagFilter& tagFilter, bool isEncryption, unsigned char* output) {
+    if (isEncryption) {
+        aead.finish(output);
+        return Aead::kTagSize;
+    }
+    unsigned char tag[Aead::kTagSize];
+    aead.finish(tag);
+    if (tagFilter.tagSize() != sizeof(tag) || !constant_time_equal(tag, tagFilter.tagData(), sizeof(tag))) {
+        throw make_error(VirgilCryptoError::InvalidAuth);
+    }
+    return 0;
+}
+
 }}}}
 
 class VirgilSymmetricCipher::Impl {
+public:
+    void setup(const char* name) {
+        if (std::strcmp(name, internal::kChaCha20Poly1305_Name) == 0) {
+            chachapoly = std::make_unique<VirgilChaCha20Poly1305>();
+        } else {
+            cipher_ctx.setup(name);
+        }
+    }
+
+    /**
+     * @brief Use AES-NI based implementation for the GCM mode, if it is supported by CPU.
+     * @return true if built-in implementation is used, false - if underlying crypto library should be used.
+     */
+    bool setupAesGcm(const VirgilByteArray& key) {
+        const size_t keyBitLen = (size_t) mbedtls_cipher_get_key_bitlen(cipher_ctx.get());
+        if (mbedtls_cipher_get_cipher_mode(cipher_ctx.get()) != MBEDTLS_MODE_GCM ||
+                key.size() * 8 != keyBitLen || !VirgilAesGcm::isSupported(key.size())) {
+            aesgcm.reset();
+            return false;
+        }
+        if (!aesgcm) {
+            aesgcm = std::make_unique<VirgilAesGcm>();
+        }
+        aesgcm->setKey(key.data(), key.size());
+        if (!iv.empty()) {
+            aesgcm->setIV(iv.data(), iv.size());
+        }
+        return true;
+    }
+
+    /**
+     * @brief Use AES-NI based implementation for the CBC mode decryption, if it is supported by CPU.
+     * @note Key is set to the cipher_ctx as well, because padding can be changed to unsupported one later.
+     */
+    void setupAesCbc(const VirgilByteArray& key) {
+        useAesCbc = false;
+        const size_t keyBitLen = (size_t) mbedtls_cipher_get_key_bitlen(cipher_ctx.get());
+        if (mbedtls_cipher_get_cipher_mode(cipher_ctx.get()) != MBEDTLS_MODE_CBC ||
+                key.size() * 8 != keyBitLen || !VirgilAesCbc::isSupported(key.size())) {
+            aescbc.reset();
+            return;
+        }
+        if (!aescbc) {
+            aescbc = std::make_unique<VirgilAesCbc>();
+        }
+        aescbc->setThreadsNum(decryptionThreadsNum);
+        aescbc->setKey(key.data(), key.size());
+    }
+
+    /**
+     * @brief Start AES-NI based CBC decryption, if it was set up and configured padding is supported.
+     */
+    void startAesCbc() {
+        useAesCbc = aescbc && iv.size() == (size_t) mbedtls_cipher_get_iv_size(cipher_ctx.get()) &&
+                (padding == VirgilSymmetricCipher::Padding::PKCS7 || padding == VirgilSymmetricCipher::Padding::None);
+        if (useAesCbc) {
+            aescbc->start(iv.data(), iv.size(), padding == VirgilSymmetricCipher::Padding::PKCS7);
+        }
+    }
+
 public:
     internal::mbedtls_context <mbedtls_cipher_context_t> cipher_ctx;
+    //  Defined if algorithm is ChaCha20-Poly1305, in this case cipher_ctx is not used.
+    std::unique_ptr<VirgilChaCha20Poly1305> chachapoly;
+    //  Defined if AES-GCM key is set and CPU supports AES-NI, in this case cipher_ctx is used for metadata only.
+    std::unique_ptr<VirgilAesGcm> aesgcm;
+    //  Defined if AES-CBC decryption key is set and CPU supports AES-NI.
+    std::unique_ptr<VirgilAesCbc> aescbc;
+    //  True if current decryption is done by aescbc instead of cipher_ctx.
+    bool useAesCbc = false;
+    //  Number of threads used by aescbc for the large inputs.
+    size_t decryptionThreadsNum = 1;
+    VirgilSymmetricCipher::Padding padding = VirgilSymmetricCipher::Padding::PKCS7;
+    //  Operation of the built-in implementations: chachapoly or aesgcm.
+    mbedtls_operation_t operation = MBEDTLS_OPERATION_NONE;
     VirgilByteArray iv;
     VirgilByteArray authData;
     VirgilTagFilter tagFilter;
@@ -77,15 +210,15 @@ public:
 VirgilSymmetricCipher::VirgilSymmetricCipher() : impl_(std::make_unique<Impl>()) {}
 
 VirgilSymmetricCipher::VirgilSymmetricCipher(Algorithm algorithm) : impl_(std::make_unique<Impl>()) {
-    impl_->cipher_ctx.setup(std::to_string(algorithm).c_str());
+    impl_->setup(std::to_string(algorithm).c_str());
 }
 
 VirgilSymmetricCipher::VirgilSymmetricCipher(const std::string& name) : impl_(std::make_unique<Impl>()) {
-    impl_->cipher_ctx.setup(name.c_str());
+    impl_->setup(name.c_str());
 }
 
 VirgilSymmetricCipher::VirgilSymmetricCipher(const char* name) : impl_(std::make_unique<Impl>()) {
-    impl_->cipher_ctx.setup(name);
+    impl_->setup(name);
 }
 
 VirgilSymmetricCipher::VirgilSymmetricCipher(VirgilSymmetricCipher&&) noexcept = default;
@@ -96,26 +229,39 @@ VirgilSymmetricCipher::~VirgilSymmetricCipher() noexcept = default;
 
 
 bool VirgilSymmetricCipher::isInited() const {
-    return impl_->cipher_ctx.get()->cipher_info != nullptr;
+    return impl_->chachapoly || impl_->cipher_ctx.get()->cipher_info != nullptr;
 }
 
 std::string VirgilSymmetricCipher::name() const {
     checkState();
+    if (impl_->chachapoly) {
+        return internal::kChaCha20Poly1305_Name;
+    }
     return mbedtls_cipher_get_name(impl_->cipher_ctx.get());
 }
 
 size_t VirgilSymmetricCipher::blockSize() const {
     checkState();
+    if (impl_->chachapoly) {
+        // Stream cipher.
+        return 1;
+    }
     return mbedtls_cipher_get_block_size(impl_->cipher_ctx.get());
 }
 
 size_t VirgilSymmetricCipher::ivSize() const {
     checkState();
+    if (impl_->chachapoly) {
+        return VirgilChaCha20Poly1305::kNonceSize;
+    }
     return (size_t) mbedtls_cipher_get_iv_size(impl_->cipher_ctx.get());
 }
 
 size_t VirgilSymmetricCipher::keySize() const {
     checkState();
+    if (impl_->chachapoly) {
+        return VirgilChaCha20Poly1305::kKeySize * 8;
+    }
     return (size_t) mbedtls_cipher_get_key_bitlen(impl_->cipher_ctx.get());
 }
 
@@ -125,6 +271,9 @@ size_t VirgilSymmetricCipher::keyLength() const {
 
 size_t VirgilSymmetricCipher::authTagLength() const {
     checkState();
+    if (impl_->chachapoly) {
+        return VirgilChaCha20Poly1305::kTagSize;
+    }
     switch (mbedtls_cipher_get_cipher_mode(impl_->cipher_ctx.get())) {
         case MBEDTLS_MODE_GCM:
             return 16;
@@ -135,21 +284,33 @@ size_t VirgilSymmetricCipher::authTagLength() const {
 
 bool VirgilSymmetricCipher::isEncryptionMode() const {
     checkState();
+    if (impl_->chachapoly || impl_->aesgcm) {
+        return impl_->operation == MBEDTLS_ENCRYPT;
+    }
     return mbedtls_cipher_get_operation(impl_->cipher_ctx.get()) == MBEDTLS_ENCRYPT;
 }
 
 bool VirgilSymmetricCipher::isDecryptionMode() const {
     checkState();
+    if (impl_->chachapoly || impl_->aesgcm) {
+        return impl_->operation == MBEDTLS_DECRYPT;
+    }
     return mbedtls_cipher_get_operation(impl_->cipher_ctx.get()) == MBEDTLS_DECRYPT;
 }
 
 bool VirgilSymmetricCipher::isAuthMode() const {
     checkState();
+    if (impl_->chachapoly) {
+        return true;
+    }
     return mbedtls_cipher_get_cipher_mode(impl_->cipher_ctx.get()) == MBEDTLS_MODE_GCM;
 }
 
 bool VirgilSymmetricCipher::isSupportPadding() const {
     checkState();
+    if (impl_->chachapoly) {
+        return false;
+    }
     return mbedtls_cipher_get_cipher_mode(impl_->cipher_ctx.get()) == MBEDTLS_MODE_CBC;
 }
 
@@ -160,6 +321,17 @@ VirgilByteArray VirgilSymmetricCipher::iv() const {
 
 void VirgilSymmetricCipher::setEncryptionKey(const VirgilByteArray& key) {
     checkState();
+    if (impl_->chachapoly) {
+        impl_->chachapoly->setKey(key.data(), key.size());
+        impl_->operation = MBEDTLS_ENCRYPT;
+        return;
+    }
+    if (impl_->setupAesGcm(key)) {
+        impl_->operation = MBEDTLS_ENCRYPT;
+        return;
+    }
+    impl_->aescbc.reset();
+    impl_->useAesCbc = false;
     system_crypto_handler(
             mbedtls_cipher_setkey(impl_->cipher_ctx.get(), key.data(), key.size() * 8, MBEDTLS_ENCRYPT),
             [](int) {
@@ -171,6 +343,15 @@ void VirgilSymmetricCipher::setEncryptionKey(const VirgilByteArray& key) {
 
 void VirgilSymmetricCipher::setDecryptionKey(const VirgilByteArray& key) {
     checkState();
+    if (impl_->chachapoly) {
+        impl_->chachapoly->setKey(key.data(), key.size());
+        impl_->operation = MBEDTLS_DECRYPT;
+        return;
+    }
+    if (impl_->setupAesGcm(key)) {
+        impl_->operation = MBEDTLS_DECRYPT;
+        return;
+    }
     system_crypto_handler(
             mbedtls_cipher_setkey(impl_->cipher_ctx.get(), key.data(), key.size() * 8, MBEDTLS_DECRYPT),
             [](int) {
@@ -178,18 +359,33 @@ void VirgilSymmetricCipher::setDecryptionKey(const VirgilByteArray& key) {
                         make_error(VirgilCryptoError::InvalidArgument, "Bad key for symmetric decryption."));
             }
     );
+    impl_->setupAesCbc(key);
 }
 
 void VirgilSymmetricCipher::setPadding(VirgilSymmetricCipher::Padding padding) {
     checkState();
+    if (impl_->chachapoly) {
+        throw make_error(VirgilCryptoError::UnsupportedAlgorithm, "Padding is not supported by stream cipher.");
+    }
     system_crypto_handler(
             mbedtls_cipher_set_padding_mode(impl_->cipher_ctx.get(), internal::convert_padding(padding)),
             [](int) { std::throw_with_nested(make_error(VirgilCryptoError::UnsupportedAlgorithm)); }
     );
+    impl_->padding = padding;
 }
 
 void VirgilSymmetricCipher::setIV(const VirgilByteArray& iv) {
     checkState();
+    if (impl_->chachapoly) {
+        impl_->chachapoly->setNonce(iv.data(), iv.size());
+        impl_->iv = iv;
+        return;
+    }
+    if (impl_->aesgcm) {
+        impl_->aesgcm->setIV(iv.data(), iv.size());
+        impl_->iv = iv;
+        return;
+    }
     system_crypto_handler(
             mbedtls_cipher_set_iv(impl_->cipher_ctx.get(), iv.data(), iv.size()),
             [](int) {
@@ -200,6 +396,17 @@ void VirgilSymmetricCipher::setIV(const VirgilByteArray& iv) {
     impl_->iv = iv;
 }
 
+void VirgilSymmetricCipher::setDecryptionThreadsNum(size_t threadsNum) {
+    impl_->decryptionThreadsNum = std::max<size_t>(threadsNum, 1);
+    if (impl_->aescbc) {
+        impl_->aescbc->setThreadsNum(impl_->decryptionThreadsNum);
+    }
+}
+
+size_t VirgilSymmetricCipher::getDecryptionThreadsNum() const {
+    return impl_->decryptionThreadsNum;
+}
+
 void VirgilSymmetricCipher::setAuthData(const virgil::crypto::VirgilByteArray& authData) {
     checkState();
     impl_->authData = authData;
@@ -207,10 +414,27 @@ void VirgilSymmetricCipher::setAuthData(const virgil::crypto::VirgilByteArray& a
 
 void VirgilSymmetricCipher::reset() {
     checkState();
+    if (impl_->chachapoly) {
+        impl_->chachapoly->start(impl_->authData.data(), impl_->authData.size());
+        if (isDecryptionMode()) {
+            impl_->tagFilter.reset(authTagLength());
+        }
+        return;
+    }
+    if (impl_->aesgcm) {
+        impl_->aesgcm->start(impl_->authData.data(), impl_->authData.size());
+        if (isDecryptionMode()) {
+            impl_->tagFilter.reset(authTagLength());
+        }
+        return;
+    }
     system_crypto_handler(
             mbedtls_cipher_reset(impl_->cipher_ctx.get()),
             [](int) { std::throw_with_nested(make_error(VirgilCryptoError::InvalidState)); }
     );
+    if (isDecryptionMode()) {
+        impl_->startAesCbc();
+    }
     if (mbedtls_cipher_get_cipher_mode(impl_->cipher_ctx.get()) == MBEDTLS_MODE_GCM) {
         system_crypto_handler(
                 mbedtls_cipher_update_ad(impl_->cipher_ctx.get(), impl_->authData.data(), impl_->authData.size()),
@@ -218,14 +442,27 @@ void VirgilSymmetricCipher::reset() {
 
         );
         if (isDecryptionMode()) {
-            impl_->tagFilter.reset(blockSize());
+            impl_->tagFilter.reset(authTagLength());
         }
     }
 }
 
 void VirgilSymmetricCipher::clear() {
+    if (impl_->chachapoly) {
+        impl_->chachapoly->clear();
+        impl_->operation = MBEDTLS_OPERATION_NONE;
+        impl_->iv.clear();
+        impl_->authData.clear();
+        impl_->tagFilter.reset(0);
+        return;
+    }
     auto cipher_type = mbedtls_cipher_get_type(impl_->cipher_ctx.get());
     impl_->cipher_ctx.clear();
+    impl_->aesgcm.reset();
+    impl_->aescbc.reset();
+    impl_->useAesCbc = false;
+    impl_->padding = Padding::PKCS7;
+    impl_->operation = MBEDTLS_OPERATION_NONE;
     impl_->iv.clear();
     impl_->authData.clear();
     impl_->tagFilter.reset(0);
@@ -250,59 +487,112 @@ VirgilByteArray VirgilSymmetricCipher::crypt(const VirgilByteArray& input, const
 }
 
 VirgilByteArray VirgilSymmetricCipher::update(const VirgilByteArray& input) {
+    VirgilByteArray result(updateOutputSizeMax(input.size()));
+    result.resize(update(input.data(), input.size(), result.data(), result.size()));
+    return result;
+}
+
+VirgilByteArray VirgilSymmetricCipher::finish() {
+    VirgilByteArray result(finishOutputSizeMax());
+    result.resize(finish(result.data(), result.size()));
+    return result;
+}
+
+size_t VirgilSymmetricCipher::updateOutputSizeMax(size_t inputSize) const {
+    if (isAuthMode()) {
+        // Decryption releases data that was hold as a possible tag.
+        return isDecryptionMode() ? inputSize + authTagLength() : inputSize;
+    }
+    return inputSize + blockSize();
+}
+
+size_t VirgilSymmetricCipher::finishOutputSizeMax() const {
+    if (isAuthMode()) {
+        return isEncryptionMode() ? authTagLength() : 0;
+    }
+    return blockSize();
+}
+
+size_t VirgilSymmetricCipher::update(
+        const unsigned char* input, size_t inputSize, unsigned char* output, size_t outputCapacity) {
+
     checkState();
-    size_t writtenBytes = 0;
-    size_t bufLen = input.size() + this->blockSize();
-    VirgilByteArray result(bufLen);
+    if (outputCapacity < updateOutputSizeMax(inputSize)) {
+        throw make_error(VirgilCryptoError::InvalidArgument, "Output buffer is too small.");
+    }
+    if (input == output && inputSize > 0 && !(isAuthMode() && isEncryptionMode())) {
+        throw make_error(VirgilCryptoError::InvalidArgument,
+                "In-place processing is supported only for encryption in the authenticated mode.");
+    }
 
-    if (isDecryptionMode() && isAuthMode()) {
-        impl_->tagFilter.process(input);
-        if (impl_->tagFilter.hasData()) {
-            VirgilByteArray data = impl_->tagFilter.popData();
+    size_t writtenBytes = 0;
+    if (impl_->chachapoly) {
+        writtenBytes = internal::aead_update(
+                *impl_->chachapoly, impl_->tagFilter, isEncryptionMode(), input, inputSize, output);
+    } else if (impl_->aesgcm) {
+        writtenBytes = internal::aead_update(
+                *impl_->aesgcm, impl_->tagFilter, isEncryptionMode(), input, inputSize, output);
+    } else if (impl_->useAesCbc) {
+        writtenBytes = impl_->aescbc->update(input, inputSize, output);
+    } else if (isDecryptionMode() && isAuthMode()) {
+        mbedtls_cipher_context_t* cipher_ctx = impl_->cipher_ctx.get();
+        impl_->tagFilter.process(input, inputSize, [&](const unsigned char* data, size_t dataSize) {
+            size_t chunkWrittenBytes = 0;
             system_crypto_handler(
-                    mbedtls_cipher_update(impl_->cipher_ctx.get(), data.data(), data.size(), result.data(),
-                            &writtenBytes),
+                    mbedtls_cipher_update(cipher_ctx, data, dataSize, output + writtenBytes, &chunkWrittenBytes),
                     [](int) { std::throw_with_nested(make_error(VirgilCryptoError::InvalidState)); }
             );
-        }
+            writtenBytes += chunkWrittenBytes;
+        });
     } else {
         system_crypto_handler(
-                mbedtls_cipher_update(impl_->cipher_ctx.get(), input.data(), input.size(), result.data(),
-                        &writtenBytes),
+                mbedtls_cipher_update(impl_->cipher_ctx.get(), input, inputSize, output, &writtenBytes),
                 [](int) { std::throw_with_nested(make_error(VirgilCryptoError::InvalidState)); }
         );
     }
-
-    result.resize(writtenBytes);
-    return result;
+    return writtenBytes;
 }
 
-VirgilByteArray VirgilSymmetricCipher::finish() {
+size_t VirgilSymmetricCipher::finish(unsigned char* output, size_t outputCapacity) {
     checkState();
+    if (outputCapacity < finishOutputSizeMax()) {
+        throw make_error(VirgilCryptoError::InvalidArgument, "Output buffer is too small.");
+    }
+
     size_t writtenBytes = 0;
-    VirgilByteArray result(blockSize());
-    system_crypto_handler(
-            mbedtls_cipher_finish(impl_->cipher_ctx.get(), result.data(), &writtenBytes),
-            [](int) { std::throw_with_nested(make_error(VirgilCryptoError::InvalidState)); }
-    );
-    result.resize(writtenBytes);
-    if (isAuthMode()) {
+    if (impl_->chachapoly) {
+        writtenBytes = internal::aead_finish(*impl_->chachapoly, impl_->tagFilter, isEncryptionMode(), output);
+    } else if (impl_->aesgcm) {
+        writtenBytes = internal::aead_finish(*impl_->aesgcm, impl_->tagFilter, isEncryptionMode(), output);
+    } else if (impl_->useAesCbc) {
+        writtenBytes = impl_->aescbc->finish(output);
+    } else if (isAuthMode()) {
+        // Authenticated mode writes nothing, except the tag.
+        unsigned char unused[1];
+        system_crypto_handler(
+                mbedtls_cipher_finish(impl_->cipher_ctx.get(), unused, &writtenBytes),
+                [](int) { std::throw_with_nested(make_error(VirgilCryptoError::InvalidState)); }
+        );
         if (isEncryptionMode()) {
-            VirgilByteArray tag(authTagLength());
             system_crypto_handler(
-                    mbedtls_cipher_write_tag(impl_->cipher_ctx.get(), tag.data(), tag.size()),
+                    mbedtls_cipher_write_tag(impl_->cipher_ctx.get(), output, authTagLength()),
                     [](int) { std::throw_with_nested(make_error(VirgilCryptoError::InvalidState)); }
             );
-            result.insert(result.end(), tag.begin(), tag.end());
+            writtenBytes = authTagLength();
         } else if (isDecryptionMode()) {
-            VirgilByteArray tag = impl_->tagFilter.tag();
             system_crypto_handler(
-                    mbedtls_cipher_check_tag(impl_->cipher_ctx.get(), tag.data(), tag.size()),
+                    mbedtls_cipher_check_tag(
+                            impl_->cipher_ctx.get(), impl_->tagFilter.tagData(), impl_->tagFilter.tagSize()),
                     [](int) { std::throw_with_nested(make_error(VirgilCryptoError::InvalidAuth)); }
             );
         }
+    } else {
+        system_crypto_handler(
+                mbedtls_cipher_finish(impl_->cipher_ctx.get(), output, &writtenBytes),
+                [](int) { std::throw_with_nested(make_error(VirgilCryptoError::InvalidState)); }
+        );
     }
-    return result;
+    return writtenBytes;
 }
 
 void VirgilSymmetricCipher::checkState() const {
@@ -313,14 +603,25 @@ void VirgilSymmetricCipher::checkState() const {
 
 size_t VirgilSymmetricCipher::asn1Write(VirgilAsn1Writer& asn1Writer, size_t childWrittenBytes) const {
     checkState();
-    const char* oid = 0;
-    size_t oidLen;
-    system_crypto_handler(
-            mbedtls_oid_get_oid_by_cipher_alg(mbedtls_cipher_get_type(impl_->cipher_ctx.get()), &oid, &oidLen),
-            [](int) { std::throw_with_nested(make_error(VirgilCryptoError::UnsupportedAlgorithm)); }
-    );
     size_t len = 0;
     len += asn1Writer.writeOctetString(impl_->iv);
+    auto derOid = impl_->chachapoly ? nullptr :
+            find_der_algorithm(kDer_CipherOids, mbedtls_cipher_get_type(impl_->cipher_ctx.get()));
+    if (derOid != nullptr) {
+        len += asn1Writer.writeData(derOid->der, derOid->size);
+        return len + asn1Writer.writeSequence(len) + childWrittenBytes;
+    }
+    const char* oid = 0;
+    size_t oidLen;
+    if (impl_->chachapoly) {
+        oid = internal::kChaCha20Poly1305_Oid;
+        oidLen = sizeof(internal::kChaCha20Poly1305_Oid) - 1;
+    } else {
+        system_crypto_handler(
+                mbedtls_oid_get_oid_by_cipher_alg(mbedtls_cipher_get_type(impl_->cipher_ctx.get()), &oid, &oidLen),
+                [](int) { std::throw_with_nested(make_error(VirgilCryptoError::UnsupportedAlgorithm)); }
+        );
+    }
     len += asn1Writer.writeOID(std::string(oid, oidLen));
     len += asn1Writer.writeSequence(len);
     return len + childWrittenBytes;
@@ -329,7 +630,26 @@ size_t VirgilSymmetricCipher::asn1Write(VirgilAsn1Writer& asn1Writer, size_t chi
 void VirgilSymmetricCipher::asn1Read(VirgilAsn1Reader& asn1Reader) {
     asn1Reader.readSequence();
 
-    VirgilByteArray oid = VirgilByteArrayUtils::stringToBytes(asn1Reader.readOID());
+    auto oidAsn1 = asn1Reader.readDataView();
+    auto derOid = match_der_algorithm(kDer_CipherOids, oidAsn1.data, oidAsn1.size);
+    if (derOid != nullptr) {
+        clear();
+        impl_->chachapoly.reset();
+        impl_->cipher_ctx.setup(derOid->type);
+        setIV(asn1Reader.readOctetString());
+        return;
+    }
+
+    const std::string oidString = VirgilAsn1Reader(oidAsn1.data, oidAsn1.size).readOID();
+    if (oidString == std::string(internal::kChaCha20Poly1305_Oid, sizeof(internal::kChaCha20Poly1305_Oid) - 1)) {
+        clear();
+        impl_->cipher_ctx.clear();
+        impl_->setup(internal::kChaCha20Poly1305_Name);
+        setIV(asn1Reader.readOctetString());
+        return;
+    }
+
+    VirgilByteArray oid = VirgilByteArrayUtils::stringToBytes(oidString);
     mbedtls_asn1_buf oidAsn1Buf;
     oidAsn1Buf.p = oid.data();
     oidAsn1Buf.len = oid.size();
@@ -341,6 +661,7 @@ void VirgilSymmetricCipher::asn1Read(VirgilAsn1Reader& asn1Reader) {
     );
 
     clear();
+    impl_->chachapoly.reset();
     impl_->cipher_ctx.setup(type);
     setIV(asn1Reader.readOctetString());
 }
@@ -355,11 +676,21 @@ std::string std::to_string(virgil::crypto::foundation::VirgilSymmetricCipher::Al
             return "AES-256-CBC";
         case VirgilSymmetricCipher::Algorithm::AES_256_GCM:
             return "AES-256-GCM";
+        case VirgilSymmetricCipher::Algorithm::CHACHA20_POLY1305:
+            return virgil::crypto::foundation::internal::kChaCha20Poly1305_Name;
     }
 }
 
 namespace virgil { namespace crypto { namespace foundation { namespace internal {
 
+bool constant_time_equal(const unsigned char* a, const unsigned char* b, size_t size) noexcept {
+    unsigned char diff = 0;
+    for (size_t i = 0; i < size; ++i) {
+        diff |= a[i] ^ b[i];
+    }
+    return diff == 0;
+}
+
 mbedtls_cipher_padding_t convert_padding(VirgilSymmetricCipher::Padding padding) noexcept {
     switch (padding) {
         case VirgilSymmetricCipher::Padding::PKCS7:
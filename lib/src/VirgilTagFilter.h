@@ -37,7 +37,10 @@
 #ifndef VIRGIL_CRYPTO_TAG_FILTER_H
 #define VIRGIL_CRYPTO_TAG_FILTER_H
 
+#include <algorithm>
+#include <array>
 #include <cstdlib>
+#include <cstring>
 
 #include <virgil/crypto/VirgilByteArray.h>
 
@@ -46,9 +49,17 @@ namespace virgil { namespace crypto { namespace foundation { namespace internal
 /**
  * @brief This class analize incoming data stream to filter Virgil TAG.
  * @note Virgil TAG MUST be at the end of the data stream.
+ *
+ * Only last bytes of the stream, that can be a part of the TAG, are hold within fixed size window,
+ *     all other data is passed to the caller without copying.
  */
 class VirgilTagFilter {
 public:
+    /**
+     * @brief Maximum supported length of the Virgil TAG.
+     */
+    static constexpr size_t kTagLenMax = 16;
+
     /**
      * @brief Base initialization.
      * @note Method reset() MUST be called anyway.
@@ -59,11 +70,23 @@ public:
      * @brief Get ready for data filtration.
      * @param tagLen - length of the expected Virgil TAG.
      * @note This method MUST be called before any data will be processed.
+     * @throw VirgilCryptoException with VirgilCryptoError::InvalidArgument, if tagLen is greater than kTagLenMax.
      */
     void reset(size_t tagLen);
 
     /**
      * @brief Filter given data.
+     *
+     * Pass data that is not a part of the tag to the given consumer: first, bytes released from the window,
+     *     then prefix of the given data. Consumer signature: void(const unsigned char* data, size_t dataSize).
+     * @note Consumer is not called for the empty data.
+     */
+    template<typename Consumer>
+    void process(const unsigned char* data, size_t dataSize, Consumer&& consume);
+
+    /**
+     * @brief Filter given data.
+     * @note Filtered data is accumulated and can be retrieved with popData().
      */
     void process(const virgil::crypto::VirgilByteArray& data);
 
@@ -79,17 +102,54 @@ public:
 
     /**
      * @brief Return tag that was extracted from processed data.
-     * @note MUST be called after method finish().
      * @return Tag or empty byte array.
      */
     virgil::crypto::VirgilByteArray tag() const;
 
+    /**
+     * @brief Return pointer to the tag that was extracted from processed data.
+     */
+    const unsigned char* tagData() const;
+
+    /**
+     * @brief Return size of the tag that was extracted from processed data.
+     */
+    size_t tagSize() const;
+
 private:
     size_t tagLen_;
+    std::array<unsigned char, kTagLenMax> window_;
+    size_t windowLen_;
     virgil::crypto::VirgilByteArray data_;
-    virgil::crypto::VirgilByteArray tag_;
 };
 
+template<typename Consumer>
+void VirgilTagFilter::process(const unsigned char* data, size_t dataSize, Consumer&& consume) {
+    const size_t totalLen = windowLen_ + dataSize;
+    if (totalLen <= tagLen_) {
+        std::memcpy(window_.data() + windowLen_, data, dataSize);
+        windowLen_ = totalLen;
+        return;
+    }
+
+    const size_t releaseLen = totalLen - tagLen_;
+    const size_t releaseWindowLen = std::min(releaseLen, windowLen_);
+    const size_t releaseDataLen = releaseLen - releaseWindowLen;
+
+    if (releaseWindowLen > 0) {
+        consume(window_.data(), releaseWindowLen);
+    }
+    if (releaseDataLen > 0) {
+        consume(data, releaseDataLen);
+    }
+
+    // Window keeps the last tagLen_ bytes: the rest of the window followed by the rest of the data.
+    const size_t keepWindowLen = windowLen_ - releaseWindowLen;
+    std::memmove(window_.data(), window_.data() + releaseWindowLen, keepWindowLen);
+    std::memcpy(window_.data() + keepWindowLen, data + releaseDataLen, dataSize - releaseDataLen);
+    windowLen_ = tagLen_;
+}
+
 }}}}
 
 #endif /* VIRGIL_CRYPTO_TAG_FILTER_H */
@@ -57,6 +57,8 @@ using virgil::crypto::VirgilTinyCipherImpl;
 using virgil::crypto::VirgilByteArray;
 using virgil::crypto::VirgilByteArrayUtils;
 using virgil::crypto::VirgilKeyPair;
+using virgil::crypto::VirgilPublicKeyHandle;
+using virgil::crypto::VirgilPrivateKeyHandle;
 using virgil::crypto::VirgilCryptoError;
 using virgil::crypto::make_error;
 
@@ -276,7 +278,7 @@ static VirgilKeyPair::Type pk_type_from_code(unsigned char pkCode);
 /**
  * @brief Create cipher for common symmetric crypto operations.
  */
-static VirgilSymmetricCipher create_shared_cipher();
+static VirgilSymmetricCipher create_shared_cipher(VirgilSymmetricCipher::Algorithm algorithm);
 
 class VirgilTinyCipher::Impl {
 public:
@@ -285,6 +287,7 @@ public:
     PackageMap packageMap;
     VirgilByteArray packageSignBits;
     VirgilByteArray ephemeralPublicKey;
+    VirgilSymmetricCipher::Algorithm cipherAlgorithm = VirgilSymmetricCipher::Algorithm::AES_256_GCM;
 };
 
 VirgilTinyCipher::VirgilTinyCipher(size_t packageSize) : impl_(std::make_unique<Impl>()) {
@@ -294,6 +297,14 @@ VirgilTinyCipher::VirgilTinyCipher(size_t packageSize) : impl_(std::make_unique<
     impl_->packageSize = packageSize;
 }
 
+VirgilTinyCipher::VirgilTinyCipher(size_t packageSize, VirgilSymmetricCipher::Algorithm cipherAlgorithm)
+        : VirgilTinyCipher(packageSize) {
+    if (!VirgilSymmetricCipher(cipherAlgorithm).isAuthMode()) {
+        throw make_error(VirgilCryptoError::InvalidArgument, "Given symmetric algorithm is not authenticated.");
+    }
+    impl_->cipherAlgorithm = cipherAlgorithm;
+}
+
 VirgilTinyCipher::VirgilTinyCipher(VirgilTinyCipher&& rhs) noexcept = default;
 
 VirgilTinyCipher& VirgilTinyCipher::operator=(VirgilTinyCipher&& rhs) noexcept = default;
@@ -349,18 +360,42 @@ void VirgilTinyCipher::encryptAndSign(
         const VirgilByteArray& senderPrivateKey,
         const VirgilByteArray& senderPrivateKeyPassword) {
 
-    // 1. Encrypt
     VirgilAsymmetricCipher recipientContext;
     recipientContext.setPublicKey(recipientPublicKey);
 
+    if (senderPrivateKey.empty()) {
+        doEncryptAndSign(data, recipientContext, nullptr);
+    } else {
+        VirgilAsymmetricCipher senderContext;
+        senderContext.setPrivateKey(senderPrivateKey, senderPrivateKeyPassword);
+        doEncryptAndSign(data, recipientContext, &senderContext);
+    }
+}
+
+void VirgilTinyCipher::encrypt(const VirgilByteArray& data, const VirgilPublicKeyHandle& recipientPublicKey) {
+    doEncryptAndSign(data, *recipientPublicKey.acquireCipher(), nullptr);
+}
+
+void VirgilTinyCipher::encryptAndSign(
+        const VirgilByteArray& data, const VirgilPublicKeyHandle& recipientPublicKey,
+        const VirgilPrivateKeyHandle& senderPrivateKey) {
+
+    doEncryptAndSign(data, *recipientPublicKey.acquireCipher(), senderPrivateKey.acquireCipher().get());
+}
+
+void VirgilTinyCipher::doEncryptAndSign(
+        const VirgilByteArray& data, const VirgilAsymmetricCipher& recipientContext,
+        const VirgilAsymmetricCipher* senderContext) {
+
+    // 1. Encrypt
     VirgilAsymmetricCipher ephemeralContext;
     ephemeralContext.genKeyPairFrom(recipientContext);
 
     VirgilByteArray sharedSecret = VirgilAsymmetricCipher::computeShared(recipientContext, ephemeralContext);
 
-    VirgilSymmetricCipher sharedCipher = create_shared_cipher();
+    VirgilSymmetricCipher sharedCipher = create_shared_cipher(impl_->cipherAlgorithm);
 
-    const bool doSign = !senderPrivateKey.empty();
+    const bool doSign = senderContext != nullptr;
     size_t signLength = doSign ? get_sign_size(ephemeralContext.getKeyType()) : 0;
 
     const size_t packageCount = calc_package_count(data.size() + sharedCipher.authTagLength(), impl_->packageSize,
@@ -380,13 +415,10 @@ void VirgilTinyCipher::encryptAndSign(
     // 2. Sign if requested
     VirgilByteArray signBits;
     if (doSign) {
-        VirgilAsymmetricCipher senderContext;
-        senderContext.setPrivateKey(senderPrivateKey, senderPrivateKeyPassword);
-
         VirgilHash hash(kHashAlgorithm_Default);
         VirgilByteArray digest = hash.hash(encryptedData);
 
-        signBits = senderContext.sign(digest, hash.type());
+        signBits = senderContext->sign(digest, hash.type());
     }
 
     // 3. Pack
@@ -444,14 +476,44 @@ VirgilByteArray VirgilTinyCipher::verifyAndDecrypt(
         throw make_error(VirgilCryptoError::InvalidState, "Not all packages was received.");
     }
 
-    // 1. Configure contexts for asymmetric operations
     VirgilAsymmetricCipher recipientContext;
     recipientContext.setPrivateKey(recipientPrivateKey, recipientPrivateKeyPassword);
 
+    if (senderPublicKey.empty()) {
+        return doVerifyAndDecrypt(nullptr, recipientContext);
+    }
+
+    VirgilAsymmetricCipher senderContext;
+    senderContext.setPublicKey(senderPublicKey);
+    return doVerifyAndDecrypt(&senderContext, recipientContext);
+}
+
+VirgilByteArray VirgilTinyCipher::decrypt(const VirgilPrivateKeyHandle& recipientPrivateKey) {
+    if (!isPackagesAccumulated()) {
+        throw make_error(VirgilCryptoError::InvalidState, "Not all packages was received.");
+    }
+
+    return doVerifyAndDecrypt(nullptr, *recipientPrivateKey.acquireCipher());
+}
+
+VirgilByteArray VirgilTinyCipher::verifyAndDecrypt(
+        const VirgilPublicKeyHandle& senderPublicKey, const VirgilPrivateKeyHandle& recipientPrivateKey) {
+
+    if (!isPackagesAccumulated()) {
+        throw make_error(VirgilCryptoError::InvalidState, "Not all packages was received.");
+    }
+
+    return doVerifyAndDecrypt(senderPublicKey.acquireCipher().get(), *recipientPrivateKey.acquireCipher());
+}
+
+VirgilByteArray VirgilTinyCipher::doVerifyAndDecrypt(
+        const VirgilAsymmetricCipher* senderContext, const VirgilAsymmetricCipher& recipientContext) {
+
+    // 1. Configure contexts for asymmetric operations
     VirgilAsymmetricCipher ephemeralContext;
     ephemeralContext.setPublicKey(impl_->ephemeralPublicKey);
 
-    const bool doVerify = !senderPublicKey.empty();
+    const bool doVerify = senderContext != nullptr;
     VirgilByteArray authData = make_auth_data(impl_->packageCount, ephemeralContext, doVerify);
 
     // 2. Verify data
@@ -464,11 +526,9 @@ VirgilByteArray VirgilTinyCipher::verifyAndDecrypt(
         }
         VirgilByteArray digest = hash.finish();
 
-        VirgilAsymmetricCipher senderContext;
-        senderContext.setPublicKey(senderPublicKey);
         const VirgilByteArray& sign = impl_->packageSignBits;
 
-        if (!senderContext.verify(digest, sign, hash.type())) {
+        if (!senderContext->verify(digest, sign, hash.type())) {
             throw make_error(VirgilCryptoError::MismatchSignature);
         }
     }
@@ -476,7 +536,7 @@ VirgilByteArray VirgilTinyCipher::verifyAndDecrypt(
     // 3. Decrypt data
     VirgilByteArray sharedSecret = VirgilAsymmetricCipher::computeShared(ephemeralContext, recipientContext);
 
-    VirgilSymmetricCipher sharedCipher = create_shared_cipher();
+    VirgilSymmetricCipher sharedCipher = create_shared_cipher(impl_->cipherAlgorithm);
 
     sharedCipher.setDecryptionKey(sharedSecret);
     sharedCipher.setAuthData(authData);
@@ -643,6 +703,6 @@ static VirgilByteArray auth_to_iv(const VirgilByteArray& data, size_t ivSize) {
     return VirgilKDF(VirgilKDF::Algorithm::KDF2).derive(data, ivSize);
 }
 
-static VirgilSymmetricCipher create_shared_cipher() {
-    return VirgilSymmetricCipher(VirgilSymmetricCipher::Algorithm::AES_256_GCM);
+static VirgilSymmetricCipher create_shared_cipher(VirgilSymmetricCipher::Algorithm algorithm) {
+    return VirgilSymmetricCipher(algorithm);
 }
@@ -37,6 +37,7 @@
 #ifndef VIRGIL_CRYPTO_MBEDTLS_CONTEXT_POLICY_SPEC_H
 #define VIRGIL_CRYPTO_MBEDTLS_CONTEXT_POLICY_SPEC_H
 
+#include <mbedtls/aes.h>
 #include <mbedtls/bignum.h>
 #include <mbedtls/ctr_drbg.h>
 #include <mbedtls/ecdh.h>
@@ -48,6 +49,7 @@
 #include <virgil/crypto/foundation/VirgilSystemCryptoError.h>
 #include "mbedtls_type_utils.h"
 
+#include <algorithm>
 #include <array>
 
 namespace virgil { namespace crypto { namespace foundation { namespace internal {
@@ -229,30 +231,54 @@ public:
     }
 };
 
-inline VirgilByteArray randomize(mbedtls_context<mbedtls_ctr_drbg_context>& ctr_drbg_ctx, size_t bytesNum) {
-    std::array<unsigned char, MBEDTLS_CTR_DRBG_MAX_REQUEST> buf;
+template<>
+class mbedtls_context_policy<mbedtls_aes_context> {
+    using context_type = mbedtls_aes_context;
+public:
+    static void init_ctx(context_type* ctx) {
+        mbedtls_aes_init(ctx);
+    }
+
+    static void free_ctx(context_type* ctx) {
+        mbedtls_aes_free(ctx);
+    }
+};
+
+inline VirgilByteArray randomize(
+        mbedtls_ctr_drbg_context* ctr_drbg_ctx, size_t bytesNum,
+        const VirgilByteArray& additional = VirgilByteArray()) {
 
-    VirgilByteArray randomBytes;
-    randomBytes.reserve(bytesNum);
-    while (randomBytes.size() < bytesNum) {
-        const size_t randomChunkSize = std::min(bytesNum, (size_t) MBEDTLS_CTR_DRBG_MAX_REQUEST);
+    VirgilByteArray randomBytes(bytesNum);
+    size_t generatedBytesNum = 0;
+    while (generatedBytesNum < bytesNum) {
+        const size_t randomChunkSize =
+                std::min(bytesNum - generatedBytesNum, (size_t) MBEDTLS_CTR_DRBG_MAX_REQUEST);
         system_crypto_handler(
-                mbedtls_ctr_drbg_random(ctr_drbg_ctx.get(), buf.data(), randomChunkSize));
-        randomBytes.insert(randomBytes.end(), buf.begin(), buf.begin() + randomChunkSize);
+                mbedtls_ctr_drbg_random_with_add(
+                        ctr_drbg_ctx, randomBytes.data() + generatedBytesNum, randomChunkSize,
+                        additional.data(), additional.size()));
+        generatedBytesNum += randomChunkSize;
     }
     return randomBytes;
 };
 
-inline size_t randomize(mbedtls_context<mbedtls_ctr_drbg_context>& ctr_drbg_ctx) {
-    VirgilByteArray randomBytes = randomize(ctr_drbg_ctx, sizeof(size_t));
-    return *((size_t*) &randomBytes[0]);
+inline size_t randomize(
+        mbedtls_ctr_drbg_context* ctr_drbg_ctx, const VirgilByteArray& additional = VirgilByteArray()) {
+    size_t randomNumber = 0;
+    system_crypto_handler(
+            mbedtls_ctr_drbg_random_with_add(
+                    ctr_drbg_ctx, reinterpret_cast<unsigned char*>(&randomNumber), sizeof(randomNumber),
+                    additional.data(), additional.size()));
+    return randomNumber;
 }
 
-inline size_t randomize(mbedtls_context<mbedtls_ctr_drbg_context>& ctr_drbg_ctx, size_t min, size_t max) {
+inline size_t randomize(
+        mbedtls_ctr_drbg_context* ctr_drbg_ctx, size_t min, size_t max,
+        const VirgilByteArray& additional = VirgilByteArray()) {
     if (min >= max) {
         throw make_error(VirgilCryptoError::InvalidArgument, "MIN value is greater or equal to MAX.");
     }
-    return min + (randomize(ctr_drbg_ctx) % size_t(max - min));
+    return min + (randomize(ctr_drbg_ctx, additional) % size_t(max - min));
 }
 
 }}}}
@@ -48,57 +48,71 @@ namespace {
 class VirgilSymmetricCipherWrapper {
 public:
 
-    VirgilSymmetricCipherWrapper()
-            : cipherAlgorithm_(VirgilSymmetricCipher::Algorithm::AES_256_GCM) {}
+    explicit VirgilSymmetricCipherWrapper(VirgilSymmetricCipher::Algorithm cipherAlgorithm)
+            : cipherAlgorithm_(cipherAlgorithm), keySize_(0), nonceSize_(0) {
+        VirgilSymmetricCipher cipher(cipherAlgorithm_);
+        keySize_ = cipher.keyLength();
+        nonceSize_ = cipher.ivSize();
+    }
 
     size_t getKeySize() const {
-        VirgilSymmetricCipher cipher(cipherAlgorithm_);
-        return cipher.keyLength();
+        return keySize_;
     }
 
     size_t getNonceSize() const {
-        VirgilSymmetricCipher cipher(cipherAlgorithm_);
-        return cipher.ivSize();
+        return nonceSize_;
     }
 
     VirgilByteArray encrypt(
             const VirgilByteArray& plainText, const VirgilByteArray& key, const VirgilByteArray& nonce,
             const VirgilByteArray& authData) const {
 
-        VirgilSymmetricCipher cipher(cipherAlgorithm_);
-        cipher.setEncryptionKey(key);
-        cipher.setIV(nonce);
-        cipher.setAuthData(authData);
-        cipher.reset();
-
-        auto cipherText = VirgilByteArray();
-        virgil::crypto::bytes_append(cipherText, cipher.update(plainText));
-        virgil::crypto::bytes_append(cipherText, cipher.finish());
-        return cipherText;
+        return crypt(plainText, key, nonce, authData, true);
     }
 
     VirgilByteArray decrypt(
             const VirgilByteArray& cipherText, const VirgilByteArray& key, const VirgilByteArray& nonce,
             const VirgilByteArray& authData) const {
 
+        return crypt(cipherText, key, nonce, authData, false);
+    }
+
+private:
+    VirgilByteArray crypt(
+            const VirgilByteArray& input, const VirgilByteArray& key, const VirgilByteArray& nonce,
+            const VirgilByteArray& authData, bool isEncryption) const {
+
+        // Every message has its own key, so cipher is not shared between messages,
+        //     and key schedule is wiped when cipher is destroyed.
         VirgilSymmetricCipher cipher(cipherAlgorithm_);
-        cipher.setDecryptionKey(key);
+        if (isEncryption) {
+            cipher.setEncryptionKey(key);
+        } else {
+            cipher.setDecryptionKey(key);
+        }
         cipher.setIV(nonce);
         cipher.setAuthData(authData);
         cipher.reset();
 
-        auto plainText = VirgilByteArray();
-        virgil::crypto::bytes_append(plainText, cipher.update(cipherText));
-        virgil::crypto::bytes_append(plainText, cipher.finish());
-        return plainText;
+        VirgilByteArray output(cipher.updateOutputSizeMax(input.size()) + cipher.finishOutputSizeMax());
+        size_t writtenBytes = cipher.update(input.data(), input.size(), output.data(), output.size());
+        writtenBytes += cipher.finish(output.data() + writtenBytes, output.size() - writtenBytes);
+        output.resize(writtenBytes);
+        return output;
     }
 
 private:
     VirgilSymmetricCipher::Algorithm cipherAlgorithm_;
+    size_t keySize_;
+    size_t nonceSize_;
 };
 
 }
 
 VirgilOperationCipher VirgilOperationCipher::getDefault() {
-    return VirgilOperationCipher(VirgilSymmetricCipherWrapper());
+    return VirgilOperationCipher(VirgilSymmetricCipherWrapper(VirgilSymmetricCipher::Algorithm::AES_256_GCM));
+}
+
+VirgilOperationCipher VirgilOperationCipher::getChaCha20Poly1305() {
+    return VirgilOperationCipher(VirgilSymmetricCipherWrapper(VirgilSymmetricCipher::Algorithm::CHACHA20_POLY1305));
 }
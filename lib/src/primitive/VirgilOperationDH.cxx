@@ -41,6 +41,8 @@
 
 using virgil::crypto::VirgilByteArray;
 using virgil::crypto::VirgilCipherBase;
+using virgil::crypto::VirgilPublicKeyHandle;
+using virgil::crypto::VirgilPrivateKeyHandle;
 
 using virgil::crypto::primitive::VirgilOperationDH;
 
@@ -54,6 +56,12 @@ public:
 
         return VirgilCipherBase::computeShared(publicKey, privateKey, privateKeyPassword);
     }
+
+    VirgilByteArray calculate(
+            const VirgilPublicKeyHandle& publicKey, const VirgilPrivateKeyHandle& privateKey) const {
+
+        return VirgilCipherBase::computeShared(publicKey, privateKey);
+    }
 };
 
 }
@@ -70,4 +70,17 @@ VirgilByteArray VirgilBytesDataSource::read() {
     return VirgilByteArray(start, end);
 }
 
+size_t VirgilBytesDataSource::size() {
+    return in_.size();
+}
+
+VirgilByteArray VirgilBytesDataSource::readAt(size_t offset, size_t length) {
+    if (offset >= in_.size()) {
+        return VirgilByteArray();
+    }
+    VirgilByteArray::const_iterator start = in_.begin() + offset;
+    VirgilByteArray::const_iterator end = start + std::min(length, in_.size() - offset);
+    return VirgilByteArray(start, end);
+}
+
 #endif /* VIRGIL_CRYPTO_FEATURE_STREAM_IMPL */
@@ -40,9 +40,13 @@
 #include <virgil/crypto/VirgilByteArray.h>
 #include <virgil/crypto/stream/VirgilStreamDataSource.h>
 
+#include <virgil/crypto/VirgilCryptoError.h>
+
 #include <algorithm>
 
 using virgil::crypto::VirgilByteArray;
+using virgil::crypto::VirgilCryptoError;
+using virgil::crypto::make_error;
 using virgil::crypto::stream::VirgilStreamDataSource;
 
 static const size_t kChunkSizeMin = 32;
@@ -68,4 +72,31 @@ VirgilByteArray VirgilStreamDataSource::read() {
     return result;
 }
 
+size_t VirgilStreamDataSource::size() {
+    in_.clear();
+    const std::istream::pos_type position = in_.tellg();
+    in_.seekg(0, std::ios::end);
+    const std::istream::pos_type end = in_.tellg();
+    in_.seekg(position);
+    if (position < 0 || end < 0 || !in_) {
+        throw make_error(VirgilCryptoError::InvalidState, "Underlying stream does not support seeking.");
+    }
+    return static_cast<size_t>(end);
+}
+
+VirgilByteArray VirgilStreamDataSource::readAt(size_t offset, size_t length) {
+    in_.clear();
+    in_.seekg(static_cast<std::istream::off_type>(offset), std::ios::beg);
+    if (!in_) {
+        throw make_error(VirgilCryptoError::InvalidState, "Underlying stream does not support seeking.");
+    }
+    VirgilByteArray result(length);
+    in_.read(reinterpret_cast<std::istream::char_type*>(result.data()), length);
+    if (!in_) {
+        // Only part of data was read, so result MUST be trimmed.
+        result.resize(in_.gcount());
+    }
+    return result;
+}
+
 #endif /* VIRGIL_CRYPTO_FEATURE_STREAM_IMPL */
@@ -0,0 +1,99 @@
+/**
+ * Copyright (C) 2015-2018 Virgil Security Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *     (3) Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+ */
+/**
+ * @file test_asn1_reader.cxx
+ * @brief Covers class VirgilAsn1Reader
+ */
+
+#include "catch.hpp"
+
+#include <virgil/crypto/VirgilByteArray.h>
+#include <virgil/crypto/VirgilByteArrayUtils.h>
+#include <virgil/crypto/VirgilCryptoException.h>
+#include <virgil/crypto/foundation/asn1/VirgilAsn1Reader.h>
+
+using virgil::crypto::VirgilByteArray;
+using virgil::crypto::VirgilByteArrayUtils;
+using virgil::crypto::VirgilCryptoException;
+using virgil::crypto::foundation::asn1::VirgilAsn1Reader;
+
+TEST_CASE("ASN.1 read: borrowed buffer", "[asn1-reader]") {
+    // SEQUENCE { OCTET STRING, UTF8String, SEQUENCE { INTEGER } }
+    VirgilByteArray asn1 = VirgilByteArrayUtils::hexToBytes(
+            "3011" "0403aabbcc" "0c03414243" "3003020105" "0500");
+    VirgilAsn1Reader asn1Reader(asn1.data(), asn1.size());
+
+    SECTION ("views point to the given buffer") {
+        REQUIRE(asn1Reader.readSequence() == 0x11);
+
+        VirgilAsn1Reader::View octetString = asn1Reader.readOctetStringView();
+        REQUIRE(octetString.data == asn1.data() + 4);
+        REQUIRE(octetString.size == 3);
+        REQUIRE(VirgilByteArrayUtils::bytesToHex(octetString.toBytes()) == "aabbcc");
+
+        VirgilAsn1Reader::View utf8String = asn1Reader.readUTF8StringView();
+        REQUIRE(utf8String.data == asn1.data() + 9);
+        REQUIRE(VirgilByteArrayUtils::bytesToString(utf8String.toBytes()) == "ABC");
+
+        VirgilAsn1Reader::View data = asn1Reader.readDataView();
+        REQUIRE(data.data == asn1.data() + 12);
+        REQUIRE(VirgilByteArrayUtils::bytesToHex(data.toBytes()) == "3003020105");
+
+        VirgilAsn1Reader nestedAsn1Reader(data.data, data.size);
+        REQUIRE(nestedAsn1Reader.readSequence() == 3);
+        REQUIRE(nestedAsn1Reader.readInteger() == 5);
+        REQUIRE_THROWS_AS(nestedAsn1Reader.readNull(), VirgilCryptoException);
+
+        asn1Reader.readNull();
+    }
+
+    SECTION ("views and copies are the same") {
+        VirgilAsn1Reader copyingAsn1Reader(asn1);
+        REQUIRE(asn1Reader.readDataView().toBytes() == copyingAsn1Reader.readData());
+    }
+
+    SECTION ("and reset to the empty buffer") {
+        asn1Reader.reset(nullptr, 0);
+        REQUIRE_THROWS_AS(asn1Reader.readSequence(), VirgilCryptoException);
+    }
+
+    SECTION ("with truncated data") {
+        VirgilAsn1Reader truncatedAsn1Reader(asn1.data() + 2, 4);
+        REQUIRE_THROWS_AS(truncatedAsn1Reader.readOctetStringView(), VirgilCryptoException);
+        truncatedAsn1Reader.reset(asn1.data() + 12, 4);
+        REQUIRE_THROWS_AS(truncatedAsn1Reader.readDataView(), VirgilCryptoException);
+    }
+}
@@ -202,3 +202,89 @@ TEST_CASE("ASN.1 write: check step by step ASN.1 buffer grows", "[asn1-writer]")
     size_t len = 0;
     REQUIRE_THROWS(for (; ;) { len += asn1Writer.writeSequence(len); });
 }
+
+TEST_CASE("ASN.1 write: calculate size before writing", "[asn1-writer]") {
+    auto write = [](VirgilAsn1Writer& asn1Writer) -> size_t {
+        size_t len = 0;
+        len += asn1Writer.writeOctetString(VirgilByteArray(300, 0xAB));
+        len += asn1Writer.writeInteger(-0x7fffffff);
+        len += asn1Writer.writeContextTag(2, len);
+        len += asn1Writer.writeUTF8String(VirgilByteArrayUtils::stringToBytes("key"));
+        return len + asn1Writer.writeSequence(len);
+    };
+    VirgilAsn1Writer asn1Writer;
+    VirgilByteArray expectedAsn1;
+    REQUIRE_NOTHROW(write(asn1Writer));
+    REQUIRE_NOTHROW(expectedAsn1 = asn1Writer.finish());
+
+    SECTION ("with size only") {
+        asn1Writer.resetSizing();
+        REQUIRE(asn1Writer.isSizing());
+        REQUIRE(write(asn1Writer) == expectedAsn1.size());
+        REQUIRE_THROWS(asn1Writer.finish());
+    }
+
+    SECTION ("with exact capacity") {
+        asn1Writer.reset(expectedAsn1.size());
+        REQUIRE(write(asn1Writer) == expectedAsn1.size());
+        REQUIRE(asn1Writer.finish() == expectedAsn1);
+    }
+
+    SECTION ("to the given buffer") {
+        VirgilByteArray buffer(expectedAsn1.size() + 2, 0x00);
+        asn1Writer.reset(buffer.data(), buffer.size());
+        REQUIRE(write(asn1Writer) == expectedAsn1.size());
+        REQUIRE(VirgilByteArray(buffer.begin() + 2, buffer.end()) == expectedAsn1);
+    }
+
+    SECTION ("to the given buffer that is too small") {
+        VirgilByteArray buffer(expectedAsn1.size() - 1, 0x00);
+        asn1Writer.reset(buffer.data(), buffer.size());
+        REQUIRE_THROWS(write(asn1Writer));
+    }
+}
+
+TEST_CASE("ASN.1 write: order already written SET elements", "[asn1-writer]") {
+    const std::vector<VirgilByteArray> elements {
+        VirgilByteArrayUtils::hexToBytes("0c03434343"),
+        VirgilByteArrayUtils::hexToBytes("0c0141"),
+        VirgilByteArrayUtils::hexToBytes("0c024242"),
+        VirgilByteArrayUtils::hexToBytes("0201ff"),
+    };
+    const auto write = [&elements](VirgilAsn1Writer& asn1Writer) -> size_t {
+        size_t len = 0;
+        for (const auto& element : elements) {
+            len += asn1Writer.writeData(element);
+        }
+        len += asn1Writer.writeSortedSet(len);
+        return len + asn1Writer.writeInteger(1);
+    };
+    const VirgilByteArray expectedAsn1 =
+            VirgilByteArrayUtils::hexToBytes("020101" "310f" "0201ff" "0c0141" "0c024242" "0c03434343");
+
+    SECTION ("with growing buffer") {
+        VirgilAsn1Writer asn1Writer(1);
+        REQUIRE(write(asn1Writer) == expectedAsn1.size());
+        REQUIRE(VirgilByteArrayUtils::bytesToHex(asn1Writer.finish()) ==
+                VirgilByteArrayUtils::bytesToHex(expectedAsn1));
+    }
+
+    SECTION ("with size only") {
+        VirgilAsn1Writer asn1Writer;
+        asn1Writer.resetSizing();
+        REQUIRE(write(asn1Writer) == expectedAsn1.size());
+    }
+
+    SECTION ("to the given buffer") {
+        VirgilByteArray buffer(expectedAsn1.size(), 0x00);
+        VirgilAsn1Writer asn1Writer;
+        asn1Writer.reset(buffer.data(), buffer.size());
+        REQUIRE(write(asn1Writer) == expectedAsn1.size());
+        REQUIRE(buffer == expectedAsn1);
+    }
+
+    SECTION ("with elements that are not written") {
+        VirgilAsn1Writer asn1Writer;
+        REQUIRE_THROWS(asn1Writer.writeSortedSet(1));
+    }
+}
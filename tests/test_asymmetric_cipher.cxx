@@ -45,6 +45,8 @@
 #include <virgil/crypto/VirgilByteArray.h>
 #include <virgil/crypto/foundation/VirgilAsymmetricCipher.h>
 
+#include "VirgilKeyAgreement.h"
+
 using virgil::crypto::str2bytes;
 using virgil::crypto::hex2bytes;
 using virgil::crypto::bytes2str;
@@ -52,6 +54,7 @@ using virgil::crypto::bytes2hex;
 using virgil::crypto::VirgilByteArray;
 using virgil::crypto::VirgilKeyPair;
 using virgil::crypto::foundation::VirgilAsymmetricCipher;
+using virgil::crypto::foundation::internal::VirgilKeyAgreement;
 
 static const char* const kPublicKey1 =
         "-----BEGIN PUBLIC KEY-----\n"
@@ -244,3 +247,27 @@ TEST_CASE("Asymmetric Cipher - Deterministic Key Pair generation", "[asymmetric-
         REQUIRE(kDeterministic_FAST_EC_ED25519_Private == bytes2str(cipher.exportPrivateKeyToPEM()));
     }
 }
+
+TEST_CASE("Asymmetric Cipher - ASN.1 AlgorithmIdentifier", "[asymmetric-cipher]") {
+    VirgilAsymmetricCipher cipher;
+
+    SECTION("EC_SECP256R1") {
+        cipher.genKeyPair(VirgilKeyPair::Type::EC_SECP256R1);
+        REQUIRE(bytes2hex(cipher.toAsn1()) == "301306072a8648ce3d020106082a8648ce3d030107");
+    }
+
+    SECTION("EC_BP256R1") {
+        cipher.genKeyPair(VirgilKeyPair::Type::EC_BP256R1);
+        REQUIRE(bytes2hex(cipher.toAsn1()) == "301406072a8648ce3d020106092b2403030208010107");
+    }
+
+    SECTION("RSA_256") {
+        cipher.genKeyPair(VirgilKeyPair::Type::RSA_256);
+        REQUIRE(bytes2hex(cipher.toAsn1()) == "300d06092a864886f70d0101010500");
+    }
+}
+
+TEST_CASE("Key Agreement - ASN.1 KeyEncryptionAlgorithmIdentifier", "[asymmetric-cipher]") {
+    REQUIRE(bytes2hex(VirgilKeyAgreement::algorithm()) ==
+            "301a060b2a864886f70d0109100313300b060960864801650304012d");
+}
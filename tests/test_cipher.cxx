@@ -45,15 +45,20 @@
 #include <virgil/crypto/VirgilByteArray.h>
 #include <virgil/crypto/VirgilByteArrayUtils.h>
 #include <virgil/crypto/VirgilCipher.h>
+#include <virgil/crypto/VirgilContentKeyCache.h>
 #include <virgil/crypto/VirgilKeyPair.h>
+#include <virgil/crypto/VirgilPrivateKeyHandle.h>
 
 using virgil::crypto::str2bytes;
 using virgil::crypto::bytes2hex;
 using virgil::crypto::bytes2str;
 using virgil::crypto::VirgilByteArray;
 using virgil::crypto::VirgilCipher;
+using virgil::crypto::VirgilContentKeyCache;
+using virgil::crypto::VirgilPrivateKeyHandle;
 using virgil::crypto::VirgilKeyPair;
 using virgil::crypto::VirgilByteArrayUtils;
+using virgil::crypto::foundation::VirgilSymmetricCipher;
 
 
 static void test_encrypt_decrypt(const VirgilKeyPair& keyPair, const VirgilByteArray& keyPassword) {
@@ -251,6 +256,43 @@ TEST_CASE("VirgilCipher: encrypt and decrypt with password", "[cipher]") {
     }
 }
 
+TEST_CASE("VirgilCipher: decrypt with one of many passwords", "[cipher]") {
+    VirgilByteArray testData = str2bytes("this string will be encrypted");
+
+    VirgilCipher cipher;
+    for (auto i = 0; i < 8; ++i) {
+        cipher.addPasswordRecipient(str2bytes("password-" + std::to_string(i)));
+    }
+    VirgilByteArray encryptedData = cipher.encrypt(testData, true);
+
+    for (size_t threadsNum : { 1, 4 }) {
+        VirgilCipher decoder;
+        decoder.setRecipientsThreadsNum(threadsNum);
+        REQUIRE(decoder.decryptWithPassword(encryptedData, str2bytes("password-0")) == testData);
+        REQUIRE(decoder.decryptWithPassword(encryptedData, str2bytes("password-7")) == testData);
+        REQUIRE_THROWS(decoder.decryptWithPassword(encryptedData, str2bytes("wrong password")));
+    }
+}
+
+TEST_CASE("VirgilCipher: encrypt and decrypt with ChaCha20-Poly1305", "[cipher]") {
+    VirgilByteArray testData = str2bytes("this string will be encrypted");
+    VirgilByteArray recipientId = str2bytes("2e8176ba-34db-4c65-b977-c5eac687c4ac");
+    VirgilKeyPair keyPair = VirgilKeyPair::generateRecommended();
+
+    VirgilCipher cipher;
+    REQUIRE(cipher.getContentEncryptionAlgorithm() == VirgilSymmetricCipher::Algorithm::AES_256_GCM);
+    cipher.setContentEncryptionAlgorithm(VirgilSymmetricCipher::Algorithm::CHACHA20_POLY1305);
+    cipher.addKeyRecipient(recipientId, keyPair.publicKey());
+    VirgilByteArray encryptedData = cipher.encrypt(testData, true);
+
+    VirgilCipher decoder;
+    VirgilByteArray decryptedData = decoder.decryptWithKey(encryptedData, recipientId, keyPair.privateKey());
+    REQUIRE(testData == decryptedData);
+
+    encryptedData.back() ^= 0x01;
+    REQUIRE_THROWS(VirgilCipher().decryptWithKey(encryptedData, recipientId, keyPair.privateKey()));
+}
+
 TEST_CASE("VirgilCipher: check recipient existence", "[cipher]") {
     VirgilByteArray bobId = str2bytes("2e8176ba-34db-4c65-b977-c5eac687c4ac");
     VirgilByteArray johnId = str2bytes("968dc52d-2045-4abe-ab51-0b04737cac76");
@@ -280,6 +322,175 @@ TEST_CASE("VirgilCipher: check recipient existence", "[cipher]") {
     }
 }
 
+TEST_CASE("VirgilCipher: encrypt to the preallocated buffer", "[cipher]") {
+    VirgilKeyPair keyPair = VirgilKeyPair::generateRecommended();
+    VirgilByteArray recipientId = str2bytes("2e8176ba-34db-4c65-b977-c5eac687c4ac");
+    VirgilByteArray testData = str2bytes("this string will be encrypted to the preallocated buffer");
+
+    VirgilCipher cipher;
+    cipher.addKeyRecipient(recipientId, keyPair.publicKey());
+
+    SECTION("calculated size matches size of the encrypted data") {
+        for (size_t dataSize : { 0, 1, 15, 16, 17, 1000 }) {
+            VirgilByteArray data(dataSize, 0xAB);
+
+            VirgilCipher embeddingCipher;
+            embeddingCipher.addKeyRecipient(recipientId, keyPair.publicKey());
+            size_t encryptedSize = embeddingCipher.calculateEncryptedSize(data.size());
+            VirgilByteArray encryptedData = embeddingCipher.encrypt(data);
+            REQUIRE(encryptedData.size() == encryptedSize);
+            REQUIRE(VirgilCipher().decryptWithKey(encryptedData, recipientId, keyPair.privateKey()) == data);
+
+            VirgilCipher separatingCipher;
+            separatingCipher.addKeyRecipient(recipientId, keyPair.publicKey());
+            encryptedSize = separatingCipher.calculateEncryptedSize(data.size(), false);
+            encryptedData = separatingCipher.encrypt(data, false);
+            REQUIRE(encryptedData.size() == encryptedSize);
+            VirgilCipher decipher;
+            decipher.setContentInfo(separatingCipher.getContentInfo());
+            REQUIRE(decipher.decryptWithKey(encryptedData, recipientId, keyPair.privateKey()) == data);
+        }
+    }
+
+    SECTION("calculated size follows recipients added after calculation") {
+        const size_t keyEncryptedSize = cipher.calculateEncryptedSize(testData.size());
+        cipher.addPasswordRecipient(str2bytes("password"));
+        const size_t encryptedSize = cipher.calculateEncryptedSize(testData.size());
+        REQUIRE(encryptedSize > keyEncryptedSize);
+
+        VirgilByteArray encryptedData = cipher.encrypt(testData);
+        REQUIRE(encryptedData.size() == encryptedSize);
+        REQUIRE(VirgilCipher().decryptWithKey(encryptedData, recipientId, keyPair.privateKey()) == testData);
+        REQUIRE(VirgilCipher().decryptWithPassword(encryptedData, str2bytes("password")) == testData);
+    }
+
+    SECTION("with embedded content info") {
+        VirgilByteArray encryptedData(cipher.calculateEncryptedSize(testData.size()));
+        size_t writtenBytes = 0;
+        REQUIRE_NOTHROW(writtenBytes = cipher.encrypt(
+                testData.data(), testData.size(), encryptedData.data(), encryptedData.size()));
+        REQUIRE(writtenBytes == encryptedData.size());
+
+        VirgilCipher decipher;
+        REQUIRE(decipher.decryptWithKey(encryptedData, recipientId, keyPair.privateKey()) == testData);
+    }
+
+    SECTION("to the buffer that is too small") {
+        VirgilByteArray encryptedData(cipher.calculateEncryptedSize(testData.size()) - 1);
+        REQUIRE_THROWS(cipher.encrypt(testData.data(), testData.size(), encryptedData.data(), encryptedData.size()));
+    }
+}
+
+TEST_CASE("VirgilCipher: rekey encrypted data", "[cipher]") {
+    VirgilKeyPair aliceKeyPair = VirgilKeyPair::generateRecommended();
+    VirgilKeyPair bobKeyPair = VirgilKeyPair::generateRecommended();
+    VirgilKeyPair johnKeyPair = VirgilKeyPair::generate(VirgilKeyPair::Type::RSA_2048);
+    VirgilByteArray aliceId = str2bytes("alice");
+    VirgilByteArray bobId = str2bytes("bob");
+    VirgilByteArray johnId = str2bytes("john");
+    VirgilByteArray password = str2bytes("password");
+    VirgilByteArray testData = str2bytes("this string will be encrypted once, but recipients will be changed");
+
+    VirgilCipher cipher;
+    cipher.addKeyRecipient(aliceId, aliceKeyPair.publicKey());
+    cipher.addKeyRecipient(bobId, bobKeyPair.publicKey());
+    cipher.customParams().setString(str2bytes("name"), str2bytes("value"));
+    VirgilByteArray encryptedData = cipher.encrypt(testData, true);
+
+    const size_t contentInfoSize = VirgilCipher::defineContentInfoSize(encryptedData);
+    const VirgilByteArray contentInfo(encryptedData.cbegin(), encryptedData.cbegin() + contentInfoSize);
+    const VirgilByteArray payload(encryptedData.cbegin() + contentInfoSize, encryptedData.cend());
+
+    VirgilCipher rekeyCipher;
+    rekeyCipher.setContentInfo(contentInfo);
+    rekeyCipher.removeKeyRecipient(bobId);
+    rekeyCipher.addKeyRecipient(johnId, johnKeyPair.publicKey());
+    rekeyCipher.addPasswordRecipient(password);
+    VirgilByteArray newContentInfo;
+    REQUIRE_NOTHROW(newContentInfo = rekeyCipher.rekeyWithKey(aliceId, aliceKeyPair.privateKey()));
+
+    VirgilByteArray rekeyedData = newContentInfo;
+    VirgilByteArrayUtils::append(rekeyedData, payload);
+
+    SECTION("decrypt for added recipients") {
+        VirgilCipher decipher;
+        REQUIRE(decipher.decryptWithKey(rekeyedData, johnId, johnKeyPair.privateKey()) == testData);
+        REQUIRE(decipher.decryptWithPassword(rekeyedData, password) == testData);
+        REQUIRE(decipher.customParams().getString(str2bytes("name")) == str2bytes("value"));
+    }
+
+    SECTION("decrypt for kept recipient") {
+        VirgilCipher decipher;
+        REQUIRE(decipher.decryptWithKey(rekeyedData, aliceId, aliceKeyPair.privateKey()) == testData);
+    }
+
+    SECTION("decrypt for removed recipient") {
+        VirgilCipher decipher;
+        REQUIRE_THROWS(decipher.decryptWithKey(rekeyedData, bobId, bobKeyPair.privateKey()));
+    }
+
+    SECTION("rekey again with added password") {
+        VirgilCipher passwordRekeyCipher;
+        passwordRekeyCipher.setContentInfo(newContentInfo);
+        passwordRekeyCipher.addKeyRecipient(bobId, bobKeyPair.publicKey());
+        REQUIRE_THROWS(passwordRekeyCipher.rekeyWithPassword(str2bytes("wrong password")));
+        REQUIRE_NOTHROW(newContentInfo = passwordRekeyCipher.rekeyWithPassword(password));
+
+        VirgilCipher decipher;
+        decipher.setContentInfo(newContentInfo);
+        REQUIRE(decipher.decryptWithKey(payload, bobId, bobKeyPair.privateKey()) == testData);
+    }
+
+    SECTION("rekey without content info") {
+        VirgilCipher emptyCipher;
+        emptyCipher.addKeyRecipient(johnId, johnKeyPair.publicKey());
+        REQUIRE_THROWS(emptyCipher.rekeyWithKey(aliceId, aliceKeyPair.privateKey()));
+    }
+}
+
+TEST_CASE("VirgilCipher: encrypt with compact content info", "[cipher]") {
+    VirgilKeyPair commonKeyPair = VirgilKeyPair::generate(VirgilKeyPair::Type::RSA_2048);
+    VirgilByteArray testData = str2bytes("this string will be encrypted for recipients of the same key type");
+    VirgilByteArray lastRecipientId = str2bytes("recipient-31");
+
+    const auto encrypt = [&](bool isCompact) {
+        VirgilCipher cipher;
+        cipher.setCompactContentInfoEnabled(isCompact);
+        REQUIRE(cipher.isCompactContentInfoEnabled() == isCompact);
+        for (auto i = 0; i < 32; ++i) {
+            cipher.addKeyRecipient(str2bytes("recipient-" + std::to_string(i)), commonKeyPair.publicKey());
+        }
+        return cipher.encrypt(testData, true);
+    };
+
+    VirgilByteArray encryptedData = encrypt(false);
+    VirgilByteArray compactEncryptedData = encrypt(true);
+    REQUIRE(compactEncryptedData.size() < encryptedData.size());
+
+    SECTION("decrypt") {
+        VirgilCipher cipher;
+        REQUIRE(cipher.decryptWithKey(compactEncryptedData, lastRecipientId, commonKeyPair.privateKey()) == testData);
+    }
+
+    SECTION("decrypt with key recipient filter") {
+        VirgilCipher cipher;
+        cipher.setKeyRecipientFilterEnabled(true);
+        REQUIRE(cipher.decryptWithKey(compactEncryptedData, lastRecipientId, commonKeyPair.privateKey()) == testData);
+    }
+
+    SECTION("re-encode content info in legacy format") {
+        const size_t contentInfoSize = VirgilCipher::defineContentInfoSize(compactEncryptedData);
+        REQUIRE(contentInfoSize > 0);
+        VirgilCipher cipher;
+        cipher.setContentInfo(
+                VirgilByteArray(compactEncryptedData.cbegin(), compactEncryptedData.cbegin() + contentInfoSize));
+        REQUIRE(cipher.getContentInfo().size() > contentInfoSize);
+
+        VirgilByteArray payload(compactEncryptedData.cbegin() + contentInfoSize, compactEncryptedData.cend());
+        REQUIRE(cipher.decryptWithKey(payload, lastRecipientId, commonKeyPair.privateKey()) == testData);
+    }
+}
+
 TEST_CASE("VirgilCipher: add 512 recipients", "[cipher]") {
     VirgilCipher cipher;
     VirgilKeyPair commonKeyPair = VirgilKeyPair::generateRecommended();
@@ -299,3 +510,276 @@ TEST_CASE("VirgilCipher: add 512 recipients", "[cipher]") {
     REQUIRE_NOTHROW(decryptedData = cipher.decryptWithKey(encryptedData, lastRecipientId, commonKeyPair.privateKey()));
     REQUIRE(testData == decryptedData);
 }
+
+TEST_CASE("VirgilCipher: encrypt for multiple recipients in parallel", "[cipher]") {
+    VirgilKeyPair commonKeyPair = VirgilKeyPair::generateRecommended();
+    VirgilKeyPair rsaKeyPair = VirgilKeyPair::generate(VirgilKeyPair::Type::RSA_2048);
+    VirgilByteArray testData = str2bytes("this string will be encrypted for a lot of recipients in parallel");
+    VirgilByteArray password = str2bytes("password");
+
+    VirgilCipher cipher;
+    cipher.setRecipientsThreadsNum(4);
+    REQUIRE(cipher.getRecipientsThreadsNum() == 4);
+    for (auto i = 0; i < 64; ++i) {
+        std::string recipientId = "recipient-" + std::to_string(i);
+        cipher.addKeyRecipient(str2bytes(recipientId),
+                i % 8 == 0 ? rsaKeyPair.publicKey() : commonKeyPair.publicKey());
+    }
+    cipher.addPasswordRecipient(password);
+    cipher.addPasswordRecipient(str2bytes("other password"));
+
+    VirgilByteArray encryptedData;
+    REQUIRE_NOTHROW(encryptedData = cipher.encrypt(testData, true));
+
+    SECTION("decrypt for each key type") {
+        REQUIRE(VirgilCipher().decryptWithKey(
+                encryptedData, str2bytes("recipient-63"), commonKeyPair.privateKey()) == testData);
+        REQUIRE(VirgilCipher().decryptWithKey(
+                encryptedData, str2bytes("recipient-56"), rsaKeyPair.privateKey()) == testData);
+    }
+
+    SECTION("decrypt with password") {
+        REQUIRE(VirgilCipher().decryptWithPassword(encryptedData, password) == testData);
+    }
+
+    SECTION("with auto threads number") {
+        VirgilCipher autoCipher;
+        autoCipher.setRecipientsThreadsNum(VirgilCipher::kThreadsNumAuto);
+        REQUIRE(autoCipher.getRecipientsThreadsNum() >= 1);
+        autoCipher.addKeyRecipient(str2bytes("recipient-auto"), commonKeyPair.publicKey());
+        REQUIRE_NOTHROW(encryptedData = autoCipher.encrypt(testData, true));
+        REQUIRE(VirgilCipher().decryptWithKey(
+                encryptedData, str2bytes("recipient-auto"), commonKeyPair.privateKey()) == testData);
+    }
+}
+
+TEST_CASE("VirgilCipher: encrypt for multiple recipients with shared ephemeral key", "[cipher]") {
+    VirgilKeyPair x25519KeyPair = VirgilKeyPair::generate(VirgilKeyPair::Type::FAST_EC_X25519);
+    VirgilKeyPair secp256r1KeyPair = VirgilKeyPair::generate(VirgilKeyPair::Type::EC_SECP256R1);
+    VirgilKeyPair ed25519KeyPair = VirgilKeyPair::generate(VirgilKeyPair::Type::FAST_EC_ED25519);
+    VirgilByteArray keyPassword = str2bytes("key password");
+    VirgilKeyPair protectedKeyPair = VirgilKeyPair::generate(VirgilKeyPair::Type::FAST_EC_X25519, keyPassword);
+    VirgilByteArray testData = str2bytes("this string will be encrypted with shared ephemeral key");
+
+    VirgilCipher cipher;
+    REQUIRE_FALSE(cipher.isSharedEphemeralKeyEnabled());
+    cipher.setSharedEphemeralKeyEnabled(true);
+    REQUIRE(cipher.isSharedEphemeralKeyEnabled());
+    cipher.setRecipientsThreadsNum(4);
+    for (auto i = 0; i < 32; ++i) {
+        std::string recipientId = "recipient-" + std::to_string(i);
+        cipher.addKeyRecipient(str2bytes(recipientId),
+                i % 2 == 0 ? x25519KeyPair.publicKey() : secp256r1KeyPair.publicKey());
+    }
+    cipher.addKeyRecipient(str2bytes("recipient-ed25519"), ed25519KeyPair.publicKey());
+    cipher.addKeyRecipient(str2bytes("recipient-protected"), protectedKeyPair.publicKey());
+
+    VirgilByteArray encryptedData;
+    REQUIRE_NOTHROW(encryptedData = cipher.encrypt(testData, true));
+    REQUIRE(cipher.keyRecipientExists(str2bytes("recipient-0")));
+    REQUIRE(cipher.keyRecipientExists(str2bytes("recipient-ed25519")));
+
+    SECTION("decrypt for each key type") {
+        REQUIRE(VirgilCipher().decryptWithKey(
+                encryptedData, str2bytes("recipient-30"), x25519KeyPair.privateKey()) == testData);
+        REQUIRE(VirgilCipher().decryptWithKey(
+                encryptedData, str2bytes("recipient-31"), secp256r1KeyPair.privateKey()) == testData);
+        REQUIRE(VirgilCipher().decryptWithKey(
+                encryptedData, str2bytes("recipient-ed25519"), ed25519KeyPair.privateKey()) == testData);
+        REQUIRE(VirgilCipher().decryptWithKey(
+                encryptedData, str2bytes("recipient-protected"), protectedKeyPair.privateKey(),
+                keyPassword) == testData);
+    }
+
+    SECTION("decrypt with wrong private key") {
+        REQUIRE_THROWS(VirgilCipher().decryptWithKey(
+                encryptedData, str2bytes("recipient-0"), VirgilKeyPair::generate(
+                        VirgilKeyPair::Type::FAST_EC_X25519).privateKey()));
+    }
+
+    SECTION("content info is smaller than with separate ephemeral keys") {
+        VirgilCipher defaultCipher;
+        for (auto i = 0; i < 32; ++i) {
+            std::string recipientId = "recipient-" + std::to_string(i);
+            defaultCipher.addKeyRecipient(str2bytes(recipientId), x25519KeyPair.publicKey());
+        }
+        VirgilCipher sharedCipher;
+        sharedCipher.setSharedEphemeralKeyEnabled(true);
+        for (auto i = 0; i < 32; ++i) {
+            std::string recipientId = "recipient-" + std::to_string(i);
+            sharedCipher.addKeyRecipient(str2bytes(recipientId), x25519KeyPair.publicKey());
+        }
+        (void) defaultCipher.encrypt(testData);
+        (void) sharedCipher.encrypt(testData);
+        REQUIRE(sharedCipher.getContentInfo().size() < defaultCipher.getContentInfo().size());
+    }
+
+    SECTION("remove recipient from content info") {
+        VirgilCipher decryptCipher;
+        decryptCipher.setContentInfo(cipher.getContentInfo());
+        REQUIRE(decryptCipher.keyRecipientExists(str2bytes("recipient-1")));
+        decryptCipher.removeKeyRecipient(str2bytes("recipient-1"));
+        REQUIRE_FALSE(decryptCipher.keyRecipientExists(str2bytes("recipient-1")));
+        REQUIRE(decryptCipher.keyRecipientExists(str2bytes("recipient-3")));
+    }
+}
+
+TEST_CASE("VirgilCipher: decrypt with key recipient filter", "[cipher]") {
+    VirgilKeyPair commonKeyPair = VirgilKeyPair::generate(VirgilKeyPair::Type::FAST_EC_X25519);
+    VirgilByteArray testData = str2bytes("this string will be encrypted for a lot of recipients");
+
+    VirgilCipher cipher;
+    for (auto i = 0; i < 256; ++i) {
+        std::string recipientId = "recipient-" + std::to_string(i);
+        cipher.addKeyRecipient(str2bytes(recipientId), commonKeyPair.publicKey());
+    }
+
+    SECTION("with classic recipients") {
+        VirgilByteArray encryptedData;
+        REQUIRE_NOTHROW(encryptedData = cipher.encrypt(testData, true));
+
+        VirgilCipher decryptCipher;
+        REQUIRE_FALSE(decryptCipher.isKeyRecipientFilterEnabled());
+        decryptCipher.setKeyRecipientFilterEnabled(true);
+        REQUIRE(decryptCipher.isKeyRecipientFilterEnabled());
+        REQUIRE(decryptCipher.decryptWithKey(
+                encryptedData, str2bytes("recipient-128"), commonKeyPair.privateKey()) == testData);
+        REQUIRE(decryptCipher.keyRecipientExists(str2bytes("recipient-128")));
+        REQUIRE_FALSE(decryptCipher.keyRecipientExists(str2bytes("recipient-127")));
+    }
+
+    SECTION("with shared ephemeral key recipients") {
+        cipher.setSharedEphemeralKeyEnabled(true);
+        VirgilByteArray encryptedData;
+        REQUIRE_NOTHROW(encryptedData = cipher.encrypt(testData, true));
+
+        VirgilCipher decryptCipher;
+        decryptCipher.setKeyRecipientFilterEnabled(true);
+        REQUIRE(decryptCipher.decryptWithKey(
+                encryptedData, str2bytes("recipient-255"), commonKeyPair.privateKey()) == testData);
+        REQUIRE_FALSE(decryptCipher.keyRecipientExists(str2bytes("recipient-0")));
+    }
+
+    SECTION("for absent recipient") {
+        VirgilByteArray encryptedData;
+        REQUIRE_NOTHROW(encryptedData = cipher.encrypt(testData, true));
+
+        VirgilCipher decryptCipher;
+        decryptCipher.setKeyRecipientFilterEnabled(true);
+        REQUIRE_THROWS(decryptCipher.decryptWithKey(
+                encryptedData, str2bytes("recipient-absent"), commonKeyPair.privateKey()));
+    }
+}
+
+TEST_CASE("VirgilCipher: decrypt with content key cache", "[cipher]") {
+    VirgilKeyPair bobKeyPair = VirgilKeyPair::generateRecommended();
+    VirgilKeyPair eveKeyPair = VirgilKeyPair::generateRecommended();
+    VirgilByteArray bobId = str2bytes("bob");
+    VirgilByteArray alicePassword = str2bytes("alice secret");
+    VirgilByteArray testData = str2bytes("this string will be encrypted");
+
+    VirgilCipher cipher;
+    cipher.addKeyRecipient(bobId, bobKeyPair.publicKey());
+    cipher.addPasswordRecipient(alicePassword);
+    VirgilByteArray encryptedData = cipher.encrypt(testData, true);
+
+    REQUIRE_THROWS(VirgilContentKeyCache(0));
+
+    VirgilContentKeyCache cache(2);
+    REQUIRE(cache.capacity() == 2);
+    REQUIRE(cache.size() == 0);
+
+    auto decryptWithKey = [&cache, &encryptedData](
+            const VirgilByteArray& recipientId, const VirgilByteArray& privateKey) -> VirgilByteArray {
+        VirgilCipher decoder;
+        decoder.setContentKeyCache(cache);
+        return decoder.decryptWithKey(encryptedData, recipientId, privateKey);
+    };
+
+    SECTION("reuse key between ciphers") {
+        REQUIRE(decryptWithKey(bobId, bobKeyPair.privateKey()) == testData);
+        REQUIRE(cache.size() == 1);
+        REQUIRE(decryptWithKey(bobId, bobKeyPair.privateKey()) == testData);
+        REQUIRE(cache.size() == 1);
+
+        VirgilCipher decoder;
+        decoder.setContentKeyCache(cache);
+        VirgilPrivateKeyHandle bobPrivateKey(bobKeyPair.privateKey());
+        REQUIRE(decoder.decryptWithKey(encryptedData, bobId, bobPrivateKey) == testData);
+        REQUIRE(cache.size() == 2);
+        REQUIRE(decoder.decryptWithPassword(encryptedData, alicePassword) == testData);
+        REQUIRE(cache.size() == 2);
+
+        cache.clear();
+        REQUIRE(cache.size() == 0);
+    }
+
+    SECTION("do not share key with other credentials") {
+        REQUIRE(decryptWithKey(bobId, bobKeyPair.privateKey()) == testData);
+        REQUIRE_THROWS(decryptWithKey(bobId, eveKeyPair.privateKey()));
+        REQUIRE_THROWS(decryptWithKey(str2bytes("eve"), bobKeyPair.privateKey()));
+    }
+
+    SECTION("do not use removed cache") {
+        VirgilCipher decoder;
+        decoder.setContentKeyCache(cache);
+        decoder.removeContentKeyCache();
+        REQUIRE(decoder.decryptWithKey(encryptedData, bobId, bobKeyPair.privateKey()) == testData);
+        REQUIRE(cache.size() == 0);
+    }
+}
+
+TEST_CASE("VirgilCipher: encrypt and decrypt with compact envelope", "[cipher]") {
+    VirgilByteArray testData = str2bytes("this string will be encrypted");
+    VirgilByteArray bobId = str2bytes("2e8176ba-34db-4c65-b977-c5eac687c4ac");
+    VirgilByteArray johnId = str2bytes("968dc52d-2045-4abe-ab51-0b04737cac76");
+    VirgilKeyPair bobKeyPair = VirgilKeyPair::generate(VirgilKeyPair::Type::FAST_EC_X25519);
+    VirgilKeyPair johnKeyPair = VirgilKeyPair::generate(VirgilKeyPair::Type::FAST_EC_X25519);
+
+    VirgilCipher cipher;
+    cipher.addKeyRecipient(bobId, bobKeyPair.publicKey());
+    cipher.addKeyRecipient(johnId, johnKeyPair.publicKey());
+
+    SECTION("for each recipient") {
+        for (auto algorithm : { VirgilSymmetricCipher::Algorithm::AES_256_GCM,
+                                VirgilSymmetricCipher::Algorithm::AES_128_GCM,
+                                VirgilSymmetricCipher::Algorithm::CHACHA20_POLY1305 }) {
+            cipher.setContentEncryptionAlgorithm(algorithm);
+            VirgilByteArray encryptedData = cipher.encryptCompact(testData);
+
+            VirgilCipher decoder;
+            REQUIRE(decoder.decryptCompactWithKey(encryptedData, bobId, bobKeyPair.privateKey()) == testData);
+            VirgilPrivateKeyHandle johnPrivateKey(johnKeyPair.privateKey());
+            REQUIRE(decoder.decryptCompactWithKey(encryptedData, johnId, johnPrivateKey) == testData);
+            REQUIRE_THROWS(decoder.decryptCompactWithKey(encryptedData, str2bytes("eve"), bobKeyPair.privateKey()));
+        }
+    }
+
+    SECTION("after calculation of the encrypted size") {
+        REQUIRE(cipher.calculateEncryptedSize(testData.size()) > testData.size());
+        VirgilByteArray encryptedData = cipher.encryptCompact(testData);
+        REQUIRE(VirgilCipher().decryptCompactWithKey(encryptedData, bobId, bobKeyPair.privateKey()) == testData);
+    }
+
+    SECTION("and reject modified header or content") {
+        VirgilByteArray encryptedData = cipher.encryptCompact(testData);
+        for (size_t index : { size_t(2), size_t(10), encryptedData.size() - 1 }) {
+            VirgilByteArray modifiedData = encryptedData;
+            modifiedData[index] ^= 0x01;
+            REQUIRE_THROWS(VirgilCipher().decryptCompactWithKey(modifiedData, bobId, bobKeyPair.privateKey()));
+        }
+        encryptedData.resize(encryptedData.size() / 2);
+        REQUIRE_THROWS(VirgilCipher().decryptCompactWithKey(encryptedData, bobId, bobKeyPair.privateKey()));
+    }
+
+    SECTION("and reject unsupported configuration") {
+        cipher.setContentEncryptionAlgorithm(VirgilSymmetricCipher::Algorithm::AES_256_CBC);
+        REQUIRE_THROWS(cipher.encryptCompact(testData));
+        cipher.setContentEncryptionAlgorithm(VirgilSymmetricCipher::Algorithm::AES_256_GCM);
+        cipher.addPasswordRecipient(str2bytes("password"));
+        REQUIRE_THROWS(cipher.encryptCompact(testData));
+        cipher.removePasswordRecipient(str2bytes("password"));
+        cipher.addKeyRecipient(str2bytes("rsa"), VirgilKeyPair::generate(VirgilKeyPair::Type::RSA_2048).publicKey());
+        REQUIRE_THROWS(cipher.encryptCompact(testData));
+    }
+}
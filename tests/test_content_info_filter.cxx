@@ -0,0 +1,111 @@
+/**
+ * Copyright (C) 2015-2018 Virgil Security Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *     (3) Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+ */
+
+/**
+ * @file test_content_info_filter.cxx
+ * @brief Covers class VirgilContentInfoFilter
+ */
+
+#include "catch.hpp"
+
+#include <virgil/crypto/VirgilByteArray.h>
+#include <virgil/crypto/VirgilByteArrayUtils.h>
+#include <virgil/crypto/VirgilCipher.h>
+
+#include "VirgilContentInfoFilter.h"
+
+#include <algorithm>
+
+using virgil::crypto::str2bytes;
+using virgil::crypto::VirgilByteArray;
+using virgil::crypto::VirgilByteArrayUtils;
+using virgil::crypto::VirgilCipher;
+using virgil::crypto::internal::VirgilContentInfoFilter;
+
+/**
+ * @brief Pass data to the filter by chunks of the given size, and collect payload that is not consumed.
+ */
+static VirgilByteArray filter_by_chunks(
+        VirgilContentInfoFilter& filter, const VirgilByteArray& data, size_t chunkSize) {
+    VirgilByteArray payload;
+    for (size_t offset = 0; offset < data.size(); offset += chunkSize) {
+        const size_t size = std::min(chunkSize, data.size() - offset);
+        size_t consumedSize = 0;
+        if (filter.isWaitingData()) {
+            consumedSize = filter.filterData(data.data() + offset, size);
+            REQUIRE(consumedSize <= size);
+            VirgilByteArrayUtils::append(payload, filter.popEncryptedData());
+        }
+        payload.insert(payload.end(), data.cbegin() + offset + consumedSize, data.cbegin() + offset + size);
+    }
+    filter.tellLastChunk();
+    VirgilByteArrayUtils::append(payload, filter.popEncryptedData());
+    return payload;
+}
+
+TEST_CASE("VirgilContentInfoFilter: consume content info by chunks", "[content-info-filter]") {
+    VirgilCipher cipher;
+    cipher.addPasswordRecipient(str2bytes("password"));
+    const VirgilByteArray payload = cipher.encrypt(str2bytes("this string will be encrypted"), false);
+    const VirgilByteArray contentInfo = cipher.getContentInfo();
+    VirgilByteArray encryptedData = contentInfo;
+    VirgilByteArrayUtils::append(encryptedData, payload);
+
+    VirgilContentInfoFilter filter;
+    for (size_t chunkSize : { size_t(1), size_t(7), size_t(16), size_t(100), encryptedData.size() }) {
+        filter.reset();
+        REQUIRE(filter_by_chunks(filter, encryptedData, chunkSize) == payload);
+        REQUIRE(filter.isContentInfoFound());
+        REQUIRE(filter.popContentInfo() == contentInfo);
+    }
+}
+
+TEST_CASE("VirgilContentInfoFilter: pass data without content info", "[content-info-filter]") {
+    const VirgilByteArray data = str2bytes("data that does not start with content info");
+
+    VirgilContentInfoFilter filter;
+    for (size_t chunkSize : { size_t(1), size_t(5), data.size() }) {
+        filter.reset();
+        REQUIRE(filter_by_chunks(filter, data, chunkSize) == data);
+        REQUIRE(filter.isContentInfoAbsent());
+    }
+
+    SECTION("shorter than preamble") {
+        filter.reset();
+        REQUIRE(filter_by_chunks(filter, str2bytes("short"), 2) == str2bytes("short"));
+        REQUIRE(filter.isContentInfoAbsent());
+    }
+}
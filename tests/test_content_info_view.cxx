@@ -0,0 +1,152 @@
+/**
+ * Copyright (C) 2015-2018 Virgil Security Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *     (3) Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+ */
+
+/**
+ * @file test_content_info_view.cxx
+ * @brief Covers class VirgilContentInfoView
+ */
+
+#include "catch.hpp"
+
+#include <virgil/crypto/VirgilByteArray.h>
+#include <virgil/crypto/VirgilByteArrayUtils.h>
+#include <virgil/crypto/VirgilCipher.h>
+#include <virgil/crypto/VirgilContentInfoView.h>
+#include <virgil/crypto/VirgilCryptoException.h>
+#include <virgil/crypto/VirgilKeyPair.h>
+
+#include <string>
+#include <vector>
+
+using virgil::crypto::str2bytes;
+using virgil::crypto::VirgilByteArray;
+using virgil::crypto::VirgilCipher;
+using virgil::crypto::VirgilContentInfoView;
+using virgil::crypto::VirgilCryptoException;
+using virgil::crypto::VirgilKeyPair;
+
+using RecipientType = VirgilContentInfoView::RecipientType;
+
+TEST_CASE("VirgilContentInfoView: read content info produced by cipher", "[content-info-view]") {
+    VirgilKeyPair x25519KeyPair = VirgilKeyPair::generate(VirgilKeyPair::Type::FAST_EC_X25519);
+    VirgilKeyPair ed25519KeyPair = VirgilKeyPair::generate(VirgilKeyPair::Type::FAST_EC_ED25519);
+    VirgilByteArray testData = str2bytes("this string will be encrypted");
+
+    VirgilCipher cipher;
+    cipher.addKeyRecipient(str2bytes("recipient-x25519-1"), x25519KeyPair.publicKey());
+    cipher.addKeyRecipient(str2bytes("recipient-x25519-2"), x25519KeyPair.publicKey());
+    cipher.addKeyRecipient(str2bytes("recipient-ed25519"), ed25519KeyPair.publicKey());
+    cipher.addPasswordRecipient(str2bytes("password"));
+    cipher.customParams().setInteger(str2bytes("int"), 35777);
+    cipher.customParams().setString(str2bytes("string"), str2bytes("string parameter"));
+    cipher.customParams().setData(str2bytes("data"), str2bytes("data parameter"));
+
+    SECTION("with separate key recipients") {
+        cipher.setSharedEphemeralKeyEnabled(false);
+    }
+
+    SECTION("with shared ephemeral key") {
+        cipher.setSharedEphemeralKeyEnabled(true);
+    }
+
+    SECTION("with compact content info") {
+        cipher.setCompactContentInfoEnabled(true);
+    }
+
+    VirgilByteArray encryptedData = cipher.encrypt(testData, true);
+    const size_t contentInfoSize = VirgilCipher::defineContentInfoSize(encryptedData);
+
+    VirgilContentInfoView view(encryptedData);
+    REQUIRE(view.size() == contentInfoSize);
+
+    std::vector<std::string> recipientIds;
+    view.forEachRecipientId([&recipientIds](const VirgilContentInfoView::Bytes& recipientId) {
+        recipientIds.emplace_back(recipientId.data, recipientId.data + recipientId.size);
+    });
+    REQUIRE(recipientIds.size() == 3);
+
+    size_t passwordRecipientsNum = 0;
+    view.forEachRecipient([&passwordRecipientsNum](const VirgilContentInfoView::Recipient& recipient) {
+        if (recipient.type == RecipientType::Password) {
+            REQUIRE(recipient.recipientId.empty());
+            REQUIRE_FALSE(recipient.encryptedKey.empty());
+            ++passwordRecipientsNum;
+        }
+    });
+    REQUIRE(passwordRecipientsNum == 1);
+
+    VirgilContentInfoView::Recipient recipient {};
+    REQUIRE(view.findRecipient(str2bytes("recipient-x25519-1"), &recipient));
+    const VirgilByteArray keyEncryptionAlgorithm = recipient.keyEncryptionAlgorithm.toBytes();
+    REQUIRE(view.findRecipient(str2bytes("recipient-x25519-2"), &recipient));
+    REQUIRE(recipient.recipientId.equals(str2bytes("recipient-x25519-2")));
+    REQUIRE_FALSE(recipient.keyEncryptionAlgorithm.empty());
+    REQUIRE(recipient.keyEncryptionAlgorithm.equals(keyEncryptionAlgorithm));
+    REQUIRE(keyEncryptionAlgorithm.front() == 0x30); // AlgorithmIdentifier, not a reference
+    REQUIRE_FALSE(recipient.encryptedKey.empty());
+    REQUIRE(view.findRecipient(str2bytes("recipient-ed25519"), &recipient));
+    REQUIRE(recipient.type == RecipientType::KeyTrans);
+    REQUIRE_FALSE(view.findRecipient(str2bytes("recipient-absent")));
+
+    int intValue = 0;
+    VirgilContentInfoView::Bytes bytesValue {};
+    REQUIRE(view.getCustomInteger(str2bytes("int"), intValue));
+    REQUIRE(intValue == 35777);
+    REQUIRE(view.getCustomString(str2bytes("string"), bytesValue));
+    REQUIRE(bytesValue.toBytes() == str2bytes("string parameter"));
+    REQUIRE(view.getCustomData(str2bytes("data"), bytesValue));
+    REQUIRE(bytesValue.toBytes() == str2bytes("data parameter"));
+    REQUIRE_FALSE(view.getCustomData(str2bytes("string"), bytesValue));
+    REQUIRE_FALSE(view.getCustomInteger(str2bytes("absent"), intValue));
+
+    intValue = 0;
+    REQUIRE(view.getCustomInteger("int", intValue));
+    REQUIRE(intValue == 35777);
+    REQUIRE(view.getCustomString("string", bytesValue));
+    REQUIRE(bytesValue.toBytes() == str2bytes("string parameter"));
+    REQUIRE(view.getCustomData("data", bytesValue));
+    REQUIRE(bytesValue.toBytes() == str2bytes("data parameter"));
+    REQUIRE_FALSE(view.getCustomData("string", bytesValue));
+    REQUIRE_FALSE(view.getCustomInteger("absent", intValue));
+    const VirgilByteArray keyBuffer = str2bytes("data, not null-terminated");
+    REQUIRE(view.getCustomData(VirgilContentInfoView::Bytes { keyBuffer.data(), 4 }, bytesValue));
+    REQUIRE(bytesValue.toBytes() == str2bytes("data parameter"));
+}
+
+TEST_CASE("VirgilContentInfoView: reject malformed content info", "[content-info-view]") {
+    REQUIRE_THROWS_AS(VirgilContentInfoView { VirgilByteArray() }, VirgilCryptoException);
+    REQUIRE_THROWS_AS(VirgilContentInfoView { str2bytes("not a content info") }, VirgilCryptoException);
+}
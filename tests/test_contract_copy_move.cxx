@@ -54,6 +54,7 @@
 #include <virgil/crypto/foundation/asn1/VirgilAsn1Writer.h>
 
 #include <virgil/crypto/foundation/cms/VirgilCMSKeyTransRecipient.h>
+#include <virgil/crypto/foundation/cms/VirgilCMSKeyAgreeRecipient.h>
 #include <virgil/crypto/foundation/cms/VirgilCMSPasswordRecipient.h>
 #include <virgil/crypto/foundation/cms/VirgilCMSContent.h>
 #include <virgil/crypto/foundation/cms/VirgilCMSContentInfo.h>
@@ -116,6 +117,7 @@ TEST_CASE("Check contract: copy and move", "[copy/move]") {
     SECTION_CONTRACT_COPY_AND_MOVE(virgil::crypto::foundation::cms::VirgilCMSEncryptedContent);
     SECTION_CONTRACT_COPY_AND_MOVE(virgil::crypto::foundation::cms::VirgilCMSEnvelopedData);
     SECTION_CONTRACT_COPY_AND_MOVE(virgil::crypto::foundation::cms::VirgilCMSKeyTransRecipient);
+    SECTION_CONTRACT_COPY_AND_MOVE(virgil::crypto::foundation::cms::VirgilCMSKeyAgreeRecipient);
     SECTION_CONTRACT_COPY_AND_MOVE(virgil::crypto::foundation::cms::VirgilCMSPasswordRecipient);
 
 #if ! defined(__GNUG__)
@@ -0,0 +1,124 @@
+/**
+ * Copyright (C) 2015-2018 Virgil Security Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *     (3) Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+ */
+/**
+ * @file test_custom_params.cxx
+ * @brief Covers class VirgilCustomParams
+ */
+
+#include "catch.hpp"
+
+#include <virgil/crypto/VirgilByteArray.h>
+#include <virgil/crypto/VirgilByteArrayUtils.h>
+#include <virgil/crypto/VirgilCryptoException.h>
+#include <virgil/crypto/VirgilCustomParams.h>
+
+using virgil::crypto::str2bytes;
+using virgil::crypto::VirgilByteArray;
+using virgil::crypto::VirgilByteArrayUtils;
+using virgil::crypto::VirgilCryptoException;
+using virgil::crypto::VirgilCustomParams;
+
+TEST_CASE("Custom params: manage parameters", "[custom-params]") {
+    VirgilCustomParams params;
+    REQUIRE(params.isEmpty());
+
+    params.setInteger(str2bytes("key"), 1);
+    params.setString(str2bytes("key"), str2bytes("string"));
+    params.setData(str2bytes("key"), str2bytes("data"));
+    REQUIRE_FALSE(params.isEmpty());
+
+    SECTION ("keys of the different types do not intersect") {
+        REQUIRE(params.getInteger("key") == 1);
+        REQUIRE(params.getString(str2bytes("key")) == str2bytes("string"));
+        REQUIRE(params.getData("key") == str2bytes("data"));
+    }
+
+    SECTION ("value is overwritten") {
+        params.setInteger("key", 2);
+        params.setString(str2bytes("key"), str2bytes("longer string"));
+        params.setData(str2bytes("key"), str2bytes("d"));
+        REQUIRE(params.getInteger(str2bytes("key")) == 2);
+        REQUIRE(params.getString("key") == str2bytes("longer string"));
+        REQUIRE(params.getData(str2bytes("key")) == str2bytes("d"));
+    }
+
+    SECTION ("absent key is reported") {
+        REQUIRE_FALSE(params.hasInteger("absent"));
+        REQUIRE_FALSE(params.hasString(str2bytes("absent")));
+        REQUIRE_THROWS_AS(params.getData("absent"), VirgilCryptoException);
+    }
+
+    SECTION ("parameter is removed") {
+        params.removeString(str2bytes("key"));
+        REQUIRE(params.hasInteger("key"));
+        REQUIRE_FALSE(params.hasString("key"));
+        REQUIRE(params.hasData(str2bytes("key")));
+        params.removeInteger(str2bytes("key"));
+        params.removeData(str2bytes("key"));
+        REQUIRE(params.isEmpty());
+    }
+}
+
+TEST_CASE("Custom params: ASN.1 marshalling", "[custom-params]") {
+    VirgilCustomParams params;
+    params.setString(str2bytes("b"), str2bytes("xy"));
+    params.setInteger(str2bytes("a"), 1);
+
+    // SET { SEQUENCE { "a", [0] INTEGER 1 }, SEQUENCE { "b", [1] "xy" } }
+    const VirgilByteArray asn1 = VirgilByteArrayUtils::hexToBytes(
+            "3115" "30080c0161a003020101" "30090c0162a1040c027879");
+
+    SECTION ("elements of the SET are DER ordered") {
+        REQUIRE(params.calculateAsn1Size() == asn1.size());
+        REQUIRE(params.toAsn1() == asn1);
+    }
+
+    SECTION ("parameters are restored") {
+        VirgilCustomParams restored;
+        restored.fromAsn1(asn1);
+        REQUIRE(restored.getInteger("a") == 1);
+        REQUIRE(restored.getString("b") == str2bytes("xy"));
+        REQUIRE(restored.toAsn1() == asn1);
+    }
+
+    SECTION ("last of the duplicated keys wins") {
+        VirgilCustomParams restored;
+        restored.fromAsn1(VirgilByteArrayUtils::hexToBytes(
+                "3114" "30080c0161a003020101" "30080c0161a003020102"));
+        REQUIRE(restored.getInteger("a") == 2);
+        REQUIRE(restored.toAsn1() == VirgilByteArrayUtils::hexToBytes("310a" "30080c0161a003020102"));
+    }
+}
@@ -151,3 +151,27 @@ TEST_CASE("HMAC-MD5", "[HMAC hash]") {
         REQUIRE(hash.hmac(key, testVector) == testVectorHash);
     }
 }
+
+TEST_CASE("Hash ASN.1 AlgorithmIdentifier", "[hash]") {
+    SECTION("SHA-256 is written and read") {
+        VirgilHash hash(VirgilHash::Algorithm::SHA256);
+        const VirgilByteArray asn1 = hex2bytes("300d06096086480165030402010500");
+        REQUIRE(hash.toAsn1() == asn1);
+        VirgilHash restoredHash;
+        restoredHash.fromAsn1(asn1);
+        REQUIRE(restoredHash.algorithm() == VirgilHash::Algorithm::SHA256);
+    }
+    SECTION("SHA-384 is written and read") {
+        VirgilHash hash(VirgilHash::Algorithm::SHA384);
+        const VirgilByteArray asn1 = hex2bytes("300d06096086480165030402020500");
+        REQUIRE(hash.toAsn1() == asn1);
+        VirgilHash restoredHash;
+        restoredHash.fromAsn1(asn1);
+        REQUIRE(restoredHash.algorithm() == VirgilHash::Algorithm::SHA384);
+    }
+    SECTION("SHA-512 with long form of the length is read") {
+        VirgilHash restoredHash;
+        restoredHash.fromAsn1(hex2bytes("30810d06096086480165030402030500"));
+        REQUIRE(restoredHash.algorithm() == VirgilHash::Algorithm::SHA512);
+    }
+}
@@ -0,0 +1,162 @@
+/**
+ * Copyright (C) 2015-2018 Virgil Security Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *     (3) Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+ */
+
+/**
+ * @file test_key_handle.cxx
+ * @brief Covers classes VirgilPublicKeyHandle and VirgilPrivateKeyHandle
+ */
+
+#include "catch.hpp"
+
+#include <virgil/crypto/VirgilByteArray.h>
+#include <virgil/crypto/VirgilCipher.h>
+#include <virgil/crypto/VirgilSigner.h>
+#include <virgil/crypto/VirgilTinyCipher.h>
+#include <virgil/crypto/VirgilKeyPair.h>
+#include <virgil/crypto/VirgilPublicKeyHandle.h>
+#include <virgil/crypto/VirgilPrivateKeyHandle.h>
+#include <virgil/crypto/VirgilCryptoException.h>
+
+#include <thread>
+#include <vector>
+
+using virgil::crypto::str2bytes;
+using virgil::crypto::VirgilByteArray;
+using virgil::crypto::VirgilCipher;
+using virgil::crypto::VirgilSigner;
+using virgil::crypto::VirgilTinyCipher;
+using virgil::crypto::VirgilKeyPair;
+using virgil::crypto::VirgilPublicKeyHandle;
+using virgil::crypto::VirgilPrivateKeyHandle;
+using virgil::crypto::VirgilCryptoException;
+
+static void test_key_handle(const VirgilKeyPair& keyPair, const VirgilByteArray& keyPassword) {
+    const VirgilByteArray testData = str2bytes("this string will be processed with parsed keys");
+    const VirgilByteArray recipientId = str2bytes("2e8176ba-34db-4c65-b977-c5eac687c4ac");
+
+    const VirgilPublicKeyHandle publicKey(keyPair.publicKey());
+    const VirgilPrivateKeyHandle privateKey(keyPair.privateKey(), keyPassword);
+
+    SECTION("encrypt with handle and decrypt with raw key") {
+        VirgilCipher cipher;
+        cipher.addKeyRecipient(recipientId, publicKey);
+        VirgilByteArray encryptedData = cipher.encrypt(testData, true);
+        REQUIRE(VirgilCipher().decryptWithKey(encryptedData, recipientId, keyPair.privateKey(), keyPassword) ==
+                testData);
+    }
+
+    SECTION("encrypt with raw key and decrypt with handle") {
+        VirgilCipher cipher;
+        cipher.addKeyRecipient(recipientId, keyPair.publicKey());
+        VirgilByteArray encryptedData = cipher.encrypt(testData, true);
+        REQUIRE(VirgilCipher().decryptWithKey(encryptedData, recipientId, privateKey) == testData);
+    }
+
+    SECTION("sign with handle and verify with raw key") {
+        VirgilSigner signer;
+        VirgilByteArray sign = signer.sign(testData, privateKey);
+        REQUIRE(signer.verify(testData, sign, keyPair.publicKey()));
+        REQUIRE(signer.verify(testData, sign, publicKey));
+    }
+
+    SECTION("copy shares parsed key") {
+        VirgilPrivateKeyHandle privateKeyCopy = privateKey;
+        VirgilSigner signer;
+        VirgilByteArray sign = signer.sign(testData, privateKeyCopy);
+        REQUIRE(signer.verify(testData, sign, publicKey));
+    }
+
+    SECTION("use from multiple threads") {
+        std::vector<std::thread> threads;
+        std::vector<int> results(4, 0);
+        for (size_t i = 0; i < results.size(); ++i) {
+            threads.emplace_back([&, i]() {
+                VirgilSigner signer;
+                for (int j = 0; j < 8; ++j) {
+                    VirgilByteArray sign = signer.sign(testData, privateKey);
+                    results[i] += signer.verify(testData, sign, publicKey) ? 1 : 0;
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        for (auto result : results) {
+            REQUIRE(result == 8);
+        }
+    }
+}
+
+#define TEST_CASE_KEY_HANDLE(KeyType) \
+    TEST_CASE("VirgilKeyHandle: " #KeyType, "[key-handle]") { \
+        const VirgilByteArray keyPassword = str2bytes("key password"); \
+        test_key_handle(VirgilKeyPair::generate(VirgilKeyPair::Type::KeyType, keyPassword), keyPassword); \
+    }
+
+TEST_CASE_KEY_HANDLE(RSA_2048)
+
+TEST_CASE_KEY_HANDLE(EC_SECP256R1)
+
+TEST_CASE_KEY_HANDLE(FAST_EC_ED25519)
+
+#undef TEST_CASE_KEY_HANDLE
+
+TEST_CASE("VirgilKeyHandle: tiny cipher with parsed keys", "[key-handle]") {
+    const VirgilByteArray testData = str2bytes("this string will be encrypted and decrypted");
+    const VirgilKeyPair keyPair = VirgilKeyPair::generate(VirgilKeyPair::Type::FAST_EC_ED25519);
+    const VirgilPublicKeyHandle publicKey(keyPair.publicKey());
+    const VirgilPrivateKeyHandle privateKey(keyPair.privateKey());
+
+    VirgilTinyCipher encCipher;
+    encCipher.encryptAndSign(testData, publicKey, privateKey);
+
+    VirgilTinyCipher decCipher;
+    for (size_t i = 0; i < encCipher.getPackageCount(); ++i) {
+        decCipher.addPackage(encCipher.getPackage(i));
+    }
+    REQUIRE(decCipher.isPackagesAccumulated());
+    REQUIRE(decCipher.verifyAndDecrypt(publicKey, privateKey) == testData);
+}
+
+TEST_CASE("VirgilKeyHandle: invalid keys", "[key-handle]") {
+    const VirgilKeyPair keyPair = VirgilKeyPair::generate(
+            VirgilKeyPair::Type::EC_SECP256R1, str2bytes("key password"));
+
+    REQUIRE_THROWS_AS(VirgilPublicKeyHandle(str2bytes("malformed key")), VirgilCryptoException);
+    REQUIRE_THROWS_AS(VirgilPrivateKeyHandle(str2bytes("malformed key")), VirgilCryptoException);
+    REQUIRE_THROWS_AS(
+            VirgilPrivateKeyHandle(keyPair.privateKey(), str2bytes("wrong password")), VirgilCryptoException);
+}
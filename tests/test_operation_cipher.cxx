@@ -0,0 +1,134 @@
+/**
+ * Copyright (C) 2015-2018 Virgil Security Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     (1) Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *     (2) Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *     (3) Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Lead Maintainer: Virgil Security Inc. <support@virgilsecurity.com>
+ */
+/**
+ * @file test_operation_cipher.cxx
+ * @brief Covers class VirgilOperationCipher
+ */
+
+#include "catch.hpp"
+
+#include <thread>
+#include <vector>
+
+#include <virgil/crypto/VirgilByteArray.h>
+#include <virgil/crypto/foundation/VirgilRandom.h>
+#include <virgil/crypto/foundation/VirgilSymmetricCipher.h>
+#include <virgil/crypto/primitive/VirgilOperationCipher.h>
+
+using virgil::crypto::VirgilByteArray;
+using virgil::crypto::str2bytes;
+using virgil::crypto::foundation::VirgilRandom;
+using virgil::crypto::foundation::VirgilSymmetricCipher;
+using virgil::crypto::primitive::VirgilOperationCipher;
+
+static VirgilByteArray reference_encrypt(
+        VirgilSymmetricCipher::Algorithm algorithm, const VirgilByteArray& plainText, const VirgilByteArray& key,
+        const VirgilByteArray& nonce, const VirgilByteArray& authData) {
+
+    VirgilSymmetricCipher cipher(algorithm);
+    cipher.setEncryptionKey(key);
+    cipher.setAuthData(authData);
+    return cipher.crypt(plainText, nonce);
+}
+
+static void test_operation_cipher(VirgilOperationCipher cipher, VirgilSymmetricCipher::Algorithm algorithm) {
+    VirgilRandom random(str2bytes("operation cipher"));
+    const VirgilByteArray plainText = str2bytes("this string will be encrypted");
+    const VirgilByteArray authData = str2bytes("auth data");
+    const VirgilByteArray key = random.randomize(cipher.getKeySize());
+    const VirgilByteArray otherKey = random.randomize(cipher.getKeySize());
+    const VirgilByteArray nonce = random.randomize(cipher.getNonceSize());
+    const VirgilByteArray otherNonce = random.randomize(cipher.getNonceSize());
+
+    SECTION("reuse the same key") {
+        const VirgilByteArray cipherText = cipher.encrypt(plainText, key, nonce, authData);
+        const VirgilByteArray otherCipherText = cipher.encrypt(plainText, key, otherNonce, authData);
+        REQUIRE(cipherText == reference_encrypt(algorithm, plainText, key, nonce, authData));
+        REQUIRE(otherCipherText == reference_encrypt(algorithm, plainText, key, otherNonce, authData));
+        REQUIRE(cipher.decrypt(cipherText, key, nonce, authData) == plainText);
+        REQUIRE(cipher.decrypt(otherCipherText, key, otherNonce, authData) == plainText);
+    }
+
+    SECTION("switch between encryption and decryption") {
+        for (int i = 0; i < 4; ++i) {
+            const VirgilByteArray cipherText = cipher.encrypt(plainText, key, nonce, authData);
+            REQUIRE(cipher.decrypt(cipherText, key, nonce, authData) == plainText);
+            REQUIRE(cipher.encrypt(plainText, key, nonce, authData) == cipherText);
+        }
+    }
+
+    SECTION("change key, and recover after failure") {
+        const VirgilByteArray cipherText = cipher.encrypt(plainText, key, nonce, authData);
+        const VirgilByteArray otherCipherText = cipher.encrypt(plainText, otherKey, nonce, authData);
+        REQUIRE(cipherText != otherCipherText);
+        REQUIRE_THROWS(cipher.decrypt(cipherText, otherKey, nonce, authData));
+        REQUIRE_THROWS(cipher.decrypt(cipherText, key, nonce, str2bytes("wrong auth data")));
+        REQUIRE(cipher.decrypt(cipherText, key, nonce, authData) == plainText);
+        REQUIRE(cipher.decrypt(otherCipherText, otherKey, nonce, authData) == plainText);
+    }
+
+    SECTION("use from multiple threads") {
+        std::vector<std::thread> threads;
+        std::vector<int> results(4, 0);
+        for (size_t i = 0; i < results.size(); ++i) {
+            threads.emplace_back([&, i]() {
+                const VirgilByteArray& threadKey = i % 2 == 0 ? key : otherKey;
+                const VirgilByteArray expectedCipherText =
+                        reference_encrypt(algorithm, plainText, threadKey, nonce, authData);
+                for (int j = 0; j < 64; ++j) {
+                    const VirgilByteArray cipherText = cipher.encrypt(plainText, threadKey, nonce, authData);
+                    results[i] += cipherText == expectedCipherText &&
+                            cipher.decrypt(cipherText, threadKey, nonce, authData) == plainText ? 1 : 0;
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        for (auto result : results) {
+            REQUIRE(result == 64);
+        }
+    }
+}
+
+TEST_CASE("VirgilOperationCipher: AES-256-GCM", "[operation-cipher]") {
+    test_operation_cipher(VirgilOperationCipher::getDefault(), VirgilSymmetricCipher::Algorithm::AES_256_GCM);
+}
+
+TEST_CASE("VirgilOperationCipher: ChaCha20-Poly1305", "[operation-cipher]") {
+    test_operation_cipher(
+            VirgilOperationCipher::getChaCha20Poly1305(), VirgilSymmetricCipher::Algorithm::CHACHA20_POLY1305);
+}
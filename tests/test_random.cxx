@@ -60,6 +60,18 @@ TEST_CASE("Randomize sequence", "[random]") {
         REQUIRE(data.size() == kSequenceLength);
     }
 
+    SECTION("Differs between instances") {
+        constexpr size_t kSequenceLength = 32;
+        VirgilRandom otherRandom("secure seed");
+        REQUIRE(random.randomize(kSequenceLength) != otherRandom.randomize(kSequenceLength));
+    }
+
+    SECTION("Long personal info") {
+        constexpr size_t kSequenceLength = 32;
+        VirgilRandom longInfoRandom(VirgilByteArray(1024, 0xAB));
+        REQUIRE(longInfoRandom.randomize(kSequenceLength).size() == kSequenceLength);
+    }
+
     SECTION("Too BIG") {
         constexpr size_t kSequenceLength = std::numeric_limits<size_t>::max();
         REQUIRE_THROWS_AS(random.randomize(kSequenceLength).size(), std::bad_alloc);
@@ -41,7 +41,10 @@
 
 #include "catch.hpp"
 
+#include <algorithm>
+
 #include <virgil/crypto/VirgilByteArray.h>
+#include <virgil/crypto/VirgilByteArrayUtils.h>
 #include <virgil/crypto/foundation/VirgilSymmetricCipher.h>
 #include <virgil/crypto/foundation/VirgilRandom.h>
 
@@ -50,6 +53,7 @@ using virgil::crypto::hex2bytes;
 using virgil::crypto::bytes2str;
 using virgil::crypto::bytes2hex;
 using virgil::crypto::VirgilByteArray;
+using virgil::crypto::VirgilByteArrayUtils;
 using virgil::crypto::foundation::VirgilSymmetricCipher;
 using virgil::crypto::foundation::VirgilRandom;
 
@@ -103,6 +107,58 @@ static void test_symmetric_cipher(VirgilSymmetricCipher::Algorithm algorithm) {
         // Check
         REQUIRE(bytes2str(plainData) == bytes2str(decryptedData));
     }
+
+    SECTION("with caller provided buffer") {
+        VirgilRandom random(str2bytes("test_symmetric_cipher"));
+        VirgilByteArray key = random.randomize(cipher.keyLength());
+        VirgilByteArray iv = random.randomize(cipher.ivSize());
+        // Encrypt with byte array API
+        cipher.setEncryptionKey(key);
+        VirgilByteArray encryptedData = cipher.crypt(plainData, iv);
+        // Encrypt in parts to the buffer
+        cipher.setIV(iv);
+        cipher.reset();
+        VirgilByteArray buffer(cipher.updateOutputSizeMax(plainData.size()) + cipher.finishOutputSizeMax());
+        const size_t firstPartSize = plainData.size() / 3;
+        size_t writtenBytes = cipher.update(plainData.data(), firstPartSize, buffer.data(), buffer.size());
+        writtenBytes += cipher.update(plainData.data() + firstPartSize, plainData.size() - firstPartSize,
+                buffer.data() + writtenBytes, buffer.size() - writtenBytes);
+        writtenBytes += cipher.finish(buffer.data() + writtenBytes, buffer.size() - writtenBytes);
+        buffer.resize(writtenBytes);
+        REQUIRE(buffer == encryptedData);
+        // Check too small buffer
+        cipher.setIV(iv);
+        cipher.reset();
+        VirgilByteArray smallBuffer(plainData.size() - 1);
+        REQUIRE_THROWS(cipher.update(plainData.data(), plainData.size(), smallBuffer.data(), smallBuffer.size()));
+        // Encrypt in-place
+        cipher.setIV(iv);
+        cipher.reset();
+        VirgilByteArray inPlaceData(plainData);
+        if (cipher.isAuthMode()) {
+            writtenBytes = cipher.update(inPlaceData.data(), inPlaceData.size(), inPlaceData.data(), inPlaceData.size());
+            REQUIRE(writtenBytes == inPlaceData.size());
+            inPlaceData.resize(writtenBytes + cipher.finishOutputSizeMax());
+            inPlaceData.resize(writtenBytes +
+                    cipher.finish(inPlaceData.data() + writtenBytes, inPlaceData.size() - writtenBytes));
+            REQUIRE(inPlaceData == encryptedData);
+        } else {
+            REQUIRE_THROWS(cipher.update(
+                    inPlaceData.data(), inPlaceData.size(), inPlaceData.data(), inPlaceData.capacity()));
+        }
+        // Decrypt to the buffer
+        cipher.clear();
+        cipher.setDecryptionKey(key);
+        cipher.setIV(iv);
+        cipher.reset();
+        VirgilByteArray decryptedData(
+                cipher.updateOutputSizeMax(encryptedData.size()) + cipher.finishOutputSizeMax());
+        writtenBytes = cipher.update(encryptedData.data(), encryptedData.size(),
+                decryptedData.data(), decryptedData.size());
+        writtenBytes += cipher.finish(decryptedData.data() + writtenBytes, decryptedData.size() - writtenBytes);
+        decryptedData.resize(writtenBytes);
+        REQUIRE(decryptedData == plainData);
+    }
 }
 
 TEST_CASE("Symmetric Cipher", "[symmetric-cipher]") {
@@ -119,5 +175,193 @@ TEST_CASE("Symmetric Cipher", "[symmetric-cipher]") {
     SECTION("AES-256-GCM") {
         test_symmetric_cipher(VirgilSymmetricCipher::Algorithm::AES_256_GCM);
     }
+    SECTION("CHACHA20-POLY1305") {
+        test_symmetric_cipher(VirgilSymmetricCipher::Algorithm::CHACHA20_POLY1305);
+    }
+
+}
+
+TEST_CASE("Symmetric Cipher ChaCha20-Poly1305 - RFC 8439 test vector", "[symmetric-cipher]") {
+    const VirgilByteArray key = hex2bytes("808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f");
+    const VirgilByteArray nonce = hex2bytes("070000004041424344454647");
+    const VirgilByteArray authData = hex2bytes("50515253c0c1c2c3c4c5c6c7");
+    const VirgilByteArray plainData = str2bytes(
+            "Ladies and Gentlemen of the class of '99: If I could offer you only one tip for the future, "
+            "sunscreen would be it.");
+    const std::string expectedEncryptedData =
+            "d31a8d34648e60db7b86afbc53ef7ec2a4aded51296e08fea9e2b5a736ee62d6"
+            "3dbea45e8ca9671282fafb69da92728b1a71de0a9e060b2905d6a5b67ecd3b36"
+            "92ddbd7f2d778b8c9803aee328091b58fab324e4fad675945585808b4831d7bc"
+            "3ff4def08e4b7a9de576d26586cec64b6116"
+            "1ae10b594f09e26a7e902ecbd0600691";
+
+    VirgilSymmetricCipher cipher(VirgilSymmetricCipher::Algorithm::CHACHA20_POLY1305);
+    REQUIRE(cipher.name() == "CHACHA20-POLY1305");
+    REQUIRE(cipher.isAuthMode());
+    REQUIRE_FALSE(cipher.isSupportPadding());
+
+    cipher.setEncryptionKey(key);
+    cipher.setAuthData(authData);
+    const VirgilByteArray encryptedData = cipher.crypt(plainData, nonce);
+    REQUIRE(bytes2hex(encryptedData) == expectedEncryptedData);
+
+    SECTION("decrypt with restored from ASN.1 cipher") {
+        VirgilSymmetricCipher restoredCipher;
+        restoredCipher.fromAsn1(cipher.toAsn1());
+        REQUIRE(restoredCipher.name() == "CHACHA20-POLY1305");
+        REQUIRE(restoredCipher.iv() == nonce);
+        restoredCipher.setDecryptionKey(key);
+        restoredCipher.setAuthData(authData);
+        REQUIRE(restoredCipher.crypt(encryptedData, restoredCipher.iv()) == plainData);
+    }
+
+    SECTION("detect modified cipher text") {
+        VirgilByteArray modifiedData(encryptedData);
+        modifiedData[10] ^= 0x01;
+        cipher.clear();
+        cipher.setDecryptionKey(key);
+        cipher.setAuthData(authData);
+        REQUIRE_THROWS(cipher.crypt(modifiedData, nonce));
+    }
+}
+
+TEST_CASE("Symmetric Cipher AES-GCM - NIST test vectors", "[symmetric-cipher]") {
+    const VirgilByteArray iv = hex2bytes("cafebabefacedbaddecaf888");
+    const VirgilByteArray authData = hex2bytes("feedfacedeadbeeffeedfacedeadbeefabaddad2");
+    const VirgilByteArray plainData = hex2bytes(
+            "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+            "1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39");
+
+    SECTION("AES-128-GCM") {
+        const VirgilByteArray key = hex2bytes("feffe9928665731c6d6a8f9467308308");
+        const std::string expectedEncryptedData =
+                "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e"
+                "21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091"
+                "5bc94fbc3221a5db94fae95ae7121a47";
+
+        VirgilSymmetricCipher cipher(VirgilSymmetricCipher::Algorithm::AES_128_GCM);
+        cipher.setEncryptionKey(key);
+        cipher.setAuthData(authData);
+        const VirgilByteArray encryptedData = cipher.crypt(plainData, iv);
+        REQUIRE(bytes2hex(encryptedData) == expectedEncryptedData);
+
+        cipher.clear();
+        cipher.setDecryptionKey(key);
+        cipher.setAuthData(authData);
+        REQUIRE(cipher.crypt(encryptedData, iv) == plainData);
+    }
+
+    SECTION("AES-256-GCM") {
+        const VirgilByteArray key = hex2bytes(
+                "feffe9928665731c6d6a8f9467308308feffe9928665731c6d6a8f9467308308");
+        const std::string expectedEncryptedData =
+                "522dc1f099567d07f47f37a32a84427d643a8cdcbfe5c0c97598a2bd2555d1aa"
+                "8cb08e48590dbb3da7b08b1056828838c5f61e6393ba7a0abcc9f662"
+                "76fc6ece0f4e1768cddf8853bb2d551b";
+
+        VirgilSymmetricCipher cipher(VirgilSymmetricCipher::Algorithm::AES_256_GCM);
+        cipher.setEncryptionKey(key);
+        cipher.setAuthData(authData);
+        const VirgilByteArray encryptedData = cipher.crypt(plainData, iv);
+        REQUIRE(bytes2hex(encryptedData) == expectedEncryptedData);
+
+        cipher.clear();
+        cipher.setDecryptionKey(key);
+        cipher.setAuthData(authData);
+        REQUIRE(cipher.crypt(encryptedData, iv) == plainData);
+    }
+}
+
+static void test_process_large_data(
+        VirgilSymmetricCipher::Algorithm algorithm, size_t dataSize, size_t decryptionThreadsNum = 1) {
+    VirgilSymmetricCipher cipher(algorithm);
+    cipher.setDecryptionThreadsNum(decryptionThreadsNum);
+    const VirgilByteArray key = VirgilRandom("key").randomize(cipher.keyLength());
+    const VirgilByteArray iv = VirgilRandom("iv").randomize(cipher.ivSize());
+    const VirgilByteArray plainData = VirgilRandom("data").randomize(dataSize);
+
+    cipher.setEncryptionKey(key);
+    const VirgilByteArray encryptedData = cipher.crypt(plainData, iv);
+
+    cipher.clear();
+    REQUIRE(cipher.getDecryptionThreadsNum() == decryptionThreadsNum);
+    cipher.setDecryptionKey(key);
+    REQUIRE(cipher.crypt(encryptedData, iv) == plainData);
+
+    cipher.setIV(iv);
+    cipher.reset();
+    VirgilByteArray decryptedData;
+    // Odd piece sizes cross both 16 bytes blocks and 128 bytes parallel batches.
+    const size_t pieceSizes[] = { 1, 15, 17, 128, 129, 1000, 4093 };
+    size_t offset = 0;
+    for (size_t i = 0; offset < encryptedData.size(); ++i) {
+        const size_t pieceSize = std::min(pieceSizes[i % 7], encryptedData.size() - offset);
+        const VirgilByteArray piece(
+                encryptedData.begin() + offset, encryptedData.begin() + offset + pieceSize);
+        VirgilByteArrayUtils::append(decryptedData, cipher.update(piece));
+        offset += pieceSize;
+    }
+    VirgilByteArrayUtils::append(decryptedData, cipher.finish());
+    REQUIRE(decryptedData == plainData);
+}
+
+TEST_CASE("Symmetric Cipher - process large data", "[symmetric-cipher]") {
+    SECTION("AES-256-GCM") {
+        test_process_large_data(VirgilSymmetricCipher::Algorithm::AES_256_GCM, 64 * 1024 + 7);
+    }
+    SECTION("AES-128-CBC") {
+        test_process_large_data(VirgilSymmetricCipher::Algorithm::AES_128_CBC, 64 * 1024 + 7);
+    }
+    SECTION("AES-256-CBC, single-threaded decryption of the large input") {
+        test_process_large_data(VirgilSymmetricCipher::Algorithm::AES_256_CBC, 5 * 1024 * 1024 + 7);
+    }
+    SECTION("AES-256-CBC, multi-threaded decryption") {
+        test_process_large_data(VirgilSymmetricCipher::Algorithm::AES_256_CBC, 5 * 1024 * 1024 + 7, 4);
+    }
+}
+
+TEST_CASE("Symmetric Cipher AES-CBC - detect broken padding", "[symmetric-cipher]") {
+    VirgilSymmetricCipher cipher(VirgilSymmetricCipher::Algorithm::AES_256_CBC);
+    const VirgilByteArray key = VirgilRandom("key").randomize(cipher.keyLength());
+    const VirgilByteArray iv = VirgilRandom("iv").randomize(cipher.ivSize());
+    // Zero last byte is never a valid PKCS#7 padding.
+    const VirgilByteArray plainData(2 * cipher.blockSize(), 0x00);
+
+    cipher.setEncryptionKey(key);
+    cipher.setPadding(VirgilSymmetricCipher::Padding::None);
+    const VirgilByteArray encryptedData = cipher.crypt(plainData, iv);
+
+    cipher.clear();
+    cipher.setDecryptionKey(key);
+    REQUIRE_THROWS(cipher.crypt(encryptedData, iv));
 
+    cipher.setPadding(VirgilSymmetricCipher::Padding::None);
+    REQUIRE(cipher.crypt(encryptedData, iv) == plainData);
+}
+
+TEST_CASE("Symmetric Cipher ASN.1 AlgorithmIdentifier", "[symmetric-cipher]") {
+    SECTION("AES-256-GCM is written and read") {
+        VirgilSymmetricCipher cipher(VirgilSymmetricCipher::Algorithm::AES_256_GCM);
+        const VirgilByteArray iv = hex2bytes("000102030405060708090a0b");
+        cipher.setEncryptionKey(VirgilByteArray(cipher.keyLength(), 0x00));
+        cipher.setIV(iv);
+        const VirgilByteArray asn1 = hex2bytes("3019060960864801650304012e040c000102030405060708090a0b");
+        REQUIRE(cipher.toAsn1() == asn1);
+        VirgilSymmetricCipher restoredCipher;
+        restoredCipher.fromAsn1(asn1);
+        REQUIRE(restoredCipher.name() == "AES-256-GCM");
+        REQUIRE(restoredCipher.iv() == iv);
+    }
+    SECTION("AES-128-CBC is written and read") {
+        VirgilSymmetricCipher cipher(VirgilSymmetricCipher::Algorithm::AES_128_CBC);
+        const VirgilByteArray iv = hex2bytes("000102030405060708090a0b0c0d0e0f");
+        cipher.setEncryptionKey(VirgilByteArray(cipher.keyLength(), 0x00));
+        cipher.setIV(iv);
+        const VirgilByteArray asn1 = hex2bytes("301d06096086480165030401020410000102030405060708090a0b0c0d0e0f");
+        REQUIRE(cipher.toAsn1() == asn1);
+        VirgilSymmetricCipher restoredCipher;
+        restoredCipher.fromAsn1(asn1);
+        REQUIRE(restoredCipher.name() == "AES-128-CBC");
+        REQUIRE(restoredCipher.iv() == iv);
+    }
 }
@@ -41,6 +41,7 @@
 
 #include "catch.hpp"
 
+#include <algorithm>
 #include <iostream>
 
 #include <virgil/crypto/VirgilByteArray.h>
@@ -73,3 +74,34 @@ TEST_CASE("Get TAG", "[tag-filter]") {
         REQUIRE(VirgilByteArrayUtils::bytesToHex(tagFilter.tag()) == "2ccda65f87808b4dcdfebd970b881e95");
     }
 }
+
+TEST_CASE("Filter data by pieces", "[tag-filter]") {
+    VirgilTagFilter tagFilter;
+    const size_t kTagLen = 16;
+    const VirgilByteArray data = VirgilByteArrayUtils::hexToBytes(
+            "5eb9ee8ee83801858815e0fc301204102ccda65f87808b4dcdfebd970b881e95");
+    const VirgilByteArray expectedData(data.begin(), data.end() - kTagLen);
+
+    for (size_t pieceSize : { 1, 3, 15, 16, 17, 100 }) {
+        tagFilter.reset(kTagLen);
+        VirgilByteArray filteredData;
+        for (size_t offset = 0; offset < data.size(); offset += pieceSize) {
+            const size_t size = std::min(pieceSize, data.size() - offset);
+            tagFilter.process(data.data() + offset, size, [&](const unsigned char* chunk, size_t chunkSize) {
+                filteredData.insert(filteredData.end(), chunk, chunk + chunkSize);
+            });
+        }
+        REQUIRE(VirgilByteArrayUtils::bytesToHex(filteredData) == VirgilByteArrayUtils::bytesToHex(expectedData));
+        REQUIRE(kTagLen == tagFilter.tagSize());
+        REQUIRE(VirgilByteArrayUtils::bytesToHex(tagFilter.tag()) == "2ccda65f87808b4dcdfebd970b881e95");
+    }
+}
+
+TEST_CASE("Tag is longer than data", "[tag-filter]") {
+    VirgilTagFilter tagFilter;
+    tagFilter.reset(16);
+    tagFilter.process(VirgilByteArrayUtils::hexToBytes("0102030405"));
+    REQUIRE_FALSE(tagFilter.hasData());
+    REQUIRE(VirgilByteArrayUtils::bytesToHex(tagFilter.tag()) == "0102030405");
+    REQUIRE_THROWS(tagFilter.reset(VirgilTagFilter::kTagLenMax + 1));
+}
@@ -54,6 +54,7 @@ using virgil::crypto::VirgilByteArrayUtils;
 using virgil::crypto::VirgilTinyCipher;
 using virgil::crypto::VirgilKeyPair;
 using virgil::crypto::VirgilCryptoException;
+using virgil::crypto::foundation::VirgilSymmetricCipher;
 
 static void test_encrypt_decrypt(const VirgilKeyPair& keyPair, const VirgilByteArray& keyPassword) {
     VirgilByteArray testData = VirgilByteArrayUtils::stringToBytes("this string will be encrypted and decrypted");
@@ -170,3 +171,34 @@ static void test_encrypt_decrypt(const VirgilKeyPair& keyPair, const VirgilByteA
 TEST_CASE_ENCRYPT_DECRYPT(FAST_EC_ED25519)
 
 #undef TEST_CASE_ENCRYPT_DECRYPT
+
+TEST_CASE("VirgilTinyCipher: encrypt and decrypt with ChaCha20-Poly1305", "[tiny-cipher]") {
+    const VirgilByteArray testData = VirgilByteArrayUtils::stringToBytes("this string will be encrypted and decrypted");
+    const VirgilKeyPair keyPair = VirgilKeyPair::generate(VirgilKeyPair::Type::FAST_EC_ED25519);
+
+    VirgilTinyCipher encCipher(
+            VirgilTinyCipher::PackageSize_Short_SMS, VirgilSymmetricCipher::Algorithm::CHACHA20_POLY1305);
+    encCipher.encryptAndSign(testData, keyPair.publicKey(), keyPair.privateKey());
+
+    SECTION("with the same algorithm - OK") {
+        VirgilTinyCipher decCipher(
+                VirgilTinyCipher::PackageSize_Short_SMS, VirgilSymmetricCipher::Algorithm::CHACHA20_POLY1305);
+        for (size_t i = 0; i < encCipher.getPackageCount(); ++i) {
+            decCipher.addPackage(encCipher.getPackage(i));
+        }
+        REQUIRE(decCipher.verifyAndDecrypt(keyPair.publicKey(), keyPair.privateKey()) == testData);
+    }
+
+    SECTION("with default algorithm - FAIL") {
+        VirgilTinyCipher decCipher;
+        for (size_t i = 0; i < encCipher.getPackageCount(); ++i) {
+            decCipher.addPackage(encCipher.getPackage(i));
+        }
+        REQUIRE_THROWS(decCipher.verifyAndDecrypt(keyPair.publicKey(), keyPair.privateKey()));
+    }
+
+    SECTION("with not authenticated algorithm - FAIL") {
+        REQUIRE_THROWS(VirgilTinyCipher(
+                VirgilTinyCipher::PackageSize_Short_SMS, VirgilSymmetricCipher::Algorithm::AES_256_CBC));
+    }
+}
@@ -164,6 +164,7 @@ EMSCRIPTEN_BINDINGS(virgil_crypto) {
         .class_function("hasFeatureStreamImpl", &VirgilConfig::hasFeatureStreamImpl)
         .class_function("hasFeaturePythiaImpl", &VirgilConfig::hasFeaturePythiaImpl)
         .class_function("hasFeaturePythiaMultiThread", &VirgilConfig::hasFeaturePythiaMultiThread)
+        .class_function("hasFeatureThreadLocal", &VirgilConfig::hasFeatureThreadLocal)
     ;
 
     register_vector<unsigned char>("VirgilByteArray")
@@ -218,7 +219,8 @@ EMSCRIPTEN_BINDINGS(virgil_crypto) {
     ;
 
     class_<VirgilCipherBase>("VirgilCipherBase")
-        .function("addKeyRecipient", &VirgilCipherBase::addKeyRecipient)
+        .function("addKeyRecipient",
+                select_overload<void(const VirgilByteArray&, const VirgilByteArray&)>(&VirgilCipherBase::addKeyRecipient))
         .function("removeKeyRecipient", &VirgilCipherBase::removeKeyRecipient)
         .function("keyRecipientExists", &VirgilCipherBase::keyRecipientExists)
         .function("addPasswordRecipient", &VirgilCipherBase::addPasswordRecipient)
@@ -227,14 +229,20 @@ EMSCRIPTEN_BINDINGS(virgil_crypto) {
         .function("getContentInfo", &VirgilCipherBase::getContentInfo)
         .function("setContentInfo", &VirgilCipherBase::setContentInfo)
         .function("customParams", &VirgilCipherBase_customParams, allow_raw_pointers())
+        .function("setContentEncryptionAlgorithm", &VirgilCipherBase::setContentEncryptionAlgorithm)
+        .function("getContentEncryptionAlgorithm", &VirgilCipherBase::getContentEncryptionAlgorithm)
         .class_function("defineContentInfoSize", &VirgilCipherBase::defineContentInfoSize)
-        .class_function("computeShared", &VirgilCipherBase::computeShared)
+        .class_function("computeShared",
+                select_overload<VirgilByteArray(const VirgilByteArray&, const VirgilByteArray&, const VirgilByteArray&)>(
+                        &VirgilCipherBase::computeShared))
     ;
 
     class_<VirgilCipher, base<VirgilCipherBase>>("VirgilCipher")
         .constructor<>()
-        .function("encrypt", &VirgilCipher::encrypt)
-        .function("decryptWithKey", &VirgilCipher::decryptWithKey)
+        .function("encrypt", select_overload<VirgilByteArray(const VirgilByteArray&, bool)>(&VirgilCipher::encrypt))
+        .function("decryptWithKey",
+                select_overload<VirgilByteArray(const VirgilByteArray&, const VirgilByteArray&, const VirgilByteArray&, const VirgilByteArray&)>(
+                        &VirgilCipher::decryptWithKey))
         .function("decryptWithPassword", &VirgilCipher::decryptWithPassword)
     ;
 
@@ -242,8 +250,10 @@ EMSCRIPTEN_BINDINGS(virgil_crypto) {
         .constructor<>()
         .constructor<VirgilHash::Algorithm>()
         .function("getHashAlgorithm", &VirgilSignerBase::getHashAlgorithm)
-        .function("signHash", &VirgilSignerBase::signHash)
-        .function("verifyHash", &VirgilSignerBase::verifyHash)
+        .function("signHash",
+                select_overload<VirgilByteArray(const VirgilByteArray&, const VirgilByteArray&, const VirgilByteArray&)>(&VirgilSignerBase::signHash))
+        .function("verifyHash",
+                select_overload<bool(const VirgilByteArray&, const VirgilByteArray&, const VirgilByteArray&)>(&VirgilSignerBase::verifyHash))
     ;
 
     class_<VirgilSigner, base<VirgilSignerBase>>("VirgilSigner")
@@ -262,20 +272,22 @@ EMSCRIPTEN_BINDINGS(virgil_crypto) {
         .function("update", &VirgilSeqSigner::update)
         .function("sign", &VirgilSeqSigner_sign_1)
         .function("sign", &VirgilSeqSigner_sign_2)
-        .function("verify", &VirgilSeqSigner::verify)
+        .function("verify", select_overload<bool(const VirgilByteArray&)>(&VirgilSeqSigner::verify))
     ;
 
     class_<VirgilCustomParams>("VirgilCustomParams")
         .constructor<>()
         .function("isEmpty", &VirgilCustomParams::isEmpty)
-        .function("setInteger", &VirgilCustomParams::setInteger)
-        .function("getInteger", &VirgilCustomParams::getInteger)
+        .function("setInteger", select_overload<void(const VirgilByteArray&, int)>(&VirgilCustomParams::setInteger))
+        .function("getInteger", select_overload<int(const VirgilByteArray&) const>(&VirgilCustomParams::getInteger))
         .function("removeInteger", &VirgilCustomParams::removeInteger)
         .function("setString", &VirgilCustomParams::setString)
-        .function("getString", &VirgilCustomParams::getString)
+        .function("getString",
+                select_overload<VirgilByteArray(const VirgilByteArray&) const>(&VirgilCustomParams::getString))
         .function("removeString", &VirgilCustomParams::removeString)
         .function("setData", &VirgilCustomParams::setData)
-        .function("getData", &VirgilCustomParams::getData)
+        .function("getData",
+                select_overload<VirgilByteArray(const VirgilByteArray&) const>(&VirgilCustomParams::getData))
         .function("removeData", &VirgilCustomParams::removeData)
         .function("clear", &VirgilCustomParams::clear)
     ;
@@ -298,15 +310,20 @@ EMSCRIPTEN_BINDINGS(virgil_crypto) {
     class_<VirgilTinyCipher>("VirgilTinyCipher")
         .constructor<>()
         .constructor<size_t>()
+        .constructor<size_t, VirgilSymmetricCipher::Algorithm>()
         .function("reset", &VirgilTinyCipher::reset)
-        .function("encrypt", &VirgilTinyCipher::encrypt)
-        .function("encryptAndSign", &VirgilTinyCipher::encryptAndSign)
+        .function("encrypt", select_overload<void(const VirgilByteArray&, const VirgilByteArray&)>(&VirgilTinyCipher::encrypt))
+        .function("encryptAndSign",
+                select_overload<void(const VirgilByteArray&, const VirgilByteArray&, const VirgilByteArray&, const VirgilByteArray&)>(
+                        &VirgilTinyCipher::encryptAndSign))
         .function("getPackageCount", &VirgilTinyCipher::getPackageCount)
         .function("getPackage", &VirgilTinyCipher::getPackage)
         .function("addPackage", &VirgilTinyCipher::addPackage)
         .function("isPackagesAccumulated", &VirgilTinyCipher::isPackagesAccumulated)
-        .function("decrypt", &VirgilTinyCipher::decrypt)
-        .function("verifyAndDecrypt", &VirgilTinyCipher::verifyAndDecrypt)
+        .function("decrypt", select_overload<VirgilByteArray(const VirgilByteArray&, const VirgilByteArray&)>(&VirgilTinyCipher::decrypt))
+        .function("verifyAndDecrypt",
+                select_overload<VirgilByteArray(const VirgilByteArray&, const VirgilByteArray&, const VirgilByteArray&)>(
+                        &VirgilTinyCipher::verifyAndDecrypt))
     ;
 
     class_<VirgilDataSink>("VirgilDataSink")
@@ -324,21 +341,26 @@ EMSCRIPTEN_BINDINGS(virgil_crypto) {
     class_<VirgilStreamCipher, base<VirgilCipherBase>>("VirgilStreamCipher")
         .constructor<>()
         .function("encrypt", &VirgilStreamCipher::encrypt)
-        .function("decryptWithKey", &VirgilStreamCipher::decryptWithKey)
+        .function("decryptWithKey",
+                select_overload<void(VirgilDataSource&, VirgilDataSink&, const VirgilByteArray&, const VirgilByteArray&, const VirgilByteArray&)>(
+                        &VirgilStreamCipher::decryptWithKey))
         .function("decryptWithPassword", &VirgilStreamCipher::decryptWithPassword)
     ;
 
     class_<VirgilChunkCipher, base<VirgilCipherBase>>("VirgilChunkCipher")
         .constructor<>()
         .function("encrypt", &VirgilChunkCipher::encrypt)
-        .function("decryptWithKey", &VirgilChunkCipher::decryptWithKey)
+        .function("decryptWithKey",
+                select_overload<void(VirgilDataSource&, VirgilDataSink&, const VirgilByteArray&, const VirgilByteArray&, const VirgilByteArray&)>(
+                        &VirgilChunkCipher::decryptWithKey))
         .function("decryptWithPassword", &VirgilChunkCipher::decryptWithPassword)
     ;
 
     class_<VirgilSeqCipher, base<VirgilCipherBase>>("VirgilSeqCipher")
         .constructor<>()
         .function("startEncryption", &VirgilSeqCipher::startEncryption)
-        .function("startDecryptionWithKey", &VirgilSeqCipher::startDecryptionWithKey)
+        .function("startDecryptionWithKey",
+                select_overload<void(const VirgilByteArray&, const VirgilByteArray&, const VirgilByteArray&)>(&VirgilSeqCipher::startDecryptionWithKey))
         .function("startDecryptionWithPassword", &VirgilSeqCipher::startDecryptionWithPassword)
         .function("process", &VirgilSeqCipher::process)
         .function("finish", &VirgilSeqCipher::finish)
@@ -438,8 +460,9 @@ EMSCRIPTEN_BINDINGS(virgil_crypto_foundation) {
         .function("setPadding", &VirgilSymmetricCipher::setPadding)
         .function("reset", &VirgilSymmetricCipher::reset)
         .function("clear", &VirgilSymmetricCipher::clear)
-        .function("update", &VirgilSymmetricCipher::update)
-        .function("finish", &VirgilSymmetricCipher::finish)
+        .function("update",
+                select_overload<VirgilByteArray(const VirgilByteArray&)>(&VirgilSymmetricCipher::update))
+        .function("finish", select_overload<VirgilByteArray()>(&VirgilSymmetricCipher::finish))
     ;
 
 
@@ -456,6 +479,7 @@ EMSCRIPTEN_BINDINGS(virgil_crypto_foundation) {
         .value("AES_128_GCM", VirgilSymmetricCipher::Algorithm::AES_128_GCM)
         .value("AES_256_CBC", VirgilSymmetricCipher::Algorithm::AES_256_CBC)
         .value("AES_256_GCM", VirgilSymmetricCipher::Algorithm::AES_256_GCM)
+        .value("CHACHA20_POLY1305", VirgilSymmetricCipher::Algorithm::CHACHA20_POLY1305)
     ;
 
     class_<VirgilAsymmetricCipher>("VirgilAsymmetricCipher")